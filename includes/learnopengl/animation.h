@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <vector>
 #include <map>
 #include <glm/glm.hpp>
@@ -17,6 +18,16 @@ struct AssimpNodeData
 	std::vector<AssimpNodeData> children;
 };
 
+// one node of the flattened hierarchy; parents are always stored before their children
+struct AnimationNode
+{
+	glm::mat4 transformation;
+	int parentIndex;	// index into the node array, -1 for the root
+	int boneIndex;		// index of the animation channel (Animation::GetBone), -1 if the node isn't animated
+	int boneInfoID;		// BoneInfo id (index in the final bone matrices), -1 if no vertices are bound to the node
+	glm::mat4 offset;	// BoneInfo offset, only valid if boneInfoID is set
+};
+
 class Animation
 {
 public:
@@ -28,18 +39,34 @@ public:
 		const aiScene* scene = importer.ReadFile(animationPath, aiProcess_Triangulate);
 		assert(scene && scene->mRootNode);
 		auto animation = scene->mAnimations[0];
-		m_Duration = animation->mDuration;
-		m_TicksPerSecond = animation->mTicksPerSecond;
 		aiMatrix4x4 globalTransformation = scene->mRootNode->mTransformation;
 		globalTransformation = globalTransformation.Inverse();
-		ReadHierarchyData(m_RootNode, scene->mRootNode);
-		ReadMissingBones(animation, *model);
+		Load(animation, scene->mRootNode, model->GetBoneInfoMap(), model->GetBoneCount());
+	}
+
+	// builds the animation from a clip and node hierarchy that are already in memory, e.g. generated ones;
+	// channels of nodes no vertex is bound to get a new id in boneInfoMap, counting on from boneCount
+	Animation(const aiAnimation* animation, const aiNode* rootNode, std::map<std::string, BoneInfo>& boneInfoMap, int& boneCount)
+	{
+		Load(animation, rootNode, boneInfoMap, boneCount);
 	}
 
 	~Animation()
 	{
 	}
 
+	// a clip without channels over the same hierarchy, so it holds the bind pose; e.g. to blend a character back to rest
+	static Animation BindPose(const Animation& animation)
+	{
+		Animation pose;
+		pose.m_Duration = 1.0f;
+		pose.m_TicksPerSecond = 1;
+		pose.m_RootNode = animation.m_RootNode;
+		pose.m_BoneInfoMap = animation.m_BoneInfoMap;
+		pose.FlattenHierarchy();
+		return pose;
+	}
+
 	Bone* FindBone(const std::string& name)
 	{
 		auto iter = std::find_if(m_Bones.begin(), m_Bones.end(),
@@ -53,21 +80,49 @@ public:
 	}
 
 	
-	inline float GetTicksPerSecond() { return m_TicksPerSecond; }
-	inline float GetDuration() { return m_Duration;}
+	inline float GetTicksPerSecond() const { return m_TicksPerSecond; }
+	inline float GetDuration() const { return m_Duration;}
 	inline const AssimpNodeData& GetRootNode() { return m_RootNode; }
 	inline const std::map<std::string,BoneInfo>& GetBoneIDMap() 
 	{ 
 		return m_BoneInfoMap;
 	}
+	inline const std::vector<AnimationNode>& GetNodes() const { return m_Nodes; }
+
+	// index of the node with the given name in GetNodes(), -1 if there is none
+	int FindNode(const std::string& name) const
+	{
+		auto it = std::find(m_NodeNames.begin(), m_NodeNames.end(), name);
+		return it != m_NodeNames.end() ? (int)(it - m_NodeNames.begin()) : -1;
+	}
+	inline const std::string& GetNodeName(int index) const { return m_NodeNames[index]; }
+
+	// resamples every channel to a fixed number of keys per second, turning key lookups into a division
+	void Resample(float keysPerSecond)
+	{
+		if (keysPerSecond <= 0.0f || m_TicksPerSecond <= 0)
+			return;
+		const float interval = m_TicksPerSecond / keysPerSecond;
+		for (Bone& bone : m_Bones)
+			bone.Resample(interval, m_Duration);
+	}
+	inline Bone& GetBone(int index) { return m_Bones[index]; }
+	inline const Bone& GetBone(int index) const { return m_Bones[index]; }
+	inline int GetBoneCount() const { return (int)m_Bones.size(); }
 
 private:
-	void ReadMissingBones(const aiAnimation* animation, Model& model)
+	void Load(const aiAnimation* animation, const aiNode* rootNode, std::map<std::string, BoneInfo>& boneInfoMap, int& boneCount)
 	{
-		int size = animation->mNumChannels;
+		m_Duration = animation->mDuration;
+		m_TicksPerSecond = animation->mTicksPerSecond;
+		ReadHierarchyData(m_RootNode, rootNode);
+		ReadMissingBones(animation, boneInfoMap, boneCount);
+		FlattenHierarchy();
+	}
 
-		auto& boneInfoMap = model.GetBoneInfoMap();//getting m_BoneInfoMap from Model class
-		int& boneCount = model.GetBoneCount(); //getting the m_BoneCounter from Model class
+	void ReadMissingBones(const aiAnimation* animation, std::map<std::string, BoneInfo>& boneInfoMap, int& boneCount)
+	{
+		int size = animation->mNumChannels;
 
 		//reading channels(bones engaged in an animation and their keyframes)
 		for (int i = 0; i < size; i++)
@@ -102,10 +157,42 @@ private:
 			dest.children.push_back(newData);
 		}
 	}
+	// resolves the node tree into m_Nodes once, so that updates don't need any name lookups
+	void FlattenHierarchy()
+	{
+		std::map<std::string, int> boneIndices;
+		for (int i = 0; i < (int)m_Bones.size(); i++)
+			boneIndices.emplace(m_Bones[i].GetBoneName(), i); // the first channel wins, like FindBone
+
+		m_Nodes.clear();
+		m_NodeNames.clear();
+		FlattenNode(m_RootNode, -1, boneIndices);
+	}
+
+	void FlattenNode(const AssimpNodeData& node, int parentIndex, const std::map<std::string, int>& boneIndices)
+	{
+		AnimationNode flat;
+		flat.transformation = node.transformation;
+		flat.parentIndex = parentIndex;
+		auto bone = boneIndices.find(node.name);
+		flat.boneIndex = bone != boneIndices.end() ? bone->second : -1;
+		auto boneInfo = m_BoneInfoMap.find(node.name);
+		flat.boneInfoID = boneInfo != m_BoneInfoMap.end() ? boneInfo->second.id : -1;
+		flat.offset = boneInfo != m_BoneInfoMap.end() ? boneInfo->second.offset : glm::mat4(1.0f);
+
+		const int index = (int)m_Nodes.size();
+		m_Nodes.push_back(flat);
+		m_NodeNames.push_back(node.name);
+		for (int i = 0; i < node.childrenCount; i++)
+			FlattenNode(node.children[i], index, boneIndices);
+	}
+
 	float m_Duration;
 	int m_TicksPerSecond;
 	std::vector<Bone> m_Bones;
 	AssimpNodeData m_RootNode;
 	std::map<std::string, BoneInfo> m_BoneInfoMap;
+	std::vector<AnimationNode> m_Nodes;
+	std::vector<std::string> m_NodeNames; // parallel to m_Nodes, only needed while setting up blends
 };
 
@@ -1,12 +1,18 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/matrix_decompose.hpp>
 #include <map>
 #include <vector>
 #include <assimp/scene.h>
 #include <assimp/Importer.hpp>
 #include <learnopengl/animation.h>
 #include <learnopengl/bone.h>
+#include <learnopengl/pose.h>
+
+// size of the finalBonesMatrices array in the skinning vertex shader
+const int MAX_BONES = 100;
 
 class Animator
 {
@@ -16,65 +22,286 @@ public:
 		m_CurrentTime = 0.0;
 		m_CurrentAnimation = animation;
 
-		m_FinalBoneMatrices.reserve(100);
+		m_FinalBoneMatrices.reserve(MAX_BONES);
 
-		for (int i = 0; i < 100; i++)
+		for (int i = 0; i < MAX_BONES; i++)
 			m_FinalBoneMatrices.push_back(glm::mat4(1.0f));
+
+		if (m_CurrentAnimation)
+			allocateState();
 	}
 
 	void UpdateAnimation(float dt)
 	{
 		m_DeltaTime = dt;
 		if (m_CurrentAnimation)
+			advance(*m_CurrentAnimation, m_CurrentTime, dt);
+		if (m_Fading)
 		{
-			m_CurrentTime += m_CurrentAnimation->GetTicksPerSecond() * dt;
-			m_CurrentTime = fmod(m_CurrentTime, m_CurrentAnimation->GetDuration());
-			CalculateBoneTransform(&m_CurrentAnimation->GetRootNode(), glm::mat4(1.0f));
+			advance(*m_FadeFrom.animation, m_FadeFrom.time, dt);
+			m_FadeElapsed += dt;
+			if (m_FadeElapsed >= m_FadeDuration)
+				m_Fading = false;
 		}
+		for (Track& layer : m_Layers)
+			advance(*layer.animation, layer.time, dt);
+
+		if (m_CurrentAnimation && !m_Fading && m_Layers.empty() && m_CurrentAnimation == m_Skeleton)
+			CalculateBoneTransforms();
+		else if (m_Skeleton)
+			CalculateBlendedTransforms();
 	}
 
+	// switches to another clip immediately; this ends any cross-fade, additive layers keep playing
 	void PlayAnimation(Animation* pAnimation)
 	{
 		m_CurrentAnimation = pAnimation;
 		m_CurrentTime = 0.0f;
+		m_Fading = false;
+		if (m_CurrentAnimation)
+			allocateState();
+	}
+
+	// blends from the clip that is playing now to another one over fadeSeconds; the new clip starts from its beginning
+	void CrossFade(Animation* pAnimation, float fadeSeconds)
+	{
+		if (!m_CurrentAnimation || fadeSeconds <= 0.0f)
+		{
+			PlayAnimation(pAnimation);
+			return;
+		}
+		setupTrack(m_FadeFrom, m_CurrentAnimation, 1.0f);
+		m_FadeFrom.time = m_CurrentTime;
+		m_FadeFrom.cursors.swap(m_Cursors);
+		m_Fading = true;
+		m_FadeElapsed = 0.0f;
+		m_FadeDuration = fadeSeconds;
+
+		m_CurrentAnimation = pAnimation;
+		m_CurrentTime = 0.0f;
+		allocateState();
+	}
+
+	// plays a clip on top of the current one. The layer adds how far it has moved away from its own first
+	// frame, scaled by weight, so e.g. a breathing or aiming clip can run over any walk cycle. Without a
+	// current clip the layer plays on top of the bind pose. Returns the layer index.
+	int AddAdditiveLayer(Animation* pAnimation, float weight = 1.0f)
+	{
+		if (!m_Skeleton)
+			setSkeleton(pAnimation);
+		Track layer;
+		setupTrack(layer, pAnimation, weight);
+		// the first frame is the reference the layer's motion is measured against
+		layer.reference = allocateLocalPose(layer.referenceStorage);
+		std::vector<BoneCursor> cursors(pAnimation->GetBoneCount());
+		samplePose(*pAnimation, 0.0f, cursors.data(), layer.nodeMap, layer.reference);
+		m_Layers.push_back(std::move(layer));
+		return (int)m_Layers.size() - 1;
 	}
 
-	void CalculateBoneTransform(const AssimpNodeData* node, glm::mat4 parentTransform)
+	void SetLayerWeight(int layer, float weight)
 	{
-		std::string nodeName = node->name;
-		glm::mat4 nodeTransform = node->transformation;
+		m_Layers[layer].weight = weight;
+	}
+
+	void RemoveLayers()
+	{
+		m_Layers.clear();
+	}
+
+	void CalculateBoneTransforms()
+	{
+		EvaluatePose(*m_CurrentAnimation, m_CurrentTime, m_Cursors.data(), m_GlobalTransforms.data(),
+			m_FinalBoneMatrices.data(), (int)m_FinalBoneMatrices.size());
+	}
+
+	// samples every active clip into local poses of the skeleton, blends them and only then builds the matrices
+	void CalculateBlendedTransforms()
+	{
+		m_PoseArena.Reset();
+		const size_t nodeCount = m_Skeleton->GetNodes().size();
 
-		Bone* Bone = m_CurrentAnimation->FindBone(nodeName);
+		LocalPose pose = LocalPose::Allocate(m_PoseArena, nodeCount);
+		if (m_CurrentAnimation)
+			samplePose(*m_CurrentAnimation, m_CurrentTime, m_Cursors.data(), m_NodeMap, pose);
+		else
+			sampleBindPose(pose);
 
-		if (Bone)
+		if (m_Fading)
 		{
-			Bone->Update(m_CurrentTime);
-			nodeTransform = Bone->GetLocalTransform();
+			LocalPose from = LocalPose::Allocate(m_PoseArena, nodeCount);
+			samplePose(*m_FadeFrom.animation, m_FadeFrom.time, m_FadeFrom.cursors.data(), m_FadeFrom.nodeMap, from);
+			BlendPoses(from, pose, glm::clamp(m_FadeElapsed / m_FadeDuration, 0.0f, 1.0f));
+			pose = from;
 		}
 
-		glm::mat4 globalTransformation = parentTransform * nodeTransform;
+		if (!m_Layers.empty())
+		{
+			LocalPose layerPose = LocalPose::Allocate(m_PoseArena, nodeCount);
+			for (Track& layer : m_Layers)
+			{
+				if (layer.weight <= 0.0f)
+					continue;
+				samplePose(*layer.animation, layer.time, layer.cursors.data(), layer.nodeMap, layerPose);
+				AddPose(pose, layerPose, layer.reference, layer.weight);
+			}
+		}
 
-		auto boneInfoMap = m_CurrentAnimation->GetBoneIDMap();
-		if (boneInfoMap.find(nodeName) != boneInfoMap.end())
+		const std::vector<AnimationNode>& nodes = m_Skeleton->GetNodes();
+		for (size_t i = 0; i < nodeCount; i++)
 		{
-			int index = boneInfoMap[nodeName].id;
-			glm::mat4 offset = boneInfoMap[nodeName].offset;
-			m_FinalBoneMatrices[index] = globalTransformation * offset;
+			const AnimationNode& node = nodes[i];
+			const glm::mat4 nodeTransform = pose.GetMatrix(i);
+			m_GlobalTransforms[i] = node.parentIndex >= 0 ? m_GlobalTransforms[node.parentIndex] * nodeTransform : nodeTransform;
+			if (node.boneInfoID >= 0 && node.boneInfoID < (int)m_FinalBoneMatrices.size())
+				m_FinalBoneMatrices[node.boneInfoID] = m_GlobalTransforms[i] * node.offset;
 		}
+	}
+
+	// one pass over the flattened hierarchy; a parent's global transform is always ready before its children need it.
+	// cursors holds one entry per bone channel and globals one per node; neither the animation nor its bones are
+	// modified, so many characters can evaluate the same animation concurrently.
+	static void EvaluatePose(const Animation& animation, float time, BoneCursor* cursors, glm::mat4* globals,
+		glm::mat4* palette, int paletteSize)
+	{
+		const std::vector<AnimationNode>& nodes = animation.GetNodes();
+		for (size_t i = 0; i < nodes.size(); i++)
+		{
+			const AnimationNode& node = nodes[i];
+			glm::mat4 nodeTransform = node.transformation;
+			if (node.boneIndex >= 0)
+				nodeTransform = animation.GetBone(node.boneIndex).Evaluate(time, cursors[node.boneIndex]);
 
-		for (int i = 0; i < node->childrenCount; i++)
-			CalculateBoneTransform(&node->children[i], globalTransformation);
+			globals[i] = node.parentIndex >= 0 ? globals[node.parentIndex] * nodeTransform : nodeTransform;
+
+			if (node.boneInfoID >= 0 && node.boneInfoID < paletteSize)
+				palette[node.boneInfoID] = globals[i] * node.offset;
+		}
 	}
 
-	std::vector<glm::mat4> GetFinalBoneMatrices()
+	const std::vector<glm::mat4>& GetFinalBoneMatrices() const
 	{
 		return m_FinalBoneMatrices;
 	}
 
 private:
+	// a clip playing on the skeleton of another clip
+	struct Track
+	{
+		Animation* animation = nullptr;
+		float time = 0.0f;
+		float weight = 1.0f;
+		std::vector<BoneCursor> cursors;
+		std::vector<int> nodeMap;			// skeleton node -> node of this clip, -1 if the clip doesn't have it
+		LocalPose reference;				// additive layers only: pose at the first frame
+		std::vector<unsigned char> referenceStorage;
+	};
+
 	std::vector<glm::mat4> m_FinalBoneMatrices;
+	std::vector<glm::mat4> m_GlobalTransforms; // per node of the current animation, reused every update
+	std::vector<BoneCursor> m_Cursors;         // per bone channel of the current animation
 	Animation* m_CurrentAnimation;
 	float m_CurrentTime;
 	float m_DeltaTime;
 
+	// blending happens on the node hierarchy of the first clip the animator played
+	Animation* m_Skeleton = nullptr;
+	std::vector<glm::vec3> m_BindTranslations;	// skeleton node transforms for nodes a clip doesn't animate
+	std::vector<glm::quat> m_BindRotations;
+	std::vector<glm::vec3> m_BindScales;
+	std::vector<int> m_NodeMap;				// skeleton node -> node of the current clip
+	Track m_FadeFrom;
+	bool m_Fading = false;
+	float m_FadeElapsed = 0.0f;
+	float m_FadeDuration = 0.0f;
+	std::vector<Track> m_Layers;
+	PoseArena m_PoseArena;
+
+	void allocateState()
+	{
+		if (!m_Skeleton)
+			setSkeleton(m_CurrentAnimation);
+		m_GlobalTransforms.resize(std::max(m_CurrentAnimation->GetNodes().size(), m_Skeleton->GetNodes().size()));
+		m_Cursors.assign(m_CurrentAnimation->GetBoneCount(), BoneCursor());
+		buildNodeMap(*m_CurrentAnimation, m_NodeMap);
+	}
+
+	void setSkeleton(Animation* skeleton)
+	{
+		m_Skeleton = skeleton;
+		const std::vector<AnimationNode>& nodes = skeleton->GetNodes();
+		m_GlobalTransforms.resize(std::max(m_GlobalTransforms.size(), nodes.size()));
+		m_BindTranslations.resize(nodes.size());
+		m_BindRotations.resize(nodes.size());
+		m_BindScales.resize(nodes.size());
+		for (size_t i = 0; i < nodes.size(); i++)
+		{
+			glm::vec3 skew;
+			glm::vec4 perspective;
+			glm::decompose(nodes[i].transformation, m_BindScales[i], m_BindRotations[i], m_BindTranslations[i], skew, perspective);
+		}
+	}
+
+	void setupTrack(Track& track, Animation* animation, float weight)
+	{
+		track.animation = animation;
+		track.time = 0.0f;
+		track.weight = weight;
+		track.cursors.assign(animation->GetBoneCount(), BoneCursor());
+		buildNodeMap(*animation, track.nodeMap);
+	}
+
+	void buildNodeMap(const Animation& animation, std::vector<int>& nodeMap) const
+	{
+		const size_t nodeCount = m_Skeleton->GetNodes().size();
+		nodeMap.resize(nodeCount);
+		for (size_t i = 0; i < nodeCount; i++)
+			nodeMap[i] = &animation == m_Skeleton ? (int)i : animation.FindNode(m_Skeleton->GetNodeName((int)i));
+	}
+
+	LocalPose allocateLocalPose(std::vector<unsigned char>& storage) const
+	{
+		const size_t nodeCount = m_Skeleton->GetNodes().size();
+		storage.resize(nodeCount * (2 * sizeof(glm::vec3) + sizeof(glm::quat)));
+		LocalPose pose;
+		pose.rotations = reinterpret_cast<glm::quat*>(storage.data()); // quats first, they have the strictest alignment
+		pose.translations = reinterpret_cast<glm::vec3*>(storage.data() + nodeCount * sizeof(glm::quat));
+		pose.scales = pose.translations + nodeCount;
+		pose.count = nodeCount;
+		return pose;
+	}
+
+	// local transforms of all skeleton nodes for one clip; nodes the clip doesn't animate keep their bind transform
+	void samplePose(const Animation& animation, float time, BoneCursor* cursors, const std::vector<int>& nodeMap, LocalPose& pose) const
+	{
+		const std::vector<AnimationNode>& nodes = animation.GetNodes();
+		for (size_t i = 0; i < pose.count; i++)
+		{
+			const int node = nodeMap[i];
+			if (node >= 0 && nodes[node].boneIndex >= 0)
+			{
+				const int bone = nodes[node].boneIndex;
+				animation.GetBone(bone).Sample(time, cursors[bone], pose.translations[i], pose.rotations[i], pose.scales[i]);
+			}
+			else
+			{
+				pose.translations[i] = m_BindTranslations[i];
+				pose.rotations[i] = m_BindRotations[i];
+				pose.scales[i] = m_BindScales[i];
+			}
+		}
+	}
+
+	void sampleBindPose(LocalPose& pose) const
+	{
+		std::copy(m_BindTranslations.begin(), m_BindTranslations.end(), pose.translations);
+		std::copy(m_BindRotations.begin(), m_BindRotations.end(), pose.rotations);
+		std::copy(m_BindScales.begin(), m_BindScales.end(), pose.scales);
+	}
+
+	static void advance(const Animation& animation, float& time, float dt)
+	{
+		time += animation.GetTicksPerSecond() * dt;
+		time = fmod(time, animation.GetDuration());
+	}
 };
@@ -3,6 +3,8 @@
 /* Container for bone data */
 
 #include <vector>
+#include <algorithm>
+#include <cmath>
 #include <assimp/scene.h>
 #include <list>
 #include <glm/glm.hpp>
@@ -28,6 +30,15 @@ struct KeyScale
 	float timeStamp;
 };
 
+// segment found by the last key lookup of each channel. A Bone keeps one for Update(); callers that
+// evaluate the same Bone from several threads or characters pass their own to Evaluate().
+struct BoneCursor
+{
+	int position = 0;
+	int rotation = 0;
+	int scale = 0;
+};
+
 class Bone
 {
 public:
@@ -74,104 +85,170 @@ public:
 	
 	void Update(float animationTime)
 	{
-		glm::mat4 translation = InterpolatePosition(animationTime);
-		glm::mat4 rotation = InterpolateRotation(animationTime);
-		glm::mat4 scale = InterpolateScaling(animationTime);
-		m_LocalTransform = translation * rotation * scale;
+		m_LocalTransform = Evaluate(animationTime, m_Cursor);
+	}
+
+	// local transform at animationTime without touching the bone itself; safe to call concurrently with distinct cursors
+	glm::mat4 Evaluate(float animationTime, BoneCursor& cursor) const
+	{
+		glm::mat4 translation = glm::translate(glm::mat4(1.0f), SamplePosition(animationTime, cursor));
+		glm::mat4 rotation = glm::toMat4(SampleRotation(animationTime, cursor));
+		glm::mat4 scale = glm::scale(glm::mat4(1.0f), SampleScale(animationTime, cursor));
+		return translation * rotation * scale;
+	}
+
+	// local translation, rotation and scale at animationTime, for blending before building matrices
+	void Sample(float animationTime, BoneCursor& cursor, glm::vec3& translation, glm::quat& rotation, glm::vec3& scale) const
+	{
+		translation = SamplePosition(animationTime, cursor);
+		rotation = SampleRotation(animationTime, cursor);
+		scale = SampleScale(animationTime, cursor);
 	}
+
 	glm::mat4 GetLocalTransform() { return m_LocalTransform; }
 	std::string GetBoneName() const { return m_Name; }
 	int GetBoneID() { return m_ID; }
 	
 
 
+	// index of the key that starts the segment containing animationTime. Times outside the keys
+	// clamp to the first/last segment. Uniformly resampled channels compute it directly; otherwise
+	// the channel's cursor is advanced from the previous lookup, falling back to a binary search
+	// for seeks and loop wrap-arounds.
 	int GetPositionIndex(float animationTime)
 	{
-		for (int index = 0; index < m_NumPositions - 1; ++index)
-		{
-			if (animationTime < m_Positions[index + 1].timeStamp)
-				return index;
-		}
-		assert(0);
+		return FindKeyIndex(m_Positions, m_Cursor.position, animationTime);
 	}
 
 	int GetRotationIndex(float animationTime)
 	{
-		for (int index = 0; index < m_NumRotations - 1; ++index)
-		{
-			if (animationTime < m_Rotations[index + 1].timeStamp)
-				return index;
-		}
-		assert(0);
+		return FindKeyIndex(m_Rotations, m_Cursor.rotation, animationTime);
 	}
 
 	int GetScaleIndex(float animationTime)
 	{
-		for (int index = 0; index < m_NumScalings - 1; ++index)
+		return FindKeyIndex(m_Scales, m_Cursor.scale, animationTime);
+	}
+
+	// replaces the keys by samples taken every 'interval' ticks over [0, duration] so that key
+	// lookups no longer have to search; channels with a single key are left alone
+	void Resample(float interval, float duration)
+	{
+		if (interval <= 0.0f || duration <= 0.0f)
+			return;
+		const int count = (int)std::ceil(duration / interval) + 1;
+		std::vector<KeyPosition> positions;
+		std::vector<KeyRotation> rotations;
+		std::vector<KeyScale> scales;
+		for (int i = 0; i < count; i++)
+		{
+			const float time = std::min(i * interval, duration);
+			if (m_NumPositions > 1)
+				positions.push_back({ SamplePosition(time, m_Cursor), i * interval });
+			if (m_NumRotations > 1)
+				rotations.push_back({ SampleRotation(time, m_Cursor), i * interval });
+			if (m_NumScalings > 1)
+				scales.push_back({ SampleScale(time, m_Cursor), i * interval });
+		}
+		if (m_NumPositions > 1)
+		{
+			m_Positions.swap(positions);
+			m_NumPositions = count;
+		}
+		if (m_NumRotations > 1)
+		{
+			m_Rotations.swap(rotations);
+			m_NumRotations = count;
+		}
+		if (m_NumScalings > 1)
 		{
-			if (animationTime < m_Scales[index + 1].timeStamp)
-				return index;
+			m_Scales.swap(scales);
+			m_NumScalings = count;
 		}
-		assert(0);
+		m_SampleInterval = interval;
+		m_Cursor = BoneCursor();
 	}
 
+	bool IsResampled() const { return m_SampleInterval > 0.0f; }
+
 
 private:
 
-	float GetScaleFactor(float lastTimeStamp, float nextTimeStamp, float animationTime)
+	template<typename Key>
+	int FindKeyIndex(const std::vector<Key>& keys, int& cursor, float animationTime) const
+	{
+		const int lastSegment = (int)keys.size() - 2;
+		if (lastSegment <= 0)
+			return 0;
+		if (m_SampleInterval > 0.0f)
+		{
+			const int index = (int)((animationTime - keys[0].timeStamp) / m_SampleInterval);
+			return std::max(0, std::min(index, lastSegment));
+		}
+		// forward playback usually stays in the same segment or moves on by one or two keys
+		if (animationTime >= keys[cursor].timeStamp)
+		{
+			for (int step = 0; step < 4; step++)
+			{
+				if (cursor >= lastSegment || animationTime < keys[cursor + 1].timeStamp)
+					return cursor;
+				cursor++;
+			}
+		}
+		// random seek: first key after animationTime, the segment starts one before it
+		auto next = std::upper_bound(keys.begin() + 1, keys.end() - 1, animationTime,
+			[](float time, const Key& key) { return time < key.timeStamp; });
+		cursor = (int)(next - keys.begin()) - 1;
+		return cursor;
+	}
+
+	float GetScaleFactor(float lastTimeStamp, float nextTimeStamp, float animationTime) const
 	{
 		float scaleFactor = 0.0f;
 		float midWayLength = animationTime - lastTimeStamp;
 		float framesDiff = nextTimeStamp - lastTimeStamp;
+		if (framesDiff <= 0.0f)
+			return 0.0f;
 		scaleFactor = midWayLength / framesDiff;
-		return scaleFactor;
+		return glm::clamp(scaleFactor, 0.0f, 1.0f);
 	}
 
-	glm::mat4 InterpolatePosition(float animationTime)
+	glm::vec3 SamplePosition(float animationTime, BoneCursor& cursor) const
 	{
 		if (1 == m_NumPositions)
-			return glm::translate(glm::mat4(1.0f), m_Positions[0].position);
+			return m_Positions[0].position;
 
-		int p0Index = GetPositionIndex(animationTime);
+		int p0Index = FindKeyIndex(m_Positions, cursor.position, animationTime);
 		int p1Index = p0Index + 1;
 		float scaleFactor = GetScaleFactor(m_Positions[p0Index].timeStamp,
 			m_Positions[p1Index].timeStamp, animationTime);
-		glm::vec3 finalPosition = glm::mix(m_Positions[p0Index].position, m_Positions[p1Index].position
-			, scaleFactor);
-		return glm::translate(glm::mat4(1.0f), finalPosition);
+		return glm::mix(m_Positions[p0Index].position, m_Positions[p1Index].position, scaleFactor);
 	}
 
-	glm::mat4 InterpolateRotation(float animationTime)
+	glm::quat SampleRotation(float animationTime, BoneCursor& cursor) const
 	{
 		if (1 == m_NumRotations)
-		{
-			auto rotation = glm::normalize(m_Rotations[0].orientation);
-			return glm::toMat4(rotation);
-		}
+			return glm::normalize(m_Rotations[0].orientation);
 
-		int p0Index = GetRotationIndex(animationTime);
+		int p0Index = FindKeyIndex(m_Rotations, cursor.rotation, animationTime);
 		int p1Index = p0Index + 1;
 		float scaleFactor = GetScaleFactor(m_Rotations[p0Index].timeStamp,
 			m_Rotations[p1Index].timeStamp, animationTime);
 		glm::quat finalRotation = glm::slerp(m_Rotations[p0Index].orientation, m_Rotations[p1Index].orientation
 			, scaleFactor);
-		finalRotation = glm::normalize(finalRotation);
-		return glm::toMat4(finalRotation);
-
+		return glm::normalize(finalRotation);
 	}
 
-	glm::mat4 InterpolateScaling(float animationTime)
+	glm::vec3 SampleScale(float animationTime, BoneCursor& cursor) const
 	{
 		if (1 == m_NumScalings)
-			return glm::scale(glm::mat4(1.0f), m_Scales[0].scale);
+			return m_Scales[0].scale;
 
-		int p0Index = GetScaleIndex(animationTime);
+		int p0Index = FindKeyIndex(m_Scales, cursor.scale, animationTime);
 		int p1Index = p0Index + 1;
 		float scaleFactor = GetScaleFactor(m_Scales[p0Index].timeStamp,
 			m_Scales[p1Index].timeStamp, animationTime);
-		glm::vec3 finalScale = glm::mix(m_Scales[p0Index].scale, m_Scales[p1Index].scale
-			, scaleFactor);
-		return glm::scale(glm::mat4(1.0f), finalScale);
+		return glm::mix(m_Scales[p0Index].scale, m_Scales[p1Index].scale, scaleFactor);
 	}
 
 	std::vector<KeyPosition> m_Positions;
@@ -180,6 +257,9 @@ private:
 	int m_NumPositions;
 	int m_NumRotations;
 	int m_NumScalings;
+	BoneCursor m_Cursor;
+	// tick distance between keys after Resample, 0 while the original keys are used
+	float m_SampleInterval = 0.0f;
 
 	glm::mat4 m_LocalTransform;
 	std::string m_Name;
@@ -0,0 +1,542 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/frustum_culler.h>
+#include <learnopengl/job_system.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+// Bounding volume hierarchy over a set of axis aligned boxes (e.g. the world bounds of scene nodes).
+// It is built top down with the surface area heuristic, and when boxes move it is refitted instead of
+// rebuilt: the tree shape stays, only the node bounds grow or shrink. That keeps it cheap for mostly
+// static scenes; rebuild when many boxes have moved far. The same tree answers frustum, ray and box queries,
+// each rejecting whole subtrees at once.
+class BoundingVolumeHierarchy
+{
+public:
+    // (re)builds the tree over all boxes; item i of every query result refers to box i
+    void Build(const CullingBoxes& boxes)
+    {
+        const size_t count = boxes.Size();
+        m_Nodes.clear();
+        m_Items.resize(count);
+        m_ItemCenter.resize(count);
+        m_ItemExtent.resize(count);
+        m_LeafOfItem.assign(count, -1);
+        m_Parents.clear();
+        m_Depths.clear();
+        for (size_t i = 0; i < count; i++)
+        {
+            m_Items[i] = static_cast<unsigned int>(i);
+            m_ItemCenter[i] = glm::vec3(boxes.CenterX[i], boxes.CenterY[i], boxes.CenterZ[i]);
+            m_ItemExtent[i] = glm::vec3(boxes.ExtentX[i], boxes.ExtentY[i], boxes.ExtentZ[i]);
+        }
+        m_LevelStart.assign(1, 0);
+        m_LevelOrder.clear();
+        if (count == 0)
+            return;
+
+        m_Nodes.reserve(2 * count / MAX_LEAF_ITEMS + 1);
+        m_Nodes.emplace_back();
+        m_Parents.push_back(-1);
+        m_Depths.push_back(0);
+        build(0, 0, static_cast<unsigned int>(count), 0);
+
+        // counting sort of the nodes by depth for the parallel refit
+        const int maxDepth = *std::max_element(m_Depths.begin(), m_Depths.end());
+        m_LevelStart.assign(maxDepth + 2, 0);
+        for (int depth : m_Depths)
+            m_LevelStart[depth + 1]++;
+        for (size_t level = 1; level < m_LevelStart.size(); level++)
+            m_LevelStart[level] += m_LevelStart[level - 1];
+        std::vector<size_t> next(m_LevelStart.begin(), m_LevelStart.end() - 1);
+        m_LevelOrder.resize(m_Nodes.size());
+        for (size_t n = 0; n < m_Nodes.size(); n++)
+            m_LevelOrder[next[m_Depths[n]]++] = static_cast<unsigned int>(n);
+    }
+
+    // updates the bounds after all boxes may have moved. With a job system the nodes of each tree level are refitted
+    // in parallel, deepest level first
+    void Refit(const CullingBoxes& boxes, JobSystem* jobs = nullptr)
+    {
+        if (!jobs)
+        {
+            for (size_t i = 0; i < m_ItemCenter.size(); i++)
+                loadItem(boxes, i);
+            // children are always stored after their parent, so walking backwards visits them first
+            for (size_t n = m_Nodes.size(); n-- > 0;)
+                fitNode(static_cast<int>(n));
+            return;
+        }
+
+        jobs->ParallelFor(m_ItemCenter.size(), PARALLEL_GRAIN, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+                loadItem(boxes, i);
+        });
+        for (size_t level = m_LevelStart.size() - 1; level-- > 0;)
+        {
+            const unsigned int* nodes = &m_LevelOrder[m_LevelStart[level]];
+            jobs->ParallelFor(m_LevelStart[level + 1] - m_LevelStart[level], PARALLEL_GRAIN, [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; i++)
+                    fitNode(static_cast<int>(nodes[i]));
+            });
+        }
+    }
+
+    // updates the bounds after only the listed boxes moved; falls back to a full refit when that's most of them
+    void Refit(const CullingBoxes& boxes, const std::vector<unsigned int>& changed, JobSystem* jobs = nullptr)
+    {
+        if (changed.size() * 4 > m_ItemCenter.size())
+        {
+            Refit(boxes, jobs);
+            return;
+        }
+        for (unsigned int item : changed)
+        {
+            loadItem(boxes, item);
+            // grow or shrink the ancestors until one of them doesn't change any more
+            for (int node = m_LeafOfItem[item]; node >= 0 && fitNode(node); node = m_Parents[node])
+                ;
+        }
+    }
+
+    // appends the boxes that are at least partly inside all six planes; same plane convention as FrustumCuller
+    void Cull(const glm::vec4 planes[6], std::vector<unsigned int>& visible) const
+    {
+        if (m_Nodes.empty())
+            return;
+        glm::vec4 absPlanes[6];
+        getAbsPlanes(planes, absPlanes);
+        cullSubtree(planes, absPlanes, { 0, ALL_PLANES }, visible);
+    }
+
+    // same as above, but the top of the tree is split into subtrees that are culled as parallel jobs. Each subtree
+    // fills its own list and the lists are appended in tree order, so the result depends neither on scheduling nor
+    // on the number of threads
+    void Cull(const glm::vec4 planes[6], std::vector<unsigned int>& visible, JobSystem& jobs) const
+    {
+        if (m_Nodes.empty())
+            return;
+        glm::vec4 absPlanes[6];
+        getAbsPlanes(planes, absPlanes);
+
+        // expand the tree breadth first, dropping what is outside, until there are enough subtrees to keep every thread busy
+        std::vector<CullEntry> frontier(1, CullEntry{ 0, ALL_PLANES }), next;
+        bool expanded = true;
+        while (expanded && frontier.size() < PARALLEL_SUBTREES)
+        {
+            expanded = false;
+            next.clear();
+            for (const CullEntry& entry : frontier)
+            {
+                const Node& node = m_Nodes[entry.node];
+                if (node.count > 0)
+                {
+                    next.push_back(entry);
+                    continue;
+                }
+                unsigned int planeMask = entry.planeMask;
+                if (!testNode(planes, absPlanes, node, planeMask))
+                    continue;
+                next.push_back({ node.leftOrFirst, planeMask });
+                next.push_back({ node.leftOrFirst + 1, planeMask });
+                expanded = true;
+            }
+            frontier.swap(next);
+        }
+
+        std::vector<std::vector<unsigned int>> lists(frontier.size());
+        jobs.ParallelFor(frontier.size(), 1, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+                cullSubtree(planes, absPlanes, frontier[i], lists[i]);
+        });
+        for (const std::vector<unsigned int>& list : lists)
+            visible.insert(visible.end(), list.begin(), list.end());
+    }
+
+    // nearest box hit by the ray within maxDistance, or -1; direction doesn't need to be normalized, distances are in its units
+    int RayCast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, float* hitDistance = nullptr) const
+    {
+        int nearest = -1;
+        if (m_Nodes.empty())
+            return nearest;
+        const glm::vec3 invDirection = 1.0f / direction;
+        float nearestDistance = maxDistance;
+
+        unsigned int stack[STACK_SIZE];
+        int stackSize = 0;
+        stack[stackSize++] = 0;
+        while (stackSize > 0)
+        {
+            const Node& node = m_Nodes[stack[--stackSize]];
+            float entry;
+            if (!intersectRay(origin, invDirection, node.min, node.max, nearestDistance, entry))
+                continue;
+            if (node.count == 0)
+            {
+                // visit the nearer child first so the farther one is more likely to be rejected by the shrinking distance
+                const Node& left = m_Nodes[node.leftOrFirst];
+                const Node& right = m_Nodes[node.leftOrFirst + 1];
+                float leftEntry, rightEntry;
+                const bool hitLeft = intersectRay(origin, invDirection, left.min, left.max, nearestDistance, leftEntry);
+                const bool hitRight = intersectRay(origin, invDirection, right.min, right.max, nearestDistance, rightEntry);
+                if (hitLeft && hitRight)
+                {
+                    const bool leftFirst = leftEntry <= rightEntry;
+                    stack[stackSize++] = leftFirst ? node.leftOrFirst + 1 : node.leftOrFirst;
+                    stack[stackSize++] = leftFirst ? node.leftOrFirst : node.leftOrFirst + 1;
+                }
+                else if (hitLeft)
+                    stack[stackSize++] = node.leftOrFirst;
+                else if (hitRight)
+                    stack[stackSize++] = node.leftOrFirst + 1;
+                continue;
+            }
+            for (unsigned int i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++)
+            {
+                const unsigned int item = m_Items[i];
+                float distance;
+                if (intersectRay(origin, invDirection, m_ItemCenter[item] - m_ItemExtent[item], m_ItemCenter[item] + m_ItemExtent[item], nearestDistance, distance)
+                    && (nearest < 0 || distance < nearestDistance))
+                {
+                    nearest = static_cast<int>(item);
+                    nearestDistance = distance;
+                }
+            }
+        }
+        if (nearest >= 0 && hitDistance)
+            *hitDistance = nearestDistance;
+        return nearest;
+    }
+
+    // appends every box hit by the ray within maxDistance, in no particular order
+    void QueryRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, std::vector<unsigned int>& items) const
+    {
+        const glm::vec3 invDirection = 1.0f / direction;
+        query(items, [&](const glm::vec3& min, const glm::vec3& max)
+        {
+            float entry;
+            return intersectRay(origin, invDirection, min, max, maxDistance, entry);
+        });
+    }
+
+    // appends every box overlapping [min, max]
+    void QueryBox(const glm::vec3& min, const glm::vec3& max, std::vector<unsigned int>& items) const
+    {
+        query(items, [&](const glm::vec3& nodeMin, const glm::vec3& nodeMax)
+        {
+            return glm::all(glm::lessThanEqual(nodeMin, max)) && glm::all(glm::lessThanEqual(min, nodeMax));
+        });
+    }
+
+    size_t GetItemCount() const { return m_ItemCenter.size(); }
+    size_t GetNodeCount() const { return m_Nodes.size(); }
+
+private:
+    static const unsigned int MAX_LEAF_ITEMS = 4;
+    static const int BIN_COUNT = 16;
+    static const unsigned int ALL_PLANES = 0x3F;
+    // below this depth nodes are split at the median, which bounds the depth to MAX_SAH_DEPTH + log2(item count).
+    // depth first traversal keeps at most one pending sibling per level, so the traversal stacks can't overflow
+    static const int MAX_SAH_DEPTH = 64;
+    static const int STACK_SIZE = 128;
+    // fixed, so the parallel result is the same whatever the thread count; enough to balance a few dozen threads
+    static const size_t PARALLEL_SUBTREES = 64;
+    static const size_t PARALLEL_GRAIN = 1024;
+
+    // leaves have count > 0 and own m_Items[leftOrFirst, leftOrFirst + count); inner nodes have their children at leftOrFirst and leftOrFirst + 1
+    struct Node
+    {
+        glm::vec3 min = glm::vec3(FLT_MAX);
+        unsigned int leftOrFirst = 0;
+        glm::vec3 max = glm::vec3(-FLT_MAX);
+        unsigned int count = 0;
+    };
+
+    struct Bin
+    {
+        glm::vec3 min = glm::vec3(FLT_MAX);
+        glm::vec3 max = glm::vec3(-FLT_MAX);
+        unsigned int count = 0;
+    };
+
+    std::vector<Node> m_Nodes;
+    std::vector<int> m_Parents;
+    std::vector<int> m_Depths;
+    std::vector<unsigned int> m_LevelOrder;    // node indices sorted by depth
+    std::vector<size_t> m_LevelStart;          // where each depth starts in m_LevelOrder
+    std::vector<unsigned int> m_Items;     // box indices, grouped by leaf
+    std::vector<int> m_LeafOfItem;
+    std::vector<glm::vec3> m_ItemCenter;   // per box index
+    std::vector<glm::vec3> m_ItemExtent;
+
+    // a node still to be culled, with the planes it may still straddle; planes an ancestor was fully inside of are left out
+    struct CullEntry
+    {
+        unsigned int node;
+        unsigned int planeMask;
+    };
+
+    static void getAbsPlanes(const glm::vec4 planes[6], glm::vec4 absPlanes[6])
+    {
+        for (int p = 0; p < 6; p++)
+            absPlanes[p] = glm::vec4(glm::abs(glm::vec3(planes[p])), 0.0f);
+    }
+
+    // false if the node is outside one of the planes; clears the planes from planeMask the node is fully inside of
+    static bool testNode(const glm::vec4 planes[6], const glm::vec4 absPlanes[6], const Node& node, unsigned int& planeMask)
+    {
+        const glm::vec3 center = (node.min + node.max) * 0.5f;
+        const glm::vec3 extent = (node.max - node.min) * 0.5f;
+        for (int p = 0; p < 6; p++)
+        {
+            if (!(planeMask & (1u << p)))
+                continue;
+            const float distance = glm::dot(glm::vec3(planes[p]), center) - planes[p].w;
+            const float radius = glm::dot(glm::vec3(absPlanes[p]), extent);
+            if (distance < -radius)
+                return false;
+            if (distance >= radius)
+                planeMask &= ~(1u << p);
+        }
+        return true;
+    }
+
+    void cullSubtree(const glm::vec4 planes[6], const glm::vec4 absPlanes[6], CullEntry root, std::vector<unsigned int>& visible) const
+    {
+        CullEntry stack[STACK_SIZE];
+        int stackSize = 0;
+        stack[stackSize++] = root;
+        while (stackSize > 0)
+        {
+            const CullEntry entry = stack[--stackSize];
+            const Node& node = m_Nodes[entry.node];
+            unsigned int planeMask = entry.planeMask;
+            if (!testNode(planes, absPlanes, node, planeMask))
+                continue;
+
+            if (node.count == 0)
+            {
+                stack[stackSize++] = { node.leftOrFirst, planeMask };
+                stack[stackSize++] = { node.leftOrFirst + 1, planeMask };
+                continue;
+            }
+            for (unsigned int i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++)
+            {
+                const unsigned int item = m_Items[i];
+                if (planeMask == 0 || isItemInside(planes, absPlanes, planeMask, item))
+                    visible.push_back(item);
+            }
+        }
+    }
+
+    static float surfaceArea(const glm::vec3& min, const glm::vec3& max)
+    {
+        const glm::vec3 size = glm::max(max - min, glm::vec3(0.0f));
+        return size.x * size.y + size.y * size.z + size.z * size.x;
+    }
+
+    void loadItem(const CullingBoxes& boxes, size_t i)
+    {
+        m_ItemCenter[i] = glm::vec3(boxes.CenterX[i], boxes.CenterY[i], boxes.CenterZ[i]);
+        m_ItemExtent[i] = glm::vec3(boxes.ExtentX[i], boxes.ExtentY[i], boxes.ExtentZ[i]);
+    }
+
+    // recomputes the bounds of a node from its items or children; returns whether they changed
+    bool fitNode(int index)
+    {
+        Node& node = m_Nodes[index];
+        glm::vec3 min(FLT_MAX), max(-FLT_MAX);
+        if (node.count > 0)
+        {
+            for (unsigned int i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++)
+            {
+                const unsigned int item = m_Items[i];
+                min = glm::min(min, m_ItemCenter[item] - m_ItemExtent[item]);
+                max = glm::max(max, m_ItemCenter[item] + m_ItemExtent[item]);
+            }
+        }
+        else
+        {
+            const Node& left = m_Nodes[node.leftOrFirst];
+            const Node& right = m_Nodes[node.leftOrFirst + 1];
+            min = glm::min(left.min, right.min);
+            max = glm::max(left.max, right.max);
+        }
+        const bool changed = min != node.min || max != node.max;
+        node.min = min;
+        node.max = max;
+        return changed;
+    }
+
+    void makeLeaf(int index, unsigned int first, unsigned int count)
+    {
+        m_Nodes[index].leftOrFirst = first;
+        m_Nodes[index].count = count;
+        for (unsigned int i = first; i < first + count; i++)
+            m_LeafOfItem[m_Items[i]] = index;
+    }
+
+    void build(int index, unsigned int first, unsigned int count, int depth)
+    {
+        glm::vec3 min(FLT_MAX), max(-FLT_MAX), centroidMin(FLT_MAX), centroidMax(-FLT_MAX);
+        for (unsigned int i = first; i < first + count; i++)
+        {
+            const unsigned int item = m_Items[i];
+            min = glm::min(min, m_ItemCenter[item] - m_ItemExtent[item]);
+            max = glm::max(max, m_ItemCenter[item] + m_ItemExtent[item]);
+            centroidMin = glm::min(centroidMin, m_ItemCenter[item]);
+            centroidMax = glm::max(centroidMax, m_ItemCenter[item]);
+        }
+        m_Nodes[index].min = min;
+        m_Nodes[index].max = max;
+        if (count <= MAX_LEAF_ITEMS)
+        {
+            makeLeaf(index, first, count);
+            return;
+        }
+
+        // binned SAH: cost of a split is (area left * items left + area right * items right) / area of the node
+        int bestAxis = -1, bestSplit = 0;
+        float bestCost = FLT_MAX;
+        for (int axis = 0; axis < 3 && depth < MAX_SAH_DEPTH; axis++)
+        {
+            const float extent = centroidMax[axis] - centroidMin[axis];
+            if (extent <= 0.0f)
+                continue;
+            const float scale = BIN_COUNT / extent;
+            Bin bins[BIN_COUNT];
+            for (unsigned int i = first; i < first + count; i++)
+            {
+                const unsigned int item = m_Items[i];
+                Bin& bin = bins[std::min(BIN_COUNT - 1, static_cast<int>((m_ItemCenter[item][axis] - centroidMin[axis]) * scale))];
+                bin.min = glm::min(bin.min, m_ItemCenter[item] - m_ItemExtent[item]);
+                bin.max = glm::max(bin.max, m_ItemCenter[item] + m_ItemExtent[item]);
+                bin.count++;
+            }
+            float rightCost[BIN_COUNT];
+            Bin right;
+            for (int b = BIN_COUNT - 1; b > 0; b--)
+            {
+                right.min = glm::min(right.min, bins[b].min);
+                right.max = glm::max(right.max, bins[b].max);
+                right.count += bins[b].count;
+                rightCost[b] = right.count ? surfaceArea(right.min, right.max) * right.count : 0.0f;
+            }
+            Bin left;
+            for (int b = 0; b < BIN_COUNT - 1; b++)
+            {
+                left.min = glm::min(left.min, bins[b].min);
+                left.max = glm::max(left.max, bins[b].max);
+                left.count += bins[b].count;
+                const float cost = (left.count ? surfaceArea(left.min, left.max) * left.count : 0.0f) + rightCost[b + 1];
+                if (left.count > 0 && left.count < count && cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = b + 1;
+                }
+            }
+        }
+
+        unsigned int middle;
+        if (bestAxis < 0)
+        {
+            // all centroids in one spot or the tree is getting too deep: split at the median of the widest axis, which halves the depth left
+            const glm::vec3 extent = centroidMax - centroidMin;
+            const int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+            middle = first + count / 2;
+            std::nth_element(m_Items.data() + first, m_Items.data() + middle, m_Items.data() + first + count, [&](unsigned int a, unsigned int b)
+            {
+                return m_ItemCenter[a][axis] < m_ItemCenter[b][axis];
+            });
+        }
+        else
+        {
+            const float scale = BIN_COUNT / (centroidMax[bestAxis] - centroidMin[bestAxis]);
+            unsigned int* split = std::partition(m_Items.data() + first, m_Items.data() + first + count, [&](unsigned int item)
+            {
+                return std::min(BIN_COUNT - 1, static_cast<int>((m_ItemCenter[item][bestAxis] - centroidMin[bestAxis]) * scale)) < bestSplit;
+            });
+            middle = static_cast<unsigned int>(split - m_Items.data());
+        }
+
+        const int left = static_cast<int>(m_Nodes.size());
+        m_Nodes.emplace_back();
+        m_Nodes.emplace_back();
+        m_Parents.push_back(index);
+        m_Parents.push_back(index);
+        m_Depths.push_back(depth + 1);
+        m_Depths.push_back(depth + 1);
+        m_Nodes[index].leftOrFirst = left;
+        m_Nodes[index].count = 0;
+        build(left, first, middle - first, depth + 1);
+        build(left + 1, middle, first + count - middle, depth + 1);
+    }
+
+    bool isItemInside(const glm::vec4 planes[6], const glm::vec4 absPlanes[6], unsigned int planeMask, unsigned int item) const
+    {
+        const glm::vec3& center = m_ItemCenter[item];
+        const glm::vec3& extent = m_ItemExtent[item];
+        for (int p = 0; p < 6; p++)
+        {
+            if (!(planeMask & (1u << p)))
+                continue;
+            // written exactly like FrustumCuller so both agree on boxes touching a plane
+            const float distance = planes[p].x * center.x + planes[p].y * center.y + planes[p].z * center.z - planes[p].w;
+            const float radius = absPlanes[p].x * extent.x + absPlanes[p].y * extent.y + absPlanes[p].z * extent.z;
+            if (!(distance >= -radius))
+                return false;
+        }
+        return true;
+    }
+
+    // slab test; entry is where the ray enters the box, clamped to 0 when it starts inside
+    static bool intersectRay(const glm::vec3& origin, const glm::vec3& invDirection, const glm::vec3& min, const glm::vec3& max, float maxDistance, float& entry)
+    {
+        const glm::vec3 t0 = (min - origin) * invDirection;
+        const glm::vec3 t1 = (max - origin) * invDirection;
+        const glm::vec3 tNear = glm::min(t0, t1);
+        const glm::vec3 tFar = glm::max(t0, t1);
+        entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+        const float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+        return entry <= exit;
+    }
+
+    template<typename Overlaps>
+    void query(std::vector<unsigned int>& items, Overlaps overlaps) const
+    {
+        if (m_Nodes.empty())
+            return;
+        unsigned int stack[STACK_SIZE];
+        int stackSize = 0;
+        stack[stackSize++] = 0;
+        while (stackSize > 0)
+        {
+            const Node& node = m_Nodes[stack[--stackSize]];
+            if (!overlaps(node.min, node.max))
+                continue;
+            if (node.count == 0)
+            {
+                stack[stackSize++] = node.leftOrFirst;
+                stack[stackSize++] = node.leftOrFirst + 1;
+                continue;
+            }
+            for (unsigned int i = node.leftOrFirst; i < node.leftOrFirst + node.count; i++)
+            {
+                const unsigned int item = m_Items[i];
+                if (overlaps(m_ItemCenter[item] - m_ItemExtent[item], m_ItemCenter[item] + m_ItemExtent[item]))
+                    items.push_back(item);
+            }
+        }
+    }
+};
+#endif
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cmath>
+#include <vector>
+#include <learnopengl/animation.h>
+#include <learnopengl/animator.h>
+#include <learnopengl/bone.h>
+#include <learnopengl/job_system.h>
+
+// Animates many characters at once. Every character plays one Animation with its own clock and
+// key cursors; Update evaluates all of them in parallel on a JobSystem and writes the skinning
+// matrices into one contiguous palette buffer, MAX_BONES matrices per character. All per
+// character memory is allocated when the character is added, so an update doesn't allocate.
+class CrowdAnimator
+{
+public:
+	CrowdAnimator(JobSystem& jobs = JobSystem::Shared())
+		: m_Jobs(jobs)
+	{
+	}
+
+	// adds a character playing the given animation from startTime (in ticks); returns its index
+	int AddCharacter(Animation* animation, float startTime = 0.0f, float speed = 1.0f)
+	{
+		Character character;
+		character.animation = animation;
+		character.time = startTime;
+		character.speed = speed;
+		character.firstCursor = m_Cursors.size();
+		character.firstGlobal = m_Globals.size();
+		m_Cursors.resize(m_Cursors.size() + animation->GetBoneCount());
+		m_Globals.resize(m_Globals.size() + animation->GetNodes().size());
+		m_Palette.resize(m_Palette.size() + MAX_BONES, glm::mat4(1.0f));
+		m_Characters.push_back(character);
+		return (int)m_Characters.size() - 1;
+	}
+
+	// advances every character by dt seconds and recomputes its bone matrices
+	void Update(float dt)
+	{
+		m_Jobs.ParallelFor(m_Characters.size(), CHARACTERS_PER_JOB, [this, dt](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+				updateCharacter(i, dt);
+		});
+	}
+
+	int GetCharacterCount() const { return (int)m_Characters.size(); }
+
+	// MAX_BONES skinning matrices of one character, ready for glUniformMatrix4fv
+	const glm::mat4* GetFinalBoneMatrices(int character) const
+	{
+		return &m_Palette[character * MAX_BONES];
+	}
+
+	// the whole palette (all characters back to back), e.g. for uploading into a buffer object at once
+	const std::vector<glm::mat4>& GetPalette() const { return m_Palette; }
+
+private:
+	static const size_t CHARACTERS_PER_JOB = 8;
+
+	struct Character
+	{
+		Animation* animation;
+		float time;
+		float speed;
+		size_t firstCursor;
+		size_t firstGlobal;
+	};
+
+	JobSystem& m_Jobs;
+	std::vector<Character> m_Characters;
+	std::vector<BoneCursor> m_Cursors;	// per character, one per bone channel
+	std::vector<glm::mat4> m_Globals;	// per character, one per hierarchy node
+	std::vector<glm::mat4> m_Palette;
+
+	void updateCharacter(size_t index, float dt)
+	{
+		Character& character = m_Characters[index];
+		const Animation& animation = *character.animation;
+		character.time += animation.GetTicksPerSecond() * dt * character.speed;
+		character.time = fmod(character.time, animation.GetDuration());
+		if (character.time < 0.0f)
+			character.time += animation.GetDuration();
+		Animator::EvaluatePose(animation, character.time, &m_Cursors[character.firstCursor], &m_Globals[character.firstGlobal],
+			&m_Palette[index * MAX_BONES], MAX_BONES);
+	}
+};
@@ -2,9 +2,27 @@
 #define ENTITY_H
 
 #include <glm/glm.hpp> //glm::mat4
-#include <list> //std::list
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/euler_angles.hpp> //glm::eulerAngleYXZ
+#include <learnopengl/bvh.h> //BoundingVolumeHierarchy
+#include <learnopengl/frustum_culler.h> //CullingBoxes
+#include <learnopengl/job_system.h> //JobSystem
+#include <learnopengl/render_queue.h> //RenderQueue
+#include <algorithm> //std::fill
 #include <array> //std::array
-#include <memory> //std::unique_ptr
+#include <map> //std::map
+#include <vector> //std::vector
+
+//Translation * rotation (Y * X * Z, in degrees) * scale. The rotation is built in closed form instead of multiplying three rotation matrices
+inline glm::mat4 composeTRS(const glm::vec3& position, const glm::vec3& eulerRot, const glm::vec3& scale)
+{
+	glm::mat4 transform = glm::eulerAngleYXZ(glm::radians(eulerRot.y), glm::radians(eulerRot.x), glm::radians(eulerRot.z));
+	transform[0] *= scale.x;
+	transform[1] *= scale.y;
+	transform[2] *= scale.z;
+	transform[3] = glm::vec4(position, 1.0f);
+	return transform;
+}
 
 class Transform
 {
@@ -23,15 +41,8 @@ protected:
 protected:
 	glm::mat4 getLocalModelMatrix()
 	{
-		const glm::mat4 transformX = glm::rotate(glm::mat4(1.0f), glm::radians(m_eulerRot.x), glm::vec3(1.0f, 0.0f, 0.0f));
-		const glm::mat4 transformY = glm::rotate(glm::mat4(1.0f), glm::radians(m_eulerRot.y), glm::vec3(0.0f, 1.0f, 0.0f));
-		const glm::mat4 transformZ = glm::rotate(glm::mat4(1.0f), glm::radians(m_eulerRot.z), glm::vec3(0.0f, 0.0f, 1.0f));
-
-		// Y * X * Z
-		const glm::mat4 rotationMatrix = transformY * transformX * transformZ;
-
 		// translation * rotation * scale (also know as TRS matrix)
-		return glm::translate(glm::mat4(1.0f), m_pos) * rotationMatrix * glm::scale(glm::mat4(1.0f), m_scale);
+		return composeTRS(m_pos, m_eulerRot, m_scale);
 	}
 public:
 
@@ -269,6 +280,8 @@ struct AABB : public BoundingVolume
 		: BoundingVolume{}, center{ inCenter }, extents{ iI, iJ, iK }
 	{}
 
+	using BoundingVolume::isOnFrustum;
+
 	std::array<glm::vec3, 8> getVertice() const
 	{
 		std::array<glm::vec3, 8> vertice;
@@ -295,27 +308,7 @@ struct AABB : public BoundingVolume
 
 	bool isOnFrustum(const Frustum& camFrustum, const Transform& transform) const final
 	{
-		//Get global scale thanks to our transform
-		const glm::vec3 globalCenter{ transform.getModelMatrix() * glm::vec4(center, 1.f) };
-
-		// Scaled orientation
-		const glm::vec3 right = transform.getRight() * extents.x;
-		const glm::vec3 up = transform.getUp() * extents.y;
-		const glm::vec3 forward = transform.getForward() * extents.z;
-
-		const float newIi = std::abs(glm::dot(glm::vec3{ 1.f, 0.f, 0.f }, right)) +
-			std::abs(glm::dot(glm::vec3{ 1.f, 0.f, 0.f }, up)) +
-			std::abs(glm::dot(glm::vec3{ 1.f, 0.f, 0.f }, forward));
-
-		const float newIj = std::abs(glm::dot(glm::vec3{ 0.f, 1.f, 0.f }, right)) +
-			std::abs(glm::dot(glm::vec3{ 0.f, 1.f, 0.f }, up)) +
-			std::abs(glm::dot(glm::vec3{ 0.f, 1.f, 0.f }, forward));
-
-		const float newIk = std::abs(glm::dot(glm::vec3{ 0.f, 0.f, 1.f }, right)) +
-			std::abs(glm::dot(glm::vec3{ 0.f, 0.f, 1.f }, up)) +
-			std::abs(glm::dot(glm::vec3{ 0.f, 0.f, 1.f }, forward));
-
-		const AABB globalAABB(globalCenter, newIi, newIj, newIk);
+		const AABB globalAABB = getGlobalAABB(transform.getModelMatrix());
 
 		return (globalAABB.isOnOrForwardPlane(camFrustum.leftFace) &&
 			globalAABB.isOnOrForwardPlane(camFrustum.rightFace) &&
@@ -324,6 +317,22 @@ struct AABB : public BoundingVolume
 			globalAABB.isOnOrForwardPlane(camFrustum.nearFace) &&
 			globalAABB.isOnOrForwardPlane(camFrustum.farFace));
 	};
+
+	//Axis aligned box enclosing this box once transformed by model
+	AABB getGlobalAABB(const glm::mat4& model) const
+	{
+		const glm::vec3 globalCenter{ model * glm::vec4(center, 1.f) };
+
+		// Scaled orientation
+		const glm::vec3 right = glm::vec3(model[0]) * extents.x;
+		const glm::vec3 up = glm::vec3(model[1]) * extents.y;
+		const glm::vec3 forward = -glm::vec3(model[2]) * extents.z;
+
+		// projecting the three scaled axes on the world axes is just taking their components
+		const glm::vec3 newExtents = glm::abs(right) + glm::abs(up) + glm::abs(forward);
+
+		return AABB(globalCenter, newExtents.x, newExtents.y, newExtents.z);
+	}
 };
 
 Frustum createFrustumFromCamera(const Camera& cam, float aspect, float fovY, float zNear, float zFar)
@@ -342,6 +351,14 @@ Frustum createFrustumFromCamera(const Camera& cam, float aspect, float fovY, flo
 	return frustum;
 }
 
+//Frustum faces as (normal, distance) for FrustumCuller and BoundingVolumeHierarchy
+inline void getFrustumPlanes(const Frustum& frustum, glm::vec4 planes[6])
+{
+	const Plane* faces[6] = { &frustum.leftFace, &frustum.rightFace, &frustum.topFace, &frustum.bottomFace, &frustum.nearFace, &frustum.farFace };
+	for (int i = 0; i < 6; ++i)
+		planes[i] = glm::vec4(faces[i]->normal, faces[i]->distance);
+}
+
 AABB generateAABB(const Model& model)
 {
 	glm::vec3 minAABB = glm::vec3(std::numeric_limits<float>::max());
@@ -383,103 +400,421 @@ Sphere generateSphereBV(const Model& model)
 	return Sphere((maxAABB + minAABB) * 0.5f, glm::length(minAABB - maxAABB));
 }
 
-class Entity
+//Flat scene graph. Every node lives at an index in a set of parallel arrays, and since a node can only be created
+//after its parent, parents always come before their children. This lets update() refresh all world matrices
+//in one linear sweep instead of a recursive walk over individually allocated nodes.
+class SceneGraph
 {
 public:
-	//Scene graph
-	std::list<std::unique_ptr<Entity>> children;
-	Entity* parent = nullptr;
-
-	//Space information
-	Transform transform;
-
-	Model* pModel = nullptr;
-	std::unique_ptr<AABB> boundingVolume;
+	//Adds a node drawing model below parent (-1 for a root) and returns its index
+	int addNode(Model& model, int parent = -1)
+	{
+		return addNode(getModelAABB(model), &model, parent);
+	}
 
+	//Adds a node with the given local bounding box. model may be null for nodes that only group others or for
+	//scenes that are never drawn, e.g. when updating and culling headless
+	int addNode(const AABB& boundingVolume, Model* model, int parent = -1)
+	{
+		const int index = static_cast<int>(m_parent.size());
+		m_parent.push_back(parent);
+		m_pos.emplace_back(0.0f);
+		m_eulerRot.emplace_back(0.0f);
+		m_scale.emplace_back(1.0f);
+		m_localMatrix.emplace_back(1.0f);
+		m_modelMatrix.emplace_back(1.0f);
+		m_isDirty.push_back(1);
+		m_model.push_back(model);
+		m_boundingVolume.push_back(boundingVolume);
+		m_worldBounds.Resize(m_parent.size());
+		m_hasDirty = true;
+		return index;
+	}
 
-	// constructor, expects a filepath to a 3D model.
-	Entity(Model& model) : pModel{ &model }
+	//With a job system, update() and culling of large scenes are split into jobs running on its threads.
+	//Drawing always stays on the calling thread
+	void setJobSystem(JobSystem* jobs)
 	{
-		boundingVolume = std::make_unique<AABB>(generateAABB(model));
-		//boundingVolume = std::make_unique<Sphere>(generateSphereBV(model));
+		//A single thread gains nothing from splitting and the serial sweeps have the better memory order
+		m_jobs = jobs && jobs->GetThreadCount() > 1 ? jobs : nullptr;
+		//The size of the update jobs depends on the number of threads
+		m_partitionSize = 0;
 	}
 
-	AABB getGlobalAABB()
+	void reserve(size_t count)
+	{
+		m_parent.reserve(count);
+		m_pos.reserve(count);
+		m_eulerRot.reserve(count);
+		m_scale.reserve(count);
+		m_localMatrix.reserve(count);
+		m_modelMatrix.reserve(count);
+		m_isDirty.reserve(count);
+		m_model.reserve(count);
+		m_boundingVolume.reserve(count);
+		m_worldBounds.Reserve(count);
+	}
+
+	//Update world matrices of the nodes that changed and everything below them
+	void update()
 	{
-		//Get global scale thanks to our transform
-		const glm::vec3 globalCenter{ transform.getModelMatrix() * glm::vec4(boundingVolume->center, 1.f) };
+		if (!m_hasDirty)
+			return;
 
-		// Scaled orientation
-		const glm::vec3 right = transform.getRight() * boundingVolume->extents.x;
-		const glm::vec3 up = transform.getUp() * boundingVolume->extents.y;
-		const glm::vec3 forward = transform.getForward() * boundingVolume->extents.z;
+		const size_t count = m_parent.size();
+		if (m_jobs && count >= PARALLEL_MIN_NODES)
+		{
+			//A subtree only depends on the nodes above it, so once the trunk is done every job updates whole
+			//subtrees on its own and the update needs a single join
+			updatePartition();
+			for (size_t i = 0; i < m_trunkSize; ++i)
+				updateNode(m_updateOrder[i]);
+			const unsigned int* order = m_updateOrder.data();
+			const size_t* jobStart = m_jobStart.data();
+			m_jobs->ParallelFor(m_jobStart.size() - 1, 1, [this, order, jobStart](size_t begin, size_t end)
+			{
+				for (size_t job = begin; job < end; ++job)
+				{
+					for (size_t i = jobStart[job]; i < jobStart[job + 1]; ++i)
+						updateNode(order[i]);
+				}
+			});
+		}
+		else
+		{
+			for (size_t i = 0; i < count; ++i)
+				updateNode(i);
+		}
 
-		const float newIi = std::abs(glm::dot(glm::vec3{ 1.f, 0.f, 0.f }, right)) +
-			std::abs(glm::dot(glm::vec3{ 1.f, 0.f, 0.f }, up)) +
-			std::abs(glm::dot(glm::vec3{ 1.f, 0.f, 0.f }, forward));
+		//The dirty flags now mark exactly the nodes whose world matrix changed. Refit the hierarchy around them;
+		//nodes added since it was built make getBvh() rebuild it instead
+		const size_t bvhCount = m_bvh.GetItemCount();
+		for (size_t i = 0; i < bvhCount; ++i)
+		{
+			if (m_isDirty[i])
+				m_movedBounds.push_back(static_cast<unsigned int>(i));
+		}
+		std::fill(m_isDirty.begin(), m_isDirty.end(), 0);
+		m_hasDirty = false;
 
-		const float newIj = std::abs(glm::dot(glm::vec3{ 0.f, 1.f, 0.f }, right)) +
-			std::abs(glm::dot(glm::vec3{ 0.f, 1.f, 0.f }, up)) +
-			std::abs(glm::dot(glm::vec3{ 0.f, 1.f, 0.f }, forward));
+		if (!m_movedBounds.empty())
+		{
+			m_bvh.Refit(m_worldBounds, m_movedBounds, m_parent.size() >= PARALLEL_MIN_NODES ? m_jobs : nullptr);
+			m_movedBounds.clear();
+		}
+	}
 
-		const float newIk = std::abs(glm::dot(glm::vec3{ 0.f, 0.f, 1.f }, right)) +
-			std::abs(glm::dot(glm::vec3{ 0.f, 0.f, 1.f }, up)) +
-			std::abs(glm::dot(glm::vec3{ 0.f, 0.f, 1.f }, forward));
+	//Force update of every world matrix even if local space don't change
+	void forceUpdate()
+	{
+		std::fill(m_isDirty.begin(), m_isDirty.end(), 1);
+		m_hasDirty = true;
+		update();
+	}
 
-		return AABB(globalCenter, newIi, newIj, newIk);
+	//Draw every node
+	void draw(Shader& ourShader)
+	{
+		for (size_t i = 0; i < m_parent.size(); ++i)
+		{
+			if (!m_model[i])
+				continue;
+			ourShader.setMat4("model", m_modelMatrix[i]);
+			m_model[i]->Draw(ourShader);
+		}
 	}
 
-	//Add child. Argument input is argument of any constructor that you create. By default you can use the default constructor and don't put argument input.
-	template<typename... TArgs>
-	void addChild(TArgs&... args)
+	//Draw the nodes whose bounding box is inside the frustum. The hierarchy rejects whole groups of nodes off screen at once
+	void draw(const Frustum& frustum, Shader& ourShader, unsigned int& display, unsigned int& total)
 	{
-		children.emplace_back(std::make_unique<Entity>(args...));
-		children.back()->parent = this;
+		for (unsigned int node : cull(frustum))
+		{
+			if (!m_model[node])
+				continue;
+			ourShader.setMat4("model", m_modelMatrix[node]);
+			m_model[node]->Draw(ourShader);
+		}
+		display += static_cast<unsigned int>(m_visible.size());
+		total += static_cast<unsigned int>(m_parent.size());
 	}
 
-	//Update transform if it was changed
-	void updateSelfAndChild()
+	//Queue the nodes inside the frustum instead of drawing them right away, so the queue can sort them by GL state.
+	//viewPosition gives the depth used to order draws of the same state front to back
+	//With a job system every job fills its own draw list from a fixed slice of the visible nodes, and the lists are
+	//appended slice by slice, so the queue ends up exactly as if it was filled on one thread
+	void submit(const Frustum& frustum, const Shader& ourShader, const glm::vec3& viewPosition, RenderQueue& queue, unsigned int& display, unsigned int& total)
 	{
-		if (transform.isDirty()) {
-			forceUpdateSelfAndChild();
-			return;
+		const std::vector<unsigned int>& visible = cull(frustum);
+		const size_t slices = (visible.size() + PARALLEL_SUBMIT_GRAIN - 1) / PARALLEL_SUBMIT_GRAIN;
+		if (m_jobs && slices > 1)
+		{
+			if (m_drawLists.size() < slices)
+				m_drawLists.resize(slices);
+			m_jobs->ParallelFor(slices, 1, [&](size_t begin, size_t end)
+			{
+				for (size_t slice = begin; slice < end; ++slice)
+				{
+					RenderList& list = m_drawLists[slice];
+					list.Clear();
+					const size_t last = std::min(visible.size(), (slice + 1) * PARALLEL_SUBMIT_GRAIN);
+					for (size_t i = slice * PARALLEL_SUBMIT_GRAIN; i < last; ++i)
+						submitNode(visible[i], ourShader, viewPosition, list);
+				}
+			});
+			for (size_t slice = 0; slice < slices; ++slice)
+				queue.Append(m_drawLists[slice]);
 		}
-			
-		for (auto&& child : children)
+		else
 		{
-			child->updateSelfAndChild();
+			for (unsigned int node : visible)
+				submitNode(node, ourShader, viewPosition, queue);
 		}
+		display += static_cast<unsigned int>(m_visible.size());
+		total += static_cast<unsigned int>(m_parent.size());
 	}
 
-	//Force update of transform even if local space don't change
-	void forceUpdateSelfAndChild()
+	//Indices of the nodes whose bounding box is inside the frustum, valid until the next call. With a job system
+	//the culling runs in parallel but the order of the list doesn't depend on the number of threads
+	const std::vector<unsigned int>& cull(const Frustum& frustum)
 	{
-		if (parent)
-			transform.computeModelMatrix(parent->transform.getModelMatrix());
+		glm::vec4 planes[6];
+		getFrustumPlanes(frustum, planes);
+		const BoundingVolumeHierarchy& bvh = getBvh();
+		m_visible.clear();
+		if (m_jobs && m_parent.size() >= PARALLEL_MIN_NODES)
+			bvh.Cull(planes, m_visible, *m_jobs);
 		else
-			transform.computeModelMatrix();
+			bvh.Cull(planes, m_visible);
+		return m_visible;
+	}
+
+	//Bounding volume hierarchy over the world bounds of every node, for culling, ray and box queries. Built on first use
+	//and refitted by update(); call rebuildBvh() after moving many nodes a long way
+	const BoundingVolumeHierarchy& getBvh()
+	{
+		if (m_bvh.GetItemCount() != m_parent.size())
+			rebuildBvh();
+		return m_bvh;
+	}
 
-		for (auto&& child : children)
+	void rebuildBvh()
+	{
+		update();
+		m_bvh.Build(m_worldBounds);
+	}
+
+	bool isOnFrustum(const Frustum& frustum, int node) const
+	{
+		return m_boundingVolume[node].getGlobalAABB(m_modelMatrix[node]).isOnFrustum(frustum);
+	}
+
+	size_t size() const { return m_parent.size(); }
+
+	int getParent(int node) const { return m_parent[node]; }
+	Model* getModel(int node) const { return m_model[node]; }
+	const AABB& getBoundingVolume(int node) const { return m_boundingVolume[node]; }
+
+	void setLocalPosition(int node, const glm::vec3& newPosition) { m_pos[node] = newPosition; setDirty(node); }
+	void setLocalRotation(int node, const glm::vec3& newRotation) { m_eulerRot[node] = newRotation; setDirty(node); }
+	void setLocalScale(int node, const glm::vec3& newScale) { m_scale[node] = newScale; setDirty(node); }
+
+	const glm::vec3& getLocalPosition(int node) const { return m_pos[node]; }
+	const glm::vec3& getLocalRotation(int node) const { return m_eulerRot[node]; }
+	const glm::vec3& getLocalScale(int node) const { return m_scale[node]; }
+	const glm::mat4& getModelMatrix(int node) const { return m_modelMatrix[node]; }
+	bool isDirty(int node) const { return m_isDirty[node] != 0; }
+
+	//Contiguous world matrices in node order, e.g. for uploading into an instance buffer
+	const std::vector<glm::mat4>& getModelMatrices() const { return m_modelMatrix; }
+	const CullingBoxes& getWorldBounds() const { return m_worldBounds; }
+
+private:
+	//Below this many nodes splitting the work into jobs costs more than it saves
+	static const size_t PARALLEL_MIN_NODES = 4096;
+	static const size_t PARALLEL_GRAIN = 1024;
+	//More update jobs than threads, so a thread that finishes early can steal work from the others
+	static const size_t JOBS_PER_THREAD = 4;
+	static const size_t PARALLEL_SUBMIT_GRAIN = 512;
+
+	//Local space information, one entry per node
+	std::vector<int> m_parent;
+	std::vector<glm::vec3> m_pos;
+	std::vector<glm::vec3> m_eulerRot; //In degrees
+	std::vector<glm::vec3> m_scale;
+	std::vector<glm::mat4> m_localMatrix;
+
+	//Global space information concatenate in matrix
+	std::vector<glm::mat4> m_modelMatrix;
+
+	//Dirty flags
+	std::vector<unsigned char> m_isDirty;
+	bool m_hasDirty = false;
+
+	std::vector<Model*> m_model;
+	std::vector<AABB> m_boundingVolume;
+
+	//World space bounding boxes, refreshed together with the world matrices
+	CullingBoxes m_worldBounds;
+	BoundingVolumeHierarchy m_bvh;
+	std::vector<unsigned int> m_movedBounds;
+	std::vector<unsigned int> m_visible;
+
+	//Order of the parallel update: first the trunk, the nodes whose subtree is too big for one job, then the nodes
+	//of every job's subtrees, each in ascending index order. m_jobStart holds where each job begins and ends
+	std::vector<unsigned int> m_updateOrder;
+	size_t m_trunkSize = 0;
+	std::vector<size_t> m_jobStart;
+	size_t m_partitionSize = 0; //node count the partition was made for
+	JobSystem* m_jobs = nullptr;
+	std::vector<RenderList> m_drawLists;
+
+	//Bounding boxes of the models in use, so each model's vertices are only walked once
+	std::map<const Model*, AABB> m_modelAABB;
+
+	void updateNode(size_t i)
+	{
+		//Only nodes whose own TRS changed rebuild their local matrix, below them just the world matrix is redone
+		if (m_isDirty[i])
+			m_localMatrix[i] = composeTRS(m_pos[i], m_eulerRot[i], m_scale[i]);
+
+		const int parent = m_parent[i];
+		if (parent >= 0 && m_isDirty[parent])
+			m_isDirty[i] = 1;
+		if (m_isDirty[i])
 		{
-			child->forceUpdateSelfAndChild();
+			m_modelMatrix[i] = parent >= 0 ? m_modelMatrix[parent] * m_localMatrix[i] : m_localMatrix[i];
+			const AABB globalAABB = m_boundingVolume[i].getGlobalAABB(m_modelMatrix[i]);
+			m_worldBounds.Set(i, globalAABB.center, globalAABB.extents);
 		}
 	}
 
+	template<typename Queue>
+	void submitNode(unsigned int node, const Shader& ourShader, const glm::vec3& viewPosition, Queue& queue) const
+	{
+		if (m_model[node])
+			queue.Submit(ourShader, *m_model[node], m_modelMatrix[node], glm::length(glm::vec3(m_modelMatrix[node][3]) - viewPosition));
+	}
 
-	void drawSelfAndChild(const Frustum& frustum, Shader& ourShader, unsigned int& display, unsigned int& total)
+	//Splits the nodes into the trunk and jobs of whole subtrees, redone only when nodes were added or the job system changed
+	void updatePartition()
 	{
-		if (boundingVolume->isOnFrustum(frustum, transform))
+		const size_t count = m_parent.size();
+		if (m_partitionSize == count)
+			return;
+		m_partitionSize = count;
+
+		//Children come after their parents, so a backwards sweep adds up the size of every subtree
+		std::vector<size_t> subtree(count, 1);
+		for (size_t i = count; i-- > 0;)
+		{
+			if (m_parent[i] >= 0)
+				subtree[m_parent[i]] += subtree[i];
+		}
+
+		//Subtrees up to target nodes go to the jobs whole, the nodes above them form the trunk. owner is the root
+		//of the subtree a node's job updates, -1 for the trunk
+		const size_t target = std::max(PARALLEL_GRAIN, count / (m_jobs->GetThreadCount() * JOBS_PER_THREAD));
+		std::vector<int> owner(count);
+		std::vector<size_t> start(count + 1, 0);
+		m_updateOrder.resize(count);
+		m_trunkSize = 0;
+		for (size_t i = 0; i < count; ++i)
 		{
-			ourShader.setMat4("model", transform.getModelMatrix());
-			pModel->Draw(ourShader);
-			display++;
+			const int parent = m_parent[i];
+			if (subtree[i] > target)
+			{
+				owner[i] = -1;
+				m_updateOrder[m_trunkSize++] = static_cast<unsigned int>(i);
+			}
+			else
+			{
+				owner[i] = parent >= 0 && owner[parent] >= 0 ? owner[parent] : static_cast<int>(i);
+				start[owner[i] + 1]++;
+			}
 		}
-		total++;
 
-		for (auto&& child : children)
+		//Counting sort of the other nodes by owner, keeping ascending index order, and a new job every time the
+		//subtrees collected reach the target
+		m_jobStart.assign(1, m_trunkSize);
+		size_t offset = m_trunkSize;
+		for (size_t root = 0; root < count; ++root)
 		{
-			child->drawSelfAndChild(frustum, ourShader, display, total);
+			const size_t size = start[root + 1];
+			start[root] = offset;
+			offset += size;
+			if (size > 0 && offset - m_jobStart.back() >= target)
+				m_jobStart.push_back(offset);
 		}
+		if (m_jobStart.back() != count)
+			m_jobStart.push_back(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (owner[i] >= 0)
+				m_updateOrder[start[owner[i]]++] = static_cast<unsigned int>(i);
+		}
+	}
+
+	void setDirty(int node)
+	{
+		m_isDirty[node] = 1;
+		m_hasDirty = true;
+	}
+
+	const AABB& getModelAABB(const Model& model)
+	{
+		auto it = m_modelAABB.find(&model);
+		if (it == m_modelAABB.end())
+			it = m_modelAABB.emplace(&model, generateAABB(model)).first;
+		return it->second;
+	}
+};
+
+//Handle to a node of a SceneGraph. It is a plain index, so it stays valid while nodes are added.
+class Entity
+{
+public:
+	Entity() = default;
+
+	Entity(SceneGraph& scene, int node) : m_scene{ &scene }, m_node{ node }
+	{}
+
+	// constructor, creates a root node drawing model.
+	Entity(SceneGraph& scene, Model& model) : m_scene{ &scene }, m_node{ scene.addNode(model) }
+	{}
+
+	//Add child drawing model and return it
+	Entity addChild(Model& model)
+	{
+		return Entity(*m_scene, m_scene->addNode(model, m_node));
+	}
+
+	Entity getParent() const
+	{
+		return m_scene->getParent(m_node) >= 0 ? Entity(*m_scene, m_scene->getParent(m_node)) : Entity();
 	}
+
+	bool isValid() const { return m_scene != nullptr; }
+	int getIndex() const { return m_node; }
+	Model* getModel() const { return m_scene->getModel(m_node); }
+
+	void setLocalPosition(const glm::vec3& newPosition) { m_scene->setLocalPosition(m_node, newPosition); }
+	void setLocalRotation(const glm::vec3& newRotation) { m_scene->setLocalRotation(m_node, newRotation); }
+	void setLocalScale(const glm::vec3& newScale) { m_scene->setLocalScale(m_node, newScale); }
+
+	const glm::vec3& getLocalPosition() const { return m_scene->getLocalPosition(m_node); }
+	const glm::vec3& getLocalRotation() const { return m_scene->getLocalRotation(m_node); }
+	const glm::vec3& getLocalScale() const { return m_scene->getLocalScale(m_node); }
+	const glm::mat4& getModelMatrix() const { return m_scene->getModelMatrix(m_node); }
+	glm::vec3 getGlobalPosition() const { return getModelMatrix()[3]; }
+	bool isDirty() const { return m_scene->isDirty(m_node); }
+
+	AABB getGlobalAABB() const
+	{
+		return m_scene->getBoundingVolume(m_node).getGlobalAABB(getModelMatrix());
+	}
+
+private:
+	SceneGraph* m_scene = nullptr;
+	int m_node = -1;
 };
 #endif
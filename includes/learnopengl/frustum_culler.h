@@ -0,0 +1,189 @@
+#ifndef FRUSTUM_CULLER_H
+#define FRUSTUM_CULLER_H
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// pick the widest instruction set the compiler was told it may use (-mavx or /arch:AVX; SSE2 is always there on x86-64).
+// define FRUSTUM_CULLER_NO_SIMD to force the scalar path
+#if !defined(FRUSTUM_CULLER_NO_SIMD) && defined(__AVX__)
+#define FRUSTUM_CULLER_AVX
+#include <immintrin.h>
+#elif !defined(FRUSTUM_CULLER_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define FRUSTUM_CULLER_SSE
+#include <emmintrin.h>
+#endif
+
+// World space axis aligned boxes stored as one array per component, so that a whole batch of boxes
+// can be loaded into SIMD registers with one instruction per component.
+struct CullingBoxes
+{
+    std::vector<float> CenterX, CenterY, CenterZ;
+    std::vector<float> ExtentX, ExtentY, ExtentZ;
+
+    size_t Size() const { return CenterX.size(); }
+
+    void Reserve(size_t count)
+    {
+        CenterX.reserve(count); CenterY.reserve(count); CenterZ.reserve(count);
+        ExtentX.reserve(count); ExtentY.reserve(count); ExtentZ.reserve(count);
+    }
+
+    void Resize(size_t count)
+    {
+        CenterX.resize(count); CenterY.resize(count); CenterZ.resize(count);
+        ExtentX.resize(count); ExtentY.resize(count); ExtentZ.resize(count);
+    }
+
+    void Set(size_t index, const glm::vec3& center, const glm::vec3& extents)
+    {
+        CenterX[index] = center.x; CenterY[index] = center.y; CenterZ[index] = center.z;
+        ExtentX[index] = extents.x; ExtentY[index] = extents.y; ExtentZ[index] = extents.z;
+    }
+};
+
+// Tests batches of boxes against six frustum planes. A plane is (normal, distance) with the normal
+// pointing into the frustum, and a box is visible when it lies at least partly on the inner side of
+// every plane; that is the same test as AABB::isOnFrustum. Indices of the visible boxes are written
+// to visible in ascending order, which must have room for boxes.Size() entries.
+class FrustumCuller
+{
+public:
+    static size_t Cull(const glm::vec4 planes[6], const CullingBoxes& boxes, unsigned int* visible)
+    {
+#if defined(FRUSTUM_CULLER_AVX)
+        return cullAVX(planes, boxes, visible);
+#elif defined(FRUSTUM_CULLER_SSE)
+        return cullSSE(planes, boxes, visible);
+#else
+        return CullScalar(planes, boxes, visible);
+#endif
+    }
+
+    // one box at a time; gives exactly the same result as Cull as long as the compiler doesn't fuse its multiply-adds
+    // (GCC does with -mfma unless -ffp-contract=off)
+    static size_t CullScalar(const glm::vec4 planes[6], const CullingBoxes& boxes, unsigned int* visible)
+    {
+        return cullRange(planes, boxes, 0, boxes.Size(), visible, 0);
+    }
+
+    // number of boxes tested per instruction
+    static int GetBatchWidth()
+    {
+#if defined(FRUSTUM_CULLER_AVX)
+        return 8;
+#elif defined(FRUSTUM_CULLER_SSE)
+        return 4;
+#else
+        return 1;
+#endif
+    }
+
+private:
+    // the per plane test is written as (n.c - d) >= -(|n|.e) everywhere, so the scalar and the SIMD paths round identically
+    static size_t cullRange(const glm::vec4 planes[6], const CullingBoxes& boxes, size_t begin, size_t end, unsigned int* visible, size_t visibleCount)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            bool inside = true;
+            for (int p = 0; p < 6 && inside; p++)
+            {
+                const glm::vec4& plane = planes[p];
+                const float distance = plane.x * boxes.CenterX[i] + plane.y * boxes.CenterY[i] + plane.z * boxes.CenterZ[i] - plane.w;
+                const float radius = std::abs(plane.x) * boxes.ExtentX[i] + std::abs(plane.y) * boxes.ExtentY[i] + std::abs(plane.z) * boxes.ExtentZ[i];
+                inside = distance >= -radius;
+            }
+            if (inside)
+                visible[visibleCount++] = static_cast<unsigned int>(i);
+        }
+        return visibleCount;
+    }
+
+#if defined(FRUSTUM_CULLER_SSE)
+    static size_t cullSSE(const glm::vec4 planes[6], const CullingBoxes& boxes, unsigned int* visible)
+    {
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        __m128 nx[6], ny[6], nz[6], ax[6], ay[6], az[6], d[6];
+        for (int p = 0; p < 6; p++)
+        {
+            nx[p] = _mm_set1_ps(planes[p].x);
+            ny[p] = _mm_set1_ps(planes[p].y);
+            nz[p] = _mm_set1_ps(planes[p].z);
+            ax[p] = _mm_andnot_ps(signMask, nx[p]);
+            ay[p] = _mm_andnot_ps(signMask, ny[p]);
+            az[p] = _mm_andnot_ps(signMask, nz[p]);
+            d[p] = _mm_set1_ps(planes[p].w);
+        }
+
+        const size_t count = boxes.Size();
+        const size_t batchEnd = count & ~size_t(3);
+        size_t visibleCount = 0;
+        for (size_t i = 0; i < batchEnd; i += 4)
+        {
+            const __m128 cx = _mm_loadu_ps(&boxes.CenterX[i]), cy = _mm_loadu_ps(&boxes.CenterY[i]), cz = _mm_loadu_ps(&boxes.CenterZ[i]);
+            const __m128 ex = _mm_loadu_ps(&boxes.ExtentX[i]), ey = _mm_loadu_ps(&boxes.ExtentY[i]), ez = _mm_loadu_ps(&boxes.ExtentZ[i]);
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int p = 0; p < 6; p++)
+            {
+                const __m128 distance = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx[p], cx), _mm_mul_ps(ny[p], cy)), _mm_mul_ps(nz[p], cz)), d[p]);
+                const __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax[p], ex), _mm_mul_ps(ay[p], ey)), _mm_mul_ps(az[p], ez));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, _mm_xor_ps(radius, signMask)));
+            }
+            visibleCount = appendVisible(_mm_movemask_ps(inside), 4, i, visible, visibleCount);
+        }
+        return cullRange(planes, boxes, batchEnd, count, visible, visibleCount);
+    }
+#endif
+
+#if defined(FRUSTUM_CULLER_AVX)
+    static size_t cullAVX(const glm::vec4 planes[6], const CullingBoxes& boxes, unsigned int* visible)
+    {
+        const __m256 signMask = _mm256_set1_ps(-0.0f);
+        __m256 nx[6], ny[6], nz[6], ax[6], ay[6], az[6], d[6];
+        for (int p = 0; p < 6; p++)
+        {
+            nx[p] = _mm256_set1_ps(planes[p].x);
+            ny[p] = _mm256_set1_ps(planes[p].y);
+            nz[p] = _mm256_set1_ps(planes[p].z);
+            ax[p] = _mm256_andnot_ps(signMask, nx[p]);
+            ay[p] = _mm256_andnot_ps(signMask, ny[p]);
+            az[p] = _mm256_andnot_ps(signMask, nz[p]);
+            d[p] = _mm256_set1_ps(planes[p].w);
+        }
+
+        const size_t count = boxes.Size();
+        const size_t batchEnd = count & ~size_t(7);
+        size_t visibleCount = 0;
+        for (size_t i = 0; i < batchEnd; i += 8)
+        {
+            const __m256 cx = _mm256_loadu_ps(&boxes.CenterX[i]), cy = _mm256_loadu_ps(&boxes.CenterY[i]), cz = _mm256_loadu_ps(&boxes.CenterZ[i]);
+            const __m256 ex = _mm256_loadu_ps(&boxes.ExtentX[i]), ey = _mm256_loadu_ps(&boxes.ExtentY[i]), ez = _mm256_loadu_ps(&boxes.ExtentZ[i]);
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (int p = 0; p < 6; p++)
+            {
+                // no FMA on purpose: fused rounding would make the result differ from the scalar path on the plane boundary
+                const __m256 distance = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx[p], cx), _mm256_mul_ps(ny[p], cy)), _mm256_mul_ps(nz[p], cz)), d[p]);
+                const __m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax[p], ex), _mm256_mul_ps(ay[p], ey)), _mm256_mul_ps(az[p], ez));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, _mm256_xor_ps(radius, signMask), _CMP_GE_OQ));
+            }
+            visibleCount = appendVisible(_mm256_movemask_ps(inside), 8, i, visible, visibleCount);
+        }
+        return cullRange(planes, boxes, batchEnd, count, visible, visibleCount);
+    }
+#endif
+
+    // writes the indices of the set bits of mask without branching on them; every write stays below first + width
+    static size_t appendVisible(int mask, int width, size_t first, unsigned int* visible, size_t visibleCount)
+    {
+        for (int lane = 0; lane < width; lane++)
+        {
+            visible[visibleCount] = static_cast<unsigned int>(first + lane);
+            visibleCount += (mask >> lane) & 1;
+        }
+        return visibleCount;
+    }
+};
+#endif
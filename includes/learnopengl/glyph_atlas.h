@@ -0,0 +1,236 @@
+#ifndef GLYPH_ATLAS_H
+#define GLYPH_ATLAS_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <climits>
+#include <string>
+#include <vector>
+
+// Skyline rectangle packer. The top edge of everything packed so far is kept as a list of horizontal
+// segments, left to right; a new rectangle goes wherever its top ends up lowest (bottom-left rule),
+// preferring the narrower spot on ties, and the skyline is raised over its width. No OpenGL involved.
+class SkylinePacker
+{
+public:
+    explicit SkylinePacker(int width = 0, int height = 0) { Reset(width, height); }
+
+    void Reset(int width, int height)
+    {
+        m_Width = width;
+        m_Height = height;
+        m_UsedArea = 0;
+        m_Skyline.clear();
+        if (width > 0 && height > 0)
+            m_Skyline.push_back({ 0, 0, width });
+    }
+
+    // finds room for a width x height rectangle and returns its top-left corner in position; false if it doesn't fit
+    bool Pack(int width, int height, glm::ivec2 &position)
+    {
+        if (width <= 0 || height <= 0)
+        {
+            position = glm::ivec2(0);
+            return width >= 0 && height >= 0;
+        }
+        size_t best = m_Skyline.size();
+        int bestTop = INT_MAX, bestWidth = INT_MAX, bestY = 0;
+        for (size_t i = 0; i < m_Skyline.size(); i++)
+        {
+            int y = fit(i, width, height);
+            if (y < 0)
+                continue;
+            if (y + height < bestTop || (y + height == bestTop && m_Skyline[i].width < bestWidth))
+            {
+                best = i;
+                bestTop = y + height;
+                bestWidth = m_Skyline[i].width;
+                bestY = y;
+            }
+        }
+        if (best == m_Skyline.size())
+            return false;
+        position = glm::ivec2(m_Skyline[best].x, bestY);
+        add(best, position.x, bestY + height, width);
+        m_UsedArea += static_cast<long long>(width) * height;
+        return true;
+    }
+
+    int GetWidth() const { return m_Width; }
+    int GetHeight() const { return m_Height; }
+    // fraction of the area taken by packed rectangles
+    float Occupancy() const { return m_Width > 0 && m_Height > 0 ? static_cast<float>(m_UsedArea) / (static_cast<float>(m_Width) * m_Height) : 0.0f; }
+
+private:
+    struct Segment
+    {
+        int x, y, width;
+    };
+    std::vector<Segment> m_Skyline;
+    int m_Width = 0, m_Height = 0;
+    long long m_UsedArea = 0;
+
+    // y a rectangle rests at when its left edge is put at the start of segment index, -1 if it doesn't fit there
+    int fit(size_t index, int width, int height) const
+    {
+        int x = m_Skyline[index].x;
+        if (x + width > m_Width)
+            return -1;
+        int y = 0;
+        for (int left = width; left > 0; index++)
+        {
+            y = std::max(y, m_Skyline[index].y);
+            if (y + height > m_Height)
+                return -1;
+            left -= m_Skyline[index].width;
+        }
+        return y;
+    }
+
+    // raises the skyline to top over [x, x + width), starting at segment index
+    void add(size_t index, int x, int top, int width)
+    {
+        m_Skyline.insert(m_Skyline.begin() + index, { x, top, width });
+        // cut the covered part off the segments that follow
+        for (size_t i = index + 1; i < m_Skyline.size(); )
+        {
+            int end = m_Skyline[i - 1].x + m_Skyline[i - 1].width;
+            if (m_Skyline[i].x >= end)
+                break;
+            int shrink = end - m_Skyline[i].x;
+            if (m_Skyline[i].width <= shrink)
+            {
+                m_Skyline.erase(m_Skyline.begin() + i);
+                continue;
+            }
+            m_Skyline[i].x += shrink;
+            m_Skyline[i].width -= shrink;
+            break;
+        }
+        // merge neighbours at the same height
+        for (size_t i = 0; i + 1 < m_Skyline.size(); )
+        {
+            if (m_Skyline[i].y == m_Skyline[i + 1].y)
+            {
+                m_Skyline[i].width += m_Skyline[i + 1].width;
+                m_Skyline.erase(m_Skyline.begin() + i + 1);
+            }
+            else
+                i++;
+        }
+    }
+};
+
+// a glyph of a GlyphCache: its metrics and where its bitmap sits in the atlas pages
+struct AtlasGlyph
+{
+    bool       valid = false;
+    glm::ivec2 size = glm::ivec2(0);    // size of the glyph bitmap in pixels
+    glm::ivec2 bearing = glm::ivec2(0); // offset from the baseline to the left/top of the glyph
+    float      advance = 0.0f;          // horizontal offset to the next glyph in pixels
+    int        page = -1;               // atlas page holding the bitmap, -1 if the glyph has none
+    glm::vec2  uvMin = glm::vec2(0.0f); // texture coordinates of the top-left ...
+    glm::vec2  uvMax = glm::vec2(0.0f); // ... and bottom-right corner of the bitmap
+};
+
+// vertical metrics of a font at one pixel size
+struct LineMetrics
+{
+    float ascent = 0.0f;     // from the top of a line down to its baseline
+    float lineHeight = 0.0f; // from one baseline to the next
+};
+
+// vertex of a laid out glyph quad, matching the <vec2 pos, vec2 tex> and <float page> attributes of the text shaders
+struct TextVertex
+{
+    glm::vec2 position;
+    glm::vec2 texCoords;
+    float     page;
+};
+
+// Decodes the UTF-8 sequence starting at text[pos] and moves pos past it. Malformed sequences
+// (stray continuation bytes, truncated or overlong sequences, surrogates) decode to U+FFFD and
+// skip a single byte, so decoding always makes progress.
+inline char32_t DecodeUtf8(const std::string &text, size_t &pos)
+{
+    unsigned char lead = static_cast<unsigned char>(text[pos++]);
+    if (lead < 0x80)
+        return lead;
+    int extra;
+    char32_t codepoint;
+    if ((lead & 0xE0) == 0xC0)
+    {
+        extra = 1;
+        codepoint = lead & 0x1F;
+    }
+    else if ((lead & 0xF0) == 0xE0)
+    {
+        extra = 2;
+        codepoint = lead & 0x0F;
+    }
+    else if ((lead & 0xF8) == 0xF0)
+    {
+        extra = 3;
+        codepoint = lead & 0x07;
+    }
+    else
+        return 0xFFFD;
+    if (pos + extra > text.size())
+        return 0xFFFD;
+    for (int i = 0; i < extra; i++)
+    {
+        unsigned char next = static_cast<unsigned char>(text[pos + i]);
+        if ((next & 0xC0) != 0x80)
+            return 0xFFFD;
+        codepoint = (codepoint << 6) | (next & 0x3F);
+    }
+    static const char32_t smallest[] = { 0, 0x80, 0x800, 0x10000 };
+    if (codepoint < smallest[extra] || (codepoint >= 0xD800 && codepoint <= 0xDFFF) || codepoint > 0x10FFFF)
+        return 0xFFFD;
+    pos += extra;
+    return codepoint;
+}
+
+// Lays UTF-8 text out as one quad (two triangles) per visible glyph and appends the vertices, so a whole
+// string can be drawn with a single draw call whatever pages its glyphs are on. lookup(codepoint) returns
+// the glyph as a const AtlasGlyph*, or nullptr for one that isn't available (yet), which is left out.
+// With yDown, y is the top of the first line and y grows downwards (for a projection that flips y);
+// otherwise y is the baseline of the first line and y grows upwards. A '\n' starts a new line
+// metrics.lineHeight further on at the starting x. Triangles wind counter-clockwise on screen either way.
+// Returns the pen position after the last glyph.
+template<typename GlyphLookup>
+inline float LayoutText(GlyphLookup lookup, const LineMetrics &metrics, const std::string &text, float x, float y, float scale, bool yDown, std::vector<TextVertex> &vertices)
+{
+    const float lineStart = x;
+    for (size_t pos = 0; pos < text.size(); )
+    {
+        char32_t codepoint = DecodeUtf8(text, pos);
+        if (codepoint == '\n')
+        {
+            x = lineStart;
+            y += (yDown ? metrics.lineHeight : -metrics.lineHeight) * scale;
+            continue;
+        }
+        const AtlasGlyph *glyph = lookup(codepoint);
+        if (!glyph)
+            continue;
+        if (glyph->page >= 0)
+        {
+            float left = x + glyph->bearing.x * scale;
+            float right = left + glyph->size.x * scale;
+            float top = yDown ? y + (metrics.ascent - glyph->bearing.y) * scale : y + glyph->bearing.y * scale;
+            float bottom = yDown ? top + glyph->size.y * scale : top - glyph->size.y * scale;
+            float page = static_cast<float>(glyph->page);
+            TextVertex topLeft = { glm::vec2(left, top), glyph->uvMin, page };
+            TextVertex bottomLeft = { glm::vec2(left, bottom), glm::vec2(glyph->uvMin.x, glyph->uvMax.y), page };
+            TextVertex bottomRight = { glm::vec2(right, bottom), glyph->uvMax, page };
+            TextVertex topRight = { glm::vec2(right, top), glm::vec2(glyph->uvMax.x, glyph->uvMin.y), page };
+            vertices.insert(vertices.end(), { topLeft, bottomLeft, bottomRight, topLeft, bottomRight, topRight });
+        }
+        x += glyph->advance * scale;
+    }
+    return x;
+}
+
+#endif
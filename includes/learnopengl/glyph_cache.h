@@ -0,0 +1,401 @@
+#ifndef GLYPH_CACHE_H
+#define GLYPH_CACHE_H
+
+#include <learnopengl/glyph_atlas.h>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct GlyphCacheStats
+{
+    unsigned long long hits = 0;         // GetGlyph calls answered from the atlas
+    unsigned long long misses = 0;       // GetGlyph calls for glyphs not rasterized (yet)
+    unsigned long long rasterized = 0;   // glyphs FreeType rendered
+    unsigned long long evictedPages = 0;
+    unsigned long long evictedGlyphs = 0;
+    double rasterizeMilliseconds = 0.0;  // FreeType time of all rasterized glyphs, spent on the worker thread
+
+    float HitRate() const { return hits + misses > 0 ? static_cast<float>(hits) / static_cast<float>(hits + misses) : 0.0f; }
+};
+
+// GlyphCache rasterizes glyphs keyed by (font, pixel size, code point) the first time they're asked
+// for, so any Unicode text at any size can be drawn without loading a font up front. FreeType runs on
+// a worker thread of its own: GetGlyph never waits for it, a glyph that isn't ready yet is queued and
+// reported missing until Update moves it into the atlas. The atlas is a stack of square pages packed
+// with a SkylinePacker (a renderer keeps them as the layers of one array texture). A skyline can't free
+// single rectangles, so when every page is full the page used least recently is cleared as a whole and
+// its glyphs are rasterized again on their next use.
+// Everything but the worker runs on the thread calling GetGlyph/Update. No OpenGL involved.
+class GlyphCache
+{
+public:
+    // maxPages pageSize x pageSize pages of one byte per pixel is all the memory the atlas takes; padding
+    // is the number of empty pixels kept around every glyph, so filtering doesn't bleed neighbours in
+    explicit GlyphCache(int pageSize = 512, unsigned int maxPages = 4, int padding = 1)
+        : m_PageSize(pageSize), m_MaxPages(maxPages > 0 ? maxPages : 1), m_Padding(padding)
+    {
+        m_Worker = std::thread([this] { workerLoop(); });
+    }
+
+    GlyphCache(const GlyphCache&) = delete;
+    GlyphCache& operator=(const GlyphCache&) = delete;
+
+    ~GlyphCache()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stopping = true;
+        }
+        m_WorkerWake.notify_all();
+        m_Worker.join();
+    }
+
+    // registers a font file and returns the id glyphs of it are asked for with; the worker opens it on first use
+    unsigned int AddFont(const std::string &path)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_FontPaths.push_back(path);
+        return static_cast<unsigned int>(m_FontPaths.size() - 1);
+    }
+
+    // the glyph if it's in the atlas, nullptr if not: then it's queued for rasterization (once) and shows up
+    // after a later Update. The pointer stays valid until the next Update.
+    const AtlasGlyph* GetGlyph(unsigned int font, unsigned int pixelSize, char32_t codepoint)
+    {
+        uint64_t key = makeKey(font, pixelSize, codepoint);
+        std::unordered_map<uint64_t, Entry>::iterator it = m_Glyphs.find(key);
+        if (it != m_Glyphs.end() && it->second.ready)
+        {
+            m_Stats.hits++;
+            if (it->second.glyph.page >= 0)
+                m_Pages[it->second.glyph.page].lastUse = ++m_UseClock;
+            return &it->second.glyph;
+        }
+        m_Stats.misses++;
+        if (it == m_Glyphs.end())
+        {
+            m_Glyphs[key] = Entry();
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_Requests.push(key);
+            }
+            m_WorkerWake.notify_one();
+        }
+        return nullptr;
+    }
+
+    // moves the glyphs the worker finished into the atlas pages, evicting pages when they're full.
+    // Cheap when there's nothing new; call it once per frame. Returns true if the atlas changed.
+    bool Update()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Finished.swap(m_Adding);
+        }
+        for (Rasterized &glyph : m_Adding)
+            add(glyph);
+        bool changed = !m_Adding.empty();
+        m_Adding.clear();
+        if (changed)
+            m_Generation++;
+        return changed;
+    }
+
+    // blocks until every queued glyph is rasterized, then adds them. For loading screens and tools that want
+    // text complete on the first frame, not for use inside the frame.
+    void Flush()
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_WorkerIdle.wait(lock, [this] { return m_Requests.empty() && !m_Busy; });
+        }
+        Update();
+    }
+
+    // region of page written since the last call as x, y, width, height; false if the page is unchanged.
+    // Renderers upload that region of GetPagePixels to the page's texture layer.
+    bool TakeDirtyRegion(unsigned int page, glm::ivec4 &region)
+    {
+        Page &target = m_Pages[page];
+        if (target.dirtyMax.x <= target.dirtyMin.x || target.dirtyMax.y <= target.dirtyMin.y)
+            return false;
+        region = glm::ivec4(target.dirtyMin, target.dirtyMax - target.dirtyMin);
+        target.dirtyMin = glm::ivec2(m_PageSize);
+        target.dirtyMax = glm::ivec2(0);
+        return true;
+    }
+
+    // rows of GetPageSize() bytes, top row first
+    const std::vector<unsigned char>& GetPagePixels(unsigned int page) const { return m_Pages[page].pixels; }
+    int GetPageSize() const { return m_PageSize; }
+    unsigned int GetPageCount() const { return static_cast<unsigned int>(m_Pages.size()); }
+    unsigned int GetMaxPages() const { return m_MaxPages; }
+    // changes whenever glyphs are added or evicted; layouts built with an older generation may be stale
+    unsigned long long GetGeneration() const { return m_Generation; }
+    const GlyphCacheStats& GetStats() const { return m_Stats; }
+    // ascent and line height of font at pixelSize, taken from the face when its first glyph of that size
+    // arrives (zero until then). Unlike GetGlyph this neither counts as a hit or miss nor touches the pages.
+    LineMetrics GetLineMetrics(unsigned int font, unsigned int pixelSize) const
+    {
+        std::unordered_map<uint64_t, LineMetrics>::const_iterator it = m_LineMetrics.find(makeKey(font, pixelSize, 0));
+        return it != m_LineMetrics.end() ? it->second : LineMetrics();
+    }
+    // fraction of the whole atlas budget (all maxPages pages) taken by glyphs
+    float Occupancy() const
+    {
+        float used = 0.0f;
+        for (const Page &page : m_Pages)
+            used += page.packer.Occupancy();
+        return used / static_cast<float>(m_MaxPages);
+    }
+
+private:
+    struct Entry
+    {
+        AtlasGlyph glyph;
+        bool       ready = false; // false while the worker hasn't delivered it
+    };
+    struct Page
+    {
+        SkylinePacker         packer;
+        std::vector<unsigned char> pixels;
+        std::vector<uint64_t> keys;    // glyphs with their bitmap on this page
+        unsigned long long    lastUse = 0;
+        glm::ivec2            dirtyMin, dirtyMax;
+    };
+    // a glyph as the worker hands it over
+    struct Rasterized
+    {
+        uint64_t                   key;
+        std::vector<unsigned char> bitmap; // tightly packed rows
+        glm::ivec2                 size, bearing;
+        float                      advance;
+        LineMetrics                lineMetrics; // of the face at the glyph's size, zero if the size couldn't be set
+        double                     milliseconds;
+    };
+
+    int m_PageSize;
+    unsigned int m_MaxPages;
+    int m_Padding;
+    std::vector<Page> m_Pages;
+    std::unordered_map<uint64_t, Entry> m_Glyphs;
+    std::unordered_map<uint64_t, LineMetrics> m_LineMetrics; // per font and size, code point 0
+    unsigned long long m_UseClock = 0;
+    unsigned long long m_Generation = 0;
+    GlyphCacheStats m_Stats;
+    std::vector<Rasterized> m_Adding;
+
+    // shared with the worker, guarded by m_Mutex
+    std::mutex m_Mutex;
+    std::condition_variable m_WorkerWake, m_WorkerIdle;
+    std::vector<std::string> m_FontPaths;
+    std::queue<uint64_t> m_Requests;
+    std::vector<Rasterized> m_Finished;
+    bool m_Busy = false;
+    bool m_Stopping = false;
+    std::thread m_Worker;
+
+    static uint64_t makeKey(unsigned int font, unsigned int pixelSize, char32_t codepoint)
+    {
+        return (static_cast<uint64_t>(font & 0xFFFF) << 48) | (static_cast<uint64_t>(pixelSize & 0xFFFF) << 32) | codepoint;
+    }
+
+    void add(Rasterized &rasterized)
+    {
+        // a face has the same metrics for every glyph of a size, the first glyph brings them
+        if (rasterized.lineMetrics.lineHeight > 0.0f)
+            m_LineMetrics.emplace(rasterized.key & ~static_cast<uint64_t>(0xFFFFFFFF), rasterized.lineMetrics);
+        std::unordered_map<uint64_t, Entry>::iterator it = m_Glyphs.find(rasterized.key);
+        if (it == m_Glyphs.end())
+            return;
+        m_Stats.rasterized++;
+        m_Stats.rasterizeMilliseconds += rasterized.milliseconds;
+        AtlasGlyph &glyph = it->second.glyph;
+        it->second.ready = true;
+        glyph.valid = true;
+        glyph.size = rasterized.size;
+        glyph.bearing = rasterized.bearing;
+        glyph.advance = rasterized.advance;
+        glyph.page = -1;
+        if (glyph.size.x == 0 || glyph.size.y == 0)
+            return;
+        glm::ivec2 position(0);
+        int page = allocate(glyph.size.x + 2 * m_Padding, glyph.size.y + 2 * m_Padding, position);
+        if (page < 0)
+        {
+            // keep the metrics so text still lines up, just without this glyph
+            std::cout << "ERROR::GLYPH_CACHE: Glyph doesn't fit in an atlas page" << std::endl;
+            return;
+        }
+        position += m_Padding;
+        Page &target = m_Pages[page];
+        for (int row = 0; row < glyph.size.y; row++)
+            std::memcpy(&target.pixels[static_cast<size_t>(position.y + row) * m_PageSize + position.x], &rasterized.bitmap[static_cast<size_t>(row) * glyph.size.x], glyph.size.x);
+        target.keys.push_back(rasterized.key);
+        target.dirtyMin = glm::min(target.dirtyMin, position - m_Padding);
+        target.dirtyMax = glm::max(target.dirtyMax, position + glyph.size + m_Padding);
+        glyph.page = page;
+        glyph.uvMin = glm::vec2(position) / static_cast<float>(m_PageSize);
+        glyph.uvMax = glm::vec2(position + glyph.size) / static_cast<float>(m_PageSize);
+    }
+
+    // finds room for a width x height rectangle: on a page with space left, on a new page while the budget
+    // allows one, or else on the least recently used page after clearing it. -1 if it's bigger than a page.
+    int allocate(int width, int height, glm::ivec2 &position)
+    {
+        for (size_t i = 0; i < m_Pages.size(); i++)
+        {
+            if (m_Pages[i].packer.Pack(width, height, position))
+            {
+                // a page just written to is in use, whether or not anything has been drawn from it yet
+                m_Pages[i].lastUse = ++m_UseClock;
+                return static_cast<int>(i);
+            }
+        }
+        size_t page = 0;
+        if (m_Pages.size() < m_MaxPages)
+        {
+            m_Pages.emplace_back();
+            page = m_Pages.size() - 1;
+            m_Pages[page].packer.Reset(m_PageSize, m_PageSize);
+            m_Pages[page].pixels.assign(static_cast<size_t>(m_PageSize) * m_PageSize, 0);
+            m_Pages[page].dirtyMin = glm::ivec2(m_PageSize);
+            m_Pages[page].dirtyMax = glm::ivec2(0);
+        }
+        else
+        {
+            for (size_t i = 1; i < m_Pages.size(); i++)
+                if (m_Pages[i].lastUse < m_Pages[page].lastUse)
+                    page = i;
+            evict(page);
+        }
+        m_Pages[page].lastUse = ++m_UseClock;
+        return m_Pages[page].packer.Pack(width, height, position) ? static_cast<int>(page) : -1;
+    }
+
+    // clears a page; its glyphs are forgotten, so asking for them again rasterizes them anew
+    void evict(size_t page)
+    {
+        Page &target = m_Pages[page];
+        for (uint64_t key : target.keys)
+            m_Glyphs.erase(key);
+        m_Stats.evictedPages++;
+        m_Stats.evictedGlyphs += target.keys.size();
+        target.keys.clear();
+        target.packer.Reset(m_PageSize, m_PageSize);
+        std::fill(target.pixels.begin(), target.pixels.end(), static_cast<unsigned char>(0));
+        target.dirtyMin = glm::ivec2(0);
+        target.dirtyMax = glm::ivec2(m_PageSize);
+    }
+
+    // the worker owns the FreeType library and all faces, FreeType objects aren't shared between threads
+    void workerLoop()
+    {
+        FT_Library ft;
+        // all functions return a value different than 0 whenever an error occurred
+        bool loaded = FT_Init_FreeType(&ft) == 0;
+        if (!loaded)
+            std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
+        std::vector<FT_Face> faces;
+        std::vector<bool> opened;
+
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        for (;;)
+        {
+            m_WorkerWake.wait(lock, [this] { return m_Stopping || !m_Requests.empty(); });
+            if (m_Stopping)
+                break;
+            uint64_t key = m_Requests.front();
+            m_Requests.pop();
+            unsigned int font = static_cast<unsigned int>(key >> 48);
+            std::string path = font < m_FontPaths.size() ? m_FontPaths[font] : std::string();
+            m_Busy = true;
+            lock.unlock();
+
+            if (font >= faces.size())
+            {
+                faces.resize(font + 1, nullptr);
+                opened.resize(font + 1, false);
+            }
+            if (loaded && !opened[font])
+            {
+                opened[font] = true;
+                if (path.empty() || FT_New_Face(ft, path.c_str(), 0, &faces[font]))
+                {
+                    faces[font] = nullptr;
+                    std::cout << "ERROR::FREETYPE: Failed to load font " << path << std::endl;
+                }
+            }
+            Rasterized glyph = rasterize(faces[font], key);
+
+            lock.lock();
+            m_Finished.push_back(std::move(glyph));
+            m_Busy = false;
+            if (m_Requests.empty())
+                m_WorkerIdle.notify_all();
+        }
+        lock.unlock();
+        // destroy FreeType once we're finished
+        for (FT_Face face : faces)
+            if (face)
+                FT_Done_Face(face);
+        if (loaded)
+            FT_Done_FreeType(ft);
+    }
+
+    // renders one glyph; a glyph FreeType can't load comes back empty, so it isn't asked for over and over
+    static Rasterized rasterize(FT_Face face, uint64_t key)
+    {
+        Rasterized result;
+        result.key = key;
+        result.size = glm::ivec2(0);
+        result.bearing = glm::ivec2(0);
+        result.advance = 0.0f;
+        result.lineMetrics = LineMetrics();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        bool sized = face && !FT_Set_Pixel_Sizes(face, 0, static_cast<FT_UInt>((key >> 32) & 0xFFFF));
+        if (sized)
+        {
+            // the size metrics are in 1/64th pixels as well
+            result.lineMetrics.ascent = static_cast<float>(face->size->metrics.ascender >> 6);
+            result.lineMetrics.lineHeight = static_cast<float>(face->size->metrics.height >> 6);
+        }
+        if (sized && !FT_Load_Char(face, static_cast<FT_ULong>(key & 0xFFFFFFFF), FT_LOAD_RENDER))
+        {
+            FT_GlyphSlot slot = face->glyph;
+            result.size = glm::ivec2(slot->bitmap.width, slot->bitmap.rows);
+            result.bearing = glm::ivec2(slot->bitmap_left, slot->bitmap_top);
+            // advance is in 1/64th pixels
+            result.advance = static_cast<float>(slot->advance.x >> 6);
+            result.bitmap.resize(static_cast<size_t>(result.size.x) * result.size.y);
+            for (int row = 0; row < result.size.y; row++)
+                std::memcpy(&result.bitmap[static_cast<size_t>(row) * result.size.x], slot->bitmap.buffer + row * slot->bitmap.pitch, result.size.x);
+        }
+        else if (face)
+            std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
+        result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return result;
+    }
+};
+
+// LayoutText for the glyphs of one font and size in cache. Glyphs it doesn't have yet are requested and left
+// out; the cache's generation changes once they arrive, so cached layouts know to be redone.
+inline float LayoutText(GlyphCache &cache, unsigned int font, unsigned int pixelSize, const std::string &text, float x, float y, float scale, bool yDown, std::vector<TextVertex> &vertices)
+{
+    return LayoutText([&](char32_t codepoint) { return cache.GetGlyph(font, pixelSize, codepoint); }, cache.GetLineMetrics(font, pixelSize), text, x, y, scale, yDown, vertices);
+}
+
+#endif
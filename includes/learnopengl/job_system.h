@@ -0,0 +1,232 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fork/join job system for data parallel per-frame work. Every thread (the workers plus the thread
+// that calls ParallelFor) owns a fixed size deque of jobs: it pushes and pops at the back of its own
+// deque and, once that runs dry, steals from the front of the others. A job only holds a function
+// pointer, a context pointer and an index range, so running a batch never touches the heap.
+class JobSystem
+{
+public:
+    // threadCount is the total number of threads working on a batch including the caller; 0 means one per hardware thread
+    explicit JobSystem(unsigned int threadCount = 0)
+    {
+        if (threadCount == 0)
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        // queue 0 belongs to whichever outside thread is calling ParallelFor
+        m_Queues.reserve(threadCount);
+        for (unsigned int i = 0; i < threadCount; i++)
+            m_Queues.emplace_back(new JobQueue());
+        for (unsigned int i = 1; i < threadCount; i++)
+            m_Workers.emplace_back([this, i] { workerLoop(i); });
+    }
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    ~JobSystem()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_SleepMutex);
+            m_Stopping = true;
+        }
+        m_WakeCondition.notify_all();
+        for (std::thread &worker : m_Workers)
+            worker.join();
+    }
+
+    // calls body(begin, end) for consecutive ranges of at most grainSize items covering [0, count) and
+    // returns once all of them are done. The calling thread works on the batch too. Can be nested.
+    template<typename F>
+    void ParallelFor(size_t count, size_t grainSize, F &&body)
+    {
+        if (count == 0)
+            return;
+        grainSize = std::max<size_t>(grainSize, 1);
+        using Body = typename std::remove_reference<F>::type;
+        Job job;
+        job.run = [](void *context, size_t begin, size_t end) { (*static_cast<Body*>(context))(begin, end); };
+        job.context = const_cast<void*>(static_cast<const void*>(&body));
+        std::atomic<size_t> remaining(0);
+        job.remaining = &remaining;
+
+        // deal the chunks out round robin so every thread starts with local work
+        const size_t chunks = (count + grainSize - 1) / grainSize;
+        remaining.store(chunks, std::memory_order_relaxed);
+        const unsigned int self = currentQueue();
+        for (size_t chunk = 0; chunk < chunks; chunk++)
+        {
+            job.begin = chunk * grainSize;
+            job.end = std::min(count, job.begin + grainSize);
+            JobQueue &queue = *m_Queues[(self + chunk) % m_Queues.size()];
+            m_QueuedJobs.fetch_add(1, std::memory_order_release);
+            if (!queue.Push(job))
+            {
+                m_QueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+                execute(job); // queue full, just run it here
+            }
+        }
+        wakeWorkers();
+
+        // help out until the whole batch is finished
+        while (remaining.load(std::memory_order_acquire) > 0)
+        {
+            Job next;
+            if (takeJob(self, next))
+                execute(next);
+            else
+                std::this_thread::yield();
+        }
+    }
+
+    // number of threads that work on a batch, including the calling thread
+    unsigned int GetThreadCount() const { return static_cast<unsigned int>(m_Queues.size()); }
+
+    // process-wide job system, created on first use
+    static JobSystem& Shared()
+    {
+        static JobSystem jobs;
+        return jobs;
+    }
+
+private:
+    struct Job
+    {
+        void (*run)(void*, size_t, size_t) = nullptr;
+        void *context = nullptr;
+        size_t begin = 0, end = 0;
+        std::atomic<size_t> *remaining = nullptr;
+    };
+
+    // bounded deque; the owner works at the back, thieves take from the front
+    class JobQueue
+    {
+    public:
+        bool Push(const Job &job)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (m_Count == CAPACITY)
+                return false;
+            m_Jobs[(m_Front + m_Count) % CAPACITY] = job;
+            m_Count++;
+            return true;
+        }
+
+        bool Pop(Job &job)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (m_Count == 0)
+                return false;
+            m_Count--;
+            job = m_Jobs[(m_Front + m_Count) % CAPACITY];
+            return true;
+        }
+
+        bool Steal(Job &job)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (m_Count == 0)
+                return false;
+            job = m_Jobs[m_Front];
+            m_Front = (m_Front + 1) % CAPACITY;
+            m_Count--;
+            return true;
+        }
+
+    private:
+        static const size_t CAPACITY = 1024;
+        std::mutex m_Mutex;
+        Job m_Jobs[CAPACITY];
+        size_t m_Front = 0, m_Count = 0;
+    };
+
+    std::vector<std::unique_ptr<JobQueue>> m_Queues;
+    std::vector<std::thread> m_Workers;
+    std::atomic<size_t> m_QueuedJobs{0};
+    std::mutex m_SleepMutex;
+    std::condition_variable m_WakeCondition;
+    bool m_Stopping = false;
+
+    // queue of the calling thread: its own for workers, queue 0 for everybody else
+    unsigned int currentQueue() const
+    {
+        return workerIndex() < m_Queues.size() && workerOwner() == this ? workerIndex() : 0;
+    }
+
+    static unsigned int& workerIndex()
+    {
+        static thread_local unsigned int index = ~0u;
+        return index;
+    }
+
+    static const JobSystem*& workerOwner()
+    {
+        static thread_local const JobSystem *owner = nullptr;
+        return owner;
+    }
+
+    bool takeJob(unsigned int self, Job &job)
+    {
+        if (m_Queues[self]->Pop(job))
+        {
+            m_QueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+        for (size_t i = 1; i < m_Queues.size(); i++)
+        {
+            if (m_Queues[(self + i) % m_Queues.size()]->Steal(job))
+            {
+                m_QueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void execute(const Job &job)
+    {
+        job.run(job.context, job.begin, job.end);
+        job.remaining->fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    void wakeWorkers()
+    {
+        if (m_Workers.empty())
+            return;
+        {
+            // taking the lock orders this with a worker that is just about to go to sleep
+            std::lock_guard<std::mutex> lock(m_SleepMutex);
+        }
+        m_WakeCondition.notify_all();
+    }
+
+    void workerLoop(unsigned int index)
+    {
+        workerIndex() = index;
+        workerOwner() = this;
+        for (;;)
+        {
+            Job job;
+            if (takeJob(index, job))
+            {
+                execute(job);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(m_SleepMutex);
+            m_WakeCondition.wait(lock, [this] { return m_Stopping || m_QueuedJobs.load(std::memory_order_acquire) > 0; });
+            if (m_Stopping)
+                return;
+        }
+    }
+};
+#endif
@@ -7,66 +7,139 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include <learnopengl/shader.h>
+#include <learnopengl/vertex_format.h>
 
+#include <algorithm>
+#include <cmath>
 #include <string>
 #include <vector>
 using namespace std;
 
-#define MAX_BONE_INFLUENCE 4
-
-struct Vertex {
-    // position
-    glm::vec3 Position;
-    // normal
-    glm::vec3 Normal;
-    // texCoords
-    glm::vec2 TexCoords;
-    // tangent
-    glm::vec3 Tangent;
-    // bitangent
-    glm::vec3 Bitangent;
-	//bone indexes which will influence this vertex
-	int m_BoneIDs[MAX_BONE_INFLUENCE];
-	//weights from each bone
-	float m_Weights[MAX_BONE_INFLUENCE];
-};
-
 struct Texture {
     unsigned int id;
     string type;
     string path;
 };
 
+// a coarser level of detail: an index buffer into the same vertices as the full mesh
+struct MeshLod {
+    vector<unsigned int> indices;
+    float error; // largest object space distance from a vertex of the full mesh to this level's surface
+};
+
+// screen space size in pixels of one unit at distance one, for a perspective projection with the given vertical fov (radians)
+inline float LodProjectionScale(float fovy, float viewportHeight)
+{
+    return viewportHeight / (2.0f * tan(fovy * 0.5f));
+}
+
 class Mesh {
 public:
     // mesh Data
     vector<Vertex>       vertices;
     vector<unsigned int> indices;
     vector<Texture>      textures;
-    unsigned int VAO;
-
-    // constructor
-    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
+    vector<string>       samplerNames; // per texture: the sampler uniform it binds to, e.g. texture_diffuse1
+    vector<MeshLod>      lods;     // levels of detail 1..n, level 0 is indices itself
+    unsigned int VAO = 0;
+    // layout of the GPU vertex buffer; vertices above always stay in full precision
+    VertexFormat format;
+
+    // constructor; without upload the mesh only keeps its data on the CPU and can't be drawn
+    Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, VertexFormat format = VERTEX_FORMAT_FULL, vector<MeshLod> lods = vector<MeshLod>(), bool upload = true)
     {
         this->vertices = vertices;
         this->indices = indices;
         this->textures = textures;
+        this->format = format;
+        this->lods = lods;
 
+        setupSamplerNames();
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
-        setupMesh();
+        if (upload)
+            setupMesh();
     }
 
-    // render the mesh
-    void Draw(Shader &shader) 
+    // render the mesh at the given level of detail
+    void Draw(Shader &shader, unsigned int lod = 0) 
     {
         // bind appropriate textures
+        for(unsigned int i = 0; i < textures.size(); i++)
+        {
+            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
+            // now set the sampler to the correct texture unit
+            glUniform1i(glGetUniformLocation(shader.ID, samplerNames[i].c_str()), i);
+            // and finally bind the texture
+            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+        }
+        
+        // draw mesh
+        glBindVertexArray(VAO);
+        glDrawElements(GL_TRIANGLES, GetLodIndexCount(lod), GL_UNSIGNED_INT, (void*)GetLodIndexOffset(lod));
+        glBindVertexArray(0);
+
+        // always good practice to set everything back to defaults once configured.
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    unsigned int GetLodCount() const { return static_cast<unsigned int>(lods.size()) + 1; }
+
+    // number of indices to draw for a level of detail; out of range levels are clamped to the coarsest one
+    unsigned int GetLodIndexCount(unsigned int lod) const
+    {
+        lod = std::min(lod, GetLodCount() - 1);
+        return static_cast<unsigned int>(lod == 0 ? indices.size() : lods[lod - 1].indices.size());
+    }
+
+    // byte offset of a level of detail in the element buffer, for glDrawElements(Instanced)
+    size_t GetLodIndexOffset(unsigned int lod) const
+    {
+        lod = std::min(lod, GetLodCount() - 1);
+        size_t offset = 0;
+        if (lod > 0)
+            offset += indices.size();
+        for (unsigned int i = 1; i < lod; i++)
+            offset += lods[i - 1].indices.size();
+        return offset * sizeof(unsigned int);
+    }
+
+    // picks the coarsest level of detail whose simplification error stays below maxPixelError on screen, for
+    // an instance drawn at the given distance and uniform scale (see LodProjectionScale for projectionScale)
+    unsigned int SelectLod(float distance, float scale, float projectionScale, float maxPixelError = 1.0f) const
+    {
+        if (distance <= 0.0f)
+            return 0;
+        const float pixelsPerUnit = scale * projectionScale / distance;
+        unsigned int lod = 0;
+        for (unsigned int i = 0; i < lods.size(); i++)
+        {
+            if (lods[i].error * pixelsPerUnit > maxPixelError)
+                break;
+            lod = i + 1;
+        }
+        return lod;
+    }
+
+    // bytes taken by the vertex buffer on the GPU
+    size_t GetVertexBufferSize() const
+    {
+        return vertices.size() * VertexLayout::Get(format).stride;
+    }
+
+private:
+    // render data 
+    unsigned int VBO = 0, EBO = 0;
+
+    // names the textures texture_diffuseN, texture_specularN, ... once instead of on every draw
+    void setupSamplerNames()
+    {
         unsigned int diffuseNr  = 1;
         unsigned int specularNr = 1;
         unsigned int normalNr   = 1;
         unsigned int heightNr   = 1;
+        samplerNames.resize(textures.size());
         for(unsigned int i = 0; i < textures.size(); i++)
         {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
             // retrieve texture number (the N in diffuse_textureN)
             string number;
             string name = textures[i].type;
@@ -78,26 +151,10 @@ public:
                 number = std::to_string(normalNr++); // transfer unsigned int to string
              else if(name == "texture_height")
                 number = std::to_string(heightNr++); // transfer unsigned int to string
-
-            // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
-            // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+            samplerNames[i] = name + number;
         }
-        
-        // draw mesh
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-
-        // always good practice to set everything back to defaults once configured.
-        glActiveTexture(GL_TEXTURE0);
     }
 
-private:
-    // render data 
-    unsigned int VBO, EBO;
-
     // initializes all the buffer objects/arrays
     void setupMesh()
     {
@@ -111,35 +168,38 @@ private:
         glBindBuffer(GL_ARRAY_BUFFER, VBO);
         // A great thing about structs is that their memory layout is sequential for all its items.
         // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
-        // again translates to 3/2 floats which translates to a byte array.
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);  
+        // again translates to 3/2 floats which translates to a byte array. The compact formats are packed into a byte array first.
+        const VertexLayout layout = VertexLayout::Get(format);
+        if (format == VERTEX_FORMAT_FULL)
+            glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+        else
+        {
+            vector<unsigned char> packed = VertexPacking::Pack(vertices, format);
+            glBufferData(GL_ARRAY_BUFFER, packed.size(), packed.data(), GL_STATIC_DRAW);
+        }
 
+        // all levels of detail share one element buffer, level 0 first
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-
-        // set the vertex attribute pointers
-        // vertex Positions
-        glEnableVertexAttribArray(0);	
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-        // vertex normals
-        glEnableVertexAttribArray(1);	
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-        // vertex texture coords
-        glEnableVertexAttribArray(2);	
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-        // vertex tangent
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
-        // vertex bitangent
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
-		// ids
-		glEnableVertexAttribArray(5);
-		glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, m_BoneIDs));
-
-		// weights
-		glEnableVertexAttribArray(6);
-		glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_Weights));
+        if (lods.empty())
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        else
+        {
+            vector<unsigned int> allIndices(indices);
+            for (const MeshLod &lod : lods)
+                allIndices.insert(allIndices.end(), lod.indices.begin(), lod.indices.end());
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, allIndices.size() * sizeof(unsigned int), &allIndices[0], GL_STATIC_DRAW);
+        }
+
+        // set the vertex attribute pointers as described by the layout:
+        // positions, normals, texture coords, tangents, bitangents, bone ids and weights
+        for (const VertexAttribute &attribute : layout.attributes)
+        {
+            glEnableVertexAttribArray(attribute.location);
+            if (attribute.integer)
+                glVertexAttribIPointer(attribute.location, attribute.size, attribute.type, layout.stride, (void*)attribute.offset);
+            else
+                glVertexAttribPointer(attribute.location, attribute.size, attribute.type, attribute.normalized, layout.stride, (void*)attribute.offset);
+        }
         glBindVertexArray(0);
     }
 };
@@ -0,0 +1,384 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <learnopengl/mesh.h>
+#include <learnopengl/mapped_file.h>
+
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <type_traits>
+
+// bump this whenever the on-disk layout (or the Vertex struct) changes; older caches are then simply ignored and rebuilt.
+#define MESH_CACHE_VERSION 4
+
+static_assert(std::is_trivially_copyable<Vertex>::value, "Vertex must be trivially copyable to be stored in the mesh cache");
+
+// on-disk layout of a mesh cache file:
+//   MeshCacheHeader
+//   MeshCacheEntry   [meshCount]
+//   MeshCacheTexture [textureCount]
+//   MeshCacheLod     [lodCount]
+//   string table (texture types and paths, not null-terminated)
+//   per mesh: vertex array (16 byte aligned) followed by its index array and the index arrays of its levels of detail
+struct MeshCacheHeader
+{
+    char     magic[8];      // "LOGLMSH\0"
+    uint32_t version;       // MESH_CACHE_VERSION
+    uint32_t vertexStride;  // sizeof(Vertex) of the writer
+    uint64_t sourceHash;    // hash of the source model file and its material libraries
+    uint32_t importFlags;   // ASSIMP post-processing flags used for the import
+    uint32_t optimizeFlags; // MeshOptimizeFlags applied after the import
+    uint32_t meshCount;
+    uint32_t textureCount;
+    uint32_t stringTableSize;
+    uint32_t lodCount;
+    uint64_t fileSize;      // guards against truncated writes
+};
+
+struct MeshCacheEntry
+{
+    uint64_t vertexOffset;  // byte offset of the first Vertex from the start of the file
+    uint64_t indexOffset;   // byte offset of the first index from the start of the file
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t firstTexture;  // index into the MeshCacheTexture table
+    uint32_t textureCount;
+    uint32_t firstLod;      // index into the MeshCacheLod table
+    uint32_t lodCount;
+};
+
+struct MeshCacheTexture
+{
+    uint32_t typeOffset, typeLength; // into the string table
+    uint32_t pathOffset, pathLength;
+};
+
+struct MeshCacheLod
+{
+    uint64_t indexOffset;   // byte offset of the first index from the start of the file
+    uint32_t indexCount;
+    float    error;         // MeshLod::error
+};
+
+// Versioned binary cache of the flattened mesh data produced by a model import. A cache file is
+// only accepted if its version, vertex stride, source hash, import and optimize flags all match, otherwise
+// the caller falls back to a regular import and rewrites the cache. Vertex and index arrays are
+// read straight out of a memory mapping so a warm start does no parsing at all.
+class MeshCache
+{
+public:
+    // the cache file lives right next to the source model
+    static std::string GetCachePath(const std::string &modelPath)
+    {
+        return modelPath + ".meshcache";
+    }
+
+    // 64-bit FNV-1a hash over the contents of a file, returns 0 if the file can't be read.
+    static uint64_t HashFile(const std::string &path)
+    {
+        MappedFile file;
+        if (!file.Open(path))
+            return 0;
+        return HashBytes(file.Data(), file.Size());
+    }
+
+    // hash of everything an import of modelPath reads: the model file and, for OBJ files, the material
+    // libraries it names with mtllib. Editing a .mtl therefore invalidates the cache just like editing
+    // the model does. Returns 0 if the model itself can't be read.
+    static uint64_t HashSource(const std::string &modelPath)
+    {
+        MappedFile file;
+        if (!file.Open(modelPath))
+            return 0;
+        uint64_t hash = HashBytes(file.Data(), file.Size());
+        if (!hasExtension(modelPath, ".obj"))
+            return hash;
+
+        const std::string directory = modelPath.substr(0, modelPath.find_last_of('/') + 1);
+        for (const std::string &library : findMaterialLibraries(reinterpret_cast<const char*>(file.Data()), file.Size()))
+        {
+            // the name goes into the hash as well, so a library that appears or disappears changes it too
+            hash = HashBytes(library.data(), library.size(), hash);
+            MappedFile material;
+            if (material.Open(directory + library))
+                hash = HashBytes(material.Data(), material.Size(), hash);
+        }
+        return hash;
+    }
+
+    static uint64_t HashBytes(const void *data, size_t size, uint64_t hash = 14695981039346656037ull)
+    {
+        const unsigned char *bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // maps the cache file and validates it against the given source hash/import flags/optimize flags.
+    bool Open(const std::string &cachePath, uint64_t sourceHash, uint32_t importFlags, uint32_t optimizeFlags)
+    {
+        if (sourceHash == 0 || !m_File.Open(cachePath))
+            return false;
+        if (m_File.Size() < sizeof(MeshCacheHeader))
+            return fail();
+        m_Header = reinterpret_cast<const MeshCacheHeader*>(m_File.Data());
+        if (std::memcmp(m_Header->magic, "LOGLMSH", 8) != 0 ||
+            m_Header->version != MESH_CACHE_VERSION ||
+            m_Header->vertexStride != sizeof(Vertex) ||
+            m_Header->sourceHash != sourceHash ||
+            m_Header->importFlags != importFlags ||
+            m_Header->optimizeFlags != optimizeFlags ||
+            m_Header->fileSize != m_File.Size())
+            return fail();
+
+        const size_t tablesSize = sizeof(MeshCacheHeader) + m_Header->meshCount * sizeof(MeshCacheEntry) +
+            m_Header->textureCount * sizeof(MeshCacheTexture) + m_Header->lodCount * sizeof(MeshCacheLod) + m_Header->stringTableSize;
+        if (tablesSize > m_File.Size())
+            return fail();
+        m_Meshes = reinterpret_cast<const MeshCacheEntry*>(m_File.Data() + sizeof(MeshCacheHeader));
+        m_Textures = reinterpret_cast<const MeshCacheTexture*>(m_Meshes + m_Header->meshCount);
+        m_Lods = reinterpret_cast<const MeshCacheLod*>(m_Textures + m_Header->textureCount);
+        m_Strings = reinterpret_cast<const char*>(m_Lods + m_Header->lodCount);
+
+        // make sure every range we hand out later lies within the file
+        for (unsigned int i = 0; i < m_Header->meshCount; i++)
+        {
+            const MeshCacheEntry &entry = m_Meshes[i];
+            if (entry.vertexOffset + uint64_t(entry.vertexCount) * sizeof(Vertex) > m_File.Size() ||
+                entry.indexOffset + uint64_t(entry.indexCount) * sizeof(unsigned int) > m_File.Size() ||
+                uint64_t(entry.firstTexture) + entry.textureCount > m_Header->textureCount ||
+                uint64_t(entry.firstLod) + entry.lodCount > m_Header->lodCount)
+                return fail();
+        }
+        for (unsigned int i = 0; i < m_Header->lodCount; i++)
+        {
+            if (m_Lods[i].indexOffset + uint64_t(m_Lods[i].indexCount) * sizeof(unsigned int) > m_File.Size())
+                return fail();
+        }
+        for (unsigned int i = 0; i < m_Header->textureCount; i++)
+        {
+            const MeshCacheTexture &texture = m_Textures[i];
+            if (uint64_t(texture.typeOffset) + texture.typeLength > m_Header->stringTableSize ||
+                uint64_t(texture.pathOffset) + texture.pathLength > m_Header->stringTableSize)
+                return fail();
+        }
+        return true;
+    }
+
+    unsigned int GetMeshCount() const { return m_Header ? m_Header->meshCount : 0; }
+    const MeshCacheEntry& GetMesh(unsigned int mesh) const { return m_Meshes[mesh]; }
+
+    const Vertex* GetVertices(unsigned int mesh) const
+    {
+        return reinterpret_cast<const Vertex*>(m_File.Data() + m_Meshes[mesh].vertexOffset);
+    }
+
+    const unsigned int* GetIndices(unsigned int mesh) const
+    {
+        return reinterpret_cast<const unsigned int*>(m_File.Data() + m_Meshes[mesh].indexOffset);
+    }
+
+    const MeshCacheLod& GetLod(unsigned int mesh, unsigned int lod) const { return m_Lods[m_Meshes[mesh].firstLod + lod]; }
+
+    const unsigned int* GetLodIndices(unsigned int mesh, unsigned int lod) const
+    {
+        return reinterpret_cast<const unsigned int*>(m_File.Data() + GetLod(mesh, lod).indexOffset);
+    }
+
+    std::string GetTextureType(unsigned int mesh, unsigned int texture) const
+    {
+        const MeshCacheTexture &tex = m_Textures[m_Meshes[mesh].firstTexture + texture];
+        return std::string(m_Strings + tex.typeOffset, tex.typeLength);
+    }
+
+    std::string GetTexturePath(unsigned int mesh, unsigned int texture) const
+    {
+        const MeshCacheTexture &tex = m_Textures[m_Meshes[mesh].firstTexture + texture];
+        return std::string(m_Strings + tex.pathOffset, tex.pathLength);
+    }
+
+    // writes the flattened meshes of a freshly imported model. A failed write (e.g. read-only
+    // resource directory) is not an error, the model is simply imported again next time.
+    static bool Write(const std::string &cachePath, uint64_t sourceHash, uint32_t importFlags, uint32_t optimizeFlags, const std::vector<Mesh> &meshes)
+    {
+        if (sourceHash == 0)
+            return false;
+
+        MeshCacheHeader header = {};
+        std::memcpy(header.magic, "LOGLMSH", 8);
+        header.version = MESH_CACHE_VERSION;
+        header.vertexStride = sizeof(Vertex);
+        header.sourceHash = sourceHash;
+        header.importFlags = importFlags;
+        header.optimizeFlags = optimizeFlags;
+        header.meshCount = static_cast<uint32_t>(meshes.size());
+
+        // build the texture table and string table
+        std::vector<MeshCacheEntry> entries(meshes.size());
+        std::vector<MeshCacheTexture> textures;
+        std::vector<MeshCacheLod> lods;
+        std::string strings;
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            entries[i].vertexCount = static_cast<uint32_t>(meshes[i].vertices.size());
+            entries[i].indexCount = static_cast<uint32_t>(meshes[i].indices.size());
+            entries[i].firstTexture = static_cast<uint32_t>(textures.size());
+            entries[i].textureCount = static_cast<uint32_t>(meshes[i].textures.size());
+            entries[i].firstLod = static_cast<uint32_t>(lods.size());
+            entries[i].lodCount = static_cast<uint32_t>(meshes[i].lods.size());
+            for (const MeshLod &lod : meshes[i].lods)
+            {
+                MeshCacheLod cached = {};
+                cached.indexCount = static_cast<uint32_t>(lod.indices.size());
+                cached.error = lod.error;
+                lods.push_back(cached);
+            }
+            for (const Texture &texture : meshes[i].textures)
+            {
+                MeshCacheTexture tex;
+                tex.typeOffset = static_cast<uint32_t>(strings.size());
+                tex.typeLength = static_cast<uint32_t>(texture.type.size());
+                strings += texture.type;
+                tex.pathOffset = static_cast<uint32_t>(strings.size());
+                tex.pathLength = static_cast<uint32_t>(texture.path.size());
+                strings += texture.path;
+                textures.push_back(tex);
+            }
+        }
+        header.textureCount = static_cast<uint32_t>(textures.size());
+        header.stringTableSize = static_cast<uint32_t>(strings.size());
+        header.lodCount = static_cast<uint32_t>(lods.size());
+
+        // lay out the vertex/index arrays after the tables
+        const uint64_t tablesSize = sizeof(MeshCacheHeader) + entries.size() * sizeof(MeshCacheEntry) +
+            textures.size() * sizeof(MeshCacheTexture) + lods.size() * sizeof(MeshCacheLod) + strings.size();
+        uint64_t offset = tablesSize;
+        for (MeshCacheEntry &entry : entries)
+        {
+            entry.vertexOffset = align(offset);
+            entry.indexOffset = align(entry.vertexOffset + uint64_t(entry.vertexCount) * sizeof(Vertex));
+            offset = entry.indexOffset + uint64_t(entry.indexCount) * sizeof(unsigned int);
+            for (uint32_t i = 0; i < entry.lodCount; i++)
+            {
+                MeshCacheLod &lod = lods[entry.firstLod + i];
+                lod.indexOffset = offset; // indices are 4 byte aligned already
+                offset += uint64_t(lod.indexCount) * sizeof(unsigned int);
+            }
+        }
+        header.fileSize = offset;
+
+        // write to a temporary file first so a reader never sees a half-written cache
+        const std::string tempPath = cachePath + ".tmp";
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            if (!out)
+                return false;
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(MeshCacheEntry));
+            out.write(reinterpret_cast<const char*>(textures.data()), textures.size() * sizeof(MeshCacheTexture));
+            out.write(reinterpret_cast<const char*>(lods.data()), lods.size() * sizeof(MeshCacheLod));
+            out.write(strings.data(), strings.size());
+            uint64_t written = tablesSize;
+            for (size_t i = 0; i < meshes.size(); i++)
+            {
+                pad(out, written, entries[i].vertexOffset);
+                out.write(reinterpret_cast<const char*>(meshes[i].vertices.data()), meshes[i].vertices.size() * sizeof(Vertex));
+                written += meshes[i].vertices.size() * sizeof(Vertex);
+                pad(out, written, entries[i].indexOffset);
+                out.write(reinterpret_cast<const char*>(meshes[i].indices.data()), meshes[i].indices.size() * sizeof(unsigned int));
+                written += meshes[i].indices.size() * sizeof(unsigned int);
+                for (const MeshLod &lod : meshes[i].lods)
+                {
+                    out.write(reinterpret_cast<const char*>(lod.indices.data()), lod.indices.size() * sizeof(unsigned int));
+                    written += lod.indices.size() * sizeof(unsigned int);
+                }
+            }
+            if (!out)
+            {
+                out.close();
+                std::remove(tempPath.c_str());
+                return false;
+            }
+        }
+        std::remove(cachePath.c_str());
+        return std::rename(tempPath.c_str(), cachePath.c_str()) == 0;
+    }
+
+private:
+    MappedFile m_File;
+    const MeshCacheHeader *m_Header = nullptr;
+    const MeshCacheEntry *m_Meshes = nullptr;
+    const MeshCacheTexture *m_Textures = nullptr;
+    const MeshCacheLod *m_Lods = nullptr;
+    const char *m_Strings = nullptr;
+
+    bool fail()
+    {
+        m_File.Close();
+        m_Header = nullptr;
+        return false;
+    }
+
+    static bool hasExtension(const std::string &path, const char *extension)
+    {
+        const size_t length = std::strlen(extension);
+        if (path.size() < length)
+            return false;
+        for (size_t i = 0; i < length; i++)
+            if (std::tolower(static_cast<unsigned char>(path[path.size() - length + i])) != extension[i])
+                return false;
+        return true;
+    }
+
+    // the file names of every "mtllib a.mtl b.mtl" statement in an OBJ file
+    static std::vector<std::string> findMaterialLibraries(const char *data, size_t size)
+    {
+        std::vector<std::string> libraries;
+        size_t lineStart = 0;
+        while (lineStart < size)
+        {
+            const char *lineEndPtr = static_cast<const char*>(std::memchr(data + lineStart, '\n', size - lineStart));
+            const size_t lineEnd = lineEndPtr ? static_cast<size_t>(lineEndPtr - data) : size;
+            size_t pos = lineStart;
+            while (pos < lineEnd && (data[pos] == ' ' || data[pos] == '\t'))
+                pos++;
+            if (lineEnd - pos > 7 && std::memcmp(data + pos, "mtllib", 6) == 0 && (data[pos + 6] == ' ' || data[pos + 6] == '\t'))
+            {
+                pos += 6;
+                while (pos < lineEnd)
+                {
+                    while (pos < lineEnd && std::isspace(static_cast<unsigned char>(data[pos])))
+                        pos++;
+                    const size_t nameStart = pos;
+                    while (pos < lineEnd && !std::isspace(static_cast<unsigned char>(data[pos])))
+                        pos++;
+                    if (pos > nameStart)
+                        libraries.push_back(std::string(data + nameStart, pos - nameStart));
+                }
+            }
+            lineStart = lineEnd + 1;
+        }
+        return libraries;
+    }
+
+    static uint64_t align(uint64_t offset)
+    {
+        return (offset + 15) & ~uint64_t(15);
+    }
+
+    static void pad(std::ofstream &out, uint64_t &written, uint64_t target)
+    {
+        static const char zeros[16] = {};
+        out.write(zeros, static_cast<std::streamsize>(target - written));
+        written = target;
+    }
+};
+#endif
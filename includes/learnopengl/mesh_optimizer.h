@@ -0,0 +1,272 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <learnopengl/vertex_format.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+// optional steps run on freshly imported meshes, before they are uploaded or written to the mesh cache.
+enum MeshOptimizeFlags {
+    MESH_OPTIMIZE_NONE         = 0,
+    MESH_OPTIMIZE_WELD         = 1 << 0, // merge bit-identical vertices
+    MESH_OPTIMIZE_VERTEX_CACHE = 1 << 1, // reorder triangles for the post-transform vertex cache
+    MESH_OPTIMIZE_VERTEX_FETCH = 1 << 2, // reorder vertices in the order they are first used
+    MESH_OPTIMIZE_LODS         = 1 << 3, // build simplified levels of detail (see MeshSimplifier), implies welding
+    MESH_OPTIMIZE_ALL          = MESH_OPTIMIZE_WELD | MESH_OPTIMIZE_VERTEX_CACHE | MESH_OPTIMIZE_VERTEX_FETCH | MESH_OPTIMIZE_LODS
+};
+
+// efficiency of an index buffer with a simulated FIFO post-transform cache
+struct VertexCacheStats {
+    unsigned int transformedVertices = 0; // cache misses
+    unsigned int triangles = 0;
+    unsigned int referencedVertices = 0;  // distinct vertices used by the index buffer
+    float acmr = 0.0f;                    // average cache miss ratio: transformed vertices per triangle (0.5 is ideal)
+    float atvr = 0.0f;                    // average transform to vertex ratio: transformed vertices per vertex (1.0 is ideal)
+};
+
+// Index and vertex buffer optimizations done once at import time.
+// Triangle reordering follows Tom Forsyth's "Linear-Speed Vertex Cache Optimisation".
+class MeshOptimizer
+{
+public:
+    // runs the requested steps in the order weld, vertex cache, vertex fetch; levels of detail are built by the caller
+    static void Optimize(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices, unsigned int flags)
+    {
+        // simplification needs shared vertices to find the mesh topology
+        if (flags & (MESH_OPTIMIZE_WELD | MESH_OPTIMIZE_LODS))
+            WeldVertices(vertices, indices);
+        if (flags & MESH_OPTIMIZE_VERTEX_CACHE)
+            OptimizeVertexCache(indices, vertices.size());
+        if (flags & MESH_OPTIMIZE_VERTEX_FETCH)
+            OptimizeVertexFetch(vertices, indices);
+    }
+
+    // merges vertices whose attributes are bit-for-bit identical and rewrites the indices accordingly
+    static void WeldVertices(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices)
+    {
+        std::unordered_map<VertexKey, unsigned int, VertexKeyHash> unique;
+        unique.reserve(vertices.size());
+        std::vector<unsigned int> remap(vertices.size());
+        std::vector<Vertex> welded;
+        welded.reserve(vertices.size());
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            auto result = unique.emplace(VertexKey{ &vertices[i] }, static_cast<unsigned int>(welded.size()));
+            if (result.second)
+                welded.push_back(vertices[i]);
+            remap[i] = result.first->second;
+        }
+        if (welded.size() == vertices.size())
+            return;
+        for (unsigned int &index : indices)
+            index = remap[index];
+        vertices.swap(welded);
+    }
+
+    // reorders the triangles of an indexed triangle list to maximize post-transform cache hits
+    static void OptimizeVertexCache(std::vector<unsigned int> &indices, size_t vertexCount)
+    {
+        const size_t triangleCount = indices.size() / 3;
+        if (triangleCount == 0 || vertexCount == 0)
+            return;
+
+        // triangle adjacency per vertex
+        std::vector<unsigned int> valence(vertexCount, 0);
+        for (unsigned int index : indices)
+            valence[index]++;
+        std::vector<unsigned int> adjacencyOffset(vertexCount + 1, 0);
+        for (size_t v = 0; v < vertexCount; v++)
+            adjacencyOffset[v + 1] = adjacencyOffset[v] + valence[v];
+        std::vector<unsigned int> adjacency(indices.size());
+        std::vector<unsigned int> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+        for (size_t t = 0; t < triangleCount; t++)
+            for (int k = 0; k < 3; k++)
+                adjacency[fill[indices[t * 3 + k]]++] = static_cast<unsigned int>(t);
+
+        // live triangle count and score per vertex, score per triangle
+        std::vector<unsigned int> liveTriangles(valence);
+        std::vector<float> vertexScore(vertexCount);
+        for (size_t v = 0; v < vertexCount; v++)
+            vertexScore[v] = scoreVertex(-1, liveTriangles[v]);
+        std::vector<float> triangleScore(triangleCount);
+        for (size_t t = 0; t < triangleCount; t++)
+            triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+        std::vector<bool> emitted(triangleCount, false);
+
+        std::vector<unsigned int> result;
+        result.reserve(indices.size());
+        std::vector<unsigned int> cache, nextCache;
+        cache.reserve(FORSYTH_CACHE_SIZE + 3);
+        nextCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+        size_t scanCursor = 0;
+        int bestTriangle = -1;
+        float bestScore = -1.0f;
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            if (triangleScore[t] > bestScore)
+            {
+                bestScore = triangleScore[t];
+                bestTriangle = static_cast<int>(t);
+            }
+        }
+
+        while (bestTriangle >= 0)
+        {
+            // emit the triangle and take it out of its vertices' live counts
+            const unsigned int *tri = &indices[bestTriangle * 3];
+            result.insert(result.end(), tri, tri + 3);
+            emitted[bestTriangle] = true;
+            for (int k = 0; k < 3; k++)
+                liveTriangles[tri[k]]--;
+
+            // its vertices move to the front of the LRU cache
+            nextCache.assign(tri, tri + 3);
+            for (unsigned int v : cache)
+                if (v != tri[0] && v != tri[1] && v != tri[2])
+                    nextCache.push_back(v);
+            cache.swap(nextCache);
+
+            // rescore everything that is (or just fell out of) the cache
+            for (size_t i = 0; i < cache.size(); i++)
+            {
+                const unsigned int v = cache[i];
+                const int position = i < FORSYTH_CACHE_SIZE ? static_cast<int>(i) : -1;
+                const float score = scoreVertex(position, liveTriangles[v]);
+                const float delta = score - vertexScore[v];
+                vertexScore[v] = score;
+                for (unsigned int a = adjacencyOffset[v]; a < adjacencyOffset[v + 1]; a++)
+                    triangleScore[adjacency[a]] += delta;
+            }
+            if (cache.size() > FORSYTH_CACHE_SIZE)
+                cache.resize(FORSYTH_CACHE_SIZE);
+
+            // the next triangle is the best one touching the cache
+            bestTriangle = -1;
+            bestScore = -1.0f;
+            for (unsigned int v : cache)
+            {
+                for (unsigned int a = adjacencyOffset[v]; a < adjacencyOffset[v + 1]; a++)
+                {
+                    const unsigned int t = adjacency[a];
+                    if (!emitted[t] && triangleScore[t] > bestScore)
+                    {
+                        bestScore = triangleScore[t];
+                        bestTriangle = static_cast<int>(t);
+                    }
+                }
+            }
+            // dead end: continue with the next triangle that hasn't been emitted yet
+            if (bestTriangle < 0)
+            {
+                while (scanCursor < triangleCount && emitted[scanCursor])
+                    scanCursor++;
+                if (scanCursor < triangleCount)
+                    bestTriangle = static_cast<int>(scanCursor);
+            }
+        }
+        // leftover indices of a malformed (non multiple of 3) list are kept at the end
+        result.insert(result.end(), indices.begin() + triangleCount * 3, indices.end());
+        indices.swap(result);
+    }
+
+    // renumbers vertices in the order the index buffer first references them; unreferenced vertices are dropped
+    static void OptimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices)
+    {
+        const unsigned int unused = ~0u;
+        std::vector<unsigned int> remap(vertices.size(), unused);
+        std::vector<Vertex> ordered;
+        ordered.reserve(vertices.size());
+        for (unsigned int &index : indices)
+        {
+            if (remap[index] == unused)
+            {
+                remap[index] = static_cast<unsigned int>(ordered.size());
+                ordered.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+        vertices.swap(ordered);
+    }
+
+    // simulates a FIFO post-transform cache of the given size over the index buffer
+    static VertexCacheStats AnalyzeVertexCache(const std::vector<unsigned int> &indices, size_t vertexCount, unsigned int cacheSize = 16)
+    {
+        VertexCacheStats stats;
+        stats.triangles = static_cast<unsigned int>(indices.size() / 3);
+        // a vertex is in the cache while fewer than cacheSize misses happened since it was loaded;
+        // loadedAt holds the 1-based number of the miss that loaded it, 0 means never loaded
+        std::vector<unsigned int> loadedAt(vertexCount, 0);
+        std::vector<bool> referenced(vertexCount, false);
+        for (unsigned int index : indices)
+        {
+            if (!referenced[index])
+            {
+                referenced[index] = true;
+                stats.referencedVertices++;
+            }
+            if (loadedAt[index] == 0 || stats.transformedVertices - loadedAt[index] >= cacheSize)
+            {
+                stats.transformedVertices++;
+                loadedAt[index] = stats.transformedVertices;
+            }
+        }
+        if (stats.triangles > 0)
+            stats.acmr = static_cast<float>(stats.transformedVertices) / stats.triangles;
+        if (stats.referencedVertices > 0)
+            stats.atvr = static_cast<float>(stats.transformedVertices) / stats.referencedVertices;
+        return stats;
+    }
+
+private:
+    static const size_t FORSYTH_CACHE_SIZE = 32;
+
+    // vertex score from its position in the simulated LRU cache and its remaining triangles
+    static float scoreVertex(int cachePosition, unsigned int liveTriangles)
+    {
+        if (liveTriangles == 0)
+            return -1.0f; // no triangles left, never pick this vertex again
+        float score = 0.0f;
+        if (cachePosition >= 0)
+        {
+            if (cachePosition < 3)
+                score = 0.75f; // part of the last triangle; fixed score so strips don't get favoured too much
+            else
+                score = std::pow(1.0f - float(cachePosition - 3) / float(FORSYTH_CACHE_SIZE - 3), 1.5f);
+        }
+        // boost vertices with few triangles left so lone triangles get cleared away
+        score += 2.0f / std::sqrt(static_cast<float>(liveTriangles));
+        return score;
+    }
+
+    struct VertexKey
+    {
+        const Vertex *vertex;
+        bool operator==(const VertexKey &other) const
+        {
+            return std::memcmp(vertex, other.vertex, sizeof(Vertex)) == 0;
+        }
+    };
+
+    struct VertexKeyHash
+    {
+        size_t operator()(const VertexKey &key) const
+        {
+            // FNV-1a over the raw vertex bytes
+            const unsigned char *bytes = reinterpret_cast<const unsigned char*>(key.vertex);
+            uint64_t hash = 14695981039346656037ull;
+            for (size_t i = 0; i < sizeof(Vertex); i++)
+            {
+                hash ^= bytes[i];
+                hash *= 1099511628211ull;
+            }
+            return static_cast<size_t>(hash);
+        }
+    };
+};
+#endif
@@ -0,0 +1,404 @@
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include <learnopengl/vertex_format.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+// Quadric error metric (Garland & Heckbert) mesh simplification by edge collapse.
+// Vertices are only ever collapsed onto one of their neighbours, so a simplified mesh is just a
+// new index buffer into the original vertex buffer and all levels of detail can share one VBO.
+// Vertices on open borders and on attribute seams (several vertices at the same position) are
+// locked so that the silhouette and texture mapping stay intact.
+class MeshSimplifier
+{
+public:
+    // reduces the index buffer towards targetIndexCount without collapsing any edge whose quadric error
+    // (the root mean squared distance to the planes of the triangles merged into it) exceeds maxError.
+    // Returns the new index buffer; resultError receives the largest distance from any vertex of the
+    // original mesh to the simplified surface (what MeasureDistance computes by brute force), which can
+    // exceed maxError a little since the quadrics only measure distances to planes.
+    static std::vector<unsigned int> Simplify(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices,
+                                              size_t targetIndexCount, float maxError, float *resultError = nullptr)
+    {
+        std::vector<unsigned int> result(indices.begin(), indices.begin() + indices.size() / 3 * 3);
+        const size_t vertexCount = vertices.size();
+        if (vertexCount == 0 || result.size() <= targetIndexCount)
+        {
+            if (resultError)
+                *resultError = 0.0f;
+            return result;
+        }
+        const std::vector<unsigned int> original(result);
+
+        std::vector<unsigned char> kind = classifyVertices(vertices, result);
+        std::vector<Quadric> quadrics(vertexCount);
+        for (size_t i = 0; i < result.size(); i += 3)
+        {
+            const Quadric plane = Quadric::FromTriangle(vertices[result[i]].Position, vertices[result[i + 1]].Position, vertices[result[i + 2]].Position);
+            for (int k = 0; k < 3; k++)
+                quadrics[result[i + k]].Add(plane);
+        }
+
+        const double maxErrorSquared = double(maxError) * double(maxError);
+        std::vector<unsigned int> collapse(vertexCount);
+        std::vector<unsigned char> touched(vertexCount);
+        std::vector<Collapse> candidates;
+        std::vector<unsigned int> triangleOffset, triangleList;
+
+        while (result.size() > targetIndexCount)
+        {
+            buildVertexTriangles(result, vertexCount, triangleOffset, triangleList);
+
+            // every edge gives up to two candidates, one per direction
+            candidates.clear();
+            for (size_t i = 0; i < result.size(); i += 3)
+            {
+                for (int k = 0; k < 3; k++)
+                {
+                    const unsigned int a = result[i + k], b = result[i + (k + 1) % 3];
+                    if (kind[a] == KIND_MANIFOLD)
+                        candidates.push_back({ a, b, quadrics[a].Evaluate(vertices[b].Position) });
+                    if (kind[b] == KIND_MANIFOLD)
+                        candidates.push_back({ b, a, quadrics[b].Evaluate(vertices[a].Position) });
+                }
+            }
+            if (candidates.empty())
+                break;
+            std::sort(candidates.begin(), candidates.end(), [](const Collapse &l, const Collapse &r) { return l.error < r.error; });
+
+            // collapse the cheapest edges whose neighbourhoods don't overlap within this pass
+            for (size_t v = 0; v < vertexCount; v++)
+                collapse[v] = static_cast<unsigned int>(v);
+            std::fill(touched.begin(), touched.end(), 0);
+            const size_t trianglesToRemove = (result.size() - targetIndexCount) / 3;
+            size_t removed = 0;
+            for (const Collapse &candidate : candidates)
+            {
+                if (candidate.error > maxErrorSquared || removed >= trianglesToRemove)
+                    break;
+                if (touched[candidate.from] || touched[candidate.to])
+                    continue;
+                if (flipsTriangle(vertices, result, triangleOffset, triangleList, candidate.from, candidate.to))
+                    continue;
+
+                collapse[candidate.from] = candidate.to;
+                quadrics[candidate.to].Add(quadrics[candidate.from]);
+                // lock the one-ring of the collapsed vertex for the rest of this pass
+                for (unsigned int t = triangleOffset[candidate.from]; t < triangleOffset[candidate.from + 1]; t++)
+                {
+                    const unsigned int triangle = triangleList[t];
+                    for (int k = 0; k < 3; k++)
+                    {
+                        const unsigned int corner = result[triangle * 3 + k];
+                        touched[corner] = 1;
+                        if (corner == candidate.to)
+                            removed++; // the triangles that share the edge vanish
+                    }
+                }
+            }
+            if (removed == 0)
+                break;
+
+            // apply the collapses and drop degenerate triangles
+            size_t write = 0;
+            for (size_t i = 0; i < result.size(); i += 3)
+            {
+                const unsigned int a = collapse[result[i]], b = collapse[result[i + 1]], c = collapse[result[i + 2]];
+                if (a == b || b == c || a == c)
+                    continue;
+                result[write++] = a;
+                result[write++] = b;
+                result[write++] = c;
+            }
+            result.resize(write);
+        }
+        if (resultError)
+            *resultError = SurfaceDistance(vertices, original, result);
+        return result;
+    }
+
+    // largest distance from any vertex used by the original index buffer to the surface of the simplified one;
+    // brute force, meant for checking the error bound of Simplify on small meshes
+    static float MeasureDistance(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &original, const std::vector<unsigned int> &simplified)
+    {
+        float worst = 0.0f;
+        std::vector<unsigned char> used(vertices.size(), 0);
+        for (unsigned int index : original)
+            used[index] = 1;
+        for (size_t v = 0; v < vertices.size(); v++)
+        {
+            if (!used[v])
+                continue;
+            float closest = INFINITY;
+            for (size_t i = 0; i + 2 < simplified.size(); i += 3)
+                closest = std::min(closest, pointTriangleDistance(vertices[v].Position, vertices[simplified[i]].Position,
+                                                                  vertices[simplified[i + 1]].Position, vertices[simplified[i + 2]].Position));
+            worst = std::max(worst, closest);
+        }
+        return worst;
+    }
+
+    // the same distance as MeasureDistance, with the simplified triangles sorted into a uniform grid so each
+    // vertex only visits the cells around it, nearest first, until no cell can hold a closer triangle
+    static float SurfaceDistance(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &original, const std::vector<unsigned int> &simplified)
+    {
+        const size_t triangleCount = simplified.size() / 3;
+        if (triangleCount == 0)
+            return original.empty() ? 0.0f : INFINITY;
+        glm::vec3 gridMin = vertices[simplified[0]].Position, gridMax = gridMin;
+        for (unsigned int index : simplified)
+        {
+            gridMin = glm::min(gridMin, vertices[index].Position);
+            gridMax = glm::max(gridMax, vertices[index].Position);
+        }
+        // about one triangle per cell along the surface
+        const int resolution = std::max(1, std::min(64, static_cast<int>(std::sqrt(static_cast<float>(triangleCount)))));
+        const glm::vec3 cellSize = glm::max((gridMax - gridMin) / static_cast<float>(resolution), glm::vec3(1e-6f));
+        const float minCellSize = std::min(cellSize.x, std::min(cellSize.y, cellSize.z));
+        auto cellOf = [&](const glm::vec3 &p) {
+            return glm::clamp(glm::ivec3(glm::floor((p - gridMin) / cellSize)), glm::ivec3(0), glm::ivec3(resolution - 1));
+        };
+        auto cellIndex = [&](int x, int y, int z) { return (static_cast<size_t>(z) * resolution + y) * resolution + x; };
+
+        // every triangle goes into all cells its bounding box touches
+        const size_t cellCount = static_cast<size_t>(resolution) * resolution * resolution;
+        std::vector<unsigned int> cellOffset(cellCount + 1, 0), cellTriangles;
+        for (int pass = 0; pass < 2; pass++)
+        {
+            std::vector<unsigned int> fill(cellOffset.begin(), cellOffset.end() - 1);
+            for (size_t t = 0; t < triangleCount; t++)
+            {
+                const glm::vec3 &a = vertices[simplified[t * 3]].Position, &b = vertices[simplified[t * 3 + 1]].Position, &c = vertices[simplified[t * 3 + 2]].Position;
+                const glm::ivec3 lo = cellOf(glm::min(a, glm::min(b, c))), hi = cellOf(glm::max(a, glm::max(b, c)));
+                for (int z = lo.z; z <= hi.z; z++)
+                    for (int y = lo.y; y <= hi.y; y++)
+                        for (int x = lo.x; x <= hi.x; x++)
+                        {
+                            if (pass == 0)
+                                cellOffset[cellIndex(x, y, z) + 1]++;
+                            else
+                                cellTriangles[fill[cellIndex(x, y, z)]++] = static_cast<unsigned int>(t);
+                        }
+            }
+            if (pass == 0)
+            {
+                for (size_t i = 0; i < cellCount; i++)
+                    cellOffset[i + 1] += cellOffset[i];
+                cellTriangles.resize(cellOffset[cellCount]);
+            }
+        }
+
+        std::vector<unsigned char> used(vertices.size(), 0);
+        for (unsigned int index : original)
+            used[index] = 1;
+        std::vector<size_t> visited(triangleCount, 0); // stamp of the last vertex that measured each triangle
+        float worst = 0.0f;
+        for (size_t v = 0; v < vertices.size(); v++)
+        {
+            if (!used[v])
+                continue;
+            const glm::vec3 &p = vertices[v].Position;
+            const glm::ivec3 center = cellOf(p);
+            float closest = INFINITY;
+            // cells r steps away from the center cell are at least (r - 1) cells away from p
+            for (int ring = 0; ring < resolution && closest > (ring - 1) * minCellSize; ring++)
+            {
+                const glm::ivec3 lo = glm::max(center - ring, glm::ivec3(0)), hi = glm::min(center + ring, glm::ivec3(resolution - 1));
+                for (int z = lo.z; z <= hi.z; z++)
+                    for (int y = lo.y; y <= hi.y; y++)
+                        for (int x = lo.x; x <= hi.x; x++)
+                        {
+                            const glm::ivec3 d = glm::abs(glm::ivec3(x, y, z) - center);
+                            if (std::max(d.x, std::max(d.y, d.z)) != ring)
+                                continue; // visited in an earlier ring
+                            const size_t cell = cellIndex(x, y, z);
+                            for (unsigned int i = cellOffset[cell]; i < cellOffset[cell + 1]; i++)
+                            {
+                                const unsigned int t = cellTriangles[i];
+                                if (visited[t] == v + 1)
+                                    continue;
+                                visited[t] = v + 1;
+                                closest = std::min(closest, pointTriangleDistance(p, vertices[simplified[t * 3]].Position,
+                                                                                  vertices[simplified[t * 3 + 1]].Position, vertices[simplified[t * 3 + 2]].Position));
+                            }
+                        }
+            }
+            worst = std::max(worst, closest);
+        }
+        return worst;
+    }
+
+private:
+    enum VertexKind {
+        KIND_MANIFOLD, // interior vertex, free to collapse
+        KIND_LOCKED    // border or seam vertex, only used as a collapse target
+    };
+
+    struct Collapse
+    {
+        unsigned int from, to;
+        double error;
+    };
+
+    // symmetric 4x4 matrix of a sum of squared plane distances
+    struct Quadric
+    {
+        double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0;
+
+        // plane of the triangle weighted by its area
+        static Quadric FromTriangle(const glm::vec3 &p0, const glm::vec3 &p1, const glm::vec3 &p2)
+        {
+            Quadric q;
+            const glm::dvec3 n = glm::cross(glm::dvec3(p1) - glm::dvec3(p0), glm::dvec3(p2) - glm::dvec3(p0));
+            const double length = glm::length(n);
+            if (length <= 0.0)
+                return q;
+            const glm::dvec3 unit = n / length;
+            const double d = -glm::dot(unit, glm::dvec3(p0));
+            const double w = length * 0.5;
+            q.a2 = w * unit.x * unit.x; q.ab = w * unit.x * unit.y; q.ac = w * unit.x * unit.z; q.ad = w * unit.x * d;
+            q.b2 = w * unit.y * unit.y; q.bc = w * unit.y * unit.z; q.bd = w * unit.y * d;
+            q.c2 = w * unit.z * unit.z; q.cd = w * unit.z * d;
+            q.d2 = w * d * d;
+            return q;
+        }
+
+        void Add(const Quadric &o)
+        {
+            a2 += o.a2; ab += o.ab; ac += o.ac; ad += o.ad;
+            b2 += o.b2; bc += o.bc; bd += o.bd;
+            c2 += o.c2; cd += o.cd;
+            d2 += o.d2;
+        }
+
+        // area weighted squared distance; dividing by the area turns it into a mean squared distance
+        double Evaluate(const glm::vec3 &p) const
+        {
+            const double x = p.x, y = p.y, z = p.z;
+            const double weight = a2 + b2 + c2; // the plane normals are unit length, so this is the summed area
+            const double e = a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+                           + b2 * y * y + 2 * bc * y * z + 2 * bd * y
+                           + c2 * z * z + 2 * cd * z
+                           + d2;
+            return weight > 0.0 ? std::max(e, 0.0) / weight : 0.0;
+        }
+    };
+
+    struct PositionHash
+    {
+        size_t operator()(const glm::vec3 &p) const
+        {
+            unsigned int h[3];
+            std::memcpy(h, &p, sizeof(h));
+            return (h[0] * 73856093u) ^ (h[1] * 19349663u) ^ (h[2] * 83492791u);
+        }
+    };
+
+    // locks vertices that share their position with another vertex (attribute seams) and vertices on open borders
+    static std::vector<unsigned char> classifyVertices(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices)
+    {
+        std::vector<unsigned char> kind(vertices.size(), KIND_MANIFOLD);
+        std::unordered_map<glm::vec3, unsigned int, PositionHash> firstAtPosition;
+        firstAtPosition.reserve(vertices.size());
+        for (size_t v = 0; v < vertices.size(); v++)
+        {
+            auto result = firstAtPosition.emplace(vertices[v].Position, static_cast<unsigned int>(v));
+            if (!result.second)
+            {
+                kind[v] = KIND_LOCKED;
+                kind[result.first->second] = KIND_LOCKED;
+            }
+        }
+        // an edge without a matching opposite half-edge lies on a border
+        std::unordered_map<unsigned long long, unsigned int> halfEdges;
+        halfEdges.reserve(indices.size());
+        for (size_t i = 0; i < indices.size(); i += 3)
+            for (int k = 0; k < 3; k++)
+                halfEdges[edgeKey(indices[i + k], indices[i + (k + 1) % 3])]++;
+        for (const auto &edge : halfEdges)
+        {
+            const unsigned int a = static_cast<unsigned int>(edge.first >> 32), b = static_cast<unsigned int>(edge.first);
+            auto opposite = halfEdges.find(edgeKey(b, a));
+            if (opposite == halfEdges.end() || opposite->second != edge.second)
+            {
+                kind[a] = KIND_LOCKED;
+                kind[b] = KIND_LOCKED;
+            }
+        }
+        return kind;
+    }
+
+    static unsigned long long edgeKey(unsigned int a, unsigned int b)
+    {
+        return (static_cast<unsigned long long>(a) << 32) | b;
+    }
+
+    // triangles using each vertex, as offsets into a flat list
+    static void buildVertexTriangles(const std::vector<unsigned int> &indices, size_t vertexCount,
+                                     std::vector<unsigned int> &offsets, std::vector<unsigned int> &triangles)
+    {
+        offsets.assign(vertexCount + 1, 0);
+        for (unsigned int index : indices)
+            offsets[index + 1]++;
+        for (size_t v = 0; v < vertexCount; v++)
+            offsets[v + 1] += offsets[v];
+        triangles.resize(indices.size());
+        std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); i++)
+            triangles[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+    }
+
+    // true if moving 'from' onto 'to' would turn any remaining triangle around 'from' upside down
+    static bool flipsTriangle(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices,
+                              const std::vector<unsigned int> &offsets, const std::vector<unsigned int> &triangles,
+                              unsigned int from, unsigned int to)
+    {
+        for (unsigned int t = offsets[from]; t < offsets[from + 1]; t++)
+        {
+            const unsigned int *tri = &indices[triangles[t] * 3];
+            if (tri[0] == to || tri[1] == to || tri[2] == to)
+                continue; // collapses away
+            glm::vec3 before[3], after[3];
+            for (int k = 0; k < 3; k++)
+            {
+                before[k] = vertices[tri[k]].Position;
+                after[k] = tri[k] == from ? vertices[to].Position : before[k];
+            }
+            const glm::vec3 n0 = glm::cross(before[1] - before[0], before[2] - before[0]);
+            const glm::vec3 n1 = glm::cross(after[1] - after[0], after[2] - after[0]);
+            // reject flips as well as slivers that turn more than ~75 degrees
+            if (glm::dot(n0, n1) <= 0.25f * glm::length(n0) * glm::length(n1))
+                return true;
+        }
+        return false;
+    }
+
+    static float pointTriangleDistance(const glm::vec3 &p, const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c)
+    {
+        // Ericson, Real-Time Collision Detection 5.1.5
+        const glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+        const float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+        if (d1 <= 0.0f && d2 <= 0.0f) return glm::length(p - a);
+        const glm::vec3 bp = p - b;
+        const float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+        if (d3 >= 0.0f && d4 <= d3) return glm::length(p - b);
+        const float vc = d1 * d4 - d3 * d2;
+        if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) return glm::length(p - (a + ab * (d1 / (d1 - d3))));
+        const glm::vec3 cp = p - c;
+        const float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+        if (d6 >= 0.0f && d5 <= d6) return glm::length(p - c);
+        const float vb = d5 * d2 - d1 * d6;
+        if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) return glm::length(p - (a + ac * (d2 / (d2 - d6))));
+        const float va = d3 * d6 - d5 * d4;
+        if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+            return glm::length(p - (b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)))));
+        const float denom = 1.0f / (va + vb + vc);
+        return glm::length(p - (a + ab * (vb * denom) + ac * (vc * denom)));
+    }
+};
+#endif
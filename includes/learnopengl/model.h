@@ -11,18 +11,57 @@
 #include <assimp/postprocess.h>
 
 #include <learnopengl/mesh.h>
+#include <learnopengl/mesh_cache.h>
+#include <learnopengl/mesh_optimizer.h>
+#include <learnopengl/mesh_simplifier.h>
 #include <learnopengl/shader.h>
+#include <learnopengl/texture_loader.h>
+#include <learnopengl/texture_registry.h>
 
+#include <algorithm>
+#include <filesystem>
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <map>
+#include <unordered_map>
 #include <vector>
 using namespace std;
 
+// ASSIMP post-processing steps used for every import; also part of the mesh cache key.
+const unsigned int MODEL_IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace;
+
+// levels of detail built with MESH_OPTIMIZE_LODS, including the full mesh; each halves the triangle count of the previous one.
+// the simplification error is capped at this fraction of the mesh's bounding box diagonal.
+// both end up in the mesh cache, so bump MESH_CACHE_VERSION when changing them.
+const unsigned int MODEL_LOD_LEVELS = 4;
+const float MODEL_LOD_MAX_ERROR = 0.05f;
+
 unsigned int TextureFromFile(const char *path, const string &directory, bool gamma = false);
 
+// every model file directly inside the subdirectories of directory (e.g. resources/objects/rock/rock.obj), sorted
+inline vector<string> FindModelFiles(string const &directory)
+{
+    static const char *extensions[] = { ".obj", ".dae", ".fbx", ".gltf", ".glb", ".3ds" };
+    vector<string> files;
+    std::error_code error;
+    for(const std::filesystem::directory_entry &folder : std::filesystem::directory_iterator(directory, error))
+    {
+        if(!folder.is_directory())
+            continue;
+        for(const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(folder.path(), error))
+        {
+            const string extension = entry.path().extension().string();
+            for(const char *supported : extensions)
+                if(extension == supported)
+                    files.push_back(entry.path().generic_string());
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
 class Model 
 {
 public:
@@ -31,38 +70,139 @@ public:
     vector<Mesh>    meshes;
     string directory;
     bool gammaCorrection;
+    VertexFormat vertexFormat;
+    unsigned int optimizeFlags; // MeshOptimizeFlags run on every mesh at import time
+    bool upload; // false keeps everything on the CPU: no GL buffers, no textures, so no GL context is needed
 
     // constructor, expects a filepath to a 3D model.
-    Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
+    Model(string const &path, bool gamma = false, VertexFormat format = VERTEX_FORMAT_FULL, unsigned int optimize = MESH_OPTIMIZE_NONE, bool upload = true)
+        : gammaCorrection(gamma), vertexFormat(format), optimizeFlags(optimize), upload(upload)
     {
         loadModel(path);
     }
 
+    // a model holds references on its textures in the TextureRegistry, so it can be moved but not copied
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
+    Model(Model&&) = default;
+
+    ~Model()
+    {
+        Unload();
+    }
+
+    // gives back the model's textures to the registry, which deletes those no other model uses, and drops its meshes.
+    // this needs the GL context, so models that live until the end of main have to be unloaded before glfwTerminate.
+    void Unload()
+    {
+        for(unsigned int i = 0; i < textures_loaded.size(); i++)
+            TextureRegistry::Get().Release(textures_loaded[i].id);
+        textures_loaded.clear();
+        textureIndices.clear();
+        meshes.clear();
+    }
+
     // draws the model, and thus all its meshes
-    void Draw(Shader &shader)
+    void Draw(Shader &shader, unsigned int lod = 0)
     {
         for(unsigned int i = 0; i < meshes.size(); i++)
-            meshes[i].Draw(shader);
+            meshes[i].Draw(shader, lod);
+    }
+
+    // level of detail for one instance of the model; the finest level any of the meshes asks for (see Mesh::SelectLod)
+    unsigned int SelectLod(float distance, float scale, float projectionScale, float maxPixelError = 1.0f) const
+    {
+        unsigned int lod = MODEL_LOD_LEVELS;
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            lod = std::min(lod, meshes[i].SelectLod(distance, scale, projectionScale, maxPixelError));
+        return meshes.empty() ? 0 : lod;
+    }
+
+    // bytes used by the vertex buffers of all meshes
+    size_t GetVertexMemory() const
+    {
+        size_t bytes = 0;
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            bytes += meshes[i].GetVertexBufferSize();
+        return bytes;
     }
     
 private:
+    // decodes textures in the background while a model is being loaded
+    TextureLoader *textureLoader = nullptr;
+    // index into textures_loaded for every texture path this model uses
+    unordered_map<string, size_t> textureIndices;
+    // vertex cache efficiency of all imported meshes before/after optimization
+    VertexCacheStats statsBefore, statsAfter;
+
     // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
     void loadModel(string const &path)
     {
+        // retrieve the directory path of the filepath
+        directory = path.substr(0, path.find_last_of('/'));
+
+        // textures are decoded on worker threads while we build the meshes, and uploaded once loading is done
+        TextureLoader loader;
+        textureLoader = &loader;
+        importModel(path);
+        loader.Finish();
+        textureLoader = nullptr;
+    }
+
+    void importModel(string const &path)
+    {
+        // a valid binary mesh cache lets us skip ASSIMP entirely
+        const string cachePath = MeshCache::GetCachePath(path);
+        const uint64_t sourceHash = MeshCache::HashSource(path);
+        if(loadFromCache(cachePath, sourceHash))
+            return;
+
         // read file via ASSIMP
         Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        const aiScene* scene = importer.ReadFile(path, MODEL_IMPORT_FLAGS);
         // check for errors
         if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
         {
             cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
             return;
         }
-        // retrieve the directory path of the filepath
-        directory = path.substr(0, path.find_last_of('/'));
 
         // process ASSIMP's root node recursively
         processNode(scene->mRootNode, scene);
+        if(optimizeFlags != MESH_OPTIMIZE_NONE)
+            cout << "MODEL::OPTIMIZE:: " << path << " ACMR " << statsBefore.acmr << " -> " << statsAfter.acmr
+                 << ", ATVR " << statsBefore.atvr << " -> " << statsAfter.atvr << endl;
+
+        // store the flattened (and optimized) result so the next start can skip the import
+        MeshCache::Write(cachePath, sourceHash, MODEL_IMPORT_FLAGS, optimizeFlags, meshes);
+    }
+
+    // fills the meshes vector from a binary mesh cache; returns false if there's no valid cache for this source file.
+    bool loadFromCache(string const &cachePath, uint64_t sourceHash)
+    {
+        MeshCache cache;
+        if(!cache.Open(cachePath, sourceHash, MODEL_IMPORT_FLAGS, optimizeFlags))
+            return false;
+
+        meshes.reserve(cache.GetMeshCount());
+        for(unsigned int i = 0; i < cache.GetMeshCount(); i++)
+        {
+            const MeshCacheEntry &entry = cache.GetMesh(i);
+            // vertex and index data come straight out of the mapped file
+            vector<Vertex> vertices(cache.GetVertices(i), cache.GetVertices(i) + entry.vertexCount);
+            vector<unsigned int> indices(cache.GetIndices(i), cache.GetIndices(i) + entry.indexCount);
+            vector<Texture> textures;
+            for(unsigned int j = 0; j < entry.textureCount; j++)
+                textures.push_back(loadTexture(cache.GetTexturePath(i, j), cache.GetTextureType(i, j)));
+            vector<MeshLod> lods(entry.lodCount);
+            for(unsigned int j = 0; j < entry.lodCount; j++)
+            {
+                lods[j].indices.assign(cache.GetLodIndices(i, j), cache.GetLodIndices(i, j) + cache.GetLod(i, j).indexCount);
+                lods[j].error = cache.GetLod(i, j).error;
+            }
+            meshes.push_back(Mesh(vertices, indices, textures, vertexFormat, lods, upload));
+        }
+        return true;
     }
 
     // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
@@ -94,7 +234,7 @@ private:
         // walk through each of the mesh's vertices
         for(unsigned int i = 0; i < mesh->mNumVertices; i++)
         {
-            Vertex vertex;
+            Vertex vertex = {}; // zero attributes the mesh doesn't have so identical vertices compare equal
             glm::vec3 vector; // we declare a placeholder vector since assimp uses its own vector class that doesn't directly convert to glm's vec3 class so we transfer the data to this placeholder glm::vec3 first.
             // positions
             vector.x = mesh->mVertices[i].x;
@@ -142,6 +282,16 @@ private:
             for(unsigned int j = 0; j < face.mNumIndices; j++)
                 indices.push_back(face.mIndices[j]);        
         }
+        // optionally weld duplicate vertices and reorder for the vertex cache
+        if(optimizeFlags != MESH_OPTIMIZE_NONE)
+        {
+            accumulate(statsBefore, MeshOptimizer::AnalyzeVertexCache(indices, vertices.size()));
+            MeshOptimizer::Optimize(vertices, indices, optimizeFlags);
+            accumulate(statsAfter, MeshOptimizer::AnalyzeVertexCache(indices, vertices.size()));
+        }
+        vector<MeshLod> lods;
+        if(optimizeFlags & MESH_OPTIMIZE_LODS)
+            lods = generateLods(vertices, indices);
         // process materials
         aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];    
         // we assume a convention for sampler names in the shaders. Each diffuse texture should be named
@@ -165,7 +315,52 @@ private:
         textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
         
         // return a mesh object created from the extracted mesh data
-        return Mesh(vertices, indices, textures);
+        return Mesh(vertices, indices, textures, vertexFormat, lods, upload);
+    }
+
+    // simplifies a mesh into up to MODEL_LOD_LEVELS - 1 coarser index buffers over the same vertices
+    vector<MeshLod> generateLods(const vector<Vertex> &vertices, const vector<unsigned int> &indices)
+    {
+        vector<MeshLod> lods;
+        if(vertices.empty())
+            return lods;
+        glm::vec3 minPos = vertices[0].Position, maxPos = vertices[0].Position;
+        for(const Vertex &vertex : vertices)
+        {
+            minPos = glm::min(minPos, vertex.Position);
+            maxPos = glm::max(maxPos, vertex.Position);
+        }
+        const float maxError = glm::length(maxPos - minPos) * MODEL_LOD_MAX_ERROR;
+
+        size_t target = indices.size();
+        size_t previous = indices.size();
+        float previousError = 0.0f;
+        for(unsigned int level = 1; level < MODEL_LOD_LEVELS; level++)
+        {
+            // always simplify the full mesh so the error is measured against the original surface
+            target = target / 2 / 3 * 3;
+            MeshLod lod;
+            lod.indices = MeshSimplifier::Simplify(vertices, indices, target, maxError, &lod.error);
+            // stop once the error cap (or locked borders) keep the simplifier from making real progress
+            if(lod.indices.empty() || lod.indices.size() > previous * 9 / 10)
+                break;
+            lod.error = std::max(lod.error, previousError);
+            MeshOptimizer::OptimizeVertexCache(lod.indices, vertices.size());
+            previous = lod.indices.size();
+            previousError = lod.error;
+            lods.push_back(lod);
+        }
+        return lods;
+    }
+
+    // adds the counts of one mesh to the model totals
+    static void accumulate(VertexCacheStats &total, const VertexCacheStats &mesh)
+    {
+        total.transformedVertices += mesh.transformedVertices;
+        total.triangles += mesh.triangles;
+        total.referencedVertices += mesh.referencedVertices;
+        total.acmr = total.triangles ? float(total.transformedVertices) / total.triangles : 0.0f;
+        total.atvr = total.referencedVertices ? float(total.transformedVertices) / total.referencedVertices : 0.0f;
     }
 
     // checks all material textures of a given type and loads the textures if they're not loaded yet.
@@ -177,29 +372,38 @@ private:
         {
             aiString str;
             mat->GetTexture(type, i, &str);
-            // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-            bool skip = false;
-            for(unsigned int j = 0; j < textures_loaded.size(); j++)
-            {
-                if(std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-                {
-                    textures.push_back(textures_loaded[j]);
-                    skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-                    break;
-                }
-            }
-            if(!skip)
-            {   // if texture hasn't been loaded already, load it
-                Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
-                texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
-                textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecessary load duplicate textures.
-            }
+            textures.push_back(loadTexture(str.C_Str(), typeName));
         }
         return textures;
     }
+
+    // returns the texture at the given path (relative to the model's directory), loading it if it isn't loaded yet.
+    Texture loadTexture(string const &path, string const &typeName)
+    {
+        // without uploads the meshes only remember which textures they use
+        if(!upload)
+            return Texture{0, typeName, path};
+
+        // check if this model already uses the texture; if so, skip loading a new texture (optimization)
+        auto loaded = textureIndices.find(path);
+        if(loaded != textureIndices.end())
+            return textures_loaded[loaded->second];
+
+        // textures are shared with every other model in the process through the registry
+        Texture texture;
+        const string canonicalPath = TextureRegistry::Canonicalize(this->directory + '/' + path);
+        texture.id = TextureRegistry::Get().Acquire(canonicalPath, TEXTURE_FORMAT_FROM_IMAGE, true).id;
+        if(texture.id == 0)
+        {   // if texture hasn't been loaded already, load it
+            texture.id = textureLoader->Load(canonicalPath);
+            TextureRegistry::Get().Insert(canonicalPath, TEXTURE_FORMAT_FROM_IMAGE, true, texture.id);
+        }
+        texture.type = typeName;
+        texture.path = path;
+        textureIndices[path] = textures_loaded.size();
+        textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecessary load duplicate textures.
+        return texture;
+    }
 };
 
 
@@ -211,34 +415,12 @@ unsigned int TextureFromFile(const char *path, const string &directory, bool gam
     unsigned int textureID;
     glGenTextures(1, &textureID);
 
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    if (data)
-    {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
+    DecodedImage image = DecodedImage::Decode(filename);
+    if (image.data)
+        UploadTexture(textureID, image);
     else
-    {
         std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
+    image.Free();
 
     return textureID;
 }
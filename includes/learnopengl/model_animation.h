@@ -12,12 +12,15 @@
 
 #include <learnopengl/mesh.h>
 #include <learnopengl/shader.h>
+#include <learnopengl/texture_loader.h>
+#include <learnopengl/texture_registry.h>
 
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <learnopengl/assimp_glm_helpers.h>
 #include <learnopengl/animdata.h>
@@ -32,22 +35,47 @@ public:
     vector<Mesh>    meshes;
     string directory;
     bool gammaCorrection;
+    VertexFormat vertexFormat;
 	
 	
 
     // constructor, expects a filepath to a 3D model.
-    Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
+    Model(string const &path, bool gamma = false, VertexFormat format = VERTEX_FORMAT_FULL) : gammaCorrection(gamma), vertexFormat(format)
     {
+        // animated meshes always need their bone data
+        if (vertexFormat == VERTEX_FORMAT_COMPACT)
+            vertexFormat = VERTEX_FORMAT_COMPACT_SKINNED;
         loadModel(path);
     }
 
+    // a model holds references on its textures in the TextureRegistry, so it can be moved but not copied
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
+    Model(Model&&) = default;
+
+    ~Model()
+    {
+        Unload();
+    }
+
+    // gives back the model's textures to the registry, which deletes those no other model uses, and drops its meshes.
+    // this needs the GL context, so models that live until the end of main have to be unloaded before glfwTerminate.
+    void Unload()
+    {
+        for(unsigned int i = 0; i < textures_loaded.size(); i++)
+            TextureRegistry::Get().Release(textures_loaded[i].id);
+        textures_loaded.clear();
+        m_TextureIndices.clear();
+        meshes.clear();
+    }
+
     // draws the model, and thus all its meshes
     void Draw(Shader &shader)
     {
         for(unsigned int i = 0; i < meshes.size(); i++)
             meshes[i].Draw(shader);
     }
-    
+
 	auto& GetBoneInfoMap() { return m_BoneInfoMap; }
 	int& GetBoneCount() { return m_BoneCounter; }
 	
@@ -56,6 +84,10 @@ private:
 
 	std::map<string, BoneInfo> m_BoneInfoMap;
 	int m_BoneCounter = 0;
+	// decodes textures in the background while a model is being loaded
+	TextureLoader* m_TextureLoader = nullptr;
+	// index into textures_loaded for every texture path this model uses
+	std::unordered_map<string, size_t> m_TextureIndices;
 
     // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
     void loadModel(string const &path)
@@ -72,8 +104,13 @@ private:
         // retrieve the directory path of the filepath
         directory = path.substr(0, path.find_last_of('/'));
 
+        // textures are decoded on worker threads while we build the meshes, and uploaded once loading is done
+        TextureLoader loader;
+        m_TextureLoader = &loader;
         // process ASSIMP's root node recursively
         processNode(scene->mRootNode, scene);
+        loader.Finish();
+        m_TextureLoader = nullptr;
     }
 
     // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
@@ -149,7 +186,7 @@ private:
 
 		ExtractBoneWeightForVertices(vertices,mesh,scene);
 
-		return Mesh(vertices, indices, textures);
+		return Mesh(vertices, indices, textures, vertexFormat);
 	}
 
 	void SetVertexBoneData(Vertex& vertex, int boneID, float weight)
@@ -203,46 +240,6 @@ private:
 	}
 
 
-	unsigned int TextureFromFile(const char* path, const string& directory, bool gamma = false)
-	{
-		string filename = string(path);
-		filename = directory + '/' + filename;
-
-		unsigned int textureID;
-		glGenTextures(1, &textureID);
-
-		int width, height, nrComponents;
-		unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-		if (data)
-		{
-			GLenum format;
-			if (nrComponents == 1)
-				format = GL_RED;
-			else if (nrComponents == 3)
-				format = GL_RGB;
-			else if (nrComponents == 4)
-				format = GL_RGBA;
-
-			glBindTexture(GL_TEXTURE_2D, textureID);
-			glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-			glGenerateMipmap(GL_TEXTURE_2D);
-
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-			stbi_image_free(data);
-		}
-		else
-		{
-			std::cout << "Texture failed to load at path: " << path << std::endl;
-			stbi_image_free(data);
-		}
-
-		return textureID;
-	}
-    
     // checks all material textures of a given type and loads the textures if they're not loaded yet.
     // the required info is returned as a Texture struct.
     vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, string typeName)
@@ -252,29 +249,34 @@ private:
         {
             aiString str;
             mat->GetTexture(type, i, &str);
-            // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-            bool skip = false;
-            for(unsigned int j = 0; j < textures_loaded.size(); j++)
-            {
-                if(std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-                {
-                    textures.push_back(textures_loaded[j]);
-                    skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-                    break;
-                }
-            }
-            if(!skip)
-            {   // if texture hasn't been loaded already, load it
-                Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
-                texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
-                textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecessary load duplicate textures.
-            }
+            textures.push_back(loadTexture(str.C_Str(), typeName));
         }
         return textures;
     }
+
+    // returns the texture at the given path (relative to the model's directory), loading it if it isn't loaded yet.
+    Texture loadTexture(string const &path, string const &typeName)
+    {
+        // check if this model already uses the texture; if so, skip loading a new texture (optimization)
+        auto loaded = m_TextureIndices.find(path);
+        if(loaded != m_TextureIndices.end())
+            return textures_loaded[loaded->second];
+
+        // textures are shared with every other model in the process through the registry
+        Texture texture;
+        const string canonicalPath = TextureRegistry::Canonicalize(this->directory + '/' + path);
+        texture.id = TextureRegistry::Get().Acquire(canonicalPath, TEXTURE_FORMAT_FROM_IMAGE, true).id;
+        if(texture.id == 0)
+        {   // if texture hasn't been loaded already, load it
+            texture.id = m_TextureLoader->Load(canonicalPath);
+            TextureRegistry::Get().Insert(canonicalPath, TEXTURE_FORMAT_FROM_IMAGE, true, texture.id);
+        }
+        texture.type = typeName;
+        texture.path = path;
+        m_TextureIndices[path] = textures_loaded.size();
+        textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecessary load duplicate textures.
+        return texture;
+    }
 };
 
 
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/quaternion.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Linear allocator for short lived pose buffers. Everything allocated during a frame is released at
+// once by Reset(). If a frame needs more than the arena holds the extra requests are served from
+// overflow blocks, and the next Reset() grows the arena to fit; once the working set is known no
+// further allocations happen.
+class PoseArena
+{
+public:
+	explicit PoseArena(size_t capacity = 64 * 1024)
+	{
+		grow(capacity);
+	}
+
+	PoseArena(const PoseArena&) = delete;
+	PoseArena& operator=(const PoseArena&) = delete;
+
+	// uninitialized storage for count trivially constructible objects
+	template<typename T>
+	T* Allocate(size_t count)
+	{
+		const size_t bytes = count * sizeof(T);
+		const size_t offset = (m_Used + alignof(T) - 1) & ~(alignof(T) - 1);
+		if (offset + bytes <= m_Capacity)
+		{
+			m_Used = offset + bytes;
+			return reinterpret_cast<T*>(m_Buffer.get() + offset);
+		}
+		m_Overflow.emplace_back(new unsigned char[bytes + alignof(T)]);
+		m_OverflowBytes += bytes + alignof(T);
+		unsigned char* block = m_Overflow.back().get();
+		const size_t misalignment = reinterpret_cast<size_t>(block) & (alignof(T) - 1);
+		return reinterpret_cast<T*>(block + (misalignment ? alignof(T) - misalignment : 0));
+	}
+
+	// releases everything allocated since the last Reset
+	void Reset()
+	{
+		if (!m_Overflow.empty())
+		{
+			grow(m_Capacity + m_OverflowBytes);
+			m_Overflow.clear();
+			m_OverflowBytes = 0;
+		}
+		m_Used = 0;
+	}
+
+	size_t GetCapacity() const { return m_Capacity; }
+	size_t GetUsed() const { return m_Used + m_OverflowBytes; }
+
+private:
+	std::unique_ptr<unsigned char[]> m_Buffer;
+	size_t m_Capacity = 0;
+	size_t m_Used = 0;
+	std::vector<std::unique_ptr<unsigned char[]>> m_Overflow;
+	size_t m_OverflowBytes = 0;
+
+	void grow(size_t capacity)
+	{
+		// operator new[] memory is aligned for every fundamental type, which covers glm's vectors and quaternions
+		m_Buffer.reset(new unsigned char[capacity]);
+		m_Capacity = capacity;
+	}
+};
+
+// local (parent relative) transforms of every node of a skeleton, stored as separate arrays
+struct LocalPose
+{
+	glm::vec3* translations = nullptr;
+	glm::quat* rotations = nullptr;
+	glm::vec3* scales = nullptr;
+	size_t count = 0;
+
+	static LocalPose Allocate(PoseArena& arena, size_t count)
+	{
+		LocalPose pose;
+		pose.translations = arena.Allocate<glm::vec3>(count);
+		pose.rotations = arena.Allocate<glm::quat>(count);
+		pose.scales = arena.Allocate<glm::vec3>(count);
+		pose.count = count;
+		return pose;
+	}
+
+	glm::mat4 GetMatrix(size_t node) const
+	{
+		glm::mat4 transform = glm::toMat4(rotations[node]);
+		transform[0] *= scales[node].x;
+		transform[1] *= scales[node].y;
+		transform[2] *= scales[node].z;
+		transform[3] = glm::vec4(translations[node], 1.0f);
+		return transform;
+	}
+};
+
+// result = mix(result, other, weight), per node
+inline void BlendPoses(LocalPose& result, const LocalPose& other, float weight)
+{
+	for (size_t i = 0; i < result.count; i++)
+	{
+		result.translations[i] = glm::mix(result.translations[i], other.translations[i], weight);
+		result.rotations[i] = glm::normalize(glm::slerp(result.rotations[i], other.rotations[i], weight));
+		result.scales[i] = glm::mix(result.scales[i], other.scales[i], weight);
+	}
+}
+
+// adds the difference between pose and reference, scaled by weight, on top of result
+inline void AddPose(LocalPose& result, const LocalPose& pose, const LocalPose& reference, float weight)
+{
+	const glm::quat identity(1.0f, 0.0f, 0.0f, 0.0f);
+	for (size_t i = 0; i < result.count; i++)
+	{
+		result.translations[i] += (pose.translations[i] - reference.translations[i]) * weight;
+		const glm::quat delta = glm::inverse(reference.rotations[i]) * pose.rotations[i];
+		result.rotations[i] = glm::normalize(result.rotations[i] * glm::slerp(identity, delta, weight));
+		// an axis scaled to zero in the reference has no ratio to scale by, it's left as it is
+		glm::vec3 ratio(1.0f);
+		for (int axis = 0; axis < 3; axis++)
+			if (reference.scales[i][axis] != 0.0f)
+				ratio[axis] = pose.scales[i][axis] / reference.scales[i][axis];
+		result.scales[i] *= glm::mix(glm::vec3(1.0f), ratio, weight);
+	}
+}
@@ -0,0 +1,442 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <learnopengl/mesh.h>
+#include <learnopengl/model.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// The GL calls a render queue issues. GLRenderBackend forwards them to OpenGL; RecordingRenderBackend only counts
+// them, so sorting and state filtering can be checked and measured without a GL context.
+class RenderBackend
+{
+public:
+    virtual ~RenderBackend() {}
+    virtual void UseProgram(unsigned int program) = 0;
+    virtual void ActiveTexture(unsigned int unit) = 0;
+    virtual void BindTexture(unsigned int texture) = 0;
+    virtual void BindVertexArray(unsigned int vao) = 0;
+    virtual int GetUniformLocation(unsigned int program, const char* name) = 0;
+    virtual void SetUniform(int location, int value) = 0;
+    virtual void SetUniform(int location, const glm::mat4& value) = 0;
+    virtual void DrawElements(unsigned int indexCount, size_t indexOffset) = 0;
+};
+
+class GLRenderBackend : public RenderBackend
+{
+public:
+    void UseProgram(unsigned int program) override { glUseProgram(program); }
+    void ActiveTexture(unsigned int unit) override { glActiveTexture(GL_TEXTURE0 + unit); }
+    void BindTexture(unsigned int texture) override { glBindTexture(GL_TEXTURE_2D, texture); }
+    void BindVertexArray(unsigned int vao) override { glBindVertexArray(vao); }
+    int GetUniformLocation(unsigned int program, const char* name) override { return glGetUniformLocation(program, name); }
+    void SetUniform(int location, int value) override { glUniform1i(location, value); }
+    void SetUniform(int location, const glm::mat4& value) override { glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value)); }
+    void DrawElements(unsigned int indexCount, size_t indexOffset) override
+    {
+        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, (void*)indexOffset);
+    }
+};
+
+// number of calls per kind
+struct RenderCallCounts
+{
+    unsigned int useProgram = 0;
+    unsigned int activeTexture = 0;
+    unsigned int bindTexture = 0;
+    unsigned int bindVertexArray = 0;
+    unsigned int getUniformLocation = 0;
+    unsigned int uniform = 0;
+    unsigned int drawElements = 0;
+
+    unsigned int StateChanges() const { return useProgram + activeTexture + bindTexture + bindVertexArray + uniform; }
+};
+
+class RecordingRenderBackend : public RenderBackend
+{
+public:
+    RenderCallCounts calls;
+    // the vertex arrays drawn, in order, to check what the sort did
+    std::vector<unsigned int> drawnVertexArrays;
+
+    void UseProgram(unsigned int) override { calls.useProgram++; }
+    void ActiveTexture(unsigned int) override { calls.activeTexture++; }
+    void BindTexture(unsigned int) override { calls.bindTexture++; }
+    void BindVertexArray(unsigned int vao) override { calls.bindVertexArray++; m_BoundVertexArray = vao; }
+    int GetUniformLocation(unsigned int program, const char* name) override
+    {
+        calls.getUniformLocation++;
+        // any stable number works as long as different names get different locations
+        return static_cast<int>((std::hash<std::string>()(name) ^ program) & 0x7FFF);
+    }
+    void SetUniform(int, int) override { calls.uniform++; }
+    void SetUniform(int, const glm::mat4&) override { calls.uniform++; }
+    void DrawElements(unsigned int, size_t) override { calls.drawElements++; drawnVertexArrays.push_back(m_BoundVertexArray); }
+
+    void Reset()
+    {
+        calls = RenderCallCounts();
+        drawnVertexArrays.clear();
+    }
+
+private:
+    unsigned int m_BoundVertexArray = 0;
+};
+
+// Sits in front of a backend and drops calls that wouldn't change the GL state: binding the program, texture
+// or vertex array that is already bound, or setting a sampler uniform to the value it already has. It also
+// remembers uniform locations so every name is only looked up once per program.
+// GL calls made around it aren't seen, so call Invalidate() before using it after other code touched the state.
+class RenderStateCache
+{
+public:
+    static const unsigned int MAX_TEXTURE_UNITS = 32;
+
+    explicit RenderStateCache(RenderBackend& backend) : m_Backend(backend)
+    {
+        Invalidate();
+    }
+
+    void Invalidate()
+    {
+        m_Program = UNKNOWN;
+        m_ActiveUnit = UNKNOWN;
+        m_VertexArray = UNKNOWN;
+        std::fill(m_Textures, m_Textures + MAX_TEXTURE_UNITS, UNKNOWN);
+        m_IntUniforms.clear();
+    }
+
+    void UseProgram(unsigned int program)
+    {
+        if (program == m_Program)
+            return;
+        m_Backend.UseProgram(program);
+        m_Program = program;
+    }
+
+    void BindTexture(unsigned int unit, unsigned int texture)
+    {
+        if (unit < MAX_TEXTURE_UNITS && m_Textures[unit] == texture)
+            return;
+        if (unit != m_ActiveUnit)
+        {
+            m_Backend.ActiveTexture(unit);
+            m_ActiveUnit = unit;
+        }
+        m_Backend.BindTexture(texture);
+        if (unit < MAX_TEXTURE_UNITS)
+            m_Textures[unit] = texture;
+    }
+
+    void BindVertexArray(unsigned int vao)
+    {
+        if (vao == m_VertexArray)
+            return;
+        m_Backend.BindVertexArray(vao);
+        m_VertexArray = vao;
+    }
+
+    // location of a uniform of the current program; -1 if it doesn't exist
+    int GetUniformLocation(const std::string& name)
+    {
+        std::unordered_map<std::string, int>& locations = m_Locations[m_Program];
+        auto it = locations.find(name);
+        if (it == locations.end())
+            it = locations.emplace(name, m_Backend.GetUniformLocation(m_Program, name.c_str())).first;
+        return it->second;
+    }
+
+    // uniforms belong to the program, so their values are remembered per program
+    void SetUniform(int location, int value)
+    {
+        if (location < 0)
+            return;
+        const uint64_t key = (uint64_t(m_Program) << 32) | uint32_t(location);
+        auto it = m_IntUniforms.find(key);
+        if (it != m_IntUniforms.end() && it->second == value)
+            return;
+        m_Backend.SetUniform(location, value);
+        m_IntUniforms[key] = value;
+    }
+
+    void SetUniform(int location, const glm::mat4& value)
+    {
+        if (location >= 0)
+            m_Backend.SetUniform(location, value);
+    }
+
+    void DrawElements(unsigned int indexCount, size_t indexOffset)
+    {
+        m_Backend.DrawElements(indexCount, indexOffset);
+    }
+
+    // restore the defaults Mesh::Draw leaves behind
+    void Reset()
+    {
+        BindVertexArray(0);
+        if (m_ActiveUnit != 0)
+        {
+            m_Backend.ActiveTexture(0);
+            m_ActiveUnit = 0;
+        }
+    }
+
+private:
+    static const unsigned int UNKNOWN = ~0u;
+
+    RenderBackend& m_Backend;
+    unsigned int m_Program;
+    unsigned int m_ActiveUnit;
+    unsigned int m_VertexArray;
+    unsigned int m_Textures[MAX_TEXTURE_UNITS];
+    std::unordered_map<uint64_t, int> m_IntUniforms;
+    std::unordered_map<unsigned int, std::unordered_map<std::string, int>> m_Locations;
+};
+
+// what it takes to draw one mesh; the arrays are owned by the caller and must outlive the flush
+struct RenderItem
+{
+    unsigned int vao = 0;
+    const Texture* textures = nullptr;
+    const std::string* samplerNames = nullptr;
+    unsigned int textureCount = 0;
+    unsigned int indexCount = 0;
+    size_t indexOffset = 0;
+};
+
+// Draws collected away from the queue, e.g. one list per job while culling in parallel, and added to it with
+// RenderQueue::Append. Filling a list doesn't touch the queue, so lists can be filled on different threads.
+class RenderList
+{
+public:
+    void Submit(unsigned int program, const RenderItem& item, const glm::mat4& model, float depth)
+    {
+        Draw draw;
+        draw.program = program;
+        draw.item = item;
+        draw.model = model;
+        draw.depth = depth;
+        m_Draws.push_back(draw);
+    }
+
+    void Submit(const Shader& shader, const Mesh& mesh, const glm::mat4& model, float depth, unsigned int lod = 0)
+    {
+        RenderItem item;
+        item.vao = mesh.VAO;
+        item.textures = mesh.textures.data();
+        item.samplerNames = mesh.samplerNames.data();
+        item.textureCount = static_cast<unsigned int>(mesh.textures.size());
+        item.indexCount = mesh.GetLodIndexCount(lod);
+        item.indexOffset = mesh.GetLodIndexOffset(lod);
+        Submit(shader.ID, item, model, depth);
+    }
+
+    void Submit(const Shader& shader, const Model& model, const glm::mat4& transform, float depth, unsigned int lod = 0)
+    {
+        for (const Mesh& mesh : model.meshes)
+            Submit(shader, mesh, transform, depth, lod);
+    }
+
+    void Clear() { m_Draws.clear(); }
+    size_t Size() const { return m_Draws.size(); }
+
+private:
+    friend class RenderQueue;
+
+    struct Draw
+    {
+        unsigned int program;
+        RenderItem item;
+        glm::mat4 model;
+        float depth;
+    };
+
+    std::vector<Draw> m_Draws;
+};
+
+// Collects the draws of a frame and issues them sorted by a 64-bit key, so draws sharing a program, textures
+// and vertex array end up next to each other and the state cache can skip the repeated binds. From the most
+// significant bits down the key holds:
+//   program (10 bits) | material, i.e. the set of textures (18 bits) | vertex array (20 bits) | depth (16 bits)
+// Within the same state the draws go front to back, which helps early depth rejection.
+class RenderQueue
+{
+public:
+    // depths (distance to the camera) in [near, far] are spread over the depth bits; others are clamped
+    void SetDepthRange(float nearDepth, float farDepth)
+    {
+        m_NearDepth = nearDepth;
+        m_FarDepth = farDepth;
+    }
+
+    void Submit(unsigned int program, const RenderItem& item, const glm::mat4& model, float depth)
+    {
+        Command command;
+        command.program = program;
+        command.item = item;
+        command.model = model;
+        m_Keys.push_back(MakeKey(programIndex(program), materialIndex(item), item.vao, depthBucket(depth)));
+        m_Commands.push_back(command);
+    }
+
+    void Submit(const Shader& shader, const Mesh& mesh, const glm::mat4& model, float depth, unsigned int lod = 0)
+    {
+        RenderItem item;
+        item.vao = mesh.VAO;
+        item.textures = mesh.textures.data();
+        item.samplerNames = mesh.samplerNames.data();
+        item.textureCount = static_cast<unsigned int>(mesh.textures.size());
+        item.indexCount = mesh.GetLodIndexCount(lod);
+        item.indexOffset = mesh.GetLodIndexOffset(lod);
+        Submit(shader.ID, item, model, depth);
+    }
+
+    void Submit(const Shader& shader, const Model& model, const glm::mat4& transform, float depth, unsigned int lod = 0)
+    {
+        for (const Mesh& mesh : model.meshes)
+            Submit(shader, mesh, transform, depth, lod);
+    }
+
+    // submits the draws of a list in the order they were added to it; appending lists in a fixed order gives the
+    // same queue no matter which threads filled them
+    void Append(const RenderList& list)
+    {
+        for (const RenderList::Draw& draw : list.m_Draws)
+            Submit(draw.program, draw.item, draw.model, draw.depth);
+    }
+
+    // draws everything submitted since the last flush in key order, then empties the queue.
+    // The model matrix goes to the uniform called "model"
+    void Flush(RenderStateCache& state)
+    {
+        Sort();
+        for (size_t i = 0; i < m_Order.size(); i++)
+        {
+            const Command& command = m_Commands[m_Order[i]];
+            const RenderItem& item = command.item;
+            state.UseProgram(command.program);
+            for (unsigned int t = 0; t < item.textureCount; t++)
+            {
+                state.SetUniform(state.GetUniformLocation(item.samplerNames[t]), static_cast<int>(t));
+                state.BindTexture(t, item.textures[t].id);
+            }
+            state.SetUniform(state.GetUniformLocation(m_ModelUniform), command.model);
+            state.BindVertexArray(item.vao);
+            state.DrawElements(item.indexCount, item.indexOffset);
+        }
+        state.Reset();
+        Clear();
+    }
+
+    // orders the submitted draws by key; Flush does this itself
+    void Sort()
+    {
+        const size_t count = m_Keys.size();
+        m_Order.resize(count);
+        for (size_t i = 0; i < count; i++)
+            m_Order[i] = static_cast<unsigned int>(i);
+        radixSort();
+    }
+
+    void Clear()
+    {
+        m_Keys.clear();
+        m_Commands.clear();
+        m_Order.clear();
+    }
+
+    size_t Size() const { return m_Keys.size(); }
+
+    // key of the i-th draw in sorted order, valid after Sort()
+    uint64_t GetSortedKey(size_t i) const { return m_Keys[m_Order[i]]; }
+
+    static uint64_t MakeKey(unsigned int program, unsigned int material, unsigned int vao, unsigned int depth)
+    {
+        return (uint64_t(program & 0x3FF) << 54) | (uint64_t(material & 0x3FFFF) << 36) | (uint64_t(vao & 0xFFFFF) << 16) | (depth & 0xFFFF);
+    }
+
+private:
+    struct Command
+    {
+        unsigned int program;
+        RenderItem item;
+        glm::mat4 model;
+    };
+
+    const std::string m_ModelUniform = "model";
+    std::vector<uint64_t> m_Keys;
+    std::vector<Command> m_Commands;
+    std::vector<unsigned int> m_Order;
+    std::vector<unsigned int> m_Scratch;
+    float m_NearDepth = 0.1f;
+    float m_FarDepth = 100.0f;
+
+    // programs and texture sets get small dense numbers in order of first use, they stay stable across frames
+    std::unordered_map<unsigned int, unsigned int> m_ProgramIndex;
+    std::unordered_map<uint64_t, unsigned int> m_MaterialIndex;
+
+    unsigned int programIndex(unsigned int program)
+    {
+        return m_ProgramIndex.emplace(program, static_cast<unsigned int>(m_ProgramIndex.size())).first->second;
+    }
+
+    unsigned int materialIndex(const RenderItem& item)
+    {
+        // FNV-1a over the texture ids; a collision only makes the sort a little worse, never the drawing wrong
+        uint64_t hash = 14695981039346656037ull;
+        for (unsigned int t = 0; t < item.textureCount; t++)
+        {
+            hash ^= item.textures[t].id;
+            hash *= 1099511628211ull;
+        }
+        return m_MaterialIndex.emplace(hash, static_cast<unsigned int>(m_MaterialIndex.size())).first->second;
+    }
+
+    unsigned int depthBucket(float depth) const
+    {
+        const float range = m_FarDepth - m_NearDepth;
+        const float t = range > 0.0f ? (depth - m_NearDepth) / range : 0.0f;
+        return static_cast<unsigned int>(std::min(std::max(t, 0.0f), 1.0f) * 65535.0f);
+    }
+
+    // least significant digit radix sort of m_Order by key, 8 bits per pass; passes where every key has the
+    // same digit are skipped, which is most of them as there are only a few programs, materials and vertex arrays
+    void radixSort()
+    {
+        const size_t count = m_Order.size();
+        if (count < 2)
+            return;
+        m_Scratch.resize(count);
+        for (int shift = 0; shift < 64; shift += 8)
+        {
+            size_t histogram[256] = {};
+            for (size_t i = 0; i < count; i++)
+                histogram[(m_Keys[i] >> shift) & 0xFF]++;
+            if (histogram[(m_Keys[0] >> shift) & 0xFF] == count)
+                continue;
+
+            size_t offset = 0;
+            for (int digit = 0; digit < 256; digit++)
+            {
+                const size_t digitCount = histogram[digit];
+                histogram[digit] = offset;
+                offset += digitCount;
+            }
+            for (size_t i = 0; i < count; i++)
+            {
+                const unsigned int command = m_Order[i];
+                m_Scratch[histogram[(m_Keys[command] >> shift) & 0xFF]++] = command;
+            }
+            m_Order.swap(m_Scratch);
+        }
+    }
+};
+#endif
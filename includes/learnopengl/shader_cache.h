@@ -0,0 +1,299 @@
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include <glad/glad.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// 64 bit FNV-1a hash over everything that decides what a program binary looks like: the source of
+// every stage, which stage it is for, any defines, and the driver that compiled it.
+class ShaderCacheKey
+{
+public:
+    void Add(const void* data, size_t size)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            m_Hash ^= bytes[i];
+            m_Hash *= 0x100000001b3ull;
+        }
+    }
+
+    void Add(const std::string& text)
+    {
+        // the length goes in first so that "ab" + "c" and "a" + "bc" don't hash the same
+        const uint64_t length = text.size();
+        Add(&length, sizeof(length));
+        Add(text.data(), text.size());
+    }
+
+    void Add(GLenum stage, const std::string& source)
+    {
+        Add(&stage, sizeof(stage));
+        Add(source);
+    }
+
+    uint64_t GetHash() const { return m_Hash; }
+
+private:
+    uint64_t m_Hash = 0xcbf29ce484222325ull;
+};
+
+// one stage of a program for ShaderCache::Build: which stage, its source, and the type name compile
+// errors are reported under ("VERTEX", "FRAGMENT", ...)
+struct ShaderStageSource
+{
+    GLenum stage;
+    std::string source;
+    std::string type;
+};
+
+// how long building the programs took, split by where they came from
+struct ShaderCacheStats
+{
+    unsigned int cacheHits = 0;
+    unsigned int compiled = 0;
+    double cacheMilliseconds = 0.0;   // reading and uploading binaries, including the file io
+    double compileMilliseconds = 0.0; // compiling and linking from source, including storing the binary
+};
+
+// On-disk cache of linked program binaries (glGetProgramBinary/glProgramBinary, core since OpenGL 4.1).
+// The shader classes build their programs through Build(), which looks a program up by the hash of its
+// sources before compiling anything and only falls back to glCompileShader when there is no usable
+// binary: when the cache is disabled, the context is older than 4.1, the driver offers no binary formats,
+// or it rejects a stored binary (after a driver update, for instance; the key includes the driver
+// strings so that is rare).
+// Mesa (llvmpipe included) only offers a binary format while its own shader disk cache is enabled.
+//
+// Binaries go to shader_cache/ in the working directory. Set LOGL_SHADER_CACHE to
+// another directory, or to 0 to turn the cache off. Set LOGL_SHADER_TIMING to print how long each
+// program took to build.
+class ShaderCache
+{
+public:
+    static bool IsEnabled()
+    {
+        static const bool enabled = getDirectory() != "0";
+        return enabled && isSupported();
+    }
+
+    // starts a key with the identity of the driver, so binaries are never offered to a different one
+    static ShaderCacheKey MakeKey()
+    {
+        ShaderCacheKey key;
+        key.Add(getDriverString());
+        return key;
+    }
+
+    // a linked program restored from the cache, or 0 if there is none
+    static unsigned int Load(const ShaderCacheKey& key)
+    {
+        if (!IsEnabled())
+            return 0;
+        std::ifstream file(getPath(key), std::ios::binary);
+        if (!file)
+            return 0;
+
+        FileHeader header;
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, MAGIC, sizeof(header.magic)) != 0 ||
+            header.hash != key.GetHash() || header.length == 0)
+            return 0;
+        std::vector<char> binary(header.length);
+        if (!file.read(binary.data(), binary.size()))
+            return 0;
+
+        unsigned int program = glCreateProgram();
+        glProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+        GLint success = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success)
+        {
+            // the driver no longer accepts it; compile from source and overwrite the stale file
+            glDeleteProgram(program);
+            return 0;
+        }
+        return program;
+    }
+
+    // the program made of stages: restored from the cache if an earlier run stored it, otherwise compiled,
+    // linked and stored. checkErrors(object, type) is called on every compiled shader with its type and on
+    // the linked program with "PROGRAM"; fromCache tells which of the two happened
+    template<typename CheckErrors>
+    static unsigned int Build(const std::vector<ShaderStageSource>& stages, bool& fromCache, CheckErrors checkErrors)
+    {
+        ShaderCacheKey key = MakeKey();
+        for (const ShaderStageSource& stage : stages)
+            key.Add(stage.stage, stage.source);
+        unsigned int program = Load(key);
+        fromCache = program != 0;
+        if (fromCache)
+            return program;
+
+        std::vector<unsigned int> shaders;
+        for (const ShaderStageSource& stage : stages)
+        {
+            const char* code = stage.source.c_str();
+            const unsigned int shader = glCreateShader(stage.stage);
+            glShaderSource(shader, 1, &code, NULL);
+            glCompileShader(shader);
+            checkErrors(shader, stage.type);
+            shaders.push_back(shader);
+        }
+        program = glCreateProgram();
+        for (unsigned int shader : shaders)
+            glAttachShader(program, shader);
+        PrepareForLink(program);
+        glLinkProgram(program);
+        checkErrors(program, std::string("PROGRAM"));
+        Store(program, key);
+        // delete the shaders as they're linked into our program now and no longer necessary
+        for (unsigned int shader : shaders)
+            glDeleteShader(shader);
+        return program;
+    }
+
+    // asks the driver to keep the binary of program around; call before glLinkProgram
+    static void PrepareForLink(unsigned int program)
+    {
+        if (IsEnabled())
+            glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    // writes the binary of a successfully linked program
+    static void Store(unsigned int program, const ShaderCacheKey& key)
+    {
+        if (!IsEnabled())
+            return;
+        GLint success = 0, length = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (!success || length <= 0)
+            return;
+
+        FileHeader header;
+        std::memcpy(header.magic, MAGIC, sizeof(header.magic));
+        header.hash = key.GetHash();
+        std::vector<char> binary(length);
+        GLsizei written = 0;
+        glGetProgramBinary(program, length, &written, &header.format, binary.data());
+        if (written <= 0)
+            return;
+        header.length = (uint32_t)written;
+
+        std::error_code error;
+        std::filesystem::create_directories(getDirectory(), error);
+        // written under a temporary name and renamed, so a demo that is killed halfway never leaves a
+        // truncated binary behind. The name is unique, so demos (or threads) storing the same program at
+        // the same time each write their own file and the last rename wins
+        const std::string path = getPath(key);
+        const std::string temporary = path + "." + getUniqueSuffix() + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            if (!file.write(reinterpret_cast<const char*>(&header), sizeof(header)) || !file.write(binary.data(), written))
+            {
+                std::cout << "ERROR::SHADER_CACHE::WRITE_FAILED: " << temporary << std::endl;
+                return;
+            }
+        }
+        std::filesystem::rename(temporary, path, error);
+        if (error)
+            std::filesystem::remove(temporary, error);
+    }
+
+    // records how long one program took to build; name is whatever identifies it in the output
+    static void Record(const std::string& name, std::chrono::steady_clock::time_point start, bool fromCache)
+    {
+        const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        ShaderCacheStats& stats = GetStats();
+        if (fromCache)
+        {
+            stats.cacheHits++;
+            stats.cacheMilliseconds += milliseconds;
+        }
+        else
+        {
+            stats.compiled++;
+            stats.compileMilliseconds += milliseconds;
+        }
+        static const bool printTiming = std::getenv("LOGL_SHADER_TIMING") != nullptr;
+        if (printTiming)
+            std::cout << "SHADER::TIMING: " << name << (fromCache ? " loaded from cache in " : " compiled in ") << milliseconds << " ms" << std::endl;
+    }
+
+    static ShaderCacheStats& GetStats()
+    {
+        static ShaderCacheStats stats;
+        return stats;
+    }
+
+private:
+    static constexpr char MAGIC[8] = { 'L', 'O', 'G', 'L', 'P', 'B', 'I', 'N' };
+
+    struct FileHeader
+    {
+        char magic[8];
+        uint64_t hash;     // the whole key, in case two keys ever end up on the same file name
+        GLenum format = 0;
+        uint32_t length = 0;
+    };
+
+    static bool isSupported()
+    {
+        // needs a current context, so it can't be answered once at startup
+        if (!GLAD_GL_VERSION_4_1)
+            return false;
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        return formats > 0;
+    }
+
+    static const std::string& getDirectory()
+    {
+        static const char* env = std::getenv("LOGL_SHADER_CACHE");
+        static const std::string directory = env != nullptr && env[0] != '\0' ? env : "shader_cache";
+        return directory;
+    }
+
+    static std::string getPath(const ShaderCacheKey& key)
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key.GetHash());
+        return getDirectory() + "/" + name;
+    }
+
+    // random per process, counting up within it
+    static std::string getUniqueSuffix()
+    {
+        static const uint64_t processId = (uint64_t(std::random_device()()) << 32) ^ uint64_t(std::chrono::steady_clock::now().time_since_epoch().count());
+        static std::atomic<unsigned int> counter(0);
+        char suffix[32];
+        std::snprintf(suffix, sizeof(suffix), "%016llx-%u", (unsigned long long)processId, counter++);
+        return suffix;
+    }
+
+    static std::string getDriverString()
+    {
+        std::string driver;
+        const GLenum names[] = { GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION };
+        for (GLenum name : names)
+        {
+            const GLubyte* value = glGetString(name);
+            driver += value ? reinterpret_cast<const char*>(value) : "";
+            driver += '\n';
+        }
+        return driver;
+    }
+};
+#endif
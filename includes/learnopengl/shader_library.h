@@ -0,0 +1,132 @@
+#ifndef SHADER_LIBRARY_H
+#define SHADER_LIBRARY_H
+
+#include <learnopengl/shader.h>
+#include <learnopengl/shader_cache.h>
+#include <learnopengl/shader_preprocessor.h>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Owns the permutations of a demo's shaders. Asking for the same files with the same defines twice
+// returns the same Shader, and so do two requests whose preprocessed sources turn out identical (a
+// define none of the files mention, for instance), so every distinct program is compiled once.
+// Requests merged that way keep sharing their Shader after a reload.
+//
+// Reload() is for hot reloading: it rebuilds only the programs that were assembled from a file that
+// changed on disk. A rebuilt program starts with default uniform values and new uniform handles, so
+// callers redo their one-off setup for the shaders it returns.
+class ShaderLibrary
+{
+public:
+    ShaderLibrary(ShaderPreprocessor& preprocessor = ShaderPreprocessor::Shared()) : m_Preprocessor(preprocessor) { }
+
+    ShaderLibrary(const ShaderLibrary&) = delete;
+    ShaderLibrary& operator=(const ShaderLibrary&) = delete;
+
+    // geometryPath may be empty; the Shader stays valid for as long as the library
+    Shader& Get(const std::string& vertexPath, const std::string& fragmentPath, const ShaderDefines& defines = ShaderDefines(),
+        const std::string& geometryPath = std::string())
+    {
+        const std::string request = vertexPath + '\n' + fragmentPath + '\n' + geometryPath + '\n' + defines.ToSource();
+        std::unordered_map<std::string, Variant*>::iterator it = m_Requests.find(request);
+        if (it != m_Requests.end())
+            return *it->second->shader;
+
+        std::unique_ptr<Variant> variant(new Variant());
+        variant->vertexPath = vertexPath;
+        variant->fragmentPath = fragmentPath;
+        variant->geometryPath = geometryPath;
+        variant->defines = defines;
+        Sources sources = preprocess(*variant);
+
+        std::unordered_map<uint64_t, Variant*>::iterator same = m_BySource.find(sources.hash);
+        if (same != m_BySource.end())
+        {
+            m_Requests.emplace(request, same->second);
+            return *same->second->shader;
+        }
+
+        variant->shader.reset(new Shader());
+        variant->shader->compile(sources.vertex, sources.fragment, sources.geometry, vertexPath);
+        variant->hash = sources.hash;
+        Variant* added = variant.get();
+        m_Variants.push_back(std::move(variant));
+        m_BySource.emplace(sources.hash, added);
+        m_Requests.emplace(request, added);
+        return *added->shader;
+    }
+
+    // rebuilds every program whose files changed on disk since they were read and returns those shaders
+    std::vector<Shader*> Reload()
+    {
+        std::vector<Shader*> reloaded;
+        const std::vector<std::string> changed = m_Preprocessor.Refresh();
+        if (changed.empty())
+            return reloaded;
+        for (std::unique_ptr<Variant>& variant : m_Variants)
+        {
+            if (!ShaderPreprocessor::DependsOn(variant->files, changed))
+                continue;
+            Sources sources = preprocess(*variant);
+            if (sources.hash == variant->hash)
+                continue;
+            variant->shader->compile(sources.vertex, sources.fragment, sources.geometry, variant->vertexPath);
+            std::unordered_map<uint64_t, Variant*>::iterator previous = m_BySource.find(variant->hash);
+            if (previous != m_BySource.end() && previous->second == variant.get())
+                m_BySource.erase(previous);
+            variant->hash = sources.hash;
+            m_BySource.emplace(sources.hash, variant.get());
+            reloaded.push_back(variant->shader.get());
+        }
+        return reloaded;
+    }
+
+    // number of distinct programs built so far
+    size_t Size() const { return m_Variants.size(); }
+
+private:
+    struct Variant
+    {
+        std::unique_ptr<Shader> shader;
+        std::string vertexPath, fragmentPath, geometryPath;
+        ShaderDefines defines;
+        std::vector<std::string> files; // every file of every stage
+        uint64_t hash = 0;
+    };
+
+    struct Sources
+    {
+        std::string vertex, fragment, geometry;
+        uint64_t hash;
+    };
+
+    ShaderPreprocessor& m_Preprocessor;
+    std::vector<std::unique_ptr<Variant>> m_Variants;
+    std::unordered_map<uint64_t, Variant*> m_BySource;
+    std::unordered_map<std::string, Variant*> m_Requests; // files + defines -> variant
+
+    Sources preprocess(Variant& variant)
+    {
+        Sources sources;
+        variant.files.clear();
+        ShaderCacheKey key;
+        const std::string* paths[] = { &variant.vertexPath, &variant.fragmentPath, &variant.geometryPath };
+        std::string* codes[] = { &sources.vertex, &sources.fragment, &sources.geometry };
+        const GLenum stages[] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER, GL_GEOMETRY_SHADER };
+        for (int i = 0; i < 3; i++)
+        {
+            if (paths[i]->empty())
+                continue;
+            PreprocessedShader stage = m_Preprocessor.Process(*paths[i], variant.defines);
+            *codes[i] = std::move(stage.source);
+            variant.files.insert(variant.files.end(), stage.files.begin(), stage.files.end());
+            key.Add(stages[i], *codes[i]);
+        }
+        sources.hash = key.GetHash();
+        return sources;
+    }
+};
+#endif
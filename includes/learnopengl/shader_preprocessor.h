@@ -0,0 +1,390 @@
+#ifndef SHADER_PREPROCESSOR_H
+#define SHADER_PREPROCESSOR_H
+
+#include <learnopengl/filesystem.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Defines injected into a shader to select one permutation of it. They are kept sorted by name, so the
+// same set always produces the same source, whatever order it was built in.
+class ShaderDefines
+{
+public:
+    ShaderDefines() { }
+    ShaderDefines(std::initializer_list<std::pair<std::string, std::string>> defines)
+    {
+        for (const std::pair<std::string, std::string>& define : defines)
+            Set(define.first, define.second);
+    }
+
+    ShaderDefines& Set(const std::string& name, const std::string& value = "1")
+    {
+        std::vector<std::pair<std::string, std::string>>::iterator it = std::lower_bound(m_Defines.begin(), m_Defines.end(), name,
+            [](const std::pair<std::string, std::string>& define, const std::string& key) { return define.first < key; });
+        if (it != m_Defines.end() && it->first == name)
+            it->second = value;
+        else
+            m_Defines.insert(it, std::make_pair(name, value));
+        return *this;
+    }
+
+    ShaderDefines& Set(const std::string& name, int value)
+    {
+        return Set(name, std::to_string(value));
+    }
+
+    bool Empty() const { return m_Defines.empty(); }
+    const std::vector<std::pair<std::string, std::string>>& Get() const { return m_Defines; }
+
+    // one "#define NAME VALUE" line per define
+    std::string ToSource() const
+    {
+        std::string source;
+        for (const std::pair<std::string, std::string>& define : m_Defines)
+            source += "#define " + define.first + " " + define.second + "\n";
+        return source;
+    }
+
+private:
+    std::vector<std::pair<std::string, std::string>> m_Defines;
+};
+
+// a shader stage ready for glShaderSource, and every file it was assembled from
+struct PreprocessedShader
+{
+    std::string source;
+    std::vector<std::string> files; // the shader itself first, then its includes
+};
+
+// Resolves #include "file" in GLSL sources and injects permutation defines. It doesn't touch the GPU.
+//
+// An include is looked up next to the file that includes it first and then relative to the project
+// root (FileSystem::getPath), so shared code can live anywhere in the tree. Every file is included
+// at most once per shader, which makes include guards unnecessary; cycles are reported. #line
+// directives keep compiler messages pointing at the right line, with the index of the file in
+// PreprocessedShader::files as the source string number. A shader without includes or defines comes
+// out exactly as it went in.
+//
+// Sources registered with AddSource live in memory and are found under their name before anything on
+// disk; the GLSL helpers of the shared headers are registered like that (see the constructor).
+//
+// Files are read once and the include-expanded text of every shader is kept, so building several
+// permutations of one shader only costs pasting in the defines. Defines whose name doesn't occur in
+// the shader are dropped. Refresh() throws away whatever was
+// modified on disk since it was read.
+class ShaderPreprocessor
+{
+public:
+    // the instance the Shader constructor goes through
+    static ShaderPreprocessor& Shared()
+    {
+        static ShaderPreprocessor preprocessor;
+        return preprocessor;
+    }
+
+    // makes #include "name" resolve to text; replacing a source forgets the shaders that included it
+    void AddSource(const std::string& name, const std::string& text)
+    {
+        const std::string path = Normalize(name);
+        m_Sources[path] = text;
+        for (std::unordered_map<std::string, Resolved>::iterator it = m_Resolved.begin(); it != m_Resolved.end(); )
+        {
+            if (DependsOn(it->second.files, { path }))
+                it = m_Resolved.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    PreprocessedShader Process(const std::string& path, const ShaderDefines& defines = ShaderDefines())
+    {
+        const Resolved& resolved = resolve(Normalize(path));
+        PreprocessedShader shader;
+        shader.files = resolved.files;
+        const std::string& text = resolved.text;
+
+        // defines the shader never mentions are left out, so they don't create a permutation of their own
+        std::string defineSource;
+        for (const std::pair<std::string, std::string>& define : defines.Get())
+            if (containsIdentifier(text, define.first))
+                defineSource += "#define " + define.first + " " + define.second + "\n";
+        if (defineSource.empty())
+        {
+            shader.source = text;
+            return shader;
+        }
+
+        // defines go right after #version, which has to stay the first statement
+        size_t insertAt = 0;
+        int lineAfter = 1;
+        const size_t version = findDirective(text, "version");
+        if (version != std::string::npos)
+        {
+            const size_t end = text.find('\n', version);
+            insertAt = end == std::string::npos ? text.size() : end + 1;
+            lineAfter = 1 + (int)std::count(text.begin(), text.begin() + insertAt, '\n');
+        }
+        shader.source.reserve(text.size() + 256);
+        shader.source.append(text, 0, insertAt);
+        if (insertAt > 0 && text[insertAt - 1] != '\n')
+            shader.source += '\n';
+        shader.source += defineSource;
+        shader.source += "#line " + std::to_string(lineAfter) + " 0\n";
+        shader.source.append(text, insertAt, std::string::npos);
+        return shader;
+    }
+
+    // forgets every file that changed on disk (or disappeared) since it was read, and every shader that
+    // included one; returns their paths so callers can tell which of their shaders are affected
+    std::vector<std::string> Refresh()
+    {
+        std::vector<std::string> changed;
+        for (std::unordered_map<std::string, SourceFile>::iterator it = m_Files.begin(); it != m_Files.end(); )
+        {
+            if (getModifiedTime(it->first) != it->second.modified)
+            {
+                changed.push_back(it->first);
+                it = m_Files.erase(it);
+            }
+            else
+                ++it;
+        }
+        if (changed.empty())
+            return changed;
+        for (std::unordered_map<std::string, Resolved>::iterator it = m_Resolved.begin(); it != m_Resolved.end(); )
+        {
+            if (DependsOn(it->second.files, changed))
+                it = m_Resolved.erase(it);
+            else
+                ++it;
+        }
+        return changed;
+    }
+
+    void Clear()
+    {
+        m_Files.clear();
+        m_Resolved.clear();
+    }
+
+    // whether any of files is in changed
+    static bool DependsOn(const std::vector<std::string>& files, const std::vector<std::string>& changed)
+    {
+        for (const std::string& file : files)
+            if (std::find(changed.begin(), changed.end(), file) != changed.end())
+                return true;
+        return false;
+    }
+
+    // the form paths are stored and compared in
+    static std::string Normalize(const std::string& path)
+    {
+        return std::filesystem::path(path).lexically_normal().generic_string();
+    }
+
+private:
+    struct SourceFile
+    {
+        std::string text;
+        std::filesystem::file_time_type modified;
+    };
+
+    struct Resolved
+    {
+        std::string text; // includes expanded, no defines yet
+        std::vector<std::string> files;
+    };
+
+    std::unordered_map<std::string, SourceFile> m_Files;
+    std::unordered_map<std::string, std::string> m_Sources; // added with AddSource, never refreshed
+    std::unordered_map<std::string, Resolved> m_Resolved;
+
+    const Resolved& resolve(const std::string& path)
+    {
+        std::unordered_map<std::string, Resolved>::iterator it = m_Resolved.find(path);
+        if (it != m_Resolved.end())
+            return it->second;
+
+        Resolved resolved;
+        std::vector<std::string> stack;
+        expand(path, resolved, stack);
+        return m_Resolved.emplace(path, std::move(resolved)).first->second;
+    }
+
+    void expand(const std::string& path, Resolved& resolved, std::vector<std::string>& stack)
+    {
+        const int fileIndex = (int)resolved.files.size();
+        resolved.files.push_back(path);
+        stack.push_back(path);
+
+        const std::string& text = read(path);
+        const bool isInclude = stack.size() > 1;
+        if (isInclude)
+            resolved.text += "#line 1 " + std::to_string(fileIndex) + "\n";
+
+        size_t lineStart = 0;
+        int lineNumber = 1;
+        while (lineStart < text.size())
+        {
+            size_t lineEnd = text.find('\n', lineStart);
+            const bool lastLine = lineEnd == std::string::npos;
+            if (lastLine)
+                lineEnd = text.size();
+            const std::string line = text.substr(lineStart, lineEnd - lineStart);
+
+            std::string name;
+            if (parseInclude(line, name))
+            {
+                const std::string includePath = findInclude(name, path);
+                if (includePath.empty())
+                    std::cout << "ERROR::SHADER::INCLUDE_NOT_FOUND: " << name << " (" << path << ":" << lineNumber << ")" << std::endl;
+                else if (std::find(stack.begin(), stack.end(), includePath) != stack.end())
+                    std::cout << "ERROR::SHADER::INCLUDE_CYCLE: " << includePath << " (" << path << ":" << lineNumber << ")" << std::endl;
+                else if (std::find(resolved.files.begin(), resolved.files.end(), includePath) == resolved.files.end())
+                {
+                    expand(includePath, resolved, stack);
+                    resolved.text += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileIndex) + "\n";
+                }
+            }
+            else if (!(isInclude && isPragmaOnce(line)))
+            {
+                resolved.text += line;
+                if (!lastLine || isInclude)
+                    resolved.text += '\n';
+            }
+            lineStart = lineEnd + 1;
+            lineNumber++;
+        }
+        stack.pop_back();
+    }
+
+    const std::string& read(const std::string& path)
+    {
+        std::unordered_map<std::string, std::string>::const_iterator source = m_Sources.find(path);
+        if (source != m_Sources.end())
+            return source->second;
+        std::unordered_map<std::string, SourceFile>::iterator it = m_Files.find(path);
+        if (it != m_Files.end())
+            return it->second.text;
+
+        SourceFile file;
+        file.modified = getModifiedTime(path);
+        std::ifstream stream;
+        stream.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+        try
+        {
+            stream.open(path);
+            std::stringstream buffer;
+            buffer << stream.rdbuf();
+            stream.close();
+            file.text = buffer.str();
+        }
+        catch (std::ifstream::failure& e)
+        {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << path << ": " << e.what() << std::endl;
+        }
+        return m_Files.emplace(path, std::move(file)).first->second.text;
+    }
+
+    static std::filesystem::file_time_type getModifiedTime(const std::string& path)
+    {
+        std::error_code error;
+        const std::filesystem::file_time_type modified = std::filesystem::last_write_time(path, error);
+        return error ? std::filesystem::file_time_type::min() : modified;
+    }
+
+    std::string findInclude(const std::string& name, const std::string& includer) const
+    {
+        const std::string source = Normalize(name);
+        if (m_Sources.count(source) != 0)
+            return source;
+        std::error_code error;
+        const std::string besideIncluder = Normalize((std::filesystem::path(includer).parent_path() / name).string());
+        if (std::filesystem::is_regular_file(besideIncluder, error))
+            return besideIncluder;
+        const std::string fromRoot = Normalize(FileSystem::getPath(name));
+        if (std::filesystem::is_regular_file(fromRoot, error))
+            return fromRoot;
+        return std::string();
+    }
+
+    // position of the first "#name" directive in text, npos if there is none
+    static size_t findDirective(const std::string& text, const char* name)
+    {
+        size_t lineStart = 0;
+        while (lineStart < text.size())
+        {
+            size_t pos = text.find_first_not_of(" \t", lineStart);
+            if (pos != std::string::npos && text[pos] == '#')
+            {
+                pos = text.find_first_not_of(" \t", pos + 1);
+                if (pos != std::string::npos && text.compare(pos, std::strlen(name), name) == 0)
+                    return lineStart;
+            }
+            const size_t lineEnd = text.find('\n', lineStart);
+            if (lineEnd == std::string::npos)
+                break;
+            lineStart = lineEnd + 1;
+        }
+        return std::string::npos;
+    }
+
+    static bool containsIdentifier(const std::string& text, const std::string& name)
+    {
+        for (size_t pos = text.find(name); pos != std::string::npos; pos = text.find(name, pos + 1))
+        {
+            const size_t end = pos + name.size();
+            if ((pos == 0 || !isIdentifierChar(text[pos - 1])) && (end == text.size() || !isIdentifierChar(text[end])))
+                return true;
+        }
+        return false;
+    }
+
+    static bool isIdentifierChar(char c)
+    {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    }
+
+    // #include "name" or #include <name>
+    static bool parseInclude(const std::string& line, std::string& name)
+    {
+        size_t pos = line.find_first_not_of(" \t");
+        if (pos == std::string::npos || line[pos] != '#')
+            return false;
+        pos = line.find_first_not_of(" \t", pos + 1);
+        if (pos == std::string::npos || line.compare(pos, 7, "include") != 0)
+            return false;
+        pos = line.find_first_not_of(" \t", pos + 7);
+        if (pos == std::string::npos || (line[pos] != '"' && line[pos] != '<'))
+            return false;
+        const size_t end = line.find(line[pos] == '"' ? '"' : '>', pos + 1);
+        if (end == std::string::npos)
+            return false;
+        name = line.substr(pos + 1, end - pos - 1);
+        return true;
+    }
+
+    static bool isPragmaOnce(const std::string& line)
+    {
+        std::istringstream stream(line);
+        std::string hash, pragma, once;
+        stream >> hash;
+        if (hash == "#pragma")
+            stream >> once;
+        else if (hash == "#")
+            stream >> pragma >> once;
+        else
+            return false;
+        return (hash == "#pragma" || pragma == "pragma") && once == "once";
+    }
+};
+#endif
@@ -3,12 +3,16 @@
 
 #include <glad/glad.h>
 
+#include <chrono>
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 
-class Shader
+#include <learnopengl/shader_cache.h>
+#include <learnopengl/shader_uniforms.h>
+
+class Shader : public ShaderUniformSetters
 {
 public:
     unsigned int ID;
@@ -16,6 +20,7 @@ public:
     // ------------------------------------------------------------------------
     Shader(const char* vertexPath, const char* fragmentPath)
     {
+        const auto start = std::chrono::steady_clock::now();
         // 1. retrieve the vertex/fragment source code from filePath
         std::string vertexCode;
         std::string fragmentCode;
@@ -44,29 +49,12 @@ public:
         {
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << e.what() << std::endl;
         }
-        const char* vShaderCode = vertexCode.c_str();
-        const char * fShaderCode = fragmentCode.c_str();
-        // 2. compile shaders
-        unsigned int vertex, fragment;
-        // vertex shader
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
-        glCompileShader(vertex);
-        checkCompileErrors(vertex, "VERTEX");
-        // fragment Shader
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);
-        glCompileShader(fragment);
-        checkCompileErrors(fragment, "FRAGMENT");
-        // shader Program
-        ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
-        glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
-        // delete the shaders as they're linked into our program now and no longer necessary
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
+        // 2. reuse the program binary of an earlier run if the sources haven't changed, otherwise compile them
+        bool fromCache;
+        ID = ShaderCache::Build({ { GL_VERTEX_SHADER, vertexCode, "VERTEX" }, { GL_FRAGMENT_SHADER, fragmentCode, "FRAGMENT" } }, fromCache,
+            [this](unsigned int object, const std::string &type) { checkCompileErrors(object, type); });
+        uniforms.Reflect(ID);
+        ShaderCache::Record(vertexPath, start, fromCache);
     }
     // activate the shader
     // ------------------------------------------------------------------------
@@ -74,22 +62,8 @@ public:
     { 
         glUseProgram(ID); 
     }
-    // utility uniform functions
-    // ------------------------------------------------------------------------
-    void setBool(const std::string &name, bool value) const
-    {         
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
-    }
-    // ------------------------------------------------------------------------
-    void setInt(const std::string &name, int value) const
-    { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
-    }
-    // ------------------------------------------------------------------------
-    void setFloat(const std::string &name, float value) const
-    { 
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
-    }
+    // the uniform setters (setBool, setInt, ..., setMat4, by name or by a handle from getUniform()) come
+    // from ShaderUniformSetters in shader_uniforms.h
 
 private:
     // utility function for checking shader compilation/linking errors.
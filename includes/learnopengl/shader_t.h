@@ -4,12 +4,17 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <chrono>
 #include <string>
+#include <vector>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 
-class Shader
+#include <learnopengl/shader_cache.h>
+#include <learnopengl/shader_uniforms.h>
+
+class Shader : public ShaderUniformSetters
 {
 public:
     unsigned int ID;
@@ -18,6 +23,7 @@ public:
     Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr,
            const char* tessControlPath = nullptr, const char* tessEvalPath = nullptr)
     {
+        const auto start = std::chrono::steady_clock::now();
         // 1. retrieve the vertex/fragment source code from filePath
         std::string vertexCode;
         std::string fragmentCode;
@@ -79,67 +85,18 @@ public:
             std::cout << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " 
                 << e.what() << std::endl;
         }
-        const char* vShaderCode = vertexCode.c_str();
-        const char * fShaderCode = fragmentCode.c_str();
-        // 2. compile shaders
-        unsigned int vertex, fragment;
-        // vertex shader
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
-        glCompileShader(vertex);
-        checkCompileErrors(vertex, "VERTEX");
-        // fragment Shader
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);
-        glCompileShader(fragment);
-        checkCompileErrors(fragment, "FRAGMENT");
-        // if geometry shader is given, compile geometry shader
-        unsigned int geometry;
-        if(geometryPath != nullptr)
-        {
-            const char * gShaderCode = geometryCode.c_str();
-            geometry = glCreateShader(GL_GEOMETRY_SHADER);
-            glShaderSource(geometry, 1, &gShaderCode, NULL);
-            glCompileShader(geometry);
-            checkCompileErrors(geometry, "GEOMETRY");
-        }
-        // if tessellation shader is given, compile tessellation shader
-        unsigned int tessControl;
-        if(tessControlPath != nullptr)
-        {
-            const char * tcShaderCode = tessControlCode.c_str();
-            tessControl = glCreateShader(GL_TESS_CONTROL_SHADER);
-            glShaderSource(tessControl, 1, &tcShaderCode, NULL);
-            glCompileShader(tessControl);
-            checkCompileErrors(tessControl, "TESS_CONTROL");
-        }
-        unsigned int tessEval;
-        if(tessEvalPath != nullptr)
-        {
-            const char * teShaderCode = tessEvalCode.c_str();
-            tessEval = glCreateShader(GL_TESS_EVALUATION_SHADER);
-            glShaderSource(tessEval, 1, &teShaderCode, NULL);
-            glCompileShader(tessEval);
-            checkCompileErrors(tessEval, "TESS_EVALUATION");
-        }
-        // shader Program
-        ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
+        // 2. reuse the program binary of an earlier run if the sources haven't changed, otherwise compile them
+        bool fromCache;
+        std::vector<ShaderStageSource> stages = { { GL_VERTEX_SHADER, vertexCode, "VERTEX" }, { GL_FRAGMENT_SHADER, fragmentCode, "FRAGMENT" } };
         if(geometryPath != nullptr)
-            glAttachShader(ID, geometry);
+            stages.push_back({ GL_GEOMETRY_SHADER, geometryCode, "GEOMETRY" });
         if(tessControlPath != nullptr)
-            glAttachShader(ID, tessControl);
+            stages.push_back({ GL_TESS_CONTROL_SHADER, tessControlCode, "TESS_CONTROL" });
         if(tessEvalPath != nullptr)
-            glAttachShader(ID, tessEval);
-        glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
-        // delete the shaders as they're linked into our program now and no longer necessary
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
-        if(geometryPath != nullptr)
-            glDeleteShader(geometry);
-
+            stages.push_back({ GL_TESS_EVALUATION_SHADER, tessEvalCode, "TESS_EVALUATION" });
+        ID = ShaderCache::Build(stages, fromCache, [this](unsigned int object, const std::string &type) { checkCompileErrors(object, type); });
+        uniforms.Reflect(ID);
+        ShaderCache::Record(vertexPath, start, fromCache);
     }
     // activate the shader
     // ------------------------------------------------------------------------
@@ -147,64 +104,8 @@ public:
     {
         glUseProgram(ID);
     }
-    // utility uniform functions
-    // ------------------------------------------------------------------------
-    void setBool(const std::string &name, bool value) const
-    {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
-    }
-    // ------------------------------------------------------------------------
-    void setInt(const std::string &name, int value) const
-    {
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
-    }
-    // ------------------------------------------------------------------------
-    void setFloat(const std::string &name, float value) const
-    {
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
-    }
-    // ------------------------------------------------------------------------
-    void setVec2(const std::string &name, const glm::vec2 &value) const
-    {
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
-    }
-    void setVec2(const std::string &name, float x, float y) const
-    {
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
-    }
-    // ------------------------------------------------------------------------
-    void setVec3(const std::string &name, const glm::vec3 &value) const
-    {
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
-    }
-    void setVec3(const std::string &name, float x, float y, float z) const
-    {
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
-    }
-    // ------------------------------------------------------------------------
-    void setVec4(const std::string &name, const glm::vec4 &value) const
-    {
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
-    }
-    void setVec4(const std::string &name, float x, float y, float z, float w)
-    {
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
-    }
-    // ------------------------------------------------------------------------
-    void setMat2(const std::string &name, const glm::mat2 &mat) const
-    {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
-    }
-    // ------------------------------------------------------------------------
-    void setMat3(const std::string &name, const glm::mat3 &mat) const
-    {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
-    }
-    // ------------------------------------------------------------------------
-    void setMat4(const std::string &name, const glm::mat4 &mat) const
-    {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
-    }
+    // the uniform setters (setBool, setInt, ..., setMat4, by name or by a handle from getUniform()) come
+    // from ShaderUniformSetters in shader_uniforms.h
 
 private:
     // utility function for checking shader compilation/linking errors.
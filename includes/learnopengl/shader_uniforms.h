@@ -0,0 +1,378 @@
+#ifndef SHADER_UNIFORMS_H
+#define SHADER_UNIFORMS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Handle to one active uniform of a linked program, obtained once through Shader::getUniform<T>(name).
+// The type parameter is the C++ type the uniform is set with, so a handle for a vec3 can only be passed
+// to the vec3 setters. A default constructed handle (or one for a uniform that isn't active) is invalid
+// and setting it does nothing, the same as setting location -1. Handles belong to the shader that made them.
+template<typename T>
+struct Uniform
+{
+    int location = -1;
+    int slot = -1; // index into the owning ShaderUniforms value cache
+
+    bool IsValid() const { return slot >= 0; }
+};
+
+// how a value of type T is checked against the GLSL type reported by the driver and uploaded
+template<typename T> struct UniformTraits;
+
+namespace uniform_types
+{
+    inline bool IsFloatType(GLenum type)
+    {
+        switch (type)
+        {
+        case GL_FLOAT: case GL_FLOAT_VEC2: case GL_FLOAT_VEC3: case GL_FLOAT_VEC4:
+        case GL_FLOAT_MAT2: case GL_FLOAT_MAT3: case GL_FLOAT_MAT4:
+        case GL_FLOAT_MAT2x3: case GL_FLOAT_MAT2x4: case GL_FLOAT_MAT3x2:
+        case GL_FLOAT_MAT3x4: case GL_FLOAT_MAT4x2: case GL_FLOAT_MAT4x3:
+        case GL_DOUBLE:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // samplers and images are set with glUniform1i, as are ints and bools
+    inline bool IsIntType(GLenum type)
+    {
+        switch (type)
+        {
+        case GL_INT_VEC2: case GL_INT_VEC3: case GL_INT_VEC4:
+        case GL_BOOL_VEC2: case GL_BOOL_VEC3: case GL_BOOL_VEC4:
+        case GL_UNSIGNED_INT: case GL_UNSIGNED_INT_VEC2: case GL_UNSIGNED_INT_VEC3: case GL_UNSIGNED_INT_VEC4:
+            return false;
+        default:
+            return !IsFloatType(type);
+        }
+    }
+}
+
+template<> struct UniformTraits<bool>
+{
+    static bool Accepts(GLenum type) { return type == GL_BOOL || type == GL_INT; }
+    static void Upload(int location, const bool& value) { glUniform1i(location, (int)value); }
+};
+template<> struct UniformTraits<int>
+{
+    static bool Accepts(GLenum type) { return uniform_types::IsIntType(type); }
+    static void Upload(int location, const int& value) { glUniform1i(location, value); }
+};
+template<> struct UniformTraits<float>
+{
+    static bool Accepts(GLenum type) { return type == GL_FLOAT || type == GL_BOOL; }
+    static void Upload(int location, const float& value) { glUniform1f(location, value); }
+};
+template<> struct UniformTraits<glm::vec2>
+{
+    static bool Accepts(GLenum type) { return type == GL_FLOAT_VEC2; }
+    static void Upload(int location, const glm::vec2& value) { glUniform2fv(location, 1, &value[0]); }
+};
+template<> struct UniformTraits<glm::vec3>
+{
+    static bool Accepts(GLenum type) { return type == GL_FLOAT_VEC3; }
+    static void Upload(int location, const glm::vec3& value) { glUniform3fv(location, 1, &value[0]); }
+};
+template<> struct UniformTraits<glm::vec4>
+{
+    static bool Accepts(GLenum type) { return type == GL_FLOAT_VEC4; }
+    static void Upload(int location, const glm::vec4& value) { glUniform4fv(location, 1, &value[0]); }
+};
+template<> struct UniformTraits<glm::mat2>
+{
+    static bool Accepts(GLenum type) { return type == GL_FLOAT_MAT2; }
+    static void Upload(int location, const glm::mat2& value) { glUniformMatrix2fv(location, 1, GL_FALSE, &value[0][0]); }
+};
+template<> struct UniformTraits<glm::mat3>
+{
+    static bool Accepts(GLenum type) { return type == GL_FLOAT_MAT3; }
+    static void Upload(int location, const glm::mat3& value) { glUniformMatrix3fv(location, 1, GL_FALSE, &value[0][0]); }
+};
+template<> struct UniformTraits<glm::mat4>
+{
+    static bool Accepts(GLenum type) { return type == GL_FLOAT_MAT4; }
+    static void Upload(int location, const glm::mat4& value) { glUniformMatrix4fv(location, 1, GL_FALSE, &value[0][0]); }
+};
+
+// Every active uniform of a program, read once after linking so that setting a uniform by name is a
+// hash map lookup instead of a glGetUniformLocation round trip into the driver. Arrays are listed per
+// element ("samples[3]") as well as by their bare name, the way glGetUniformLocation accepts them.
+//
+// Setting through a Uniform<T> handle also remembers the last value uploaded to that uniform and skips
+// the GL call when it hasn't changed. Setting by name always uploads and makes the handle of that uniform
+// forget its value. Anything else that uploads to the program behind its back (plain glUniform* calls on
+// shader.ID, a RenderStateCache, ...) isn't seen; call Invalidate() after such code. Like any glUniform*
+// call, the program has to be in use when a value is set.
+class ShaderUniforms
+{
+public:
+    struct Info
+    {
+        int location;
+        GLenum type;
+        int slot;
+    };
+
+    void Reflect(unsigned int program)
+    {
+        m_Uniforms.clear();
+        m_Values.clear();
+
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<GLchar> buffer(maxLength > 0 ? maxLength : 1);
+        for (GLint i = 0; i < count; i++)
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(program, (GLuint)i, (GLsizei)buffer.size(), &length, &size, &type, buffer.data());
+            std::string name(buffer.data(), length);
+            const int location = glGetUniformLocation(program, name.c_str());
+            if (location < 0) // members of uniform blocks have no location
+                continue;
+
+            // arrays come back as "name[0]" with their element count in size; elements past the first
+            // aren't guaranteed to have consecutive locations, so each one is queried
+            const bool isArray = name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0;
+            add(name, location, type);
+            if (isArray)
+            {
+                const std::string base = name.substr(0, name.size() - 3);
+                m_Uniforms.emplace(base, m_Uniforms[name]);
+                for (GLint element = 1; element < size; element++)
+                {
+                    const std::string elementName = base + "[" + std::to_string(element) + "]";
+                    add(elementName, glGetUniformLocation(program, elementName.c_str()), type);
+                }
+            }
+        }
+    }
+
+    // nullptr if the program has no active uniform of that name
+    const Info* Find(const std::string& name) const
+    {
+        std::unordered_map<std::string, Info>::const_iterator it = m_Uniforms.find(name);
+        return it == m_Uniforms.end() ? nullptr : &it->second;
+    }
+
+    int GetLocation(const std::string& name) const
+    {
+        const Info* info = Find(name);
+        return info ? info->location : -1;
+    }
+
+    // an invalid handle if the uniform isn't active (the compiler removes unused ones) or isn't a T
+    template<typename T>
+    Uniform<T> GetHandle(const std::string& name) const
+    {
+        Uniform<T> handle;
+        const Info* info = Find(name);
+        if (!info)
+            return handle;
+        if (!UniformTraits<T>::Accepts(info->type))
+        {
+            std::cout << "ERROR::SHADER::UNIFORM_TYPE_MISMATCH: " << name << std::endl;
+            return handle;
+        }
+        handle.location = info->location;
+        handle.slot = info->slot;
+        return handle;
+    }
+
+    // uploads value unless it is what this handle uploaded last
+    template<typename T>
+    void Set(Uniform<T> handle, const T& value) const
+    {
+        static_assert(sizeof(T) <= sizeof(CachedValue::data), "uniform value too large for the cache");
+        if (!handle.IsValid())
+            return;
+        CachedValue& cached = m_Values[handle.slot];
+        if (cached.valid && std::memcmp(cached.data, &value, sizeof(T)) == 0)
+            return;
+        std::memcpy(cached.data, &value, sizeof(T));
+        cached.valid = true;
+        UniformTraits<T>::Upload(handle.location, value);
+    }
+
+    // uploads value to the uniform called name, whatever was set before; does nothing if there is no such
+    // uniform, the same as glUniform* on location -1
+    template<typename T>
+    void Set(const std::string& name, const T& value) const
+    {
+        const Info* info = Find(name);
+        if (!info)
+            return;
+        m_Values[info->slot].valid = false;
+        UniformTraits<T>::Upload(info->location, value);
+    }
+
+    // forgets the remembered values, so the next Set through every handle uploads again
+    void Invalidate() const
+    {
+        for (CachedValue& cached : m_Values)
+            cached.valid = false;
+    }
+
+    size_t Size() const { return m_Uniforms.size(); }
+
+private:
+    struct CachedValue
+    {
+        unsigned char data[sizeof(glm::mat4)];
+        bool valid = false;
+    };
+
+    std::unordered_map<std::string, Info> m_Uniforms;
+    mutable std::vector<CachedValue> m_Values; // one per uniform location, indexed by Info::slot
+
+    void add(const std::string& name, int location, GLenum type)
+    {
+        if (location < 0)
+            return;
+        Info info = { location, type, (int)m_Values.size() };
+        m_Values.emplace_back();
+        m_Uniforms.emplace(name, info);
+    }
+};
+
+// The uniform setters the shader classes share, by name and by handle. A shader class derives from it and
+// calls uniforms.Reflect() on its program after linking.
+class ShaderUniformSetters
+{
+public:
+    // uniform handles: look a uniform up once, outside the render loop, and set it through the handle.
+    // Setting by handle skips the upload when the value is the one it set last time.
+    // ------------------------------------------------------------------------
+    template<typename T>
+    Uniform<T> getUniform(const std::string &name) const
+    {
+        return uniforms.GetHandle<T>(name);
+    }
+    // call after uploading to this program without going through the shader, so handles upload again
+    void resetUniformCache() const
+    {
+        uniforms.Invalidate();
+    }
+    // utility uniform functions
+    // ------------------------------------------------------------------------
+    void setBool(const std::string &name, bool value) const
+    {
+        uniforms.Set(name, value);
+    }
+    void setBool(Uniform<bool> uniform, bool value) const
+    {
+        uniforms.Set(uniform, value);
+    }
+    // ------------------------------------------------------------------------
+    void setInt(const std::string &name, int value) const
+    {
+        uniforms.Set(name, value);
+    }
+    void setInt(Uniform<int> uniform, int value) const
+    {
+        uniforms.Set(uniform, value);
+    }
+    // ------------------------------------------------------------------------
+    void setFloat(const std::string &name, float value) const
+    {
+        uniforms.Set(name, value);
+    }
+    void setFloat(Uniform<float> uniform, float value) const
+    {
+        uniforms.Set(uniform, value);
+    }
+    // ------------------------------------------------------------------------
+    void setVec2(const std::string &name, const glm::vec2 &value) const
+    {
+        uniforms.Set(name, value);
+    }
+    void setVec2(const std::string &name, float x, float y) const
+    {
+        uniforms.Set(name, glm::vec2(x, y));
+    }
+    void setVec2(Uniform<glm::vec2> uniform, const glm::vec2 &value) const
+    {
+        uniforms.Set(uniform, value);
+    }
+    void setVec2(Uniform<glm::vec2> uniform, float x, float y) const
+    {
+        uniforms.Set(uniform, glm::vec2(x, y));
+    }
+    // ------------------------------------------------------------------------
+    void setVec3(const std::string &name, const glm::vec3 &value) const
+    {
+        uniforms.Set(name, value);
+    }
+    void setVec3(const std::string &name, float x, float y, float z) const
+    {
+        uniforms.Set(name, glm::vec3(x, y, z));
+    }
+    void setVec3(Uniform<glm::vec3> uniform, const glm::vec3 &value) const
+    {
+        uniforms.Set(uniform, value);
+    }
+    void setVec3(Uniform<glm::vec3> uniform, float x, float y, float z) const
+    {
+        uniforms.Set(uniform, glm::vec3(x, y, z));
+    }
+    // ------------------------------------------------------------------------
+    void setVec4(const std::string &name, const glm::vec4 &value) const
+    {
+        uniforms.Set(name, value);
+    }
+    void setVec4(const std::string &name, float x, float y, float z, float w) const
+    {
+        uniforms.Set(name, glm::vec4(x, y, z, w));
+    }
+    void setVec4(Uniform<glm::vec4> uniform, const glm::vec4 &value) const
+    {
+        uniforms.Set(uniform, value);
+    }
+    void setVec4(Uniform<glm::vec4> uniform, float x, float y, float z, float w) const
+    {
+        uniforms.Set(uniform, glm::vec4(x, y, z, w));
+    }
+    // ------------------------------------------------------------------------
+    void setMat2(const std::string &name, const glm::mat2 &mat) const
+    {
+        uniforms.Set(name, mat);
+    }
+    void setMat2(Uniform<glm::mat2> uniform, const glm::mat2 &mat) const
+    {
+        uniforms.Set(uniform, mat);
+    }
+    // ------------------------------------------------------------------------
+    void setMat3(const std::string &name, const glm::mat3 &mat) const
+    {
+        uniforms.Set(name, mat);
+    }
+    void setMat3(Uniform<glm::mat3> uniform, const glm::mat3 &mat) const
+    {
+        uniforms.Set(uniform, mat);
+    }
+    // ------------------------------------------------------------------------
+    void setMat4(const std::string &name, const glm::mat4 &mat) const
+    {
+        uniforms.Set(name, mat);
+    }
+    void setMat4(Uniform<glm::mat4> uniform, const glm::mat4 &mat) const
+    {
+        uniforms.Set(uniform, mat);
+    }
+
+protected:
+    ShaderUniforms uniforms;
+};
+#endif
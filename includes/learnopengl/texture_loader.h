@@ -0,0 +1,150 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <glad/glad.h>
+
+#include <stb_image.h>
+
+#include <learnopengl/texture_registry.h>
+#include <learnopengl/thread_pool.h>
+
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// pixels of a decoded image file; data is owned by stb_image and released with Free().
+struct DecodedImage
+{
+    unsigned char *data = nullptr;
+    int width = 0, height = 0, nrComponents = 0;
+
+    // decodes an image file, safe to call from any thread
+    static DecodedImage Decode(const std::string &filename)
+    {
+        DecodedImage image;
+        image.data = stbi_load(filename.c_str(), &image.width, &image.height, &image.nrComponents, 0);
+        return image;
+    }
+
+    void Free()
+    {
+        stbi_image_free(data);
+        data = nullptr;
+    }
+};
+
+// uploads decoded pixels into the given texture object; must be called on the GL thread.
+inline void UploadTexture(unsigned int textureID, const DecodedImage &image)
+{
+    GLenum format = GL_RGB;
+    if (image.nrComponents == 1)
+        format = GL_RED;
+    else if (image.nrComponents == 3)
+        format = GL_RGB;
+    else if (image.nrComponents == 4)
+        format = GL_RGBA;
+
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.data);
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+// Decodes image files on a worker pool while the GL thread only creates texture names and
+// uploads finished pixels. Load() hands out a texture ID right away so callers can keep
+// building their meshes; Finish() has to be called (on the GL thread) before the textures
+// are used for rendering.
+class TextureLoader
+{
+public:
+    explicit TextureLoader(ThreadPool &pool = ThreadPool::Shared()) : m_Pool(pool) { }
+
+    TextureLoader(const TextureLoader&) = delete;
+    TextureLoader& operator=(const TextureLoader&) = delete;
+
+    ~TextureLoader()
+    {
+        Finish();
+    }
+
+    // reserves a texture object and queues the file for decoding
+    unsigned int Load(const std::string &filename)
+    {
+        unsigned int textureID;
+        glGenTextures(1, &textureID);
+        PendingTexture pending;
+        pending.textureID = textureID;
+        pending.filename = filename;
+        pending.image = m_Pool.Submit([filename] { return DecodedImage::Decode(filename); });
+        m_Pending.push_back(std::move(pending));
+        return textureID;
+    }
+
+    // uploads every queued texture, in the order the decodes finish
+    void Finish()
+    {
+        size_t remaining = m_Pending.size();
+        while (remaining > 0)
+        {
+            bool uploadedAny = false;
+            for (PendingTexture &pending : m_Pending)
+            {
+                if (pending.image.valid() && pending.image.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+                {
+                    upload(pending);
+                    remaining--;
+                    uploadedAny = true;
+                }
+            }
+            // nothing ready yet; block on the oldest outstanding decode instead of spinning
+            if (!uploadedAny)
+            {
+                for (PendingTexture &pending : m_Pending)
+                {
+                    if (pending.image.valid())
+                    {
+                        pending.image.wait();
+                        break;
+                    }
+                }
+            }
+        }
+        m_Pending.clear();
+    }
+
+    size_t GetPendingCount() const { return m_Pending.size(); }
+
+private:
+    struct PendingTexture
+    {
+        unsigned int textureID;
+        std::string filename;
+        std::future<DecodedImage> image;
+    };
+
+    ThreadPool &m_Pool;
+    std::vector<PendingTexture> m_Pending;
+
+    void upload(PendingTexture &pending)
+    {
+        DecodedImage image = pending.image.get();
+        if (image.data)
+        {
+            UploadTexture(pending.textureID, image);
+            TextureRegistry::Get().SetImageInfo(pending.textureID, image.width, image.height, image.nrComponents, true);
+        }
+        else
+        {
+            std::cout << "Texture failed to load at path: " << pending.filename << std::endl;
+            TextureRegistry::Get().Forget(pending.textureID);
+        }
+        image.Free();
+    }
+};
+#endif
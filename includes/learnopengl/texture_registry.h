@@ -0,0 +1,174 @@
+#ifndef TEXTURE_REGISTRY_H
+#define TEXTURE_REGISTRY_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// image properties of a registered texture
+struct RegisteredTexture
+{
+    unsigned int id = 0;
+    int width = 0, height = 0, nrComponents = 0;
+    size_t residentBytes = 0;
+    unsigned int refCount = 0;
+};
+
+struct TextureRegistryStats
+{
+    size_t hits = 0;          // Acquire calls that found an already loaded texture
+    size_t misses = 0;        // Acquire calls that required a new load
+    size_t residentBytes = 0; // estimated GPU memory of all registered textures
+    size_t textureCount = 0;
+};
+
+// internal format for Acquire/Insert of loaders that pick it from the channel count of the decoded image
+const GLenum TEXTURE_FORMAT_FROM_IMAGE = 0;
+
+// Process-wide, reference counted registry of loaded textures. A texture is keyed by its canonical file
+// path, its internal format and whether it has mipmaps, so loaders that upload the same file differently
+// get textures of their own. Every loader first tries to Acquire a key; on a miss it loads the texture
+// itself and Inserts it. Each successful Acquire/Insert holds one reference that is given back with
+// Release; the GL texture is deleted when the last reference goes away. A loader whose file fails to
+// decode calls Forget, so the next Acquire of that key tries the file again instead of sharing the
+// broken texture.
+class TextureRegistry
+{
+public:
+    static TextureRegistry& Get()
+    {
+        static TextureRegistry registry;
+        return registry;
+    }
+
+    // absolute, normalized path so that different spellings of the same file share one entry
+    static std::string Canonicalize(const std::string &path)
+    {
+        std::error_code error;
+        std::filesystem::path canonical = std::filesystem::weakly_canonical(path, error);
+        if (error)
+            canonical = std::filesystem::path(path).lexically_normal();
+        return canonical.generic_string();
+    }
+
+    // returns the texture registered under the key and takes a reference to it; the returned id is 0 if it isn't loaded yet
+    RegisteredTexture Acquire(const std::string &canonicalPath, GLenum internalFormat, bool mipmapped)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto key = m_Keys.find(makeKey(canonicalPath, internalFormat, mipmapped));
+        if (key == m_Keys.end())
+        {
+            m_Stats.misses++;
+            return RegisteredTexture();
+        }
+        m_Stats.hits++;
+        RegisteredTexture &texture = m_Textures[key->second].texture;
+        texture.refCount++;
+        return texture;
+    }
+
+    // registers a texture that was just created for the key, holding one reference
+    void Insert(const std::string &canonicalPath, GLenum internalFormat, bool mipmapped, unsigned int textureID)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        const std::string key = makeKey(canonicalPath, internalFormat, mipmapped);
+        Entry &entry = m_Textures[textureID];
+        entry.texture.id = textureID;
+        entry.texture.refCount++;
+        entry.key = key;
+        m_Keys[key] = textureID;
+        m_Stats.textureCount = m_Textures.size();
+    }
+
+    // records the image size of a registered texture once its pixels are uploaded; ignored for unregistered textures
+    void SetImageInfo(unsigned int textureID, int width, int height, int nrComponents, bool mipmapped = false)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto it = m_Textures.find(textureID);
+        if (it == m_Textures.end())
+            return;
+        RegisteredTexture &texture = it->second.texture;
+        size_t bytes = size_t(width) * size_t(height) * size_t(nrComponents);
+        if (mipmapped)
+            bytes += bytes / 3; // a full mip chain adds roughly a third
+        m_Stats.residentBytes = m_Stats.residentBytes - texture.residentBytes + bytes;
+        texture.width = width;
+        texture.height = height;
+        texture.nrComponents = nrComponents;
+        texture.residentBytes = bytes;
+    }
+
+    // takes a texture whose file failed to load out of the lookup; the references already handed out stay
+    // valid and still have to be released
+    void Forget(unsigned int textureID)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto it = m_Textures.find(textureID);
+        if (it == m_Textures.end())
+            return;
+        unlink(it->second);
+    }
+
+    // gives back a reference; deletes the GL texture and returns true once it is no longer used
+    bool Release(unsigned int textureID)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto it = m_Textures.find(textureID);
+        if (it == m_Textures.end())
+            return false;
+        if (--it->second.texture.refCount > 0)
+            return false;
+        glDeleteTextures(1, &it->second.texture.id);
+        m_Stats.residentBytes -= it->second.texture.residentBytes;
+        unlink(it->second);
+        m_Textures.erase(it);
+        m_Stats.textureCount = m_Textures.size();
+        return true;
+    }
+
+    TextureRegistryStats GetStats() const
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        return m_Stats;
+    }
+
+    void ResetCounters()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stats.hits = 0;
+        m_Stats.misses = 0;
+    }
+
+private:
+    struct Entry
+    {
+        RegisteredTexture texture;
+        std::string key; // empty once forgotten
+    };
+
+    TextureRegistry() = default;
+
+    mutable std::mutex m_Mutex;
+    std::unordered_map<unsigned int, Entry> m_Textures;  // by GL texture name
+    std::unordered_map<std::string, unsigned int> m_Keys; // lookup key -> GL texture name
+    TextureRegistryStats m_Stats;
+
+    static std::string makeKey(const std::string &canonicalPath, GLenum internalFormat, bool mipmapped)
+    {
+        return canonicalPath + '|' + std::to_string(internalFormat) + (mipmapped ? "|mipmapped" : "");
+    }
+
+    // removes the entry's key from the lookup, unless it was registered again for another texture since
+    void unlink(Entry &entry)
+    {
+        auto key = m_Keys.find(entry.key);
+        if (key != m_Keys.end() && key->second == entry.texture.id)
+            m_Keys.erase(key);
+        entry.key.clear();
+    }
+};
+#endif
@@ -0,0 +1,298 @@
+#ifndef VERTEX_FORMAT_H
+#define VERTEX_FORMAT_H
+
+#include <glad/glad.h> // holds all OpenGL type declarations
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#define MAX_BONE_INFLUENCE 4
+
+struct Vertex {
+    // position
+    glm::vec3 Position;
+    // normal
+    glm::vec3 Normal;
+    // texCoords
+    glm::vec2 TexCoords;
+    // tangent
+    glm::vec3 Tangent;
+    // bitangent
+    glm::vec3 Bitangent;
+	//bone indexes which will influence this vertex
+	int m_BoneIDs[MAX_BONE_INFLUENCE];
+	//weights from each bone
+	float m_Weights[MAX_BONE_INFLUENCE];
+};
+
+// GPU side vertex layouts a Mesh can be uploaded with. The CPU side always keeps full Vertex data.
+enum VertexFormat {
+    VERTEX_FORMAT_FULL,           // Vertex as is, 88 bytes
+    VERTEX_FORMAT_COMPACT,        // CompactVertex, 24 bytes, no skinning data
+    VERTEX_FORMAT_COMPACT_SKINNED // CompactSkinnedVertex, 32 bytes
+};
+
+// Quantized vertex for static meshes:
+//   normal and tangent are octahedral encoded unit vectors stored as 2x snorm16,
+//   texture coordinates are half floats,
+//   the bitangent is reconstructed as cross(N, T) * sign, with the sign kept in the
+//   lowest bit of the tangent's second component (set means negative).
+struct CompactVertex {
+    glm::vec3      Position;
+    short          Normal[2];
+    short          Tangent[2];
+    unsigned short TexCoords[2];
+};
+
+// Quantized vertex for skinned meshes: bone IDs as uint8 and weights as unorm8.
+struct CompactSkinnedVertex {
+    CompactVertex  Base;
+    unsigned char  m_BoneIDs[MAX_BONE_INFLUENCE];
+    unsigned char  m_Weights[MAX_BONE_INFLUENCE];
+};
+
+// one glVertexAttrib(I)Pointer call
+struct VertexAttribute {
+    GLuint    location;
+    GLint     size;
+    GLenum    type;
+    GLboolean normalized;
+    bool      integer;   // glVertexAttribIPointer instead of glVertexAttribPointer
+    size_t    offset;
+};
+
+// describes how a vertex buffer is laid out, setupMesh configures the VAO from this
+struct VertexLayout {
+    GLsizei stride = 0;
+    std::vector<VertexAttribute> attributes;
+
+    static VertexLayout Get(VertexFormat format)
+    {
+        VertexLayout layout;
+        if (format == VERTEX_FORMAT_FULL)
+        {
+            layout.stride = sizeof(Vertex);
+            layout.attributes = {
+                { 0, 3, GL_FLOAT, GL_FALSE, false, offsetof(Vertex, Position) },
+                { 1, 3, GL_FLOAT, GL_FALSE, false, offsetof(Vertex, Normal) },
+                { 2, 2, GL_FLOAT, GL_FALSE, false, offsetof(Vertex, TexCoords) },
+                { 3, 3, GL_FLOAT, GL_FALSE, false, offsetof(Vertex, Tangent) },
+                { 4, 3, GL_FLOAT, GL_FALSE, false, offsetof(Vertex, Bitangent) },
+                { 5, 4, GL_INT,   GL_FALSE, true,  offsetof(Vertex, m_BoneIDs) },
+                { 6, 4, GL_FLOAT, GL_FALSE, false, offsetof(Vertex, m_Weights) },
+            };
+            return layout;
+        }
+        // the compact layouts share locations with the full one; location 4 (bitangent) is not used,
+        // the vertex shader rebuilds it from the normal, tangent and sign (see COMPACT_VERTEX_GLSL).
+        const size_t base = format == VERTEX_FORMAT_COMPACT_SKINNED ? offsetof(CompactSkinnedVertex, Base) : 0;
+        layout.stride = format == VERTEX_FORMAT_COMPACT_SKINNED ? sizeof(CompactSkinnedVertex) : sizeof(CompactVertex);
+        layout.attributes = {
+            { 0, 3, GL_FLOAT,      GL_FALSE, false, base + offsetof(CompactVertex, Position) },
+            { 1, 2, GL_SHORT,      GL_TRUE,  false, base + offsetof(CompactVertex, Normal) },
+            { 2, 2, GL_HALF_FLOAT, GL_FALSE, false, base + offsetof(CompactVertex, TexCoords) },
+            { 3, 2, GL_SHORT,      GL_TRUE,  false, base + offsetof(CompactVertex, Tangent) },
+        };
+        if (format == VERTEX_FORMAT_COMPACT_SKINNED)
+        {
+            layout.attributes.push_back({ 5, 4, GL_UNSIGNED_BYTE, GL_FALSE, true,  offsetof(CompactSkinnedVertex, m_BoneIDs) });
+            layout.attributes.push_back({ 6, 4, GL_UNSIGNED_BYTE, GL_TRUE,  false, offsetof(CompactSkinnedVertex, m_Weights) });
+        }
+        return layout;
+    }
+};
+
+// GLSL helpers for vertex shaders that consume the compact layouts:
+//   vec3 normal = octDecode(aNormal);
+//   vec3 tangent = octDecode(aTangent);
+//   vec3 bitangent = cross(normal, tangent) * bitangentSign(aTangent);
+// Programs that use them register the text with the ShaderPreprocessor under COMPACT_VERTEX_GLSL_NAME,
+// after which shaders get them with #include "learnopengl/compact_vertex.glsl".
+inline constexpr const char *COMPACT_VERTEX_GLSL_NAME = "learnopengl/compact_vertex.glsl";
+inline constexpr const char *COMPACT_VERTEX_GLSL = R"(
+vec3 octDecode(vec2 e)
+{
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
+float bitangentSign(vec2 tangent)
+{
+    return (int(round(tangent.y * 32767.0)) & 1) != 0 ? -1.0 : 1.0;
+}
+)";
+
+namespace VertexPacking
+{
+    // maps a unit vector onto the [-1, 1] square of an octahedron
+    inline glm::vec2 OctEncode(glm::vec3 n)
+    {
+        const float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+        if (l1 <= 0.0f)
+            return glm::vec2(0.0f);
+        n /= l1;
+        glm::vec2 e(n.x, n.y);
+        if (n.z < 0.0f)
+        {
+            const glm::vec2 signs(e.x >= 0.0f ? 1.0f : -1.0f, e.y >= 0.0f ? 1.0f : -1.0f);
+            e = (1.0f - glm::abs(glm::vec2(e.y, e.x))) * signs;
+        }
+        return e;
+    }
+
+    inline glm::vec3 OctDecode(glm::vec2 e)
+    {
+        glm::vec3 n(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+        if (n.z < 0.0f)
+        {
+            const glm::vec2 signs(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+            const glm::vec2 xy = (1.0f - glm::abs(glm::vec2(n.y, n.x))) * signs;
+            n.x = xy.x;
+            n.y = xy.y;
+        }
+        return glm::normalize(n);
+    }
+
+    inline short ToSnorm16(float v)
+    {
+        return static_cast<short>(std::round(glm::clamp(v, -1.0f, 1.0f) * 32767.0f));
+    }
+
+    inline float FromSnorm16(short v)
+    {
+        return glm::max(static_cast<float>(v) / 32767.0f, -1.0f);
+    }
+
+    // sign of the bitangent relative to cross(normal, tangent)
+    inline bool IsBitangentFlipped(const Vertex &vertex)
+    {
+        return glm::dot(glm::cross(vertex.Normal, vertex.Tangent), vertex.Bitangent) < 0.0f;
+    }
+
+    inline CompactVertex PackCompact(const Vertex &vertex)
+    {
+        CompactVertex packed;
+        packed.Position = vertex.Position;
+        const glm::vec2 normal = OctEncode(vertex.Normal);
+        packed.Normal[0] = ToSnorm16(normal.x);
+        packed.Normal[1] = ToSnorm16(normal.y);
+        // the tangent's second component gives up its lowest bit for the bitangent sign;
+        // quantizing to +-32766 keeps the tagged value inside the snorm16 range.
+        const glm::vec2 tangent = OctEncode(vertex.Tangent);
+        const int ty = static_cast<int>(std::round(glm::clamp(tangent.y, -1.0f, 1.0f) * 32766.0f));
+        packed.Tangent[0] = ToSnorm16(tangent.x);
+        packed.Tangent[1] = static_cast<short>((ty & ~1) | (IsBitangentFlipped(vertex) ? 1 : 0));
+        packed.TexCoords[0] = glm::packHalf1x16(vertex.TexCoords.x);
+        packed.TexCoords[1] = glm::packHalf1x16(vertex.TexCoords.y);
+        return packed;
+    }
+
+    inline CompactSkinnedVertex PackCompactSkinned(const Vertex &vertex)
+    {
+        CompactSkinnedVertex packed;
+        packed.Base = PackCompact(vertex);
+        float total = 0.0f;
+        for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+            total += vertex.m_BoneIDs[i] >= 0 ? vertex.m_Weights[i] : 0.0f;
+        for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+        {
+            // unused slots (-1) become bone 0 with zero weight
+            const bool used = vertex.m_BoneIDs[i] >= 0 && total > 0.0f;
+            packed.m_BoneIDs[i] = used ? static_cast<unsigned char>(vertex.m_BoneIDs[i]) : 0;
+            packed.m_Weights[i] = used ? static_cast<unsigned char>(std::round(glm::clamp(vertex.m_Weights[i] / total, 0.0f, 1.0f) * 255.0f)) : 0;
+        }
+        // give the rounding remainder to the largest weight so that they still sum up to one
+        int sum = 0, largest = 0;
+        for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+        {
+            sum += packed.m_Weights[i];
+            if (packed.m_Weights[i] > packed.m_Weights[largest])
+                largest = i;
+        }
+        if (sum > 0)
+            packed.m_Weights[largest] = static_cast<unsigned char>(packed.m_Weights[largest] + 255 - sum);
+        return packed;
+    }
+
+    // expands a compact vertex back to floats, mainly to measure the quantization error
+    inline Vertex Unpack(const CompactVertex &packed)
+    {
+        Vertex vertex = {};
+        vertex.Position = packed.Position;
+        vertex.Normal = OctDecode(glm::vec2(FromSnorm16(packed.Normal[0]), FromSnorm16(packed.Normal[1])));
+        vertex.Tangent = OctDecode(glm::vec2(FromSnorm16(packed.Tangent[0]), FromSnorm16(packed.Tangent[1])));
+        const float sign = (packed.Tangent[1] & 1) ? -1.0f : 1.0f;
+        vertex.Bitangent = glm::cross(vertex.Normal, vertex.Tangent) * sign;
+        vertex.TexCoords = glm::vec2(glm::unpackHalf1x16(packed.TexCoords[0]), glm::unpackHalf1x16(packed.TexCoords[1]));
+        for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+        {
+            vertex.m_BoneIDs[i] = -1;
+            vertex.m_Weights[i] = 0.0f;
+        }
+        return vertex;
+    }
+
+    // worst case error introduced by the compact formats
+    struct PackingError
+    {
+        float maxNormalDegrees = 0.0f;
+        float maxTangentDegrees = 0.0f;
+        float maxTexCoordError = 0.0f;
+        size_t bitangentSignErrors = 0;
+    };
+
+    inline PackingError MeasureError(const std::vector<Vertex> &vertices)
+    {
+        PackingError error;
+        for (const Vertex &vertex : vertices)
+        {
+            const Vertex unpacked = Unpack(PackCompact(vertex));
+            const float normal = glm::degrees(std::acos(glm::clamp(glm::dot(glm::normalize(vertex.Normal), unpacked.Normal), -1.0f, 1.0f)));
+            const float tangent = glm::degrees(std::acos(glm::clamp(glm::dot(glm::normalize(vertex.Tangent), unpacked.Tangent), -1.0f, 1.0f)));
+            const glm::vec2 uv = glm::abs(vertex.TexCoords - unpacked.TexCoords);
+            error.maxNormalDegrees = glm::max(error.maxNormalDegrees, normal);
+            error.maxTangentDegrees = glm::max(error.maxTangentDegrees, tangent);
+            error.maxTexCoordError = glm::max(error.maxTexCoordError, glm::max(uv.x, uv.y));
+            if (glm::dot(vertex.Bitangent, unpacked.Bitangent) < 0.0f)
+                error.bitangentSignErrors++;
+        }
+        return error;
+    }
+
+    // converts vertices to the byte layout of the given format
+    inline std::vector<unsigned char> Pack(const std::vector<Vertex> &vertices, VertexFormat format)
+    {
+        std::vector<unsigned char> bytes;
+        if (format == VERTEX_FORMAT_COMPACT)
+        {
+            bytes.resize(vertices.size() * sizeof(CompactVertex));
+            for (size_t i = 0; i < vertices.size(); i++)
+            {
+                const CompactVertex packed = PackCompact(vertices[i]);
+                std::memcpy(&bytes[i * sizeof(CompactVertex)], &packed, sizeof(CompactVertex));
+            }
+        }
+        else if (format == VERTEX_FORMAT_COMPACT_SKINNED)
+        {
+            bytes.resize(vertices.size() * sizeof(CompactSkinnedVertex));
+            for (size_t i = 0; i < vertices.size(); i++)
+            {
+                const CompactSkinnedVertex packed = PackCompactSkinned(vertices[i]);
+                std::memcpy(&bytes[i * sizeof(CompactSkinnedVertex)], &packed, sizeof(CompactSkinnedVertex));
+            }
+        }
+        else
+        {
+            bytes.resize(vertices.size() * sizeof(Vertex));
+            if (!vertices.empty())
+                std::memcpy(bytes.data(), vertices.data(), bytes.size());
+        }
+        return bytes;
+    }
+}
+#endif
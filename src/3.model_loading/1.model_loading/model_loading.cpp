@@ -10,12 +10,24 @@
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <future>
 #include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow *window);
+bool runMeshCacheBenchmark(const std::string &path, unsigned int warmLoads);
+bool runTextureDecodeBenchmark(const std::string &directory);
+bool runVertexCacheReport();
 
 // settings
 const unsigned int SCR_WIDTH = 800;
@@ -31,8 +43,37 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
-int main()
+int main(int argc, char *argv[])
 {
+    // "--texture-decode-benchmark [directory]" decodes every image in the directory on one thread and on
+    // the loader's worker pool and exits; like the other benchmarks it doesn't need a window
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--texture-decode-benchmark")
+        {
+            std::string directory = i + 1 < argc ? argv[i + 1] : FileSystem::getPath("resources/objects/nanosuit");
+            return runTextureDecodeBenchmark(directory) ? 0 : 1;
+        }
+        // "--mesh-cache-benchmark [model]" times a cold import against warm loads from the mesh cache for the
+        // model, or for every model under resources/objects, and exits
+        if (std::string(argv[i]) == "--mesh-cache-benchmark")
+        {
+            std::vector<std::string> paths;
+            if (i + 1 < argc)
+                paths.push_back(argv[i + 1]);
+            else
+                paths = FindModelFiles(FileSystem::getPath("resources/objects"));
+            bool identical = !paths.empty();
+            for (const std::string &path : paths)
+                identical = runMeshCacheBenchmark(path, 10) && identical;
+            return identical ? 0 : 1;
+        }
+        // "--vertex-cache-report" imports every model under resources/objects as is and with MESH_OPTIMIZE_ALL and
+        // prints the vertex cache efficiency of both, then exits
+        if (std::string(argv[i]) == "--vertex-cache-report")
+            return runVertexCacheReport() ? 0 : 1;
+    }
+
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
@@ -82,7 +123,8 @@ int main()
 
     // load models
     // -----------
-    Model ourModel(FileSystem::getPath("resources/objects/backpack/backpack.obj"));
+    // welded, reordered for the vertex cache and with levels of detail; the first run prints what that gained
+    Model ourModel(FileSystem::getPath("resources/objects/backpack/backpack.obj"), false, VERTEX_FORMAT_FULL, MESH_OPTIMIZE_ALL);
 
     
     // draw in wireframe
@@ -130,12 +172,166 @@ int main()
         glfwPollEvents();
     }
 
+    // de-allocate the model's textures while the OpenGL context still exists
+    // ----------------------------------------------------------------------
+    ourModel.Unload();
+
     // glfw: terminate, clearing all previously allocated GLFW resources.
     // ------------------------------------------------------------------
     glfwTerminate();
     return 0;
 }
 
+// loads the model once with its mesh cache deleted, which runs the full ASSIMP import and writes a new
+// cache, and then warmLoads times from that cache. Prints the load times and returns whether the warm
+// loads reproduced the imported meshes exactly. The models aren't uploaded and skip their textures, so
+// only the mesh import is timed and no GL context is needed.
+// ---------------------------------------------------------------------------------------------------------
+bool runMeshCacheBenchmark(const std::string &path, unsigned int warmLoads)
+{
+    std::remove(MeshCache::GetCachePath(path).c_str());
+
+    std::vector<Mesh> imported;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    {
+        Model model(path, false, VERTEX_FORMAT_FULL, MESH_OPTIMIZE_NONE, false);
+        imported = model.meshes;
+    }
+    double coldTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    bool identical = !imported.empty();
+    double warmTime = 0.0;
+    for (unsigned int load = 0; load < warmLoads; ++load)
+    {
+        start = std::chrono::steady_clock::now();
+        Model model(path, false, VERTEX_FORMAT_FULL, MESH_OPTIMIZE_NONE, false);
+        warmTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (model.meshes.size() != imported.size())
+            identical = false;
+        for (unsigned int i = 0; identical && i < imported.size(); ++i)
+        {
+            const Mesh &a = imported[i], &b = model.meshes[i];
+            identical = a.indices == b.indices && a.vertices.size() == b.vertices.size() &&
+                std::memcmp(a.vertices.data(), b.vertices.data(), a.vertices.size() * sizeof(Vertex)) == 0 &&
+                a.textures.size() == b.textures.size();
+            for (unsigned int j = 0; identical && j < a.textures.size(); ++j)
+                identical = a.textures[j].path == b.textures[j].path && a.textures[j].type == b.textures[j].type;
+        }
+    }
+
+    size_t vertices = 0;
+    for (const Mesh &mesh : imported)
+        vertices += mesh.vertices.size();
+    std::cout << "MESH CACHE BENCHMARK: " << path << ", " << imported.size() << " meshes, " << vertices << " vertices" << std::endl;
+    std::cout << "  cold (import + write cache): " << coldTime << " ms" << std::endl;
+    std::cout << "  warm (from cache):           " << warmTime / warmLoads << " ms, average of " << warmLoads << std::endl;
+    std::cout << (identical ? "  meshes identical" : "  meshes differ") << std::endl;
+    return identical;
+}
+
+// decodes every .png/.jpg in directory once on this thread and then on worker pools of 1 up to
+// hardware_concurrency threads, the way TextureLoader does during a model load. Prints the times and the
+// speedup of every pool size over the single thread and returns whether all runs produced the same pixels.
+// ---------------------------------------------------------------------------------------------------------
+bool runTextureDecodeBenchmark(const std::string &directory)
+{
+    std::vector<std::string> files;
+    std::error_code error;
+    for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(directory, error))
+    {
+        std::string extension = entry.path().extension().string();
+        if (extension == ".png" || extension == ".jpg")
+            files.push_back(entry.path().string());
+    }
+    std::sort(files.begin(), files.end());
+    if (files.empty())
+    {
+        std::cout << "No images found in " << directory << std::endl;
+        return false;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<DecodedImage> serial;
+    for (const std::string &file : files)
+        serial.push_back(DecodedImage::Decode(file));
+    double serialTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    bool identical = true;
+    size_t bytes = 0;
+    for (const DecodedImage &image : serial)
+        bytes += static_cast<size_t>(image.width) * image.height * image.nrComponents;
+    std::cout << "TEXTURE DECODE BENCHMARK: " << files.size() << " images, " << bytes / (1024 * 1024) << " MB decoded" << std::endl;
+    std::cout << "  one thread:       " << serialTime << " ms" << std::endl;
+
+    const unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned int threads = 1; threads <= maxThreads; ++threads)
+    {
+        ThreadPool pool(threads);
+        start = std::chrono::steady_clock::now();
+        std::vector<std::future<DecodedImage>> pending;
+        for (const std::string &file : files)
+            pending.push_back(pool.Submit([file] { return DecodedImage::Decode(file); }));
+        std::vector<DecodedImage> threaded;
+        for (std::future<DecodedImage> &image : pending)
+            threaded.push_back(image.get());
+        double threadedTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        for (unsigned int i = 0; i < files.size(); ++i)
+        {
+            const DecodedImage &a = serial[i], &b = threaded[i];
+            if (!a.data || !b.data || a.width != b.width || a.height != b.height || a.nrComponents != b.nrComponents ||
+                std::memcmp(a.data, b.data, static_cast<size_t>(a.width) * a.height * a.nrComponents) != 0)
+            {
+                std::cout << "  " << files[i] << " differs or failed to decode" << std::endl;
+                identical = false;
+            }
+            threaded[i].Free();
+        }
+        std::cout << "  worker pool (" << threads << "): " << threadedTime << " ms, " << serialTime / threadedTime << "x" << std::endl;
+    }
+    for (DecodedImage &image : serial)
+        image.Free();
+
+    std::cout << (identical ? "  pixels identical" : "  pixels differ") << std::endl;
+    return identical;
+}
+
+// loads every model under resources/objects without uploading it, once as imported and once with
+// MESH_OPTIMIZE_ALL, and prints the average cache miss ratio (transformed vertices per triangle) and the
+// average transform to vertex ratio (transformed per referenced vertex) of both. Both models write the mesh
+// cache with their own flags, so every load is a full import. Returns whether every model got better.
+// ---------------------------------------------------------------------------------------------------------
+bool runVertexCacheReport()
+{
+    // the statistics of all meshes of a model together
+    auto analyze = [](const Model &model) {
+        VertexCacheStats total = {};
+        for (const Mesh &mesh : model.meshes)
+        {
+            const VertexCacheStats stats = MeshOptimizer::AnalyzeVertexCache(mesh.indices, mesh.vertices.size());
+            total.transformedVertices += stats.transformedVertices;
+            total.triangles += stats.triangles;
+            total.referencedVertices += stats.referencedVertices;
+        }
+        total.acmr = total.triangles ? float(total.transformedVertices) / total.triangles : 0.0f;
+        total.atvr = total.referencedVertices ? float(total.transformedVertices) / total.referencedVertices : 0.0f;
+        return total;
+    };
+
+    const std::vector<std::string> paths = FindModelFiles(FileSystem::getPath("resources/objects"));
+    std::cout << "VERTEX CACHE REPORT: " << paths.size() << " models, MESH_OPTIMIZE_ALL" << std::endl;
+    bool improved = !paths.empty();
+    for (const std::string &path : paths)
+    {
+        const VertexCacheStats before = analyze(Model(path, false, VERTEX_FORMAT_FULL, MESH_OPTIMIZE_NONE, false));
+        const VertexCacheStats after = analyze(Model(path, false, VERTEX_FORMAT_FULL, MESH_OPTIMIZE_ALL, false));
+        std::cout << "  " << path.substr(path.find_last_of('/') + 1) << ": " << before.triangles << " triangles, ACMR "
+                  << before.acmr << " -> " << after.acmr << ", ATVR " << before.atvr << " -> " << after.atvr << std::endl;
+        improved = improved && after.triangles == before.triangles && after.acmr < before.acmr;
+    }
+    return improved;
+}
+
 // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
 // ---------------------------------------------------------------------------------------------------------
 void processInput(GLFWwindow *window)
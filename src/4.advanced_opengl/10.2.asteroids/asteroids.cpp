@@ -162,6 +162,11 @@ int main()
         glfwPollEvents();
     }
 
+    // de-allocate the models' textures while the OpenGL context still exists
+    // ----------------------------------------------------------------------
+    rock.Unload();
+    planet.Unload();
+
     glfwTerminate();
     return 0;
 }
@@ -12,11 +12,13 @@
 #include <learnopengl/model.h>
 
 #include <iostream>
+#include <vector>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow *window);
+void setInstanceMatrixPointers(size_t firstInstance);
 
 // settings
 const unsigned int SCR_WIDTH = 800;
@@ -81,7 +83,8 @@ int main()
 
     // load models
     // -----------
-    Model rock(FileSystem::getPath("resources/objects/rock/rock.obj"));
+    // the rock gets simplified levels of detail; every asteroid picks one from its size on screen
+    Model rock(FileSystem::getPath("resources/objects/rock/rock.obj"), false, VERTEX_FORMAT_FULL, MESH_OPTIMIZE_ALL);
     Model planet(FileSystem::getPath("resources/objects/planet/planet.obj"));
 
     // generate a large list of semi-random model transformation matrices
@@ -89,6 +92,8 @@ int main()
     unsigned int amount = 100000;
     glm::mat4* modelMatrices;
     modelMatrices = new glm::mat4[amount];
+    std::vector<glm::vec3> positions(amount);
+    std::vector<float> scales(amount);
     srand(static_cast<unsigned int>(glfwGetTime())); // initialize random seed
     float radius = 150.0;
     float offset = 25.0f;
@@ -104,10 +109,12 @@ int main()
         displacement = (rand() % (int)(2 * offset * 100)) / 100.0f - offset;
         float z = cos(angle) * radius + displacement;
         model = glm::translate(model, glm::vec3(x, y, z));
+        positions[i] = glm::vec3(x, y, z);
 
         // 2. scale: Scale between 0.05 and 0.25f
         float scale = static_cast<float>((rand() % 20) / 100.0 + 0.05);
         model = glm::scale(model, glm::vec3(scale));
+        scales[i] = scale;
 
         // 3. rotation: add random rotation around a (semi)randomly picked rotation axis vector
         float rotAngle = static_cast<float>((rand() % 360));
@@ -117,12 +124,14 @@ int main()
         modelMatrices[i] = model;
     }
 
-    // configure instanced array
-    // -------------------------
+    // configure instanced array; refilled every frame with the matrices sorted by level of detail
+    // -------------------------------------------------------------------------------------------
     unsigned int buffer;
     glGenBuffers(1, &buffer);
     glBindBuffer(GL_ARRAY_BUFFER, buffer);
-    glBufferData(GL_ARRAY_BUFFER, amount * sizeof(glm::mat4), &modelMatrices[0], GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, amount * sizeof(glm::mat4), &modelMatrices[0], GL_DYNAMIC_DRAW);
+    std::vector<glm::mat4> sortedMatrices(amount);
+    std::vector<unsigned int> instanceLods(amount);
 
     // set transformation matrices as an instance vertex attribute (with divisor 1)
     // note: we're cheating a little by taking the, now publicly declared, VAO of the model's mesh(es) and adding new vertexAttribPointers
@@ -134,13 +143,10 @@ int main()
         glBindVertexArray(VAO);
         // set attribute pointers for matrix (4 times vec4)
         glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)0);
         glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(sizeof(glm::vec4)));
         glEnableVertexAttribArray(5);
-        glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(2 * sizeof(glm::vec4)));
         glEnableVertexAttribArray(6);
-        glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(3 * sizeof(glm::vec4)));
+        setInstanceMatrixPointers(0);
 
         glVertexAttribDivisor(3, 1);
         glVertexAttribDivisor(4, 1);
@@ -186,6 +192,24 @@ int main()
         planetShader.setMat4("model", model);
         planet.Draw(planetShader);
 
+        // pick a level of detail per meteorite and sort the matrices by it, so each level is one instanced draw
+        const float projectionScale = LodProjectionScale(glm::radians(45.0f), (float)SCR_HEIGHT);
+        unsigned int lodInstances[MODEL_LOD_LEVELS] = {};
+        for (unsigned int i = 0; i < amount; i++)
+        {
+            instanceLods[i] = rock.SelectLod(glm::distance(camera.Position, positions[i]), scales[i], projectionScale);
+            lodInstances[instanceLods[i]]++;
+        }
+        unsigned int firstInstance[MODEL_LOD_LEVELS] = {};
+        for (unsigned int lod = 1; lod < MODEL_LOD_LEVELS; lod++)
+            firstInstance[lod] = firstInstance[lod - 1] + lodInstances[lod - 1];
+        unsigned int fill[MODEL_LOD_LEVELS];
+        std::copy(firstInstance, firstInstance + MODEL_LOD_LEVELS, fill);
+        for (unsigned int i = 0; i < amount; i++)
+            sortedMatrices[fill[instanceLods[i]]++] = modelMatrices[i];
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, amount * sizeof(glm::mat4), sortedMatrices.data());
+
         // draw meteorites
         asteroidShader.use();
         asteroidShader.setInt("texture_diffuse1", 0);
@@ -194,7 +218,15 @@ int main()
         for (unsigned int i = 0; i < rock.meshes.size(); i++)
         {
             glBindVertexArray(rock.meshes[i].VAO);
-            glDrawElementsInstanced(GL_TRIANGLES, static_cast<unsigned int>(rock.meshes[i].indices.size()), GL_UNSIGNED_INT, 0, amount);
+            for (unsigned int lod = 0; lod < MODEL_LOD_LEVELS; lod++)
+            {
+                if (lodInstances[lod] == 0)
+                    continue;
+                // OpenGL 3.3 has no base instance, so the matrix attributes start at the level's first matrix instead
+                setInstanceMatrixPointers(firstInstance[lod]);
+                glDrawElementsInstanced(GL_TRIANGLES, rock.meshes[i].GetLodIndexCount(lod), GL_UNSIGNED_INT,
+                                        (void*)rock.meshes[i].GetLodIndexOffset(lod), lodInstances[lod]);
+            }
             glBindVertexArray(0);
         }
 
@@ -204,10 +236,27 @@ int main()
         glfwPollEvents();
     }
 
+    // de-allocate the models' textures while the OpenGL context still exists
+    // ----------------------------------------------------------------------
+    rock.Unload();
+    planet.Unload();
+
     glfwTerminate();
     return 0;
 }
 
+// points the instance matrix attributes (locations 3 to 6) of the bound VAO at the instance buffer, starting
+// at the given matrix; the instance buffer has to be bound to GL_ARRAY_BUFFER
+// ---------------------------------------------------------------------------------------------------------
+void setInstanceMatrixPointers(size_t firstInstance)
+{
+    const size_t offset = firstInstance * sizeof(glm::mat4);
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)offset);
+    glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(offset + sizeof(glm::vec4)));
+    glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(offset + 2 * sizeof(glm::vec4)));
+    glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(offset + 3 * sizeof(glm::vec4)));
+}
+
 // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
 // ---------------------------------------------------------------------------------------------------------
 void processInput(GLFWwindow *window)
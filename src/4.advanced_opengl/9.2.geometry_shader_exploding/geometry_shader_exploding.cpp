@@ -122,6 +122,10 @@ int main()
         glfwPollEvents();
     }
 
+    // de-allocate the model's textures while the OpenGL context still exists
+    // ----------------------------------------------------------------------
+    nanosuit.Unload();
+
     glfwTerminate();
     return 0;
 }
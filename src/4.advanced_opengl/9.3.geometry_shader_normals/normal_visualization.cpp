@@ -129,6 +129,10 @@ int main()
         glfwPollEvents();
     }
 
+    // de-allocate the model's textures while the OpenGL context still exists
+    // ----------------------------------------------------------------------
+    backpack.Unload();
+
     glfwTerminate();
     return 0;
 }
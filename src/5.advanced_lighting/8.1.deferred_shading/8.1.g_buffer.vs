@@ -1,6 +1,11 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
+#ifdef COMPACT_VERTEX
+#include "learnopengl/compact_vertex.glsl"
+layout (location = 1) in vec2 aNormal; // octahedral encoded, see vertex_format.h
+#else
 layout (location = 1) in vec3 aNormal;
+#endif
 layout (location = 2) in vec2 aTexCoords;
 
 out vec3 FragPos;
@@ -18,7 +23,11 @@ void main()
     TexCoords = aTexCoords;
     
     mat3 normalMatrix = transpose(inverse(mat3(model)));
+#ifdef COMPACT_VERTEX
+    Normal = normalMatrix * octDecode(aNormal);
+#else
     Normal = normalMatrix * aNormal;
+#endif
 
     gl_Position = projection * view * worldPos;
 }
\ No newline at end of file
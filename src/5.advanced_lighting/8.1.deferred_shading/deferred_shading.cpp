@@ -11,6 +11,8 @@
 #include <learnopengl/model.h>
 
 #include <iostream>
+#include <string>
+#include <vector>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
@@ -19,6 +21,7 @@ void processInput(GLFWwindow *window);
 unsigned int loadTexture(const char *path, bool gammaCorrection);
 void renderQuad();
 void renderCube();
+bool runVertexMemoryReport();
 
 // settings
 const unsigned int SCR_WIDTH = 800;
@@ -34,8 +37,16 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
-int main()
+int main(int argc, char *argv[])
 {
+    // "--vertex-memory-report" prints the vertex buffer size of every model under resources/objects in the
+    // full and the compact vertex format and exits; it doesn't need a window
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--vertex-memory-report")
+            return runVertexMemoryReport() ? 0 : 1;
+    }
+
     // glfw: initialize and configure
     // ------------------------------
     glfwInit();
@@ -81,13 +92,16 @@ int main()
 
     // build and compile shaders
     // -------------------------
-    Shader shaderGeometryPass("8.1.g_buffer.vs", "8.1.g_buffer.fs");
+    // the backpack is uploaded in the 24 byte compact vertex format instead of the 88 byte full one;
+    // COMPACT_VERTEX makes the geometry pass decode its normals with the helpers of COMPACT_VERTEX_GLSL
+    ShaderPreprocessor::Shared().AddSource(COMPACT_VERTEX_GLSL_NAME, COMPACT_VERTEX_GLSL);
+    Shader shaderGeometryPass("8.1.g_buffer.vs", "8.1.g_buffer.fs", nullptr, ShaderDefines{ { "COMPACT_VERTEX", "1" } });
     Shader shaderLightingPass("8.1.deferred_shading.vs", "8.1.deferred_shading.fs");
     Shader shaderLightBox("8.1.deferred_light_box.vs", "8.1.deferred_light_box.fs");
 
     // load models
     // -----------
-    Model backpack(FileSystem::getPath("resources/objects/backpack/backpack.obj"));
+    Model backpack(FileSystem::getPath("resources/objects/backpack/backpack.obj"), false, VERTEX_FORMAT_COMPACT);
     std::vector<glm::vec3> objectPositions;
     objectPositions.push_back(glm::vec3(-3.0,  -0.5, -3.0));
     objectPositions.push_back(glm::vec3( 0.0,  -0.5, -3.0));
@@ -167,6 +181,21 @@ int main()
     shaderLightingPass.setInt("gPosition", 0);
     shaderLightingPass.setInt("gNormal", 1);
     shaderLightingPass.setInt("gAlbedoSpec", 2);
+    // look the per light uniforms up once instead of building their names every frame
+    struct LightUniforms
+    {
+        Uniform<glm::vec3> position, color;
+        Uniform<float> linear, quadratic;
+    };
+    std::vector<LightUniforms> lightUniforms(lightPositions.size());
+    for (unsigned int i = 0; i < lightPositions.size(); i++)
+    {
+        const std::string light = "lights[" + std::to_string(i) + "]";
+        lightUniforms[i].position = shaderLightingPass.getUniform<glm::vec3>(light + ".Position");
+        lightUniforms[i].color = shaderLightingPass.getUniform<glm::vec3>(light + ".Color");
+        lightUniforms[i].linear = shaderLightingPass.getUniform<float>(light + ".Linear");
+        lightUniforms[i].quadratic = shaderLightingPass.getUniform<float>(light + ".Quadratic");
+    }
 
     // render loop
     // -----------
@@ -220,13 +249,13 @@ int main()
         // send light relevant uniforms
         for (unsigned int i = 0; i < lightPositions.size(); i++)
         {
-            shaderLightingPass.setVec3("lights[" + std::to_string(i) + "].Position", lightPositions[i]);
-            shaderLightingPass.setVec3("lights[" + std::to_string(i) + "].Color", lightColors[i]);
+            shaderLightingPass.setVec3(lightUniforms[i].position, lightPositions[i]);
+            shaderLightingPass.setVec3(lightUniforms[i].color, lightColors[i]);
             // update attenuation parameters and calculate radius
             const float linear = 0.7f;
             const float quadratic = 1.8f;
-            shaderLightingPass.setFloat("lights[" + std::to_string(i) + "].Linear", linear);
-            shaderLightingPass.setFloat("lights[" + std::to_string(i) + "].Quadratic", quadratic);
+            shaderLightingPass.setFloat(lightUniforms[i].linear, linear);
+            shaderLightingPass.setFloat(lightUniforms[i].quadratic, quadratic);
         }
         shaderLightingPass.setVec3("viewPos", camera.Position);
         // finally render quad
@@ -264,10 +293,39 @@ int main()
         glfwPollEvents();
     }
 
+    // de-allocate the model's textures while the OpenGL context still exists
+    // ----------------------------------------------------------------------
+    backpack.Unload();
+
     glfwTerminate();
     return 0;
 }
 
+// loads every model under resources/objects without uploading it, once in the full and once in the compact
+// vertex format, and prints how many bytes their vertex buffers take in each. Returns false if there were
+// no models to report on.
+// ---------------------------------------------------------------------------------------------------------
+bool runVertexMemoryReport()
+{
+    const std::vector<std::string> paths = FindModelFiles(FileSystem::getPath("resources/objects"));
+    std::cout << "VERTEX MEMORY REPORT: " << paths.size() << " models, full " << VertexLayout::Get(VERTEX_FORMAT_FULL).stride
+              << " bytes, compact " << VertexLayout::Get(VERTEX_FORMAT_COMPACT).stride << " bytes per vertex" << std::endl;
+    size_t fullTotal = 0, compactTotal = 0;
+    for (const std::string &path : paths)
+    {
+        const size_t full = Model(path, false, VERTEX_FORMAT_FULL, MESH_OPTIMIZE_NONE, false).GetVertexMemory();
+        const size_t compact = Model(path, false, VERTEX_FORMAT_COMPACT, MESH_OPTIMIZE_NONE, false).GetVertexMemory();
+        fullTotal += full;
+        compactTotal += compact;
+        std::cout << "  " << path.substr(path.find_last_of('/') + 1) << ": " << full / 1024 << " KB full, "
+                  << compact / 1024 << " KB compact" << std::endl;
+    }
+    if (compactTotal > 0)
+        std::cout << "  total: " << fullTotal / 1024 << " KB full, " << compactTotal / 1024 << " KB compact, "
+                  << float(fullTotal) / compactTotal << "x smaller" << std::endl;
+    return !paths.empty();
+}
+
 // renderCube() renders a 1x1 3D cube in NDC.
 // -------------------------------------------------
 unsigned int cubeVAO = 0;
@@ -7,6 +7,7 @@
 
 #include <learnopengl/filesystem.h>
 #include <learnopengl/shader.h>
+#include <learnopengl/shader_library.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/model.h>
 
@@ -34,6 +35,10 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
+// hot reload
+bool reloadShaders = false;
+bool reloadKeyPressed = false;
+
 int main()
 {
     // glfw: initialize and configure
@@ -82,7 +87,7 @@ int main()
     // build and compile shaders
     // -------------------------
     Shader shaderGeometryPass("8.2.g_buffer.vs", "8.2.g_buffer.fs");
-    Shader shaderLightingPass("8.2.deferred_shading.vs", "8.2.deferred_shading.fs");
+    ShaderLibrary shaders; // the lighting pass is a permutation for the number of lights, and can be hot reloaded
     Shader shaderLightBox("8.2.deferred_light_box.vs", "8.2.deferred_light_box.fs");
 
     // load models
@@ -161,12 +166,36 @@ int main()
         lightColors.push_back(glm::vec3(rColor, gColor, bColor));
     }
 
-    // shader configuration
+    // loaded from the source tree rather than the copies next to the executable, so editing them there is what R picks up
+    Shader& shaderLightingPass = shaders.Get(FileSystem::getPath("src/5.advanced_lighting/8.2.deferred_shading_volumes/8.2.deferred_shading.vs"),
+        FileSystem::getPath("src/5.advanced_lighting/8.2.deferred_shading_volumes/8.2.deferred_shading.fs"), ShaderDefines().Set("NR_LIGHTS", (int)NR_LIGHTS));
+
+    // shader configuration; redone whenever the lighting pass is reloaded
     // --------------------
-    shaderLightingPass.use();
-    shaderLightingPass.setInt("gPosition", 0);
-    shaderLightingPass.setInt("gNormal", 1);
-    shaderLightingPass.setInt("gAlbedoSpec", 2);
+    struct LightUniforms
+    {
+        Uniform<glm::vec3> position, color;
+        Uniform<float> linear, quadratic, radius;
+    };
+    std::vector<LightUniforms> lightUniforms(lightPositions.size());
+    auto configureLightingPass = [&]()
+    {
+        shaderLightingPass.use();
+        shaderLightingPass.setInt("gPosition", 0);
+        shaderLightingPass.setInt("gNormal", 1);
+        shaderLightingPass.setInt("gAlbedoSpec", 2);
+        // look the per light uniforms up once instead of building their names every frame
+        for (unsigned int i = 0; i < lightPositions.size(); i++)
+        {
+            const std::string light = "lights[" + std::to_string(i) + "]";
+            lightUniforms[i].position = shaderLightingPass.getUniform<glm::vec3>(light + ".Position");
+            lightUniforms[i].color = shaderLightingPass.getUniform<glm::vec3>(light + ".Color");
+            lightUniforms[i].linear = shaderLightingPass.getUniform<float>(light + ".Linear");
+            lightUniforms[i].quadratic = shaderLightingPass.getUniform<float>(light + ".Quadratic");
+            lightUniforms[i].radius = shaderLightingPass.getUniform<float>(light + ".Radius");
+        }
+    };
+    configureLightingPass();
 
     // render loop
     // -----------
@@ -181,6 +210,13 @@ int main()
         // input
         // -----
         processInput(window);
+        // R: rebuild the shaders whose files were edited since they were loaded
+        if (reloadShaders)
+        {
+            reloadShaders = false;
+            if (!shaders.Reload().empty())
+                configureLightingPass();
+        }
 
         // render
         // ------
@@ -220,18 +256,18 @@ int main()
         // send light relevant uniforms
         for (unsigned int i = 0; i < lightPositions.size(); i++)
         {
-            shaderLightingPass.setVec3("lights[" + std::to_string(i) + "].Position", lightPositions[i]);
-            shaderLightingPass.setVec3("lights[" + std::to_string(i) + "].Color", lightColors[i]);
+            shaderLightingPass.setVec3(lightUniforms[i].position, lightPositions[i]);
+            shaderLightingPass.setVec3(lightUniforms[i].color, lightColors[i]);
             // update attenuation parameters and calculate radius
             const float constant = 1.0f; // note that we don't send this to the shader, we assume it is always 1.0 (in our case)
             const float linear = 0.7f;
             const float quadratic = 1.8f;
-            shaderLightingPass.setFloat("lights[" + std::to_string(i) + "].Linear", linear);
-            shaderLightingPass.setFloat("lights[" + std::to_string(i) + "].Quadratic", quadratic);
+            shaderLightingPass.setFloat(lightUniforms[i].linear, linear);
+            shaderLightingPass.setFloat(lightUniforms[i].quadratic, quadratic);
             // then calculate radius of light volume/sphere
             const float maxBrightness = std::fmaxf(std::fmaxf(lightColors[i].r, lightColors[i].g), lightColors[i].b);
             float radius = (-linear + std::sqrt(linear * linear - 4 * quadratic * (constant - (256.0f / 5.0f) * maxBrightness))) / (2.0f * quadratic);
-            shaderLightingPass.setFloat("lights[" + std::to_string(i) + "].Radius", radius);
+            shaderLightingPass.setFloat(lightUniforms[i].radius, radius);
         }
         shaderLightingPass.setVec3("viewPos", camera.Position);
         // finally render quad
@@ -269,6 +305,10 @@ int main()
         glfwPollEvents();
     }
 
+    // de-allocate the model's textures while the OpenGL context still exists
+    // ----------------------------------------------------------------------
+    backpack.Unload();
+
     glfwTerminate();
     return 0;
 }
@@ -395,6 +435,16 @@ void processInput(GLFWwindow *window)
         camera.ProcessKeyboard(LEFT, deltaTime);
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
         camera.ProcessKeyboard(RIGHT, deltaTime);
+
+    if (glfwGetKey(window, GLFW_KEY_R) == GLFW_PRESS && !reloadKeyPressed)
+    {
+        reloadShaders = true;
+        reloadKeyPressed = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_R) == GLFW_RELEASE)
+    {
+        reloadKeyPressed = false;
+    }
 }
 
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
@@ -213,6 +213,9 @@ int main()
     shaderSSAO.setInt("gPosition", 0);
     shaderSSAO.setInt("gNormal", 1);
     shaderSSAO.setInt("texNoise", 2);
+    std::vector<Uniform<glm::vec3>> sampleUniforms(ssaoKernel.size());
+    for (unsigned int i = 0; i < ssaoKernel.size(); ++i)
+        sampleUniforms[i] = shaderSSAO.getUniform<glm::vec3>("samples[" + std::to_string(i) + "]");
     shaderSSAOBlur.use();
     shaderSSAOBlur.setInt("ssaoInput", 0);
 
@@ -270,7 +273,7 @@ int main()
             shaderSSAO.use();
             // Send kernel + rotation 
             for (unsigned int i = 0; i < 64; ++i)
-                shaderSSAO.setVec3("samples[" + std::to_string(i) + "]", ssaoKernel[i]);
+                shaderSSAO.setVec3(sampleUniforms[i], ssaoKernel[i]);
             shaderSSAO.setMat4("projection", projection);
             glActiveTexture(GL_TEXTURE0);
             glBindTexture(GL_TEXTURE_2D, gPosition);
@@ -323,6 +326,10 @@ int main()
         glfwPollEvents();
     }
 
+    // de-allocate the model's textures while the OpenGL context still exists
+    // ----------------------------------------------------------------------
+    backpack.Unload();
+
     glfwTerminate();
     return 0;
 }
@@ -1,11 +1,12 @@
 #version 330 core
 layout (location = 0) in vec4 vertex; // <vec2 pos, vec2 tex>
-out vec2 TexCoords;
+layout (location = 1) in float page;  // atlas layer the glyph is on
+out vec3 TexCoords;
 
 uniform mat4 projection;
 
 void main()
 {
     gl_Position = projection * vec4(vertex.xy, 0.0, 1.0);
-    TexCoords = vertex.zw;
+    TexCoords = vec3(vertex.zw, page);
 }
\ No newline at end of file
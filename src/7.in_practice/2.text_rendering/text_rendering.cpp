@@ -1,6 +1,9 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
 #include <iostream>
-#include <map>
 #include <string>
+#include <vector>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
@@ -9,30 +12,27 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-#include <ft2build.h>
-#include FT_FREETYPE_H
-
 #include <learnopengl/filesystem.h>
+#include <learnopengl/glyph_cache.h>
 #include <learnopengl/shader.h>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow *window);
+void UpdateGlyphs();
 void RenderText(Shader &shader, std::string text, float x, float y, float scale, glm::vec3 color);
 
 // settings
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
+const unsigned int FONT_SIZE = 48; // pixel size of text at scale 1
 
-/// Holds all state information relevant to a character as loaded using FreeType
-struct Character {
-    unsigned int TextureID; // ID handle of the glyph texture
-    glm::ivec2   Size;      // Size of glyph
-    glm::ivec2   Bearing;   // Offset from baseline to left/top of glyph
-    unsigned int Advance;   // Horizontal offset to advance to next glyph
-};
-
-std::map<GLchar, Character> Characters;
+// glyphs are rasterized in the background as text needs them and kept in the layers of one array texture
+GlyphCache Glyphs;
+unsigned int Font;
+unsigned int AtlasTexture;
 unsigned int VAO, VBO;
+// vertices of the string being rendered, kept around so their memory is reused
+std::vector<TextVertex> TextVertices;
 
 int main()
 {
@@ -80,16 +80,8 @@ int main()
     shader.use();
     glUniformMatrix4fv(glGetUniformLocation(shader.ID, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
 
-    // FreeType
-    // --------
-    FT_Library ft;
-    // All functions return a value different than 0 whenever an error occurred
-    if (FT_Init_FreeType(&ft))
-    {
-        std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
-        return -1;
-    }
-
+    // FreeType: glyphs of the font are rasterized on first use
+    // ----------------------------------------------------------
 	// find path to font
     std::string font_name = FileSystem::getPath("resources/fonts/Antonio-Bold.ttf");
     if (font_name.empty())
@@ -97,63 +89,21 @@ int main()
         std::cout << "ERROR::FREETYPE: Failed to load font_name" << std::endl;
         return -1;
     }
-	
-	// load font as face
-    FT_Face face;
-    if (FT_New_Face(ft, font_name.c_str(), 0, &face)) {
-        std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
-        return -1;
-    }
-    else {
-        // set size to load glyphs as
-        FT_Set_Pixel_Sizes(face, 0, 48);
-
-        // disable byte-alignment restriction
-        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-
-        // load first 128 characters of ASCII set
-        for (unsigned char c = 0; c < 128; c++)
-        {
-            // Load character glyph 
-            if (FT_Load_Char(face, c, FT_LOAD_RENDER))
-            {
-                std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
-                continue;
-            }
-            // generate texture
-            unsigned int texture;
-            glGenTextures(1, &texture);
-            glBindTexture(GL_TEXTURE_2D, texture);
-            glTexImage2D(
-                GL_TEXTURE_2D,
-                0,
-                GL_RED,
-                face->glyph->bitmap.width,
-                face->glyph->bitmap.rows,
-                0,
-                GL_RED,
-                GL_UNSIGNED_BYTE,
-                face->glyph->bitmap.buffer
-            );
-            // set texture options
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            // now store character for later use
-            Character character = {
-                texture,
-                glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-                glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-                static_cast<unsigned int>(face->glyph->advance.x)
-            };
-            Characters.insert(std::pair<char, Character>(c, character));
-        }
-        glBindTexture(GL_TEXTURE_2D, 0);
-    }
-    // destroy FreeType once we're finished
-    FT_Done_Face(face);
-    FT_Done_FreeType(ft);
+    Font = Glyphs.AddFont(font_name);
+
+    // room for every atlas page as a layer of an array texture, cleared so the padding around glyphs samples as empty
+    int pageSize = Glyphs.GetPageSize();
+    std::vector<unsigned char> empty(static_cast<size_t>(pageSize) * pageSize * Glyphs.GetMaxPages(), 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glGenTextures(1, &AtlasTexture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, AtlasTexture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R8, pageSize, pageSize, Glyphs.GetMaxPages(), 0, GL_RED, GL_UNSIGNED_BYTE, empty.data());
+    // set texture options
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
 
     
     // configure VAO/VBO for texture quads
@@ -162,9 +112,10 @@ int main()
     glGenBuffers(1, &VBO);
     glBindVertexArray(VAO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(TextVertex), 0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void*)offsetof(TextVertex, page));
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 
@@ -181,8 +132,10 @@ int main()
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
+        UpdateGlyphs();
         RenderText(shader, "This is sample text", 25.0f, 25.0f, 1.0f, glm::vec3(0.5, 0.8f, 0.2f));
         RenderText(shader, "(C) LearnOpenGL.com", 540.0f, 570.0f, 0.5f, glm::vec3(0.3, 0.7f, 0.9f));
+        RenderText(shader, "UTF-8: na\xC3\xAFve caf\xC3\xA9, \xC2\xBFqu\xC3\xA9 tal?", 25.0f, 100.0f, 0.75f, glm::vec3(0.9f, 0.6f, 0.3f));
        
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
@@ -212,49 +165,50 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 }
 
 
-// render line of text
-// -------------------
+// move the glyphs rasterized since the last frame into the atlas texture
+// ---------------------------------------------------------------------
+void UpdateGlyphs()
+{
+    Glyphs.Update();
+    int pageSize = Glyphs.GetPageSize();
+    glm::ivec4 region;
+    glBindTexture(GL_TEXTURE_2D_ARRAY, AtlasTexture);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, pageSize);
+    for (unsigned int page = 0; page < Glyphs.GetPageCount(); page++)
+    {
+        if (!Glyphs.TakeDirtyRegion(page, region))
+            continue;
+        const unsigned char *pixels = Glyphs.GetPagePixels(page).data() + static_cast<size_t>(region.y) * pageSize + region.x;
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, region.x, region.y, page, region.z, region.w, 1, GL_RED, GL_UNSIGNED_BYTE, pixels);
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+// render line of UTF-8 text; glyphs that aren't rasterized yet show up in a later frame
+// ------------------------------------------------------------------------------------
 void RenderText(Shader &shader, std::string text, float x, float y, float scale, glm::vec3 color)
 {
+    // lay the whole string out as quads (two triangles per glyph) in one go, with the glyphs
+    // rasterized at the size they end up on screen rather than scaled
+    unsigned int pixelSize = std::max(1u, static_cast<unsigned int>(std::lround(FONT_SIZE * scale)));
+    TextVertices.clear();
+    LayoutText(Glyphs, Font, pixelSize, text, x, y, scale * FONT_SIZE / pixelSize, false, TextVertices);
+    if (TextVertices.empty())
+        return;
+
     // activate corresponding render state	
     shader.use();
     glUniform3f(glGetUniformLocation(shader.ID, "textColor"), color.x, color.y, color.z);
     glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, AtlasTexture);
     glBindVertexArray(VAO);
-
-    // iterate through all characters
-    std::string::const_iterator c;
-    for (c = text.begin(); c != text.end(); c++) 
-    {
-        Character ch = Characters[*c];
-
-        float xpos = x + ch.Bearing.x * scale;
-        float ypos = y - (ch.Size.y - ch.Bearing.y) * scale;
-
-        float w = ch.Size.x * scale;
-        float h = ch.Size.y * scale;
-        // update VBO for each character
-        float vertices[6][4] = {
-            { xpos,     ypos + h,   0.0f, 0.0f },            
-            { xpos,     ypos,       0.0f, 1.0f },
-            { xpos + w, ypos,       1.0f, 1.0f },
-
-            { xpos,     ypos + h,   0.0f, 0.0f },
-            { xpos + w, ypos,       1.0f, 1.0f },
-            { xpos + w, ypos + h,   1.0f, 0.0f }           
-        };
-        // render glyph texture over quad
-        glBindTexture(GL_TEXTURE_2D, ch.TextureID);
-        // update content of VBO memory
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices); // be sure to use glBufferSubData and not glBufferData
-
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        // render quad
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        // now advance cursors for next glyph (note that advance is number of 1/64 pixels)
-        x += (ch.Advance >> 6) * scale; // bitshift by 6 to get value in pixels (2^6 = 64 (divide amount of 1/64th pixels by 64 to get amount of pixels))
-    }
+    // update content of VBO memory; glBufferData hands us fresh storage instead of waiting on the last draw
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, TextVertices.size() * sizeof(TextVertex), TextVertices.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    // render all glyphs at once, they share the atlas texture
+    glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(TextVertices.size()));
     glBindVertexArray(0);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
 }
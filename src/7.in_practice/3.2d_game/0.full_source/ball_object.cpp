@@ -10,13 +10,14 @@
 
 
 BallObject::BallObject() 
-    : GameObject(), Radius(12.5f), Stuck(true), Sticky(false), PassThrough(false)  { }
+    : GameObject(), Radius(12.5f), Stuck(true), Sticky(false), PassThrough(false), LastPosition(0.0f)  { }
 
 BallObject::BallObject(glm::vec2 pos, float radius, glm::vec2 velocity, Texture2D sprite)
-    : GameObject(pos, glm::vec2(radius * 2.0f, radius * 2.0f), sprite, glm::vec3(1.0f), velocity), Radius(radius), Stuck(true), Sticky(false), PassThrough(false) { }
+    : GameObject(pos, glm::vec2(radius * 2.0f, radius * 2.0f), sprite, glm::vec3(1.0f), velocity), Radius(radius), Stuck(true), Sticky(false), PassThrough(false), LastPosition(pos) { }
 
 glm::vec2 BallObject::Move(float dt, unsigned int window_width)
 {
+    this->LastPosition = this->Position;
     // if not stuck to player board
     if (!this->Stuck)
     {
@@ -46,6 +47,7 @@ glm::vec2 BallObject::Move(float dt, unsigned int window_width)
 void BallObject::Reset(glm::vec2 position, glm::vec2 velocity)
 {
     this->Position = position;
+    this->LastPosition = position;
     this->Velocity = velocity;
     this->Stuck = true;
     this->Sticky = false;
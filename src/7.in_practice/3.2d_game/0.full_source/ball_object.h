@@ -27,6 +27,8 @@ public:
     float   Radius;
     bool    Stuck;
     bool    Sticky, PassThrough;
+    // where the last Move started from
+    glm::vec2 LastPosition;
     // constructor(s)
     BallObject();
     BallObject(glm::vec2 pos, float radius, glm::vec2 velocity, Texture2D sprite);
@@ -0,0 +1,45 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef BRICK_ARRAYS_H
+#define BRICK_ARRAYS_H
+#include <vector>
+
+#include <glm/glm.hpp>
+
+
+// Tile code of a solid (indestructible) brick; 2 and up are the colored,
+// destructible bricks and 0 is an empty tile
+const unsigned char TILE_SOLID = 1;
+
+// The bricks of a level, stored as one array per property (structure of
+// arrays). A brick doesn't hold its own texture or color: its tile code
+// is the handle the level looks both up by when drawing. All bricks of a
+// level are one tile in size.
+struct BrickArrays
+{
+    std::vector<float>         PositionX, PositionY;
+    std::vector<unsigned char> Type;      // tile code
+    std::vector<unsigned char> Destroyed; // 0 or 1
+    glm::vec2                  Size;
+
+    BrickArrays() : Size(0.0f) { }
+    unsigned int Count() const { return static_cast<unsigned int>(this->Type.size()); }
+    glm::vec2    Position(unsigned int i) const { return glm::vec2(this->PositionX[i], this->PositionY[i]); }
+    bool         IsSolid(unsigned int i) const { return this->Type[i] == TILE_SOLID; }
+    void Clear()
+    {
+        this->PositionX.clear();
+        this->PositionY.clear();
+        this->Type.clear();
+        this->Destroyed.clear();
+        this->Size = glm::vec2(0.0f);
+    }
+};
+
+#endif
@@ -0,0 +1,76 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "brick_grid.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+BrickGrid::BrickGrid()
+    : columns(0), rows(0), cellSize(1.0f), count(0)
+{
+
+}
+
+void BrickGrid::Build(const BrickArrays &bricks, unsigned int columns, unsigned int rows, glm::vec2 cellSize)
+{
+    this->columns = columns;
+    this->rows = rows;
+    this->cellSize = cellSize;
+    this->cells.assign(columns * rows, -1);
+    this->brickCells.assign(bricks.Count(), -1);
+    this->count = 0;
+    for (unsigned int i = 0; i < bricks.Count(); ++i)
+    {
+        if (bricks.Destroyed[i])
+            continue;
+        // a brick's center always lies well inside its own tile, its edges might round into the neighbours
+        glm::vec2 center = bricks.Position(i) + 0.5f * bricks.Size;
+        int x = static_cast<int>(std::floor(center.x / cellSize.x));
+        int y = static_cast<int>(std::floor(center.y / cellSize.y));
+        if (x < 0 || y < 0 || x >= static_cast<int>(columns) || y >= static_cast<int>(rows))
+            continue;
+        int cell = y * columns + x;
+        this->cells[cell] = i;
+        this->brickCells[i] = cell;
+        this->count++;
+    }
+}
+
+void BrickGrid::Remove(unsigned int brick)
+{
+    if (brick >= this->brickCells.size() || this->brickCells[brick] < 0)
+        return;
+    this->cells[this->brickCells[brick]] = -1;
+    this->brickCells[brick] = -1;
+    this->count--;
+}
+
+void BrickGrid::Query(glm::vec2 min, glm::vec2 max, std::vector<unsigned int> &result) const
+{
+    result.clear();
+    if (this->cells.empty())
+        return;
+    // widen the box by a sliver so bricks whose edges rounded into a cell boundary are not missed
+    glm::vec2 margin = 0.001f * this->cellSize;
+    glm::vec2 first = glm::floor((min - margin) / this->cellSize);
+    glm::vec2 last = glm::floor((max + margin) / this->cellSize);
+    int x0 = static_cast<int>(std::max(first.x, 0.0f)), y0 = static_cast<int>(std::max(first.y, 0.0f));
+    int x1 = static_cast<int>(std::min(last.x, this->columns - 1.0f)), y1 = static_cast<int>(std::min(last.y, this->rows - 1.0f));
+    // row by row, which matches the order GameLevel creates its bricks in
+    for (int y = y0; y <= y1; ++y)
+    {
+        const int *row = &this->cells[y * this->columns];
+        for (int x = x0; x <= x1; ++x)
+            if (row[x] >= 0)
+                result.push_back(row[x]);
+    }
+    if (!std::is_sorted(result.begin(), result.end()))
+        std::sort(result.begin(), result.end());
+}
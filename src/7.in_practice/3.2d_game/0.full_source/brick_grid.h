@@ -0,0 +1,46 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef BRICK_GRID_H
+#define BRICK_GRID_H
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "brick_arrays.h"
+
+
+// BrickGrid is the collision broad phase of a level: a uniform grid
+// laid over the level's tile layout, one cell per tile, where every
+// cell holds the index of the brick in that tile (if any). Instead of
+// testing the ball against every brick, only the bricks in the cells
+// the ball overlaps are tested. Destroyed bricks are removed from their
+// cell as they get destroyed.
+class BrickGrid
+{
+public:
+    // constructor
+    BrickGrid();
+    // (re)builds the grid for bricks laid out on columns x rows tiles of cellSize, starting at the origin
+    void Build(const BrickArrays &bricks, unsigned int columns, unsigned int rows, glm::vec2 cellSize);
+    // takes a (destroyed) brick out of the grid
+    void Remove(unsigned int brick);
+    // stores the bricks whose cells overlap the box [min, max] in result, in ascending order
+    void Query(glm::vec2 min, glm::vec2 max, std::vector<unsigned int> &result) const;
+    // number of bricks still in the grid
+    unsigned int Size() const { return this->count; }
+private:
+    // grid state
+    unsigned int      columns, rows;
+    glm::vec2         cellSize;
+    std::vector<int>  cells;      // brick index per cell, -1 for an empty cell
+    std::vector<int>  brickCells; // cell per brick, -1 once removed
+    unsigned int      count;
+};
+
+#endif
@@ -0,0 +1,41 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include <glm/glm.hpp>
+
+#include "game_object.h"
+#include "ball_object.h"
+
+
+// Represents the four possible (collision) directions
+enum Direction {
+    UP,
+    RIGHT,
+    DOWN,
+    LEFT
+};
+// Collision data of the ball against a box
+struct Collision
+{
+    bool      Hit;        // collision?
+    Direction Dir;        // what direction?
+    glm::vec2 Difference; // difference vector center - closest point
+};
+
+// AABB - AABB collision
+bool      CheckCollision(const GameObject &one, const GameObject &two);
+// AABB - Circle collision
+Collision CheckCollision(const BallObject &one, const GameObject &two);
+Collision CheckCollision(const BallObject &one, glm::vec2 position, glm::vec2 size);
+// calculates which direction a vector is facing (N,E,S or W)
+Direction VectorDirection(glm::vec2 target);
+
+#endif
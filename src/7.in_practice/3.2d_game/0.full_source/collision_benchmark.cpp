@@ -0,0 +1,98 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "collision_benchmark.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "simulation.h"
+#include "game_level.h"
+#include "ball_object.h"
+
+
+// size of a generated tile in pixels
+const float BENCHMARK_TILE_SIZE = 16.0f;
+// simulation step
+const float BENCHMARK_DT = 1.0f / 60.0f;
+
+// moves the ball through level for the given number of steps and records its state after every
+// step in trace; returns the total time spent in collision detection and response in milliseconds
+double SimulateCollisions(GameLevel &level, BallObject &ball, unsigned int steps, bool bruteForce, unsigned int size, std::vector<float> &trace, unsigned int &hitCount)
+{
+    std::vector<unsigned int> hits;
+    double milliseconds = 0.0;
+    hitCount = 0;
+    for (unsigned int step = 0; step < steps; ++step)
+    {
+        ball.Move(BENCHMARK_DT, size);
+        // the level is closed at the bottom as well
+        if (ball.Position.y + ball.Size.y >= size)
+        {
+            ball.Velocity.y = -std::abs(ball.Velocity.y);
+            ball.Position.y = size - ball.Size.y;
+        }
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        if (bruteForce)
+            level.CollideBallBruteForce(ball, hits);
+        else
+            level.CollideBall(ball, hits);
+        milliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        hitCount += hits.size();
+        trace.push_back(ball.Position.x);
+        trace.push_back(ball.Position.y);
+        trace.push_back(ball.Velocity.x);
+        trace.push_back(ball.Velocity.y);
+        trace.push_back(static_cast<float>(hits.size()));
+    }
+    return milliseconds;
+}
+
+bool RunCollisionBenchmark(unsigned int tiles, unsigned int steps)
+{
+    unsigned int size = static_cast<unsigned int>(tiles * BENCHMARK_TILE_SIZE);
+    GameLevel level;
+    level.Generate(tiles, tiles, size, size, 1234);
+    GameLevel reference = level;
+    unsigned int bricks = level.Bricks.Count();
+    // start in the middle of the level, fast enough to cross a tile per step
+    glm::vec2 start(size / 2.0f - BALL_RADIUS);
+    BallObject ball(start, BALL_RADIUS, INITIAL_BALL_VELOCITY * 3.0f, Texture2D());
+    BallObject referenceBall = ball;
+    ball.Stuck = referenceBall.Stuck = false;
+
+    std::vector<float> trace, referenceTrace;
+    unsigned int hits, referenceHits;
+    double gridTime = SimulateCollisions(level, ball, steps, false, size, trace, hits);
+    double bruteForceTime = SimulateCollisions(reference, referenceBall, steps, true, size, referenceTrace, referenceHits);
+
+    std::cout << "COLLISION BENCHMARK: " << tiles << "x" << tiles << " tiles, " << bricks << " bricks, " << steps << " steps" << std::endl;
+    std::cout << "  grid:        " << gridTime / steps << " ms/step, " << hits << " bricks hit" << std::endl;
+    std::cout << "  brute force: " << bruteForceTime / steps << " ms/step, " << referenceHits << " bricks hit" << std::endl;
+    // the grid only skips bricks that can't be hit, so both runs have to match exactly
+    for (unsigned int i = 0; i < trace.size(); ++i)
+    {
+        if (trace[i] != referenceTrace[i])
+        {
+            std::cout << "  results differ from step " << i / 5 << std::endl;
+            return false;
+        }
+    }
+    for (unsigned int i = 0; i < bricks; ++i)
+    {
+        if (level.Bricks.Destroyed[i] != reference.Bricks.Destroyed[i])
+        {
+            std::cout << "  results differ in brick " << i << std::endl;
+            return false;
+        }
+    }
+    std::cout << "  results identical" << std::endl;
+    return true;
+}
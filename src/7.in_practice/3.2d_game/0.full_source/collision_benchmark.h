@@ -0,0 +1,19 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef COLLISION_BENCHMARK_H
+#define COLLISION_BENCHMARK_H
+
+
+// Runs the ball through a generated level of tiles x tiles bricks twice:
+// once with the level's collision grid and once testing every brick. Prints
+// how long the collision step took with both and returns whether both runs
+// played out exactly the same. Needs no window or OpenGL context.
+bool RunCollisionBenchmark(unsigned int tiles, unsigned int steps);
+
+#endif
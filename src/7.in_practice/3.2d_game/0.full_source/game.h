@@ -9,71 +9,43 @@
 #ifndef GAME_H
 #define GAME_H
 #include <vector>
-#include <tuple>
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
-#include "game_level.h"
-#include "power_up.h"
-
-// Represents the current state of the game
-enum GameState {
-    GAME_ACTIVE,
-    GAME_MENU,
-    GAME_WIN
-};
-
-// Represents the four possible (collision) directions
-enum Direction {
-    UP,
-    RIGHT,
-    DOWN,
-    LEFT
-};
-// Defines a Collision typedef that represents collision data
-typedef std::tuple<bool, Direction, glm::vec2> Collision; // <collision?, what direction?, difference vector center - closest point>
-
-// Initial size of the player paddle
-const glm::vec2 PLAYER_SIZE(100.0f, 20.0f);
-// Initial velocity of the player paddle
-const float PLAYER_VELOCITY(500.0f);
-// Initial velocity of the Ball
-const glm::vec2 INITIAL_BALL_VELOCITY(100.0f, -350.0f);
-// Radius of the ball object
-const float BALL_RADIUS = 12.5f;
+#include "simulation.h"
 
 // Game holds all game-related state and functionality.
 // Combines all game-related data into a single class for
 // easy access to each of the components and manageability.
+// The game logic itself lives in a Simulation that is stepped at a
+// fixed rate; Game feeds it keyboard input and presents its state.
 class Game
 {
 public:
     // game state
-    GameState               State;	
     bool                    Keys[1024];
-    bool                    KeysProcessed[1024];
     unsigned int            Width, Height;
-    std::vector<GameLevel>  Levels;
-    std::vector<PowerUp>    PowerUps;
-    unsigned int            Level;
-    unsigned int            Lives;
+    Simulation             *World;
+    // seed and input of every tick simulated so far; with Replay set
+    // before Init, the recorded input is played back instead of the keys
+    InputRecording          Recording;
+    bool                    Replay;
+    // number of extra sprites drawn every frame to stress the renderer (0 = off)
+    unsigned int            StressSprites;
     // constructor/destructor
     Game(unsigned int width, unsigned int height);
     ~Game();
     // initialize game state (load all shaders/textures/levels)
     void Init();
     // game loop
-    void ProcessInput(float dt);
+    void ProcessInput();
     void Update(float dt);
     void Render();
-    void DoCollisions();
-    // reset
-    void ResetLevel();
-    void ResetPlayer();
-    // powerups
-    void SpawnPowerUps(GameObject &block);
-    void UpdatePowerUps(float dt);
+private:
+    unsigned char           input;      // buttons held, as gathered by ProcessInput
+    float                   tickTime;   // time not yet simulated
+    unsigned int            replayTick; // next tick of Recording to play back
 };
 
 #endif
\ No newline at end of file
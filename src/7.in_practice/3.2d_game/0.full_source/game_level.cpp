@@ -7,87 +7,179 @@
 ** option) any later version.
 ******************************************************************/
 #include "game_level.h"
+#include "collision.h"
+#include "level_file.h"
 
-#include <fstream>
-#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <random>
 
 
+// color of every tile code; codes past the end of the table are white
+const glm::vec3 TILE_COLORS[] = {
+    glm::vec3(1.0f),              // 0: empty
+    glm::vec3(0.8f, 0.8f, 0.7f),  // 1: solid
+    glm::vec3(0.2f, 0.6f, 1.0f),
+    glm::vec3(0.0f, 0.7f, 0.0f),
+    glm::vec3(0.8f, 0.8f, 0.4f),
+    glm::vec3(1.0f, 0.5f, 0.0f)
+};
+const unsigned int TILE_COLOR_COUNT = sizeof(TILE_COLORS) / sizeof(TILE_COLORS[0]);
+
 void GameLevel::Load(const char *file, unsigned int levelWidth, unsigned int levelHeight)
 {
     // clear old data
-    this->Bricks.clear();
+    this->Bricks.Clear();
+    this->grid = BrickGrid();
     // load from file
-    unsigned int tileCode;
-    GameLevel level;
-    std::string line;
-    std::ifstream fstream(file);
-    std::vector<std::vector<unsigned int>> tileData;
-    if (fstream)
+    LevelFile level;
+    if (level.Open(file))
+        this->init(level.Tiles(), level.Columns, level.Rows, levelWidth, levelHeight);
+}
+
+void GameLevel::Generate(unsigned int columns, unsigned int rows, unsigned int levelWidth, unsigned int levelHeight, unsigned int seed)
+{
+    // clear old data
+    this->Bricks.Clear();
+    this->grid = BrickGrid();
+    // roughly 40% empty tiles, 10% solid and the rest spread over the four colors
+    std::mt19937 random(seed);
+    std::vector<unsigned char> tiles(columns * rows);
+    for (unsigned char &tile : tiles)
     {
-        while (std::getline(fstream, line)) // read each line from level file
-        {
-            std::istringstream sstream(line);
-            std::vector<unsigned int> row;
-            while (sstream >> tileCode) // read each word separated by spaces
-                row.push_back(tileCode);
-            tileData.push_back(row);
-        }
-        if (tileData.size() > 0)
-            this->init(tileData, levelWidth, levelHeight);
+        unsigned int roll = random() % 10;
+        tile = roll < 4 ? 0 : roll == 4 ? TILE_SOLID : 2 + roll % 4;
     }
+    if (rows > 0 && columns > 0)
+        this->init(tiles.data(), columns, rows, levelWidth, levelHeight);
 }
 
 void GameLevel::Draw(SpriteRenderer &renderer)
 {
-    for (GameObject &tile : this->Bricks)
-        if (!tile.Destroyed)
-            tile.Draw(renderer);
+    // a brick's tile code picks its texture and color, so both are only looked up here
+    Texture2D block = ResourceManager::GetTexture("block");
+    Texture2D solid = ResourceManager::GetTexture("block_solid");
+    for (unsigned int i = 0; i < this->Bricks.Count(); ++i)
+    {
+        if (this->Bricks.Destroyed[i])
+            continue;
+        unsigned char type = this->Bricks.Type[i];
+        glm::vec3 color = type < TILE_COLOR_COUNT ? TILE_COLORS[type] : glm::vec3(1.0f);
+        renderer.DrawSprite(type == TILE_SOLID ? solid : block, this->Bricks.Position(i), this->Bricks.Size, 0.0f, color);
+    }
 }
 
 bool GameLevel::IsCompleted()
 {
-    for (GameObject &tile : this->Bricks)
-        if (!tile.IsSolid && !tile.Destroyed)
+    for (unsigned int i = 0; i < this->Bricks.Count(); ++i)
+        if (!this->Bricks.IsSolid(i) && !this->Bricks.Destroyed[i])
             return false;
     return true;
 }
 
-void GameLevel::init(std::vector<std::vector<unsigned int>> tileData, unsigned int levelWidth, unsigned int levelHeight)
+void GameLevel::DestroyBrick(unsigned int index)
+{
+    this->Bricks.Destroyed[index] = 1;
+    this->grid.Remove(index);
+}
+
+void GameLevel::CollideBall(BallObject &ball, std::vector<unsigned int> &hits)
+{
+    hits.clear();
+    // only the bricks in the cells the ball swept over since its last move are candidates
+    glm::vec2 radius(ball.Radius);
+    glm::vec2 start = ball.LastPosition + radius, end = ball.Position + radius;
+    this->grid.Query(glm::min(start, end) - radius, glm::max(start, end) + radius, this->candidates);
+    unsigned int next = 0;
+    while (next < this->candidates.size())
+    {
+        unsigned int index = this->candidates[next++];
+        if (!this->collideBrick(ball, index, hits))
+            continue;
+        // the ball got pushed out of the brick; like in the brute-force loop, the bricks after this
+        // one are tested against the new position, so add whatever that position touches
+        glm::vec2 center = ball.Position + radius;
+        this->grid.Query(center - radius, center + radius, this->found);
+        this->candidates.erase(this->candidates.begin(), this->candidates.begin() + next);
+        for (unsigned int brick : this->found)
+            if (brick > index)
+                this->candidates.push_back(brick);
+        std::sort(this->candidates.begin(), this->candidates.end());
+        this->candidates.erase(std::unique(this->candidates.begin(), this->candidates.end()), this->candidates.end());
+        next = 0;
+    }
+}
+
+void GameLevel::CollideBallBruteForce(BallObject &ball, std::vector<unsigned int> &hits)
+{
+    hits.clear();
+    for (unsigned int i = 0; i < this->Bricks.Count(); ++i)
+        this->collideBrick(ball, i, hits);
+}
+
+void GameLevel::init(const unsigned char *tiles, unsigned int columns, unsigned int rows, unsigned int levelWidth, unsigned int levelHeight)
 {
     // calculate dimensions
-    unsigned int height = tileData.size();
-    unsigned int width = tileData[0].size(); // note we can index vector at [0] since this function is only called if height > 0
-    float unit_width = levelWidth / static_cast<float>(width), unit_height = levelHeight / height; 
-    // initialize level tiles based on tileData		
-    for (unsigned int y = 0; y < height; ++y)
+    float unit_width = levelWidth / static_cast<float>(columns), unit_height = levelHeight / rows; 
+    unsigned int count = columns * rows - static_cast<unsigned int>(std::count(tiles, tiles + columns * rows, 0));
+    this->Bricks.Clear();
+    this->Bricks.Size = glm::vec2(unit_width, unit_height);
+    this->Bricks.PositionX.reserve(count);
+    this->Bricks.PositionY.reserve(count);
+    this->Bricks.Type.reserve(count);
+    this->Bricks.Destroyed.reserve(count);
+    // a brick for every non-empty tile, row by row
+    for (unsigned int y = 0; y < rows; ++y)
     {
-        for (unsigned int x = 0; x < width; ++x)
+        const unsigned char *row = tiles + y * columns;
+        for (unsigned int x = 0; x < columns; ++x)
         {
-            // check block type from level data (2D level array)
-            if (tileData[y][x] == 1) // solid
-            {
-                glm::vec2 pos(unit_width * x, unit_height * y);
-                glm::vec2 size(unit_width, unit_height);
-                GameObject obj(pos, size, ResourceManager::GetTexture("block_solid"), glm::vec3(0.8f, 0.8f, 0.7f));
-                obj.IsSolid = true;
-                this->Bricks.push_back(obj);
-            }
-            else if (tileData[y][x] > 1)	// non-solid; now determine its color based on level data
-            {
-                glm::vec3 color = glm::vec3(1.0f); // original: white
-                if (tileData[y][x] == 2)
-                    color = glm::vec3(0.2f, 0.6f, 1.0f);
-                else if (tileData[y][x] == 3)
-                    color = glm::vec3(0.0f, 0.7f, 0.0f);
-                else if (tileData[y][x] == 4)
-                    color = glm::vec3(0.8f, 0.8f, 0.4f);
-                else if (tileData[y][x] == 5)
-                    color = glm::vec3(1.0f, 0.5f, 0.0f);
-
-                glm::vec2 pos(unit_width * x, unit_height * y);
-                glm::vec2 size(unit_width, unit_height);
-                this->Bricks.push_back(GameObject(pos, size, ResourceManager::GetTexture("block"), color));
-            }
+            if (row[x] == 0)
+                continue;
+            this->Bricks.PositionX.push_back(unit_width * x);
+            this->Bricks.PositionY.push_back(unit_height * y);
+            this->Bricks.Type.push_back(row[x]);
+            this->Bricks.Destroyed.push_back(0);
         }
     }
+    // bricks sit on the tile layout, so that is the grid of the broad phase as well
+    this->grid.Build(this->Bricks, columns, rows, this->Bricks.Size);
+}
+
+bool GameLevel::collideBrick(BallObject &ball, unsigned int index, std::vector<unsigned int> &hits)
+{
+    if (this->Bricks.Destroyed[index])
+        return false;
+    Collision collision = CheckCollision(ball, this->Bricks.Position(index), this->Bricks.Size);
+    if (!collision.Hit)
+        return false;
+    hits.push_back(index);
+    // destroy block if not solid
+    bool solid = this->Bricks.IsSolid(index);
+    if (!solid)
+        this->DestroyBrick(index);
+    // don't do collision resolution on non-solid bricks if pass-through is activated
+    if (ball.PassThrough && !solid)
+        return false;
+    if (collision.Dir == LEFT || collision.Dir == RIGHT) // horizontal collision
+    {
+        ball.Velocity.x = -ball.Velocity.x; // reverse horizontal velocity
+        // relocate
+        float penetration = ball.Radius - std::abs(collision.Difference.x);
+        if (collision.Dir == LEFT)
+            ball.Position.x += penetration; // move ball to right
+        else
+            ball.Position.x -= penetration; // move ball to left;
+    }
+    else // vertical collision
+    {
+        ball.Velocity.y = -ball.Velocity.y; // reverse vertical velocity
+        // relocate
+        float penetration = ball.Radius - std::abs(collision.Difference.y);
+        if (collision.Dir == UP)
+            ball.Position.y -= penetration; // move ball bback up
+        else
+            ball.Position.y += penetration; // move ball back down
+    }
+    return true;
 }
\ No newline at end of file
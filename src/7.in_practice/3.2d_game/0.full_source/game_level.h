@@ -13,29 +13,46 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
-#include "game_object.h"
+#include "ball_object.h"
+#include "brick_arrays.h"
+#include "brick_grid.h"
 #include "sprite_renderer.h"
 #include "resource_manager.h"
 
 
 /// GameLevel holds all Tiles as part of a Breakout level and 
 /// hosts functionality to Load/render levels from the harddisk.
+/// Levels load from binary (.blvl) or text (.lvl) level files, see LevelFile.
 class GameLevel
 {
 public:
     // level state
-    std::vector<GameObject> Bricks;
+    BrickArrays Bricks;
     // constructor
     GameLevel() { }
-    // loads level from file
+    // loads level from a binary or text level file
     void Load(const char *file, unsigned int levelWidth, unsigned int levelHeight);
+    // fills a level of columns x rows tiles with random bricks (for stress testing)
+    void Generate(unsigned int columns, unsigned int rows, unsigned int levelWidth, unsigned int levelHeight, unsigned int seed);
     // render level
     void Draw(SpriteRenderer &renderer);
     // check if the level is completed (all non-solid tiles are destroyed)
     bool IsCompleted();
+    // marks a brick as destroyed and takes it out of the collision grid
+    void DestroyBrick(unsigned int index);
+    // tests the ball against the bricks near it, destroys the non-solid ones it hits and bounces
+    // it off them (unless it passes through); hits receives the indices of all bricks hit, in order
+    void CollideBall(BallObject &ball, std::vector<unsigned int> &hits);
+    // same as CollideBall, but tests the ball against every brick
+    void CollideBallBruteForce(BallObject &ball, std::vector<unsigned int> &hits);
 private:
+    // collision broad phase over the bricks
+    BrickGrid grid;
+    std::vector<unsigned int> candidates, found; // scratch space for CollideBall
     // initialize level from tile data
-    void init(std::vector<std::vector<unsigned int>> tileData, unsigned int levelWidth, unsigned int levelHeight);
+    void init(const unsigned char *tiles, unsigned int columns, unsigned int rows, unsigned int levelWidth, unsigned int levelHeight);
+    // collision test and response of the ball against one brick; returns true if the ball was moved
+    bool collideBrick(BallObject &ball, unsigned int index, std::vector<unsigned int> &hits);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,92 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "level_benchmark.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "game_level.h"
+#include "game_object.h"
+#include "level_file.h"
+
+
+// where the generated levels are written, removed again afterwards
+const char *BENCHMARK_TEXT_LEVEL = "level_benchmark.lvl";
+const char *BENCHMARK_BINARY_LEVEL = "level_benchmark.blvl";
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// loads file into level and returns how long it took in milliseconds
+double TimeLoad(GameLevel &level, const char *file, unsigned int size)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    level.Load(file, size, size);
+    return MillisecondsSince(start);
+}
+
+bool RunLevelLoadBenchmark(unsigned int tiles)
+{
+    // the same tile mix as GameLevel::Generate
+    std::mt19937 random(1234);
+    std::vector<unsigned char> tileData(static_cast<size_t>(tiles) * tiles);
+    for (unsigned char &tile : tileData)
+    {
+        unsigned int roll = random() % 10;
+        tile = roll < 4 ? 0 : roll == 4 ? TILE_SOLID : 2 + roll % 4;
+    }
+    unsigned int size = tiles * 16;
+    if (!WriteTextLevelFile(BENCHMARK_TEXT_LEVEL, tileData.data(), tiles, tiles) ||
+        !WriteLevelFile(BENCHMARK_BINARY_LEVEL, tileData.data(), tiles, tiles))
+    {
+        std::cout << "Failed to write the benchmark levels" << std::endl;
+        return false;
+    }
+
+    // the way levels used to be read: a line at a time, a vector per row
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::ifstream fstream(BENCHMARK_TEXT_LEVEL);
+    std::vector<std::vector<unsigned int>> rows;
+    std::string line;
+    unsigned int tileCode;
+    while (std::getline(fstream, line))
+    {
+        std::istringstream sstream(line);
+        std::vector<unsigned int> row;
+        while (sstream >> tileCode)
+            row.push_back(tileCode);
+        rows.push_back(row);
+    }
+    double getlineTime = MillisecondsSince(start);
+
+    GameLevel text, binary;
+    double textTime = TimeLoad(text, BENCHMARK_TEXT_LEVEL, size);
+    double binaryTime = TimeLoad(binary, BENCHMARK_BINARY_LEVEL, size);
+    std::remove(BENCHMARK_TEXT_LEVEL);
+    std::remove(BENCHMARK_BINARY_LEVEL);
+
+    unsigned int bricks = binary.Bricks.Count();
+    std::cout << "LEVEL LOAD BENCHMARK: " << tiles << "x" << tiles << " tiles, " << bricks << " bricks" << std::endl;
+    std::cout << "  getline parse only: " << getlineTime << " ms" << std::endl;
+    std::cout << "  text level:         " << textTime << " ms" << std::endl;
+    std::cout << "  binary level:       " << binaryTime << " ms" << std::endl;
+    std::cout << "  " << sizeof(float) * 2 + 2 << " bytes per brick, " << sizeof(GameObject) << " as a GameObject" << std::endl;
+    bool same = text.Bricks.PositionX == binary.Bricks.PositionX && text.Bricks.PositionY == binary.Bricks.PositionY &&
+        text.Bricks.Type == binary.Bricks.Type && text.Bricks.Size == binary.Bricks.Size;
+    std::cout << (same ? "  results identical" : "  results differ") << std::endl;
+    return same;
+}
@@ -0,0 +1,20 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef LEVEL_BENCHMARK_H
+#define LEVEL_BENCHMARK_H
+
+
+// Writes a generated level of tiles x tiles tiles as both a text and a
+// binary level file, loads each of them into a GameLevel and prints how
+// long that took (next to the std::getline parsing levels used to go
+// through). Returns whether both loads produced the same bricks. Needs
+// no window or OpenGL context.
+bool RunLevelLoadBenchmark(unsigned int tiles);
+
+#endif
@@ -0,0 +1,127 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "level_file.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+
+const char LEVEL_FILE_MAGIC[4] = { 'B', 'L', 'V', 'L' };
+const uint32_t LEVEL_FILE_VERSION = 1;
+
+bool LevelFile::Open(const char *file)
+{
+    this->Columns = this->Rows = 0;
+    this->tiles = nullptr;
+    this->parsed.clear();
+    if (!this->mapping.Open(file))
+        return false;
+    const unsigned char *data = this->mapping.Data();
+    size_t size = this->mapping.Size();
+    if (size >= sizeof(LevelFileHeader) && std::memcmp(data, LEVEL_FILE_MAGIC, sizeof(LEVEL_FILE_MAGIC)) == 0)
+    {
+        // binary level: the tiles are used straight from the mapping
+        LevelFileHeader header;
+        std::memcpy(&header, data, sizeof(header));
+        uint64_t count = static_cast<uint64_t>(header.Columns) * header.Rows;
+        if (header.Version != LEVEL_FILE_VERSION || count > size - sizeof(header))
+        {
+            this->mapping.Close();
+            return false;
+        }
+        this->Columns = header.Columns;
+        this->Rows = header.Rows;
+        this->tiles = data + sizeof(header);
+    }
+    else
+    {
+        // text level: parsed into our own storage, so the mapping isn't needed afterwards
+        this->parseText(reinterpret_cast<const char*>(data), size);
+        this->mapping.Close();
+        this->tiles = this->parsed.data();
+    }
+    return this->Columns > 0 && this->Rows > 0;
+}
+
+bool LevelFile::parseText(const char *text, size_t size)
+{
+    // every line holding tile codes is a row; the first row sets the width of the level,
+    // shorter rows are padded with empty tiles and longer ones cut off
+    std::vector<unsigned char> row;
+    const char *end = text + size;
+    while (text < end)
+    {
+        const char *lineEnd = static_cast<const char*>(std::memchr(text, '\n', end - text));
+        if (!lineEnd)
+            lineEnd = end;
+        row.clear();
+        while (text < lineEnd)
+        {
+            if (*text < '0' || *text > '9')
+            {
+                ++text;
+                continue;
+            }
+            unsigned int code = 0;
+            while (text < lineEnd && *text >= '0' && *text <= '9')
+                code = std::min(code * 10 + (*text++ - '0'), 255u);
+            row.push_back(static_cast<unsigned char>(code));
+        }
+        if (!row.empty())
+        {
+            if (this->Rows == 0)
+                this->Columns = row.size();
+            row.resize(this->Columns, 0);
+            this->parsed.insert(this->parsed.end(), row.begin(), row.end());
+            this->Rows++;
+        }
+        text = lineEnd < end ? lineEnd + 1 : end;
+    }
+    return this->Rows > 0;
+}
+
+bool WriteLevelFile(const char *file, const unsigned char *tiles, unsigned int columns, unsigned int rows)
+{
+    LevelFileHeader header;
+    std::memcpy(header.Magic, LEVEL_FILE_MAGIC, sizeof(header.Magic));
+    header.Version = LEVEL_FILE_VERSION;
+    header.Columns = columns;
+    header.Rows = rows;
+    std::ofstream stream(file, std::ios::binary | std::ios::trunc);
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(tiles), static_cast<std::streamsize>(columns) * rows);
+    return static_cast<bool>(stream);
+}
+
+bool WriteTextLevelFile(const char *file, const unsigned char *tiles, unsigned int columns, unsigned int rows)
+{
+    std::ofstream stream(file, std::ios::trunc);
+    std::string line;
+    for (unsigned int y = 0; y < rows; ++y)
+    {
+        line.clear();
+        for (unsigned int x = 0; x < columns; ++x)
+        {
+            line += std::to_string(tiles[y * columns + x]);
+            line += x + 1 < columns ? ' ' : '\n';
+        }
+        stream << line;
+    }
+    return static_cast<bool>(stream);
+}
+
+bool ConvertLevelFile(const char *source, const char *destination)
+{
+    LevelFile level;
+    if (!level.Open(source))
+        return false;
+    return WriteLevelFile(destination, level.Tiles(), level.Columns, level.Rows);
+}
@@ -0,0 +1,56 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef LEVEL_FILE_H
+#define LEVEL_FILE_H
+#include <cstdint>
+#include <vector>
+
+#include <learnopengl/mapped_file.h>
+
+
+// On-disk layout of a binary level (.blvl):
+//   LevelFileHeader
+//   one byte tile code per tile, Rows rows of Columns tiles
+struct LevelFileHeader
+{
+    char     Magic[4]; // "BLVL"
+    uint32_t Version;
+    uint32_t Columns;
+    uint32_t Rows;
+};
+
+// LevelFile reads the tile grid of a level. The file is memory mapped:
+// a binary level is used in place, a text level (rows of space
+// separated tile codes) is parsed straight from the mapping into one
+// byte per tile.
+class LevelFile
+{
+public:
+    unsigned int Columns, Rows;
+    // constructor
+    LevelFile() : Columns(0), Rows(0), tiles(nullptr) { }
+    // opens either format; false if the file can't be read or holds no tiles
+    bool Open(const char *file);
+    // tile codes, Rows rows of Columns tiles; valid while the LevelFile lives
+    const unsigned char *Tiles() const { return this->tiles; }
+private:
+    MappedFile                 mapping;
+    std::vector<unsigned char> parsed; // tiles of a text level
+    const unsigned char       *tiles;
+    bool parseText(const char *text, size_t size);
+};
+
+// writes a tile grid as a binary level
+bool WriteLevelFile(const char *file, const unsigned char *tiles, unsigned int columns, unsigned int rows);
+// writes a tile grid as a text level
+bool WriteTextLevelFile(const char *file, const unsigned char *tiles, unsigned int columns, unsigned int rows);
+// converts a level file (text or binary) to a binary level
+bool ConvertLevelFile(const char *source, const char *destination);
+
+#endif
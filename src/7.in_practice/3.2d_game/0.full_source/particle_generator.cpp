@@ -8,8 +8,19 @@
 ******************************************************************/
 #include "particle_generator.h"
 
-ParticleGenerator::ParticleGenerator(Shader shader, Texture2D texture, unsigned int amount)
-    : shader(shader), texture(texture), amount(amount)
+#include <cstring>
+
+// define PARTICLE_GENERATOR_NO_SIMD to force the scalar update
+#if !defined(PARTICLE_GENERATOR_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define PARTICLE_GENERATOR_SSE
+#include <emmintrin.h>
+#endif
+
+// number of per-particle floats uploaded for drawing: position x/y and color r/g/b/a
+const unsigned int INSTANCE_COMPONENTS = 6;
+
+ParticleGenerator::ParticleGenerator(Shader shader, Texture2D texture, unsigned int amount, unsigned int seed)
+    : amount(amount), nextOverwrite(0), rng(seed), shader(shader), texture(texture)
 {
     this->init();
 }
@@ -18,45 +29,51 @@ void ParticleGenerator::Update(float dt, GameObject &object, unsigned int newPar
 {
     // add new particles 
     for (unsigned int i = 0; i < newParticles; ++i)
-    {
-        int unusedParticle = this->firstUnusedParticle();
-        this->respawnParticle(this->particles[unusedParticle], object, offset);
-    }
+        this->respawnParticle(this->spawnIndex(), object, offset);
     // update all particles
-    for (unsigned int i = 0; i < this->amount; ++i)
-    {
-        Particle &p = this->particles[i];
-        p.Life -= dt; // reduce life
-        if (p.Life > 0.0f)
-        {	// particle is alive, thus update
-            p.Position -= p.Velocity * dt; 
-            p.Color.a -= dt * 2.5f;
-        }
-    }
+    this->updateParticles(dt);
+    this->removeDead();
 }
 
 // render all particles
 void ParticleGenerator::Draw()
 {
+    unsigned int alive = this->particles.Alive;
+    if (alive == 0)
+        return;
+    // upload the live part of each array into its section of the instance buffer
+    glBindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
+    float *sections = static_cast<float*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, INSTANCE_COMPONENTS * this->amount * sizeof(float), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    if (!sections)
+        return;
+    const std::vector<float> *components[INSTANCE_COMPONENTS] = {
+        &this->particles.PositionX, &this->particles.PositionY,
+        &this->particles.ColorR, &this->particles.ColorG, &this->particles.ColorB, &this->particles.ColorA
+    };
+    for (unsigned int i = 0; i < INSTANCE_COMPONENTS; ++i)
+        std::memcpy(sections + i * this->amount, components[i]->data(), alive * sizeof(float));
+    bool written = glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE;
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    if (!written)
+        return;
+
     // use additive blending to give it a 'glow' effect
     glBlendFunc(GL_SRC_ALPHA, GL_ONE);
     this->shader.Use();
-    for (Particle particle : this->particles)
-    {
-        if (particle.Life > 0.0f)
-        {
-            this->shader.SetVector2f("offset", particle.Position);
-            this->shader.SetVector4f("color", particle.Color);
-            this->texture.Bind();
-            glBindVertexArray(this->VAO);
-            glDrawArrays(GL_TRIANGLES, 0, 6);
-            glBindVertexArray(0);
-        }
-    }
+    glActiveTexture(GL_TEXTURE0);
+    this->texture.Bind();
+    glBindVertexArray(this->VAO);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, alive);
+    glBindVertexArray(0);
     // don't forget to reset to default blending mode
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
 
+void ParticleGenerator::Seed(unsigned int seed)
+{
+    this->rng.seed(seed);
+}
+
 void ParticleGenerator::init()
 {
     // set up mesh and attribute properties
@@ -79,42 +96,99 @@ void ParticleGenerator::init()
     // set mesh attributes
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+    // per-particle attributes: one tightly packed section of this->amount floats per component
+    glGenBuffers(1, &this->instanceVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, INSTANCE_COMPONENTS * this->amount * sizeof(float), nullptr, GL_STREAM_DRAW);
+    for (unsigned int i = 0; i < INSTANCE_COMPONENTS; ++i)
+    {
+        glEnableVertexAttribArray(1 + i);
+        glVertexAttribPointer(1 + i, 1, GL_FLOAT, GL_FALSE, sizeof(float), (void*)(i * this->amount * sizeof(float)));
+        glVertexAttribDivisor(1 + i, 1);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 
-    // create this->amount default particle instances
-    for (unsigned int i = 0; i < this->amount; ++i)
-        this->particles.push_back(Particle());
+    // reserve this->amount particles, none of them alive
+    std::vector<float> *components[] = {
+        &this->particles.PositionX, &this->particles.PositionY, &this->particles.VelocityX, &this->particles.VelocityY,
+        &this->particles.ColorR, &this->particles.ColorG, &this->particles.ColorB, &this->particles.ColorA, &this->particles.Life
+    };
+    for (std::vector<float> *component : components)
+        component->assign(this->amount, 0.0f);
+    this->particles.Alive = 0;
 }
 
-// stores the index of the last particle used (for quick access to next dead particle)
-unsigned int lastUsedParticle = 0;
-unsigned int ParticleGenerator::firstUnusedParticle()
+unsigned int ParticleGenerator::spawnIndex()
 {
-    // first search from last used particle, this will usually return almost instantly
-    for (unsigned int i = lastUsedParticle; i < this->amount; ++i){
-        if (this->particles[i].Life <= 0.0f){
-            lastUsedParticle = i;
-            return i;
-        }
+    if (this->particles.Alive < this->amount)
+        return this->particles.Alive++;
+    // all particles are taken, override the live ones in turn (note that if it repeatedly hits this case, more particles should be reserved)
+    unsigned int index = this->nextOverwrite;
+    this->nextOverwrite = (this->nextOverwrite + 1) % this->amount;
+    return index;
+}
+
+void ParticleGenerator::respawnParticle(unsigned int index, GameObject &object, glm::vec2 offset)
+{
+    // same distributions as the original rand() based spawn, but from this generator's own sequence
+    float random = ((this->rng() % 100) - 50.0f) / 10.0f;
+    float rColor = 0.5f + ((this->rng() % 100) / 100.0f);
+    ParticleArrays &p = this->particles;
+    p.PositionX[index] = object.Position.x + random + offset.x;
+    p.PositionY[index] = object.Position.y + random + offset.y;
+    p.ColorR[index] = p.ColorG[index] = p.ColorB[index] = rColor;
+    p.ColorA[index] = 1.0f;
+    p.Life[index] = 1.0f;
+    p.VelocityX[index] = object.Velocity.x * 0.1f;
+    p.VelocityY[index] = object.Velocity.y * 0.1f;
+}
+
+void ParticleGenerator::updateParticles(float dt)
+{
+    ParticleArrays &p = this->particles;
+    unsigned int i = 0;
+    // particles that die this step are updated as well; they are removed right after
+#if defined(PARTICLE_GENERATOR_SSE)
+    const __m128 step = _mm_set1_ps(dt);
+    const __m128 fade = _mm_set1_ps(dt * 2.5f);
+    for (; i + 4 <= p.Alive; i += 4)
+    {
+        _mm_storeu_ps(&p.Life[i], _mm_sub_ps(_mm_loadu_ps(&p.Life[i]), step));
+        _mm_storeu_ps(&p.PositionX[i], _mm_sub_ps(_mm_loadu_ps(&p.PositionX[i]), _mm_mul_ps(_mm_loadu_ps(&p.VelocityX[i]), step)));
+        _mm_storeu_ps(&p.PositionY[i], _mm_sub_ps(_mm_loadu_ps(&p.PositionY[i]), _mm_mul_ps(_mm_loadu_ps(&p.VelocityY[i]), step)));
+        _mm_storeu_ps(&p.ColorA[i], _mm_sub_ps(_mm_loadu_ps(&p.ColorA[i]), fade));
     }
-    // otherwise, do a linear search
-    for (unsigned int i = 0; i < lastUsedParticle; ++i){
-        if (this->particles[i].Life <= 0.0f){
-            lastUsedParticle = i;
-            return i;
-        }
+#endif
+    for (; i < p.Alive; ++i)
+    {
+        p.Life[i] -= dt; // reduce life
+        p.PositionX[i] -= p.VelocityX[i] * dt;
+        p.PositionY[i] -= p.VelocityY[i] * dt;
+        p.ColorA[i] -= dt * 2.5f;
     }
-    // all particles are taken, override the first one (note that if it repeatedly hits this case, more particles should be reserved)
-    lastUsedParticle = 0;
-    return 0;
 }
 
-void ParticleGenerator::respawnParticle(Particle &particle, GameObject &object, glm::vec2 offset)
+void ParticleGenerator::removeDead()
 {
-    float random = ((rand() % 100) - 50) / 10.0f;
-    float rColor = 0.5f + ((rand() % 100) / 100.0f);
-    particle.Position = object.Position + random + offset;
-    particle.Color = glm::vec4(rColor, rColor, rColor, 1.0f);
-    particle.Life = 1.0f;
-    particle.Velocity = object.Velocity * 0.1f;
-}
\ No newline at end of file
+    // swap the last live particle into each dead slot; particles are blended
+    // additively, so the order they end up in doesn't show
+    ParticleArrays &p = this->particles;
+    std::vector<float> *components[] = {
+        &p.PositionX, &p.PositionY, &p.VelocityX, &p.VelocityY, &p.ColorR, &p.ColorG, &p.ColorB, &p.ColorA, &p.Life
+    };
+    unsigned int i = 0;
+    while (i < p.Alive)
+    {
+        if (p.Life[i] > 0.0f)
+        {
+            ++i;
+            continue;
+        }
+        --p.Alive;
+        for (std::vector<float> *component : components)
+            (*component)[i] = (*component)[p.Alive];
+    }
+    if (this->nextOverwrite >= p.Alive)
+        this->nextOverwrite = 0;
+}
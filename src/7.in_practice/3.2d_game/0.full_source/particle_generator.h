@@ -8,6 +8,7 @@
 ******************************************************************/
 #ifndef PARTICLE_GENERATOR_H
 #define PARTICLE_GENERATOR_H
+#include <random>
 #include <vector>
 
 #include <glad/glad.h>
@@ -18,42 +19,59 @@
 #include "game_object.h"
 
 
-// Represents a single particle and its state
-struct Particle {
-    glm::vec2 Position, Velocity;
-    glm::vec4 Color;
-    float     Life;
+// The state of all particles of a generator, stored as one array per
+// component (structure of arrays) so the update can run on several
+// particles at once. Only the first Alive entries are live particles;
+// dead ones are swapped out of that range as they die.
+struct ParticleArrays {
+    std::vector<float> PositionX, PositionY;
+    std::vector<float> VelocityX, VelocityY;
+    std::vector<float> ColorR, ColorG, ColorB, ColorA;
+    std::vector<float> Life;
+    unsigned int       Alive;
 
-    Particle() : Position(0.0f), Velocity(0.0f), Color(1.0f), Life(0.0f) { }
+    ParticleArrays() : Alive(0) { }
 };
 
 
-// ParticleGenerator acts as a container for rendering a large number of 
-// particles by repeatedly spawning and updating particles and killing 
-// them after a given amount of time.
+// ParticleGenerator acts as a container for rendering a large number of
+// particles by repeatedly spawning and updating particles and killing
+// them after a given amount of time. All live particles are drawn with
+// a single instanced draw call.
 class ParticleGenerator
 {
 public:
-    // constructor
-    ParticleGenerator(Shader shader, Texture2D texture, unsigned int amount);
+    // constructor; seed makes the spawned particles reproducible
+    ParticleGenerator(Shader shader, Texture2D texture, unsigned int amount, unsigned int seed = 5489u);
     // update all particles
     void Update(float dt, GameObject &object, unsigned int newParticles, glm::vec2 offset = glm::vec2(0.0f, 0.0f));
     // render all particles
     void Draw();
+    // restarts the random sequence used for spawning particles
+    void Seed(unsigned int seed);
+    // read-only access to the particle state
+    const ParticleArrays &Particles() const { return this->particles; }
 private:
     // state
-    std::vector<Particle> particles;
+    ParticleArrays particles;
     unsigned int amount;
+    unsigned int nextOverwrite; // particle to replace when all of them are alive
+    std::mt19937 rng;
     // render state
     Shader shader;
     Texture2D texture;
     unsigned int VAO;
+    unsigned int instanceVBO;
     // initializes buffer and vertex attributes
     void init();
-    // returns the first Particle index that's currently unused e.g. Life <= 0.0f or 0 if no particle is currently inactive
-    unsigned int firstUnusedParticle();
+    // returns the index a new particle goes to: past the live ones or, if all are alive, the next one to overwrite
+    unsigned int spawnIndex();
     // respawns particle
-    void respawnParticle(Particle &particle, GameObject &object, glm::vec2 offset = glm::vec2(0.0f, 0.0f));
+    void respawnParticle(unsigned int index, GameObject &object, glm::vec2 offset = glm::vec2(0.0f, 0.0f));
+    // moves and fades all live particles
+    void updateParticles(float dt);
+    // swaps dead particles out of the live range
+    void removeDead();
 };
 
 #endif
\ No newline at end of file
@@ -11,8 +11,14 @@
 
 #include "game.h"
 #include "resource_manager.h"
+#include "collision_benchmark.h"
+#include "level_benchmark.h"
+#include "level_file.h"
+#include "simulation_runner.h"
 
+#include <cstdlib>
 #include <iostream>
+#include <string>
 
 // GLFW function declarations
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
@@ -27,6 +33,78 @@ Game Breakout(SCREEN_WIDTH, SCREEN_HEIGHT);
 
 int main(int argc, char *argv[])
 {
+    // "--collision-benchmark [tiles]" compares the collision grid against testing every brick on a
+    // generated level of tiles x tiles bricks (1000 by default); it runs headless and exits
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--collision-benchmark")
+        {
+            unsigned int tiles = 1000;
+            if (i + 1 < argc && std::atoi(argv[i + 1]) > 0)
+                tiles = std::atoi(argv[i + 1]);
+            return RunCollisionBenchmark(tiles, 600) ? 0 : 1;
+        }
+        // "--level-benchmark [tiles]" times loading a generated level of tiles x tiles (2000 by default)
+        // from a text and from a binary level file; it runs headless and exits
+        if (std::string(argv[i]) == "--level-benchmark")
+        {
+            unsigned int tiles = 2000;
+            if (i + 1 < argc && std::atoi(argv[i + 1]) > 0)
+                tiles = std::atoi(argv[i + 1]);
+            return RunLevelLoadBenchmark(tiles) ? 0 : 1;
+        }
+        // "--convert-level source destination" converts a text level to a binary one
+        if (std::string(argv[i]) == "--convert-level" && i + 2 < argc)
+        {
+            if (ConvertLevelFile(argv[i + 1], argv[i + 2]))
+                return 0;
+            std::cout << "Failed to convert " << argv[i + 1] << std::endl;
+            return 1;
+        }
+        // "--soak [sessions] [ticks]" plays that many bot-driven sessions (1000 of 7200 ticks, a minute
+        // of play each, by default) in parallel without a window and prints ticks/s and the state hash
+        if (std::string(argv[i]) == "--soak")
+        {
+            unsigned int sessions = 1000, ticks = 7200;
+            if (i + 1 < argc && std::atoi(argv[i + 1]) > 0)
+                sessions = std::atoi(argv[++i]);
+            if (i + 1 < argc && std::atoi(argv[i + 1]) > 0)
+                ticks = std::atoi(argv[++i]);
+            return RunSimulationSoak(sessions, ticks) ? 0 : 1;
+        }
+        // "--replay-headless file" plays a recording back without a window and prints the final state hash
+        if (std::string(argv[i]) == "--replay-headless" && i + 1 < argc)
+        {
+            InputRecording recording;
+            if (!recording.Load(argv[i + 1]))
+            {
+                std::cout << "Failed to load recording " << argv[i + 1] << std::endl;
+                return 1;
+            }
+            uint64_t hash = ReplayRecording(recording, SCREEN_WIDTH, SCREEN_HEIGHT);
+            std::cout << "REPLAY: " << recording.Input.size() << " ticks, state hash " << std::hex << hash << std::dec << std::endl;
+            return 0;
+        }
+    }
+
+    // "--record file" saves the input of the session to file on exit, "--replay file" plays such a
+    // recording back instead of reading the keyboard
+    const char *recordFile = nullptr;
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--record")
+            recordFile = argv[i + 1];
+        if (std::string(argv[i]) == "--replay")
+        {
+            if (!Breakout.Recording.Load(argv[i + 1]))
+            {
+                std::cout << "Failed to load recording " << argv[i + 1] << std::endl;
+                return 1;
+            }
+            Breakout.Replay = true;
+        }
+    }
+
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
@@ -60,6 +138,19 @@ int main(int argc, char *argv[])
     // ---------------
     Breakout.Init();
 
+    // stress mode: "--stress [sprites]" draws that many extra sprites (100000 by default) with
+    // vsync off and prints the frame time once a second
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::string(argv[i]) == "--stress")
+        {
+            Breakout.StressSprites = 100000;
+            if (i + 1 < argc && std::atoi(argv[i + 1]) > 0)
+                Breakout.StressSprites = std::atoi(argv[++i]);
+            glfwSwapInterval(0);
+        }
+    }
+
     // deltaTime variables
     // -------------------
     float deltaTime = 0.0f;
@@ -76,7 +167,7 @@ int main(int argc, char *argv[])
 
         // manage user input
         // -----------------
-        Breakout.ProcessInput(deltaTime);
+        Breakout.ProcessInput();
 
         // update game state
         // -----------------
@@ -91,6 +182,14 @@ int main(int argc, char *argv[])
         glfwSwapBuffers(window);
     }
 
+    if (recordFile)
+    {
+        if (Breakout.Recording.Save(recordFile))
+            std::cout << "RECORD: " << Breakout.Recording.Input.size() << " ticks, state hash " << std::hex << Breakout.World->Hash() << std::dec << std::endl;
+        else
+            std::cout << "Failed to save recording " << recordFile << std::endl;
+    }
+
     // delete all resources as loaded using the resource manager
     // ---------------------------------------------------------
     ResourceManager::Clear();
@@ -109,10 +208,7 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
         if (action == GLFW_PRESS)
             Breakout.Keys[key] = true;
         else if (action == GLFW_RELEASE)
-        {
             Breakout.Keys[key] = false;
-            Breakout.KeysProcessed[key] = false;
-        }
     }
 }
 
@@ -14,6 +14,8 @@
 
 #include "stb_image.h"
 
+#include <learnopengl/texture_registry.h>
+
 // Instantiate static variables
 std::map<std::string, Texture2D>    ResourceManager::Textures;
 std::map<std::string, Shader>       ResourceManager::Shaders;
@@ -32,7 +34,12 @@ Shader ResourceManager::GetShader(std::string name)
 
 Texture2D ResourceManager::LoadTexture(const char *file, bool alpha, std::string name)
 {
-    Textures[name] = loadTextureFromFile(file, alpha);
+    Texture2D texture = loadTextureFromFile(file, alpha);
+    // give back the reference held by the texture previously stored under this name
+    auto previous = Textures.find(name);
+    if (previous != Textures.end())
+        TextureRegistry::Get().Release(previous->second.ID);
+    Textures[name] = texture;
     return Textures[name];
 }
 
@@ -46,9 +53,9 @@ void ResourceManager::Clear()
     // (properly) delete all shaders	
     for (auto iter : Shaders)
         glDeleteProgram(iter.second.ID);
-    // (properly) delete all textures
+    // (properly) release all textures, the registry deletes them once they're no longer used
     for (auto iter : Textures)
-        glDeleteTextures(1, &iter.second.ID);
+        TextureRegistry::Get().Release(iter.second.ID);
 }
 
 Shader ResourceManager::loadShaderFromFile(const char *vShaderFile, const char *fShaderFile, const char *gShaderFile)
@@ -104,11 +111,31 @@ Texture2D ResourceManager::loadTextureFromFile(const char *file, bool alpha)
         texture.Internal_Format = GL_RGBA;
         texture.Image_Format = GL_RGBA;
     }
+    // textures are shared process-wide, a file that is already loaded is reused instead of decoded again
+    TextureRegistry &registry = TextureRegistry::Get();
+    const std::string path = TextureRegistry::Canonicalize(file);
+    RegisteredTexture registered = registry.Acquire(path, texture.Internal_Format, false);
+    if (registered.id != 0)
+    {
+        texture.ID = registered.id;
+        texture.Width = registered.width;
+        texture.Height = registered.height;
+        return texture;
+    }
     // load image
-    int width, height, nrChannels;
+    int width = 0, height = 0, nrChannels = 0;
     unsigned char* data = stbi_load(file, &width, &height, &nrChannels, 0);
     // now generate texture
     texture.Generate(width, height, data);
+    registry.Insert(path, texture.Internal_Format, false, texture.ID);
+    if (data)
+        registry.SetImageInfo(texture.ID, width, height, nrChannels);
+    else
+    {
+        // keep the (empty) texture for this caller, but don't hand it out to the next one
+        std::cout << "ERROR::TEXTURE: Failed to load texture file " << file << std::endl;
+        registry.Forget(texture.ID);
+    }
     // and finally free image data
     stbi_image_free(data);
     return texture;
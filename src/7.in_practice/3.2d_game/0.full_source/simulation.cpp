@@ -0,0 +1,418 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "simulation.h"
+#include "collision.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#include <learnopengl/filesystem.h>
+
+
+Simulation::Simulation(unsigned int width, unsigned int height, const std::vector<GameLevel> &levels, const std::map<std::string, Texture2D> &textures, unsigned int seed)
+    : State(GAME_MENU), Width(width), Height(height), Levels(levels), Level(0), Lives(3), Confuse(false), Chaos(false), Shake(false),
+      ParticleSpawns(0), Ticks(0), initialLevels(levels), textures(textures), random(seed), previousInput(0), shakeTime(0.0f)
+{
+    // configure game objects
+    glm::vec2 playerPos = glm::vec2(this->Width / 2.0f - PLAYER_SIZE.x / 2.0f, this->Height - PLAYER_SIZE.y);
+    this->Player = GameObject(playerPos, PLAYER_SIZE, this->getTexture("paddle"));
+    glm::vec2 ballPos = playerPos + glm::vec2(PLAYER_SIZE.x / 2.0f - BALL_RADIUS, -BALL_RADIUS * 2.0f);
+    this->Ball = BallObject(ballPos, BALL_RADIUS, INITIAL_BALL_VELOCITY, this->getTexture("face"));
+}
+
+void Simulation::Step(unsigned char input)
+{
+    float dt = SIMULATION_TICK;
+    this->Events.clear();
+    this->processInput(input);
+    this->previousInput = input;
+    // update objects
+    this->Ball.Move(dt, this->Width);
+    // check for collisions
+    this->doCollisions();
+    // the ball leaves a trail of particles (one per tick, 120 a second)
+    this->ParticleSpawns = 1;
+    // update PowerUps
+    this->updatePowerUps(dt);
+    // reduce shake time
+    if (this->shakeTime > 0.0f)
+    {
+        this->shakeTime -= dt;
+        if (this->shakeTime <= 0.0f)
+            this->Shake = false;
+    }
+    // check loss condition
+    if (this->Ball.Position.y >= this->Height) // did ball reach bottom edge?
+    {
+        --this->Lives;
+        // did the player lose all his lives? : game over
+        if (this->Lives == 0)
+        {
+            this->ResetLevel();
+            this->State = GAME_MENU;
+        }
+        this->ResetPlayer();
+    }
+    // check win condition
+    if (this->State == GAME_ACTIVE && this->Levels[this->Level].IsCompleted())
+    {
+        this->ResetLevel();
+        this->ResetPlayer();
+        this->Chaos = true;
+        this->State = GAME_WIN;
+    }
+    this->Ticks++;
+}
+
+uint64_t Simulation::Hash() const
+{
+    // 64 bit FNV-1a over every field that makes up the game-logic state
+    uint64_t hash = 0xcbf29ce484222325ull;
+    auto add = [&hash](const void *data, size_t size) {
+        const unsigned char *bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ull;
+        }
+    };
+    unsigned char flags[] = {
+        static_cast<unsigned char>(this->State), this->Ball.Stuck, this->Ball.Sticky, this->Ball.PassThrough,
+        this->Confuse, this->Chaos, this->Shake
+    };
+    add(flags, sizeof(flags));
+    add(&this->Level, sizeof(this->Level));
+    add(&this->Lives, sizeof(this->Lives));
+    add(&this->Ticks, sizeof(this->Ticks));
+    add(&this->shakeTime, sizeof(this->shakeTime));
+    add(&this->Player.Position, sizeof(this->Player.Position));
+    add(&this->Player.Size, sizeof(this->Player.Size));
+    add(&this->Ball.Position, sizeof(this->Ball.Position));
+    add(&this->Ball.Velocity, sizeof(this->Ball.Velocity));
+    for (const GameLevel &level : this->Levels)
+        add(level.Bricks.Destroyed.data(), level.Bricks.Destroyed.size());
+    for (const PowerUp &powerUp : this->PowerUps)
+    {
+        unsigned char state[] = { powerUp.Activated, powerUp.Destroyed };
+        add(powerUp.Type.data(), powerUp.Type.size());
+        add(state, sizeof(state));
+        add(&powerUp.Position, sizeof(powerUp.Position));
+        add(&powerUp.Duration, sizeof(powerUp.Duration));
+    }
+    return hash;
+}
+
+void Simulation::ResetLevel()
+{
+    this->Levels[this->Level] = this->initialLevels[this->Level];
+    this->Lives = 3;
+}
+
+void Simulation::ResetPlayer()
+{
+    // reset player/ball stats
+    this->Player.Size = PLAYER_SIZE;
+    this->Player.Position = glm::vec2(this->Width / 2.0f - PLAYER_SIZE.x / 2.0f, this->Height - PLAYER_SIZE.y);
+    this->Ball.Reset(this->Player.Position + glm::vec2(PLAYER_SIZE.x / 2.0f - BALL_RADIUS, -(BALL_RADIUS * 2.0f)), INITIAL_BALL_VELOCITY);
+    // also disable all active powerups
+    this->Chaos = this->Confuse = false;
+    this->Ball.PassThrough = this->Ball.Sticky = false;
+    this->Player.Color = glm::vec3(1.0f);
+    this->Ball.Color = glm::vec3(1.0f);
+}
+
+void Simulation::processInput(unsigned char input)
+{
+    // menu keys act once per press, not for as long as they are held
+    unsigned char pressed = input & ~this->previousInput;
+    if (this->State == GAME_MENU)
+    {
+        if (pressed & INPUT_CONFIRM)
+            this->State = GAME_ACTIVE;
+        if (pressed & INPUT_NEXT_LEVEL)
+            this->Level = (this->Level + 1) % this->Levels.size();
+        if (pressed & INPUT_PREVIOUS_LEVEL)
+        {
+            if (this->Level > 0)
+                --this->Level;
+            else
+                this->Level = this->Levels.size() - 1;
+        }
+    }
+    if (this->State == GAME_WIN)
+    {
+        if (input & INPUT_CONFIRM)
+        {
+            this->Chaos = false;
+            this->State = GAME_MENU;
+        }
+    }
+    if (this->State == GAME_ACTIVE)
+    {
+        float velocity = PLAYER_VELOCITY * SIMULATION_TICK;
+        // move playerboard
+        if (input & INPUT_LEFT)
+        {
+            if (this->Player.Position.x >= 0.0f)
+            {
+                this->Player.Position.x -= velocity;
+                if (this->Ball.Stuck)
+                    this->Ball.Position.x -= velocity;
+            }
+        }
+        if (input & INPUT_RIGHT)
+        {
+            if (this->Player.Position.x <= this->Width - this->Player.Size.x)
+            {
+                this->Player.Position.x += velocity;
+                if (this->Ball.Stuck)
+                    this->Ball.Position.x += velocity;
+            }
+        }
+        if (input & INPUT_LAUNCH)
+            this->Ball.Stuck = false;
+    }
+}
+
+void Simulation::doCollisions()
+{
+    // the level resolves the ball against its bricks; what's left here are the effects of each hit
+    GameLevel &level = this->Levels[this->Level];
+    level.CollideBall(this->Ball, this->hits);
+    for (unsigned int index : this->hits)
+    {
+        if (!level.Bricks.IsSolid(index))
+        {   // the block got destroyed
+            this->spawnPowerUps(level.Bricks.Position(index));
+            this->Events.push_back(EVENT_BRICK_DESTROYED);
+        }
+        else
+        {   // if block is solid, enable shake effect
+            this->shakeTime = 0.05f;
+            this->Shake = true;
+            this->Events.push_back(EVENT_SOLID_HIT);
+        }
+    }
+
+    // also check collisions on PowerUps and if so, activate them
+    for (PowerUp &powerUp : this->PowerUps)
+    {
+        if (!powerUp.Destroyed)
+        {
+            // first check if powerup passed bottom edge, if so: keep as inactive and destroy
+            if (powerUp.Position.y >= this->Height)
+                powerUp.Destroyed = true;
+
+            if (CheckCollision(this->Player, powerUp))
+            {	// collided with player, now activate powerup
+                this->activatePowerUp(powerUp);
+                powerUp.Destroyed = true;
+                powerUp.Activated = true;
+                this->Events.push_back(EVENT_POWERUP);
+            }
+        }
+    }
+
+    // and finally check collisions for player pad (unless stuck)
+    Collision result = CheckCollision(this->Ball, this->Player);
+    if (!this->Ball.Stuck && result.Hit)
+    {
+        // check where it hit the board, and change velocity based on where it hit the board
+        float centerBoard = this->Player.Position.x + this->Player.Size.x / 2.0f;
+        float distance = (this->Ball.Position.x + this->Ball.Radius) - centerBoard;
+        float percentage = distance / (this->Player.Size.x / 2.0f);
+        // then move accordingly
+        float strength = 2.0f;
+        glm::vec2 oldVelocity = this->Ball.Velocity;
+        this->Ball.Velocity.x = INITIAL_BALL_VELOCITY.x * percentage * strength; 
+        this->Ball.Velocity = glm::normalize(this->Ball.Velocity) * glm::length(oldVelocity); // keep speed consistent over both axes (multiply by length of old velocity, so total strength is not changed)
+        // fix sticky paddle
+        this->Ball.Velocity.y = -1.0f * std::abs(this->Ball.Velocity.y);
+
+        // if Sticky powerup is activated, also stick ball to paddle once new velocity vectors were calculated
+        this->Ball.Stuck = this->Ball.Sticky;
+
+        this->Events.push_back(EVENT_PADDLE_HIT);
+    }
+}
+
+void Simulation::spawnPowerUps(glm::vec2 position)
+{
+    if (this->shouldSpawn(75)) // 1 in 75 chance
+        this->PowerUps.push_back(PowerUp("speed", glm::vec3(0.5f, 0.5f, 1.0f), 0.0f, position, this->getTexture("powerup_speed")));
+    if (this->shouldSpawn(75))
+        this->PowerUps.push_back(PowerUp("sticky", glm::vec3(1.0f, 0.5f, 1.0f), 20.0f, position, this->getTexture("powerup_sticky")));
+    if (this->shouldSpawn(75))
+        this->PowerUps.push_back(PowerUp("pass-through", glm::vec3(0.5f, 1.0f, 0.5f), 10.0f, position, this->getTexture("powerup_passthrough")));
+    if (this->shouldSpawn(75))
+        this->PowerUps.push_back(PowerUp("pad-size-increase", glm::vec3(1.0f, 0.6f, 0.4), 0.0f, position, this->getTexture("powerup_increase")));
+    if (this->shouldSpawn(15)) // Negative powerups should spawn more often
+        this->PowerUps.push_back(PowerUp("confuse", glm::vec3(1.0f, 0.3f, 0.3f), 15.0f, position, this->getTexture("powerup_confuse")));
+    if (this->shouldSpawn(15))
+        this->PowerUps.push_back(PowerUp("chaos", glm::vec3(0.9f, 0.25f, 0.25f), 15.0f, position, this->getTexture("powerup_chaos")));
+}
+
+void Simulation::updatePowerUps(float dt)
+{
+    for (PowerUp &powerUp : this->PowerUps)
+    {
+        powerUp.Position += powerUp.Velocity * dt;
+        if (powerUp.Activated)
+        {
+            powerUp.Duration -= dt;
+
+            if (powerUp.Duration <= 0.0f)
+            {
+                // remove powerup from list (will later be removed)
+                powerUp.Activated = false;
+                // deactivate effects
+                if (powerUp.Type == "sticky")
+                {
+                    if (!this->isOtherPowerUpActive("sticky"))
+                    {	// only reset if no other PowerUp of type sticky is active
+                        this->Ball.Sticky = false;
+                        this->Player.Color = glm::vec3(1.0f);
+                    }
+                }
+                else if (powerUp.Type == "pass-through")
+                {
+                    if (!this->isOtherPowerUpActive("pass-through"))
+                    {	// only reset if no other PowerUp of type pass-through is active
+                        this->Ball.PassThrough = false;
+                        this->Ball.Color = glm::vec3(1.0f);
+                    }
+                }
+                else if (powerUp.Type == "confuse")
+                {
+                    if (!this->isOtherPowerUpActive("confuse"))
+                    {	// only reset if no other PowerUp of type confuse is active
+                        this->Confuse = false;
+                    }
+                }
+                else if (powerUp.Type == "chaos")
+                {
+                    if (!this->isOtherPowerUpActive("chaos"))
+                    {	// only reset if no other PowerUp of type chaos is active
+                        this->Chaos = false;
+                    }
+                }
+            }
+        }
+    }
+    // Remove all PowerUps from vector that are destroyed AND !activated (thus either off the map or finished)
+    // Note we use a lambda expression to remove each PowerUp which is destroyed and not activated
+    this->PowerUps.erase(std::remove_if(this->PowerUps.begin(), this->PowerUps.end(),
+        [](const PowerUp &powerUp) { return powerUp.Destroyed && !powerUp.Activated; }
+    ), this->PowerUps.end());
+}
+
+void Simulation::activatePowerUp(PowerUp &powerUp)
+{
+    if (powerUp.Type == "speed")
+    {
+        this->Ball.Velocity *= 1.2;
+    }
+    else if (powerUp.Type == "sticky")
+    {
+        this->Ball.Sticky = true;
+        this->Player.Color = glm::vec3(1.0f, 0.5f, 1.0f);
+    }
+    else if (powerUp.Type == "pass-through")
+    {
+        this->Ball.PassThrough = true;
+        this->Ball.Color = glm::vec3(1.0f, 0.5f, 0.5f);
+    }
+    else if (powerUp.Type == "pad-size-increase")
+    {
+        this->Player.Size.x += 50;
+    }
+    else if (powerUp.Type == "confuse")
+    {
+        if (!this->Chaos)
+            this->Confuse = true; // only activate if chaos wasn't already active
+    }
+    else if (powerUp.Type == "chaos")
+    {
+        if (!this->Confuse)
+            this->Chaos = true;
+    }
+}
+
+bool Simulation::isOtherPowerUpActive(const std::string &type) const
+{
+    // Check if another PowerUp of the same type is still active
+    // in which case we don't disable its effect (yet)
+    for (const PowerUp &powerUp : this->PowerUps)
+    {
+        if (powerUp.Activated)
+            if (powerUp.Type == type)
+                return true;
+    }
+    return false;
+}
+
+bool Simulation::shouldSpawn(unsigned int chance)
+{
+    // the simulation's own generator instead of rand(), so sessions replay exactly
+    return this->random() % chance == 0;
+}
+
+Texture2D Simulation::getTexture(const std::string &name) const
+{
+    std::map<std::string, Texture2D>::const_iterator it = this->textures.find(name);
+    return it != this->textures.end() ? it->second : Texture2D();
+}
+
+
+std::vector<GameLevel> LoadGameLevels(unsigned int width, unsigned int height)
+{
+    const char *files[] = { "one", "two", "three", "four" };
+    std::vector<GameLevel> levels(4);
+    for (unsigned int i = 0; i < levels.size(); ++i)
+        levels[i].Load(FileSystem::getPath(std::string("resources/levels/") + files[i] + ".blvl").c_str(), width, height / 2);
+    return levels;
+}
+
+
+// input recordings
+// ----------------
+const char RECORDING_MAGIC[4] = { 'B', 'K', 'I', 'N' };
+const uint32_t RECORDING_VERSION = 1;
+
+bool InputRecording::Save(const char *file) const
+{
+    std::ofstream stream(file, std::ios::binary | std::ios::trunc);
+    uint32_t header[] = { RECORDING_VERSION, this->Seed, static_cast<uint32_t>(this->Input.size()) };
+    stream.write(RECORDING_MAGIC, sizeof(RECORDING_MAGIC));
+    stream.write(reinterpret_cast<const char*>(header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(this->Input.data()), this->Input.size());
+    return static_cast<bool>(stream);
+}
+
+bool InputRecording::Load(const char *file)
+{
+    std::ifstream stream(file, std::ios::binary);
+    char magic[4];
+    uint32_t header[3];
+    if (!stream.read(magic, sizeof(magic)) || std::memcmp(magic, RECORDING_MAGIC, sizeof(magic)) != 0 ||
+        !stream.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != RECORDING_VERSION)
+        return false;
+    // the count comes from the file, so don't trust it with more memory than the file has bytes
+    std::streamoff start = stream.tellg();
+    if (!stream.seekg(0, std::ios::end))
+        return false;
+    std::streamoff remaining = stream.tellg() - start;
+    if (remaining < 0 || static_cast<uint64_t>(remaining) < header[2] || !stream.seekg(start))
+        return false;
+    this->Seed = header[1];
+    this->Input.resize(header[2]);
+    return static_cast<bool>(stream.read(reinterpret_cast<char*>(this->Input.data()), this->Input.size()));
+}
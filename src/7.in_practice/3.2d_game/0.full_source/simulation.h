@@ -0,0 +1,131 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef SIMULATION_H
+#define SIMULATION_H
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "game_level.h"
+#include "game_object.h"
+#include "ball_object.h"
+#include "power_up.h"
+#include "texture.h"
+
+// Represents the current state of the game
+enum GameState {
+    GAME_ACTIVE,
+    GAME_MENU,
+    GAME_WIN
+};
+
+// Buttons held during one tick of input, combined into one byte per tick
+enum InputButton {
+    INPUT_LEFT           = 1 << 0,
+    INPUT_RIGHT          = 1 << 1,
+    INPUT_LAUNCH         = 1 << 2,
+    INPUT_CONFIRM        = 1 << 3,
+    INPUT_NEXT_LEVEL     = 1 << 4,
+    INPUT_PREVIOUS_LEVEL = 1 << 5
+};
+
+// Things that happened during a tick which the presentation (sound) reacts to
+enum SimulationEvent {
+    EVENT_BRICK_DESTROYED,
+    EVENT_SOLID_HIT,
+    EVENT_POWERUP,
+    EVENT_PADDLE_HIT
+};
+
+// Initial size of the player paddle
+const glm::vec2 PLAYER_SIZE(100.0f, 20.0f);
+// Initial velocity of the player paddle
+const float PLAYER_VELOCITY(500.0f);
+// Initial velocity of the Ball
+const glm::vec2 INITIAL_BALL_VELOCITY(100.0f, -350.0f);
+// Radius of the ball object
+const float BALL_RADIUS = 12.5f;
+// Length of one simulation step in seconds
+const float SIMULATION_TICK = 1.0f / 120.0f;
+
+// The input of a whole session: the seed the simulation started with
+// and the buttons held during every tick. Replaying it reproduces the
+// session exactly.
+struct InputRecording
+{
+    unsigned int               Seed;
+    std::vector<unsigned char> Input;
+
+    InputRecording() : Seed(0) { }
+    // writes/reads the recording as a binary file; false on failure
+    bool Save(const char *file) const;
+    bool Load(const char *file);
+};
+
+// Simulation holds all game-logic state (ball, paddle, bricks, power-ups)
+// and advances it in fixed steps of SIMULATION_TICK from one byte of
+// input per step. It doesn't touch OpenGL, audio or any globals, so any
+// number of simulations can run side by side on different threads, and
+// the same seed and input always produce the same state.
+class Simulation
+{
+public:
+    // game state
+    GameState               State;
+    unsigned int            Width, Height;
+    std::vector<GameLevel>  Levels;
+    std::vector<PowerUp>    PowerUps;
+    unsigned int            Level;
+    unsigned int            Lives;
+    GameObject              Player;
+    BallObject              Ball;
+    // effects the post processor should show
+    bool                    Confuse, Chaos, Shake;
+    // output of the last Step
+    std::vector<SimulationEvent> Events;
+    unsigned int            ParticleSpawns; // particles the ball's trail should emit
+    // number of steps taken
+    uint64_t                Ticks;
+    // constructor: levels are copied and restored from whenever a level restarts; textures
+    // only provide the sprites of the paddle, ball and power-ups (an empty map is fine)
+    Simulation(unsigned int width, unsigned int height, const std::vector<GameLevel> &levels, const std::map<std::string, Texture2D> &textures, unsigned int seed);
+    // advances the game by one tick with the given InputButton combination held
+    void Step(unsigned char input);
+    // hash of the game-logic state, equal for equal states
+    uint64_t Hash() const;
+    // reset
+    void ResetLevel();
+    void ResetPlayer();
+private:
+    std::vector<GameLevel>            initialLevels;
+    std::map<std::string, Texture2D>  textures;
+    std::mt19937                      random;
+    unsigned char                     previousInput;
+    float                             shakeTime;
+    std::vector<unsigned int>         hits; // scratch space for doCollisions
+    // game logic
+    void processInput(unsigned char input);
+    void doCollisions();
+    // powerups
+    void spawnPowerUps(glm::vec2 position);
+    void updatePowerUps(float dt);
+    void activatePowerUp(PowerUp &powerUp);
+    bool isOtherPowerUpActive(const std::string &type) const;
+    bool shouldSpawn(unsigned int chance);
+    Texture2D getTexture(const std::string &name) const;
+};
+
+// loads the levels the game ships with, laid out for a width x height screen
+std::vector<GameLevel> LoadGameLevels(unsigned int width, unsigned int height);
+
+#endif
@@ -0,0 +1,120 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "simulation_runner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <learnopengl/job_system.h>
+
+
+// screen the soak sessions play on, the same as the game's
+const unsigned int SOAK_WIDTH = 800;
+const unsigned int SOAK_HEIGHT = 600;
+// number of sessions replayed to check the results are deterministic
+const unsigned int SOAK_REPLAYS = 8;
+
+// the input of a bot that chases the ball with the paddle, aiming a random
+// part of the paddle at it so it misses now and then
+unsigned char BotInput(const Simulation &world, std::mt19937 &random, float &aim)
+{
+    if (world.Ticks % 120 == 0)
+        aim = std::uniform_real_distribution<float>(-0.6f, 0.6f)(random) * world.Player.Size.x;
+    unsigned char input = 0;
+    // tap confirm and launch so menus and a stuck ball never stall the session
+    if (world.Ticks % 2 == 0)
+        input |= INPUT_CONFIRM | INPUT_LAUNCH;
+    if (world.State == GAME_MENU && random() % 4 == 0)
+        input |= INPUT_NEXT_LEVEL;
+    float paddle = world.Player.Position.x + world.Player.Size.x / 2.0f;
+    float target = world.Ball.Position.x + world.Ball.Radius + aim;
+    if (paddle < target - 5.0f)
+        input |= INPUT_RIGHT;
+    else if (paddle > target + 5.0f)
+        input |= INPUT_LEFT;
+    return input;
+}
+
+struct SoakSession
+{
+    uint64_t       Hash;
+    unsigned int   BricksDestroyed;
+    InputRecording Recording; // only kept for the sessions that get replayed
+};
+
+bool RunSimulationSoak(unsigned int sessions, unsigned int ticks)
+{
+    // levels are parsed once and copied into every session
+    std::vector<GameLevel> levels = LoadGameLevels(SOAK_WIDTH, SOAK_HEIGHT);
+    std::map<std::string, Texture2D> textures;
+    std::vector<SoakSession> results(sessions);
+
+    JobSystem &jobs = JobSystem::Shared();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    jobs.ParallelFor(sessions, 1, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+        {
+            SoakSession &session = results[i];
+            session.Recording.Seed = static_cast<unsigned int>(i);
+            bool record = i < SOAK_REPLAYS;
+            Simulation world(SOAK_WIDTH, SOAK_HEIGHT, levels, textures, session.Recording.Seed);
+            std::mt19937 random(static_cast<unsigned int>(i) + 1000000u);
+            float aim = 0.0f;
+            session.BricksDestroyed = 0;
+            for (unsigned int tick = 0; tick < ticks; ++tick)
+            {
+                unsigned char input = BotInput(world, random, aim);
+                if (record)
+                    session.Recording.Input.push_back(input);
+                world.Step(input);
+                session.BricksDestroyed += std::count(world.Events.begin(), world.Events.end(), EVENT_BRICK_DESTROYED);
+            }
+            session.Hash = world.Hash();
+        }
+    });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // combine the per-session hashes in session order, so the total doesn't depend on scheduling
+    uint64_t combined = 0xcbf29ce484222325ull;
+    unsigned long long bricks = 0;
+    for (const SoakSession &session : results)
+    {
+        combined = (combined ^ session.Hash) * 0x100000001b3ull;
+        bricks += session.BricksDestroyed;
+    }
+    double totalTicks = static_cast<double>(sessions) * ticks;
+    std::cout << "SOAK: " << sessions << " sessions x " << ticks << " ticks on " << jobs.GetThreadCount() << " threads" << std::endl;
+    std::cout << "  " << seconds * 1000.0 << " ms, " << totalTicks / seconds << " ticks/s (" 
+        << totalTicks * SIMULATION_TICK / seconds << "x real time), " << bricks << " bricks destroyed" << std::endl;
+    std::cout << "  state hash " << std::hex << combined << std::dec << std::endl;
+
+    // replaying the recorded input from the same seed has to end in the same state
+    unsigned int replays = std::min(sessions, SOAK_REPLAYS);
+    for (unsigned int i = 0; i < replays; ++i)
+    {
+        if (ReplayRecording(results[i].Recording, SOAK_WIDTH, SOAK_HEIGHT) != results[i].Hash)
+        {
+            std::cout << "  replay of session " << i << " diverged" << std::endl;
+            return false;
+        }
+    }
+    std::cout << "  " << replays << " replayed sessions matched" << std::endl;
+    return true;
+}
+
+uint64_t ReplayRecording(const InputRecording &recording, unsigned int width, unsigned int height)
+{
+    Simulation world(width, height, LoadGameLevels(width, height), std::map<std::string, Texture2D>(), recording.Seed);
+    for (unsigned char input : recording.Input)
+        world.Step(input);
+    return world.Hash();
+}
@@ -0,0 +1,27 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef SIMULATION_RUNNER_H
+#define SIMULATION_RUNNER_H
+
+#include "simulation.h"
+
+
+// Plays sessions games of ticks ticks each without a window, spread over
+// all hardware threads. Every session is driven by a simple bot seeded
+// with the session's index, so a run is the same on every machine. Prints
+// the ticks simulated per second and a hash over the final state of all
+// sessions, then replays the recorded input of a few sessions and returns
+// whether they ended in the same state.
+bool RunSimulationSoak(unsigned int sessions, unsigned int ticks);
+
+// Plays a recording back without a window and returns the final state
+// hash, the same one the windowed replay prints.
+uint64_t ReplayRecording(const InputRecording &recording, unsigned int width, unsigned int height);
+
+#endif
@@ -1,14 +1,24 @@
 #version 330 core
 layout (location = 0) in vec4 vertex; // <vec2 position, vec2 texCoords>
+layout (location = 1) in vec4 rect; // per sprite: <vec2 position, vec2 size>
+layout (location = 2) in vec4 colorRotation; // per sprite: <vec3 color, float rotation in radians>
 
 out vec2 TexCoords;
+out vec3 SpriteColor;
 
-uniform mat4 model;
 // note that we're omitting the view matrix; the view never changes so we basically have an identity view matrix and can therefore omit it.
 uniform mat4 projection;
 
 void main()
 {
+    // the sprite's model transform: scale the quad to size, rotate it around its center, then translate it
+    vec2 size = rect.zw;
+    vec2 centered = (vertex.xy - 0.5) * size;
+    float s = sin(colorRotation.w);
+    float c = cos(colorRotation.w);
+    vec2 rotated = vec2(c * centered.x - s * centered.y, s * centered.x + c * centered.y);
+
     TexCoords = vertex.zw;
-    gl_Position = projection * model * vec4(vertex.xy, 0.0, 1.0);
+    SpriteColor = colorRotation.rgb;
+    gl_Position = projection * vec4(rect.xy + 0.5 * size + rotated, 0.0, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,62 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#include "sprite_batch.h"
+
+
+void SpriteBatch::Add(unsigned int texture, glm::vec2 position, glm::vec2 size, float rotate, glm::vec3 color)
+{
+    SpriteInstance sprite;
+    sprite.Rect = glm::vec4(position, size);
+    sprite.ColorRotation = glm::vec4(color, glm::radians(rotate));
+    this->sprites.push_back(sprite);
+    this->textures.push_back(texture);
+}
+
+void SpriteBatch::Build(SpriteInstance *destination)
+{
+    this->batches.clear();
+    this->runs.resize(this->sprites.size());
+    // first pass: find the run of every sprite and count the sprites per run. A
+    // frame only uses a handful of textures and consecutive sprites mostly share
+    // one, so the last run is checked first and the rest searched linearly
+    unsigned int last = 0;
+    for (unsigned int i = 0; i < this->sprites.size(); ++i)
+    {
+        unsigned int texture = this->textures[i];
+        if (this->batches.empty() || this->batches[last].Texture != texture)
+        {
+            last = 0;
+            while (last < this->batches.size() && this->batches[last].Texture != texture)
+                ++last;
+            if (last == this->batches.size())
+                this->batches.push_back({ texture, 0, 0 });
+        }
+        this->batches[last].Count++;
+        this->runs[i] = last;
+    }
+    // turn the counts into offsets
+    unsigned int first = 0;
+    for (SpriteBatchRange &batch : this->batches)
+    {
+        batch.First = first;
+        first += batch.Count;
+    }
+    // second pass: scatter the sprites into their runs, keeping their order
+    std::vector<unsigned int> next(this->batches.size());
+    for (unsigned int i = 0; i < this->batches.size(); ++i)
+        next[i] = this->batches[i].First;
+    for (unsigned int i = 0; i < this->sprites.size(); ++i)
+        destination[next[this->runs[i]]++] = this->sprites[i];
+}
+
+void SpriteBatch::Clear()
+{
+    this->sprites.clear();
+    this->textures.clear();
+}
@@ -0,0 +1,63 @@
+/*******************************************************************
+** This code is part of Breakout.
+**
+** Breakout is free software: you can redistribute it and/or modify
+** it under the terms of the CC BY 4.0 license as published by
+** Creative Commons, either version 4 of the License, or (at your
+** option) any later version.
+******************************************************************/
+#ifndef SPRITE_BATCH_H
+#define SPRITE_BATCH_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+
+// Per-sprite data as the instanced sprite shader reads it (32 bytes).
+// The model matrix is built in the vertex shader from these values.
+struct SpriteInstance
+{
+    glm::vec4 Rect;          // <vec2 position, vec2 size>
+    glm::vec4 ColorRotation; // <vec3 color, float rotation in radians>
+};
+
+// A run of instances that share a texture and go out in one draw call.
+struct SpriteBatchRange
+{
+    unsigned int Texture;
+    unsigned int First;
+    unsigned int Count;
+};
+
+// SpriteBatch collects sprites on the CPU and sorts them into one
+// contiguous run per texture, so a renderer can draw each run with
+// a single instanced draw call. It does not touch OpenGL.
+// Runs come out in the order their texture was first submitted and
+// sprites keep their submission order within a run; a sprite is only
+// ever moved in front of sprites with a different texture. Callers
+// that need strict back-to-front order across textures (overlapping,
+// blended sprites) draw what they have queued before submitting more.
+class SpriteBatch
+{
+public:
+    // queues a sprite; rotate is in degrees, like SpriteRenderer::DrawSprite
+    void Add(unsigned int texture, glm::vec2 position, glm::vec2 size, float rotate, glm::vec3 color);
+    // writes all queued sprites, grouped per texture, to destination (which
+    // must hold Size() instances) and fills Batches() with the runs
+    void Build(SpriteInstance *destination);
+    // runs written by the last Build, First indexes into its destination
+    const std::vector<SpriteBatchRange> &Batches() const { return this->batches; }
+    // number of queued sprites
+    unsigned int Size() const { return static_cast<unsigned int>(this->sprites.size()); }
+    bool         Empty() const { return this->sprites.empty(); }
+    // drops the queued sprites (Batches() stays valid until the next Build)
+    void Clear();
+private:
+    std::vector<SpriteInstance>   sprites;  // in submission order
+    std::vector<unsigned int>     textures; // texture of each queued sprite
+    std::vector<unsigned int>     runs;     // run index of each queued sprite, scratch for Build
+    std::vector<SpriteBatchRange> batches;
+};
+
+#endif
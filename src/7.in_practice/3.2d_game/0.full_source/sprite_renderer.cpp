@@ -8,53 +8,81 @@
 ******************************************************************/
 #include "sprite_renderer.h"
 
+#include <algorithm>
+#include <cstddef>
 
-SpriteRenderer::SpriteRenderer(Shader &shader)
+
+SpriteRenderer::SpriteRenderer(Shader &shader, unsigned int capacity)
+    : DrawCalls(0), SpritesDrawn(0), instanceVBO(0), mapped(nullptr), capacity(0), head(0)
 {
     this->shader = shader;
+    // buffer storage (and with it persistent mapping) is core since 4.4
+    this->persistent = GLAD_GL_VERSION_4_4 != 0;
     this->initRenderData();
+    this->createInstanceBuffer(std::max(capacity, 1u));
 }
 
 SpriteRenderer::~SpriteRenderer()
 {
+    this->deleteInstanceBuffer();
     glDeleteVertexArrays(1, &this->quadVAO);
+    glDeleteBuffers(1, &this->quadVBO);
 }
 
 void SpriteRenderer::DrawSprite(Texture2D &texture, glm::vec2 position, glm::vec2 size, float rotate, glm::vec3 color)
 {
-    // prepare transformations
-    this->shader.Use();
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, glm::vec3(position, 0.0f));  // first translate (transformations are: scale happens first, then rotation, and then final translation happens; reversed order)
-
-    model = glm::translate(model, glm::vec3(0.5f * size.x, 0.5f * size.y, 0.0f)); // move origin of rotation to center of quad
-    model = glm::rotate(model, glm::radians(rotate), glm::vec3(0.0f, 0.0f, 1.0f)); // then rotate
-    model = glm::translate(model, glm::vec3(-0.5f * size.x, -0.5f * size.y, 0.0f)); // move origin back
-
-    model = glm::scale(model, glm::vec3(size, 1.0f)); // last scale
-
-    this->shader.SetMatrix4("model", model);
+    this->batch.Add(texture.ID, position, size, rotate, color);
+}
 
-    // render textured quad
-    this->shader.SetVector3f("spriteColor", color);
+void SpriteRenderer::Flush()
+{
+    if (this->batch.Empty())
+        return;
+    // write the queued sprites straight into the instance buffer, grouped by texture
+    unsigned int count = this->batch.Size();
+    unsigned int first = 0;
+    SpriteInstance *destination = this->reserve(count, first);
+    bool written = destination != nullptr;
+    if (written)
+        this->batch.Build(destination);
+    if (!this->persistent && destination)
+        written = glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE; // false if the contents got lost while mapped
+    this->batch.Clear();
+    if (!written)
+        return;
 
+    // render one instanced quad per texture
+    this->shader.Use();
     glActiveTexture(GL_TEXTURE0);
-    texture.Bind();
-
     glBindVertexArray(this->quadVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glBindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
+    for (const SpriteBatchRange &range : this->batch.Batches())
+    {
+        // point the instanced attributes at the run; a 3.3 context has no base instance to do this with
+        std::size_t offset = (first + range.First) * sizeof(SpriteInstance);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)(offset + offsetof(SpriteInstance, Rect)));
+        glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)(offset + offsetof(SpriteInstance, ColorRotation)));
+        glBindTexture(GL_TEXTURE_2D, range.Texture);
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 6, range.Count);
+        this->DrawCalls++;
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
+    this->SpritesDrawn += count;
+
+    // the range can't be overwritten until the GPU has drawn from it
+    if (this->persistent)
+        this->fences.push_back({ glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), first, count });
 }
 
 void SpriteRenderer::initRenderData()
 {
     // configure VAO/VBO
-    unsigned int VBO;
-    float vertices[] = { 
+    float vertices[] = {
         // pos      // tex
         0.0f, 1.0f, 0.0f, 1.0f,
         1.0f, 0.0f, 1.0f, 0.0f,
-        0.0f, 0.0f, 0.0f, 0.0f, 
+        0.0f, 0.0f, 0.0f, 0.0f,
 
         0.0f, 1.0f, 0.0f, 1.0f,
         1.0f, 1.0f, 1.0f, 1.0f,
@@ -62,14 +90,105 @@ void SpriteRenderer::initRenderData()
     };
 
     glGenVertexArrays(1, &this->quadVAO);
-    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &this->quadVBO);
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->quadVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
     glBindVertexArray(this->quadVAO);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
+    // per-sprite attributes; their pointers are set for every run in Flush
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
-}
\ No newline at end of file
+}
+
+void SpriteRenderer::createInstanceBuffer(unsigned int capacity)
+{
+    this->capacity = capacity;
+    this->head = 0;
+    GLsizeiptr size = capacity * sizeof(SpriteInstance);
+    glGenBuffers(1, &this->instanceVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
+    if (this->persistent)
+    {
+        // mapped once for the lifetime of the buffer; coherent, so writes need no explicit flush
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+        this->mapped = static_cast<SpriteInstance*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags));
+    }
+    else
+        glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void SpriteRenderer::deleteInstanceBuffer()
+{
+    // pending draws keep the buffer alive on the GPU side, so nothing to wait for
+    for (Fence &fence : this->fences)
+        glDeleteSync(fence.Sync);
+    this->fences.clear();
+    if (this->mapped)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        this->mapped = nullptr;
+    }
+    glDeleteBuffers(1, &this->instanceVBO);
+    this->instanceVBO = 0;
+}
+
+SpriteInstance *SpriteRenderer::reserve(unsigned int count, unsigned int &first)
+{
+    if (count > this->capacity)
+    {
+        unsigned int capacity = std::max(count, this->capacity * 2);
+        this->deleteInstanceBuffer();
+        this->createInstanceBuffer(capacity);
+    }
+    if (!this->persistent)
+    {
+        // invalidating the buffer lets the driver hand out fresh storage while the GPU still reads the old one
+        first = 0;
+        glBindBuffer(GL_ARRAY_BUFFER, this->instanceVBO);
+        return static_cast<SpriteInstance*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, count * sizeof(SpriteInstance), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    }
+    if (!this->mapped)
+        return nullptr;
+    // the persistent buffer is used as a ring: wrap around when the sprites don't fit before its end
+    if (this->head + count > this->capacity)
+        this->head = 0;
+    first = this->head;
+    this->waitForRange(first, count);
+    this->head += count;
+    return this->mapped + first;
+}
+
+void SpriteRenderer::waitForRange(unsigned int first, unsigned int count)
+{
+    // the GPU finishes commands in order, so waiting for the newest fence over
+    // the range also covers every older one
+    int newest = -1;
+    for (unsigned int i = 0; i < this->fences.size(); ++i)
+    {
+        const Fence &fence = this->fences[i];
+        if (fence.First < first + count && first < fence.First + fence.Count)
+            newest = i;
+    }
+    if (newest < 0)
+        return;
+    GLenum result;
+    do
+        result = glClientWaitSync(this->fences[newest].Sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+    while (result == GL_TIMEOUT_EXPIRED);
+    for (int i = 0; i <= newest; ++i)
+    {
+        glDeleteSync(this->fences.front().Sync);
+        this->fences.pop_front();
+    }
+}
@@ -9,29 +9,67 @@
 #ifndef SPRITE_RENDERER_H
 #define SPRITE_RENDERER_H
 
+#include <deque>
+
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "texture.h"
 #include "shader.h"
+#include "sprite_batch.h"
 
 
+// SpriteRenderer batches sprites: DrawSprite only queues a sprite and
+// Flush draws everything queued with one instanced draw call per
+// texture (see SpriteBatch for the order sprites end up in). Flush
+// before drawing anything else that has to end up on top of the queued
+// sprites, and before the frame ends.
+// The per-sprite data is streamed through an instance buffer that is
+// persistently mapped when the context supports OpenGL 4.4, and mapped
+// and invalidated per flush otherwise.
 class SpriteRenderer
 {
 public:
-    // Constructor (inits shaders/shapes)
-    SpriteRenderer(Shader &shader);
+    // draw statistics, counted up until reset by the user
+    unsigned int DrawCalls;
+    unsigned int SpritesDrawn;
+    // Constructor (inits shaders/shapes); capacity is the number of sprites
+    // the instance buffer holds before it has to grow
+    SpriteRenderer(Shader &shader, unsigned int capacity = 4096);
     // Destructor
     ~SpriteRenderer();
-    // Renders a defined quad textured with given sprite
+    // Queues a defined quad textured with given sprite
     void DrawSprite(Texture2D &texture, glm::vec2 position, glm::vec2 size = glm::vec2(10.0f, 10.0f), float rotate = 0.0f, glm::vec3 color = glm::vec3(1.0f));
+    // Renders all queued sprites
+    void Flush();
 private:
+    // a range of the persistent buffer the GPU may still be reading from
+    struct Fence
+    {
+        GLsync       Sync;
+        unsigned int First, Count;
+    };
     // Render state
-    Shader       shader; 
-    unsigned int quadVAO;
+    Shader                  shader;
+    unsigned int            quadVAO, quadVBO;
+    unsigned int            instanceVBO;
+    SpriteBatch             batch;
+    // instance buffer state
+    bool                    persistent;
+    SpriteInstance         *mapped;   // whole buffer, persistent mapping only
+    unsigned int            capacity; // in sprites
+    unsigned int            head;     // next free sprite in the persistent buffer
+    std::deque<Fence>       fences;   // oldest first
     // Initializes and configures the quad's buffer and vertex attributes
     void initRenderData();
+    // (re)creates the instance buffer with room for capacity sprites
+    void createInstanceBuffer(unsigned int capacity);
+    void deleteInstanceBuffer();
+    // returns where count sprites can be written and their index in the buffer
+    SpriteInstance *reserve(unsigned int count, unsigned int &first);
+    // waits until the GPU is done with the sprites [first, first + count)
+    void waitForRange(unsigned int first, unsigned int count);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -6,135 +6,148 @@
 ** Creative Commons, either version 4 of the License, or (at your
 ** option) any later version.
 ******************************************************************/
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
 #include <iostream>
 
 #include <glm/gtc/matrix_transform.hpp>
-#include <ft2build.h>
-#include FT_FREETYPE_H
 
 #include "text_renderer.h"
 #include "resource_manager.h"
 
 
+// number of vertices the layout cache may grow to before it starts over (a glyph takes 6)
+const unsigned int TEXT_CACHE_VERTICES = 6 * 8192;
+
 TextRenderer::TextRenderer(unsigned int width, unsigned int height)
+    : DrawCalls(0), LayoutsBuilt(0), texture(0), capacity(6 * 256), font(0), fontSize(0), generation(0)
 {
     // load and configure shader
     this->TextShader = ResourceManager::LoadShader("text_2d.vs", "text_2d.fs", nullptr, "text");
     this->TextShader.SetMatrix4("projection", glm::ortho(0.0f, static_cast<float>(width), static_cast<float>(height), 0.0f), true);
     this->TextShader.SetInteger("text", 0);
-    // configure VAO/VBO for texture quads
+    // configure VAO/VBO for the laid out strings
     glGenVertexArrays(1, &this->VAO);
     glGenBuffers(1, &this->VBO);
     glBindVertexArray(this->VAO);
     glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(TextVertex) * this->capacity, NULL, GL_DYNAMIC_DRAW);
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(TextVertex), 0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void*)offsetof(TextVertex, page));
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
+    // room for every page the glyph cache may use, cleared so the padding around glyphs samples as empty
+    int pageSize = this->Glyphs.GetPageSize();
+    unsigned int pages = this->Glyphs.GetMaxPages();
+    std::vector<unsigned char> empty(static_cast<size_t>(pageSize) * pageSize * pages, 0);
+    glGenTextures(1, &this->texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, this->texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R8, pageSize, pageSize, pages, 0, GL_RED, GL_UNSIGNED_BYTE, empty.data());
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+TextRenderer::~TextRenderer()
+{
+    glDeleteTextures(1, &this->texture);
+    glDeleteBuffers(1, &this->VBO);
+    glDeleteVertexArrays(1, &this->VAO);
 }
 
 void TextRenderer::Load(std::string font, unsigned int fontSize)
 {
-    // first clear the previously loaded Characters
-    this->Characters.clear();
-    // then initialize and load the FreeType library
-    FT_Library ft;    
-    if (FT_Init_FreeType(&ft)) // all functions return a value different than 0 whenever an error occurred
-        std::cout << "ERROR::FREETYPE: Could not init FreeType Library" << std::endl;
-    // load font as face
-    FT_Face face;
-    if (FT_New_Face(ft, font.c_str(), 0, &face))
-        std::cout << "ERROR::FREETYPE: Failed to load font" << std::endl;
-    // set size to load glyphs as
-    FT_Set_Pixel_Sizes(face, 0, fontSize);
-    // disable byte-alignment restriction
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1); 
-    // then for the first 128 ASCII characters, pre-load/compile their characters and store them
-    for (GLubyte c = 0; c < 128; c++) // lol see what I did there 
-    {
-        // load character glyph 
-        if (FT_Load_Char(face, c, FT_LOAD_RENDER))
-        {
-            std::cout << "ERROR::FREETYTPE: Failed to load Glyph" << std::endl;
-            continue;
-        }
-        // generate texture
-        unsigned int texture;
-        glGenTextures(1, &texture);
-        glBindTexture(GL_TEXTURE_2D, texture);
-        glTexImage2D(
-            GL_TEXTURE_2D,
-            0,
-            GL_RED,
-            face->glyph->bitmap.width,
-            face->glyph->bitmap.rows,
-            0,
-            GL_RED,
-            GL_UNSIGNED_BYTE,
-            face->glyph->bitmap.buffer
-            );
-        // set texture options
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-       
-        // now store character for later use
-        Character character = {
-            texture,
-            glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-            glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-            face->glyph->advance.x
-        };
-        Characters.insert(std::pair<char, Character>(c, character));
-    }
-    glBindTexture(GL_TEXTURE_2D, 0);
-    // destroy FreeType once we're finished
-    FT_Done_Face(face);
-    FT_Done_FreeType(ft);
+    // the layouts of the previous font are of no use anymore
+    this->cache.clear();
+    this->vertices.clear();
+    this->font = this->Glyphs.AddFont(font);
+    this->fontSize = fontSize;
+    // get the printable ASCII glyphs rasterizing right away, most text needs nothing else
+    for (char32_t c = 32; c < 127; c++)
+        this->Glyphs.GetGlyph(this->font, fontSize, c);
 }
 
 void TextRenderer::RenderText(std::string text, float x, float y, float scale, glm::vec3 color)
 {
-    // activate corresponding render state	
+    this->updateGlyphs();
+    // rasterize at the size the text ends up on screen instead of scaling the glyphs
+    unsigned int pixelSize = std::max(1u, static_cast<unsigned int>(std::lround(this->fontSize * scale)));
+    const CachedText &cached = this->layout(text, pixelSize);
+    if (cached.Count == 0)
+        return;
+    // activate corresponding render state; the layout is at the origin, the shader places it
     this->TextShader.Use();
     this->TextShader.SetVector3f("textColor", color);
+    this->TextShader.SetVector3f("placement", glm::vec3(x, y, scale * this->fontSize / pixelSize));
     glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, this->texture);
     glBindVertexArray(this->VAO);
+    glDrawArrays(GL_TRIANGLES, cached.First, cached.Count);
+    this->DrawCalls++;
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
 
-    // iterate through all characters
-    std::string::const_iterator c;
-    for (c = text.begin(); c != text.end(); c++)
+void TextRenderer::updateGlyphs()
+{
+    this->Glyphs.Update();
+    int pageSize = this->Glyphs.GetPageSize();
+    glm::ivec4 region;
+    glBindTexture(GL_TEXTURE_2D_ARRAY, this->texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, pageSize);
+    for (unsigned int page = 0; page < this->Glyphs.GetPageCount(); page++)
     {
-        Character ch = Characters[*c];
-
-        float xpos = x + ch.Bearing.x * scale;
-        float ypos = y + (this->Characters['H'].Bearing.y - ch.Bearing.y) * scale;
-
-        float w = ch.Size.x * scale;
-        float h = ch.Size.y * scale;
-        // update VBO for each character
-        float vertices[6][4] = {
-            { xpos,     ypos + h,   0.0f, 1.0f },
-            { xpos + w, ypos,       1.0f, 0.0f },
-            { xpos,     ypos,       0.0f, 0.0f },
+        if (!this->Glyphs.TakeDirtyRegion(page, region))
+            continue;
+        const unsigned char *pixels = this->Glyphs.GetPagePixels(page).data() + static_cast<size_t>(region.y) * pageSize + region.x;
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, region.x, region.y, page, region.z, region.w, 1, GL_RED, GL_UNSIGNED_BYTE, pixels);
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    // glyphs arrived or moved: lay everything out again as it's drawn
+    if (this->generation != this->Glyphs.GetGeneration())
+    {
+        this->generation = this->Glyphs.GetGeneration();
+        this->cache.clear();
+        this->vertices.clear();
+    }
+}
 
-            { xpos,     ypos + h,   0.0f, 1.0f },
-            { xpos + w, ypos + h,   1.0f, 1.0f },
-            { xpos + w, ypos,       1.0f, 0.0f }
-        };
-        // render glyph texture over quad
-        glBindTexture(GL_TEXTURE_2D, ch.TextureID);
-        // update content of VBO memory
-        glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices); // be sure to use glBufferSubData and not glBufferData
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        // render quad
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        // now advance cursors for next glyph
-        x += (ch.Advance >> 6) * scale; // bitshift by 6 to get value in pixels (1/64th times 2^6 = 64)
+const TextRenderer::CachedText &TextRenderer::layout(const std::string &text, unsigned int pixelSize)
+{
+    std::string key = std::to_string(pixelSize) + ':' + text;
+    std::unordered_map<std::string, CachedText>::const_iterator it = this->cache.find(key);
+    if (it != this->cache.end())
+        return it->second;
+    // changing text (scores, timers) would fill the cache forever; start over once it gets big
+    if (this->vertices.size() + 6 * text.size() > TEXT_CACHE_VERTICES)
+    {
+        this->cache.clear();
+        this->vertices.clear();
     }
-    glBindVertexArray(0);
-    glBindTexture(GL_TEXTURE_2D, 0);
-}
\ No newline at end of file
+    CachedText cached;
+    cached.First = this->vertices.size();
+    LayoutText(this->Glyphs, this->font, pixelSize, text, 0.0f, 0.0f, 1.0f, true, this->vertices);
+    cached.Count = this->vertices.size() - cached.First;
+    this->LayoutsBuilt++;
+    // upload the new vertices, growing the buffer if they don't fit
+    glBindBuffer(GL_ARRAY_BUFFER, this->VBO);
+    if (this->vertices.size() > this->capacity)
+    {
+        while (this->capacity < this->vertices.size())
+            this->capacity *= 2;
+        glBufferData(GL_ARRAY_BUFFER, sizeof(TextVertex) * this->capacity, NULL, GL_DYNAMIC_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(TextVertex) * this->vertices.size(), this->vertices.data());
+    }
+    else if (cached.Count > 0)
+        glBufferSubData(GL_ARRAY_BUFFER, sizeof(TextVertex) * cached.First, sizeof(TextVertex) * cached.Count, &this->vertices[cached.First]);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return this->cache[key] = cached;
+}
@@ -9,43 +9,63 @@
 #ifndef TEXT_RENDERER_H
 #define TEXT_RENDERER_H
 
-#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <learnopengl/glyph_cache.h>
+
 #include "texture.h"
 #include "shader.h"
 
 
-/// Holds all state information relevant to a character as loaded using FreeType
-struct Character {
-    unsigned int TextureID; // ID handle of the glyph texture
-    glm::ivec2   Size;      // size of glyph
-    glm::ivec2   Bearing;   // offset from baseline to left/top of glyph
-    unsigned int Advance;   // horizontal offset to advance to next glyph
-};
-
-
 // A renderer class for rendering text displayed by a font loaded using the 
-// FreeType library. A single font is loaded, processed into a list of Character
-// items for later rendering.
+// FreeType library. Glyphs come from a GlyphCache: they're rasterized in the
+// background the first time a string needs them, at the pixel size the text
+// is drawn at, and kept in the layers of one array texture. Every string is
+// laid out into the vertex buffer once and drawn with a single draw call;
+// strings rendered again reuse their cached layout, so static text costs no
+// layout or upload at all. Text shows up as soon as its glyphs are ready.
 class TextRenderer
 {
 public:
-    // holds a list of pre-compiled Characters
-    std::map<char, Character> Characters; 
+    // glyphs of the loaded font, rasterized on first use
+    GlyphCache Glyphs;
     // shader used for text rendering
     Shader TextShader;
-    // constructor
+    // draw statistics, counted up until reset by the user
+    unsigned int DrawCalls;
+    unsigned int LayoutsBuilt;
+    // constructor/destructor
     TextRenderer(unsigned int width, unsigned int height);
-    // pre-compiles a list of characters from the given font
+    ~TextRenderer();
+    // selects the font to render with; fontSize is the pixel size at scale 1
     void Load(std::string font, unsigned int fontSize);
-    // renders a string of text using the precompiled list of characters
+    // renders a string of UTF-8 text
     void RenderText(std::string text, float x, float y, float scale, glm::vec3 color = glm::vec3(1.0f));
 private:
+    // where the layout of a string is kept in the vertex buffer
+    struct CachedText
+    {
+        unsigned int First, Count;
+    };
     // render state
     unsigned int VAO, VBO;
+    unsigned int texture;  // array texture, one layer per atlas page
+    unsigned int capacity; // of the vertex buffer, in vertices
+    // font state
+    unsigned int font, fontSize;
+    // layout cache, keyed by pixel size and text
+    std::unordered_map<std::string, CachedText> cache;
+    std::vector<TextVertex>                     vertices;   // everything in the vertex buffer
+    unsigned long long                          generation; // of the glyph cache the layouts were built with
+    // takes in the glyphs rasterized since the last call and uploads the changed parts of the atlas
+    void updateGlyphs();
+    // returns the cached layout of text, laying it out first if needed
+    const CachedText &layout(const std::string &text, unsigned int pixelSize);
 };
 
-#endif 
\ No newline at end of file
+#endif
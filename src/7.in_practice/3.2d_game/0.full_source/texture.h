@@ -16,7 +16,7 @@
 class Texture2D
 {
 public:
-    // holds the ID of the texture object, used for all texture operations to reference to this particular texture
+    // holds the ID of the texture object, used for all texture operations to reference to this particular texture (0 until generated)
     unsigned int ID;
     // texture image dimensions
     unsigned int Width, Height; // width and height of loaded image in pixels
@@ -30,7 +30,7 @@ public:
     unsigned int Filter_Max; // filtering mode if texture pixels > screen pixels
     // constructor (sets default texture modes)
     Texture2D();
-    // generates texture from image data
+    // generates texture from image data (creates the texture object on first use)
     void Generate(unsigned int width, unsigned int height, unsigned char* data);
     // binds the texture as the current active GL_TEXTURE_2D texture object
     void Bind() const;
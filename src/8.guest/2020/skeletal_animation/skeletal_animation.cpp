@@ -9,17 +9,28 @@
 #include <learnopengl/shader_m.h>
 #include <learnopengl/camera.h>
 #include <learnopengl/animator.h>
+#include <learnopengl/crowd_animator.h>
 #include <learnopengl/model_animation.h>
 
 
 
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
 
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow* window);
+bool runAnimationBenchmark(Animation& animation, unsigned int frames);
+bool runBoneCursorBenchmark(unsigned int lookups);
+bool runCrowdBenchmark(unsigned int characters, unsigned int frames);
 
 // settings
 const unsigned int SCR_WIDTH = 800;
@@ -35,8 +46,29 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
-int main()
+int main(int argc, char* argv[])
 {
+	// these benchmarks work on synthetic data and need neither a window nor the model:
+	// "--bone-cursor-benchmark [lookups]" times key lookups on synthetic channels of 1k to 100k keys and exits
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::string(argv[i]) == "--bone-cursor-benchmark")
+		{
+			unsigned int lookups = 10000;
+			if (i + 1 < argc && std::atoi(argv[i + 1]) > 0)
+				lookups = std::atoi(argv[i + 1]);
+			return runBoneCursorBenchmark(lookups) ? 0 : 1;
+		}
+		// "--crowd-benchmark [characters]" animates a crowd of synthetic rigs on 1 to N job system threads and exits
+		if (std::string(argv[i]) == "--crowd-benchmark")
+		{
+			unsigned int characters = 1000;
+			if (i + 1 < argc && std::atoi(argv[i + 1]) > 0)
+				characters = std::atoi(argv[i + 1]);
+			return runCrowdBenchmark(characters, 300) ? 0 : 1;
+		}
+	}
+
 	// glfw: initialize and configure
 	// ------------------------------
 	glfwInit();
@@ -89,7 +121,24 @@ int main()
 	// -----------
 	Model ourModel(FileSystem::getPath("resources/objects/vampire/dancing_vampire.dae"));
 	Animation danceAnimation(FileSystem::getPath("resources/objects/vampire/dancing_vampire.dae"),&ourModel);
+	Animation bindPose = Animation::BindPose(danceAnimation);
 	Animator animator(&danceAnimation);
+	Animation* currentClip = &danceAnimation;
+
+	// "--animation-benchmark [frames]" times the recursive hierarchy walk against the flattened one and exits
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::string(argv[i]) == "--animation-benchmark")
+		{
+			unsigned int frames = 10000;
+			if (i + 1 < argc && std::atoi(argv[i + 1]) > 0)
+				frames = std::atoi(argv[i + 1]);
+			bool identical = runAnimationBenchmark(danceAnimation, frames);
+			ourModel.Unload();
+			glfwTerminate();
+			return identical ? 0 : 1;
+		}
+	}
 
 
 	// draw in wireframe
@@ -108,6 +157,18 @@ int main()
 		// input
 		// -----
 		processInput(window);
+
+		// 1 blends into the dance, 2 back into the bind pose
+		Animation* requestedClip = currentClip;
+		if (glfwGetKey(window, GLFW_KEY_1) == GLFW_PRESS)
+			requestedClip = &danceAnimation;
+		if (glfwGetKey(window, GLFW_KEY_2) == GLFW_PRESS)
+			requestedClip = &bindPose;
+		if (requestedClip != currentClip)
+		{
+			animator.CrossFade(requestedClip, 0.5f);
+			currentClip = requestedClip;
+		}
 		animator.UpdateAnimation(deltaTime);
 		
 		// render
@@ -124,7 +185,7 @@ int main()
 		ourShader.setMat4("projection", projection);
 		ourShader.setMat4("view", view);
 
-        auto transforms = animator.GetFinalBoneMatrices();
+        const auto& transforms = animator.GetFinalBoneMatrices();
 		for (int i = 0; i < transforms.size(); ++i)
 			ourShader.setMat4("finalBonesMatrices[" + std::to_string(i) + "]", transforms[i]);
 
@@ -143,12 +204,286 @@ int main()
 		glfwPollEvents();
 	}
 
+	// de-allocate the model's textures while the OpenGL context still exists
+	// ----------------------------------------------------------------------
+	ourModel.Unload();
+
 	// glfw: terminate, clearing all previously allocated GLFW resources.
 	// ------------------------------------------------------------------
 	glfwTerminate();
 	return 0;
 }
 
+// the hierarchy walk Animator did before the hierarchy was flattened: recursive, looking every node's bone up by
+// name and copying the bone info map for every node
+// ---------------------------------------------------------------------------------------------------------
+void evaluateRecursive(Animation& animation, const AssimpNodeData* node, float time, glm::mat4 parentTransform, std::vector<glm::mat4>& palette)
+{
+	glm::mat4 nodeTransform = node->transformation;
+	Bone* bone = animation.FindBone(node->name);
+	if (bone)
+	{
+		bone->Update(time);
+		nodeTransform = bone->GetLocalTransform();
+	}
+	glm::mat4 globalTransformation = parentTransform * nodeTransform;
+
+	auto boneInfoMap = animation.GetBoneIDMap();
+	if (boneInfoMap.find(node->name) != boneInfoMap.end())
+	{
+		int index = boneInfoMap[node->name].id;
+		if (index < (int)palette.size())
+			palette[index] = globalTransformation * boneInfoMap[node->name].offset;
+	}
+
+	for (int i = 0; i < node->childrenCount; i++)
+		evaluateRecursive(animation, &node->children[i], time, globalTransformation, palette);
+}
+
+// evaluates the pose of the animation at frames points in time twice: with the recursive walk above and with
+// Animator::EvaluatePose over the flattened hierarchy. Prints both times and returns whether both produced
+// the same bone matrices.
+// ---------------------------------------------------------------------------------------------------------
+bool runAnimationBenchmark(Animation& animation, unsigned int frames)
+{
+	const float step = animation.GetDuration() / 240.0f; // about four seconds at 60 fps per loop of the clip
+	std::vector<glm::mat4> recursive(MAX_BONES, glm::mat4(1.0f)), flattened(MAX_BONES, glm::mat4(1.0f));
+	std::vector<glm::mat4> globals(animation.GetNodes().size());
+	std::vector<BoneCursor> cursors(animation.GetBoneCount());
+
+	double recursiveTime = 0.0, flattenedTime = 0.0;
+	float largestDifference = 0.0f;
+	for (unsigned int frame = 0; frame < frames; ++frame)
+	{
+		float time = std::fmod(frame * step, animation.GetDuration());
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		evaluateRecursive(animation, &animation.GetRootNode(), time, glm::mat4(1.0f), recursive);
+		recursiveTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		start = std::chrono::steady_clock::now();
+		Animator::EvaluatePose(animation, time, cursors.data(), globals.data(), flattened.data(), MAX_BONES);
+		flattenedTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		for (int i = 0; i < MAX_BONES; ++i)
+			for (int column = 0; column < 4; ++column)
+				for (int row = 0; row < 4; ++row)
+					largestDifference = std::max(largestDifference, std::abs(recursive[i][column][row] - flattened[i][column][row]));
+	}
+
+	std::cout << "ANIMATION BENCHMARK: " << animation.GetNodes().size() << " nodes, " << animation.GetBoneCount() << " animated bones, " << frames << " frames" << std::endl;
+	std::cout << "  recursive: " << recursiveTime * 1000.0 / frames << " us/frame" << std::endl;
+	std::cout << "  flattened: " << flattenedTime * 1000.0 / frames << " us/frame" << std::endl;
+	std::cout << "  largest difference " << largestDifference << std::endl;
+	return largestDifference < 1e-4f;
+}
+
+// the key lookup Bone did before it kept cursors: a linear scan from the first key on every call
+// ---------------------------------------------------------------------------------------------------------
+int findKeyLinear(const std::vector<float>& timeStamps, float animationTime)
+{
+	for (int index = 0; index < (int)timeStamps.size() - 2; ++index)
+		if (animationTime < timeStamps[index + 1])
+			return index;
+	return std::max(0, (int)timeStamps.size() - 2);
+}
+
+// builds a Bone with a synthetic position channel of keyCount irregularly spaced keys (0.5 to 1.5 ticks apart)
+// for each of 1k, 10k and 100k keys, and looks up lookups points in time with the linear scan above, with the
+// bone's cursor and on a copy resampled to one key per tick. That is done twice: playing forward at half a
+// key per lookup (60 fps over a 30 keys per second clip) and seeking to random times. Prints the time per
+// lookup for every case and returns whether the cursor always found the same key as the linear scan.
+// ---------------------------------------------------------------------------------------------------------
+bool runBoneCursorBenchmark(unsigned int lookups)
+{
+	std::cout << "BONE CURSOR BENCHMARK: synthetic position channels, " << lookups << " lookups per case" << std::endl;
+	std::mt19937 rng(7);
+	bool identical = true;
+	long long checksum = 0; // keeps the lookups from being optimized away
+	const unsigned int keyCounts[] = { 1000, 10000, 100000 };
+	for (unsigned int keyCount : keyCounts)
+	{
+		aiNodeAnim channel;
+		channel.mNumPositionKeys = keyCount;
+		channel.mPositionKeys = new aiVectorKey[keyCount];
+		channel.mNumRotationKeys = channel.mNumScalingKeys = 1;
+		channel.mRotationKeys = new aiQuatKey[1];
+		channel.mRotationKeys[0] = aiQuatKey(0.0, aiQuaternion());
+		channel.mScalingKeys = new aiVectorKey[1];
+		channel.mScalingKeys[0] = aiVectorKey(0.0, aiVector3D(1.0f));
+		std::uniform_real_distribution<float> spacing(0.5f, 1.5f), value(-1.0f, 1.0f);
+		std::vector<float> timeStamps(keyCount);
+		float time = 0.0f;
+		for (unsigned int key = 0; key < keyCount; ++key)
+		{
+			timeStamps[key] = time;
+			channel.mPositionKeys[key] = aiVectorKey(time, aiVector3D(value(rng), value(rng), value(rng)));
+			time += spacing(rng);
+		}
+		const float duration = timeStamps.back();
+		Bone bone("synthetic", 0, &channel);
+		Bone resampled = bone;
+		resampled.Resample(1.0f, duration);
+
+		std::uniform_real_distribution<float> seek(0.0f, duration);
+		std::vector<float> forward(lookups), random(lookups);
+		for (unsigned int i = 0; i < lookups; ++i)
+		{
+			forward[i] = std::fmod(i * 0.5f, duration);
+			random[i] = seek(rng);
+		}
+		const std::pair<const char*, const std::vector<float>*> patterns[] = { { "forward", &forward }, { "random", &random } };
+		for (const std::pair<const char*, const std::vector<float>*>& pattern : patterns)
+		{
+			const std::vector<float>& times = *pattern.second;
+			std::vector<int> linearKeys(lookups), cursorKeys(lookups);
+
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for (unsigned int i = 0; i < lookups; ++i)
+				linearKeys[i] = findKeyLinear(timeStamps, times[i]);
+			double linearTime = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+			start = std::chrono::steady_clock::now();
+			for (unsigned int i = 0; i < lookups; ++i)
+				cursorKeys[i] = bone.GetPositionIndex(times[i]);
+			double cursorTime = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+			start = std::chrono::steady_clock::now();
+			for (unsigned int i = 0; i < lookups; ++i)
+				checksum += resampled.GetPositionIndex(times[i]);
+			double resampledTime = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+			identical = identical && linearKeys == cursorKeys;
+			checksum += linearKeys.back() + cursorKeys.back();
+			std::cout << "  " << keyCount << " keys, " << pattern.first << ": linear " << linearTime / lookups << " ns, cursor "
+				<< cursorTime / lookups << " ns, resampled " << resampledTime / lookups << " ns per lookup" << std::endl;
+		}
+	}
+	std::cout << (identical ? "  cursor and linear scan found the same keys" : "  cursor and linear scan differ")
+		<< " (checksum " << checksum << ")" << std::endl;
+	return identical;
+}
+
+// adds a chain of count nodes below parent, each one length units further along direction, and an animation
+// channel for every one of them that sways it around its local z axis with keyCount keys, one per tick
+// ---------------------------------------------------------------------------------------------------------
+aiNode* addSyntheticChain(aiNode* parent, std::vector<aiNodeAnim*>& channels, const std::string& name, unsigned int count,
+	const aiVector3D& direction, float length, unsigned int keyCount)
+{
+	for (unsigned int link = 0; link < count; ++link)
+	{
+		aiNode* node = new aiNode(name + std::to_string(link));
+		const aiVector3D offset = direction * length;
+		node->mTransformation = aiMatrix4x4(1, 0, 0, offset.x, 0, 1, 0, offset.y, 0, 0, 1, offset.z, 0, 0, 0, 1);
+		node->mParent = parent;
+		aiNode** children = new aiNode*[parent->mNumChildren + 1];
+		for (unsigned int i = 0; i < parent->mNumChildren; ++i)
+			children[i] = parent->mChildren[i];
+		children[parent->mNumChildren++] = node;
+		delete[] parent->mChildren;
+		parent->mChildren = children;
+
+		aiNodeAnim* channel = new aiNodeAnim();
+		channel->mNodeName = node->mName;
+		channel->mNumPositionKeys = channel->mNumRotationKeys = channel->mNumScalingKeys = keyCount;
+		channel->mPositionKeys = new aiVectorKey[keyCount];
+		channel->mRotationKeys = new aiQuatKey[keyCount];
+		channel->mScalingKeys = new aiVectorKey[keyCount];
+		for (unsigned int key = 0; key < keyCount; ++key)
+		{
+			const float angle = 0.3f * std::sin(key * 0.2f + channels.size() * 0.7f);
+			channel->mPositionKeys[key] = aiVectorKey(key, offset);
+			channel->mRotationKeys[key] = aiQuatKey(key, aiQuaternion(aiVector3D(0.0f, 0.0f, 1.0f), angle));
+			channel->mScalingKeys[key] = aiVectorKey(key, aiVector3D(1.0f));
+		}
+		channels.push_back(channel);
+		parent = node;
+	}
+	return parent;
+}
+
+// a humanoid sized rig of 52 animated bones (spine, head, arms with five fingers each and legs) playing a
+// two second clip at 30 keys per second; every bone is bound, as it would be in a skinned character
+// ---------------------------------------------------------------------------------------------------------
+Animation buildSyntheticAnimation()
+{
+	const unsigned int keyCount = 61;
+	aiNode root("root");
+	std::vector<aiNodeAnim*> channels;
+	aiNode* hips = addSyntheticChain(&root, channels, "hips", 1, aiVector3D(0.0f, 1.0f, 0.0f), 1.0f, keyCount);
+	aiNode* chest = addSyntheticChain(hips, channels, "spine", 3, aiVector3D(0.0f, 1.0f, 0.0f), 0.15f, keyCount);
+	addSyntheticChain(chest, channels, "head", 2, aiVector3D(0.0f, 1.0f, 0.0f), 0.1f, keyCount);
+	const char* sides[] = { "left", "right" };
+	for (int side = 0; side < 2; ++side)
+	{
+		const float x = side == 0 ? 1.0f : -1.0f;
+		aiNode* hand = addSyntheticChain(chest, channels, std::string(sides[side]) + "_arm", 4, aiVector3D(x, 0.0f, 0.0f), 0.2f, keyCount);
+		for (int finger = 0; finger < 5; ++finger)
+			addSyntheticChain(hand, channels, std::string(sides[side]) + "_finger" + std::to_string(finger) + "_", 3,
+				aiVector3D(x, 0.0f, 0.02f * (finger - 2)), 0.03f, keyCount);
+		addSyntheticChain(hips, channels, std::string(sides[side]) + "_leg", 4, aiVector3D(0.1f * x, -1.0f, 0.0f), 0.25f, keyCount);
+	}
+
+	aiAnimation clip;
+	clip.mDuration = keyCount - 1;
+	clip.mTicksPerSecond = 30.0;
+	clip.mNumChannels = (unsigned int)channels.size();
+	clip.mChannels = new aiNodeAnim*[channels.size()];
+	std::copy(channels.begin(), channels.end(), clip.mChannels);
+
+	std::map<std::string, BoneInfo> boneInfoMap;
+	int boneCount = 0;
+	for (aiNodeAnim* channel : channels)
+		boneInfoMap[channel->mNodeName.C_Str()] = BoneInfo{ boneCount++, glm::mat4(1.0f) };
+	return Animation(&clip, &root, boneInfoMap, boneCount);
+}
+
+// animates the same crowd of synthetic rigs (every character at its own offset into the clip and its own
+// speed) for frames updates on a JobSystem of every size from 1 thread to one per hardware thread. Prints
+// the time per update and the characters animated per millisecond for each, and returns whether every
+// size ended with the same bone palette as the single thread.
+// ---------------------------------------------------------------------------------------------------------
+bool runCrowdBenchmark(unsigned int characters, unsigned int frames)
+{
+	Animation animation = buildSyntheticAnimation();
+	const unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+	std::cout << "CROWD BENCHMARK: " << characters << " characters, " << animation.GetBoneCount() << " bones each, "
+		<< frames << " updates, 1 to " << maxThreads << " threads" << std::endl;
+
+	std::vector<glm::mat4> reference;
+	bool identical = true;
+	double singleThreadTime = 0.0;
+	for (unsigned int threads = 1; threads <= maxThreads; ++threads)
+	{
+		JobSystem jobs(threads);
+		CrowdAnimator crowd(jobs);
+		for (unsigned int i = 0; i < characters; ++i)
+		{
+			float startTime = std::fmod(i * 7.3f, animation.GetDuration());
+			float speed = 0.75f + 0.5f * (i % 11) / 10.0f;
+			crowd.AddCharacter(&animation, startTime, speed);
+		}
+
+		const float dt = 1.0f / 60.0f;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		for (unsigned int frame = 0; frame < frames; ++frame)
+			crowd.Update(dt);
+		double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		if (threads == 1)
+		{
+			reference = crowd.GetPalette();
+			singleThreadTime = time;
+		}
+		else
+			identical = identical && crowd.GetPalette() == reference;
+		std::cout << "  " << threads << (threads == 1 ? " thread:  " : " threads: ") << time / frames << " ms/update, "
+			<< characters * frames / time << " characters/ms, " << singleThreadTime / time << "x" << std::endl;
+	}
+	std::cout << (identical ? "  palettes identical" : "  palettes differ") << std::endl;
+	return identical;
+}
+
 // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
 // ---------------------------------------------------------------------------------------------------------
 void processInput(GLFWwindow* window)
@@ -26,12 +26,23 @@ public:
 #endif
 
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow* window);
+bool runSceneGraphBenchmark(unsigned int nodeCount, unsigned int frames);
+bool runSceneGraphScaling(unsigned int nodeCount, unsigned int frames);
 
 // settings
 const unsigned int SCR_WIDTH = 800;
@@ -47,8 +58,24 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
-int main()
+int main(int argc, char* argv[])
 {
+	// "--scene-graph-benchmark [nodes]" times the update of a large headless hierarchy stored as linked nodes
+	// and as a SceneGraph, then the SceneGraph's update and culling on 1 to N job system threads, and exits;
+	// it doesn't need a window
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::string(argv[i]) == "--scene-graph-benchmark")
+		{
+			unsigned int nodeCount = i + 1 < argc ? std::atoi(argv[i + 1]) : 1000000;
+			if (nodeCount == 0)
+				nodeCount = 1000000;
+			const bool identical = runSceneGraphBenchmark(nodeCount, 20);
+			const bool scalingIdentical = runSceneGraphScaling(nodeCount, 20);
+			return identical && scalingIdentical ? 0 : 1;
+		}
+	}
+
 	// glfw: initialize and configure
 	// ------------------------------
 	glfwInit();
@@ -99,25 +126,26 @@ int main()
 	// load entities
 	// -----------
 	Model model = Model(FileSystem::getPath("resources/objects/planet/planet.obj"));
-	Entity ourEntity(model);
-	ourEntity.transform.setLocalPosition({ 10, 0, 0 });
+	SceneGraph scene;
+	Entity ourEntity(scene, model);
+	ourEntity.setLocalPosition({ 10, 0, 0 });
 	const float scale = 0.75;
-	ourEntity.transform.setLocalScale({ scale, scale, scale });
+	ourEntity.setLocalScale({ scale, scale, scale });
 
 	{
-		Entity* lastEntity = &ourEntity;
+		Entity lastEntity = ourEntity;
 
-		for (unsigned int i = 0; i < 10; ++i)
+		//The root and nine descendants, the ten planets the demo has always drawn
+		for (unsigned int i = 0; i < 9; ++i)
 		{
-			lastEntity->addChild(model);
-			lastEntity = lastEntity->children.back().get();
+			lastEntity = lastEntity.addChild(model);
 
 			//Set transform values
-			lastEntity->transform.setLocalPosition({ 10, 0, 0 });
-			lastEntity->transform.setLocalScale({ scale, scale, scale });
+			lastEntity.setLocalPosition({ 10, 0, 0 });
+			lastEntity.setLocalScale({ scale, scale, scale });
 		}
 	}
-	ourEntity.updateSelfAndChild();
+	scene.update();
 
 	// draw in wireframe
 	//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -151,16 +179,10 @@ int main()
 		ourShader.setMat4("view", view);
 
 		// draw our scene graph
-		Entity* lastEntity = &ourEntity;
-		while (lastEntity->children.size())
-		{
-			ourShader.setMat4("model", lastEntity->transform.getModelMatrix());
-			lastEntity->pModel->Draw(ourShader);
-			lastEntity = lastEntity->children.back().get();
-		}
+		scene.draw(ourShader);
 
-		ourEntity.transform.setLocalRotation({ 0.f, ourEntity.transform.getLocalRotation().y + 20 * deltaTime, 0.f });
-		ourEntity.updateSelfAndChild();
+		ourEntity.setLocalRotation({ 0.f, ourEntity.getLocalRotation().y + 20 * deltaTime, 0.f });
+		scene.update();
 
 		// glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
 		// -------------------------------------------------------------------------------
@@ -168,6 +190,10 @@ int main()
 		glfwPollEvents();
 	}
 
+	// de-allocate the model's textures while the OpenGL context still exists
+	// ----------------------------------------------------------------------
+	model.Unload();
+
 	// glfw: terminate, clearing all previously allocated GLFW resources.
 	// ------------------------------------------------------------------
 	glfwTerminate();
@@ -226,3 +252,239 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 {
 	camera.ProcessMouseScroll(yoffset);
 }
+
+// one node of the hierarchy as the scene graph stored it before SceneGraph: individually allocated, with its
+// children behind pointers and updated by a recursive walk. Kept here as the reference for the benchmark.
+// ---------------------------------------------------------------------------------------------------------
+struct LinkedNode
+{
+	Transform transform;
+	std::vector<std::unique_ptr<LinkedNode>> children;
+	LinkedNode* parent = nullptr;
+
+	//Update transform if it was changed
+	void updateSelfAndChild()
+	{
+		if (transform.isDirty())
+		{
+			forceUpdateSelfAndChild();
+			return;
+		}
+
+		for (auto&& child : children)
+			child->updateSelfAndChild();
+	}
+
+	//Force update of transform even if local space don't change
+	void forceUpdateSelfAndChild()
+	{
+		if (parent)
+			transform.computeModelMatrix(parent->transform.getModelMatrix());
+		else
+			transform.computeModelMatrix();
+
+		for (auto&& child : children)
+			child->forceUpdateSelfAndChild();
+	}
+};
+
+// builds the same 8-ary hierarchy of nodeCount headless nodes twice, as LinkedNodes and as a SceneGraph, and
+// times frames updates of each for three cases: the root rotated (every matrix changes), 1% of the nodes
+// rotated, and nothing changed. Prints the average times and returns whether both produced the same world
+// matrices.
+// ---------------------------------------------------------------------------------------------------------
+bool runSceneGraphBenchmark(unsigned int nodeCount, unsigned int frames)
+{
+	const unsigned int FANOUT = 8;
+	const AABB unitBox(glm::vec3(-1.0f), glm::vec3(1.0f));
+
+	std::vector<LinkedNode*> linked(nodeCount);
+	std::unique_ptr<LinkedNode> root = std::make_unique<LinkedNode>();
+	linked[0] = root.get();
+	SceneGraph scene;
+	scene.reserve(nodeCount);
+	scene.addNode(unitBox, nullptr);
+	for (unsigned int i = 1; i < nodeCount; ++i)
+	{
+		LinkedNode* parent = linked[(i - 1) / FANOUT];
+		parent->children.emplace_back(std::make_unique<LinkedNode>());
+		linked[i] = parent->children.back().get();
+		linked[i]->parent = parent;
+		scene.addNode(unitBox, nullptr, (i - 1) / FANOUT);
+	}
+	for (unsigned int i = 0; i < nodeCount; ++i)
+	{
+		const glm::vec3 position(2.0f * std::cos(float(i)), 0.1f * (i % 7), 2.0f * std::sin(float(i)));
+		const glm::vec3 rotation(0.0f, float(i * 7 % 360), 0.0f);
+		linked[i]->transform.setLocalPosition(position);
+		linked[i]->transform.setLocalRotation(rotation);
+		linked[i]->transform.setLocalScale(glm::vec3(0.9f));
+		scene.setLocalPosition(i, position);
+		scene.setLocalRotation(i, rotation);
+		scene.setLocalScale(i, glm::vec3(0.9f));
+	}
+	root->updateSelfAndChild();
+	scene.update();
+
+	bool identical = true;
+	auto compare = [&]()
+	{
+		for (unsigned int i = 0; identical && i < nodeCount; ++i)
+		{
+			const glm::mat4& a = linked[i]->transform.getModelMatrix();
+			const glm::mat4& b = scene.getModelMatrix(i);
+			for (int c = 0; c < 4; ++c)
+				for (int r = 0; r < 4; ++r)
+					if (std::abs(a[c][r] - b[c][r]) > 1e-4f * std::max(1.0f, std::abs(a[c][r])))
+						identical = false;
+		}
+	};
+
+	//rotates every step-th node a little further, updates and returns the average milliseconds per frame
+	auto timeLinked = [&](unsigned int step)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (unsigned int frame = 0; frame < frames; ++frame)
+		{
+			for (unsigned int i = 0; step && i < nodeCount; i += step)
+				linked[i]->transform.setLocalRotation(linked[i]->transform.getLocalRotation() + glm::vec3(0.0f, 1.0f, 0.0f));
+			root->updateSelfAndChild();
+		}
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+	};
+	auto timeScene = [&](unsigned int step)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (unsigned int frame = 0; frame < frames; ++frame)
+		{
+			for (unsigned int i = 0; step && i < nodeCount; i += step)
+				scene.setLocalRotation(i, scene.getLocalRotation(i) + glm::vec3(0.0f, 1.0f, 0.0f));
+			scene.update();
+		}
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+	};
+
+	std::cout << "SCENE GRAPH BENCHMARK: " << nodeCount << " nodes, " << FANOUT << " children per node, average of " << frames << " frames" << std::endl;
+	const char* names[3] = { "root rotated:   ", "1% rotated:     ", "nothing changed:" };
+	const unsigned int steps[3] = { nodeCount, 100, 0 };
+	for (int test = 0; test < 3; ++test)
+	{
+		const double linkedTime = timeLinked(steps[test]);
+		const double sceneTime = timeScene(steps[test]);
+		compare();
+		std::cout << "  " << names[test] << " linked nodes " << linkedTime << " ms, SceneGraph " << sceneTime << " ms" << std::endl;
+	}
+	std::cout << (identical ? "  world matrices identical" : "  world matrices differ") << std::endl;
+	return identical;
+}
+
+// parent indices (-1 for roots) of a synthetic hierarchy of nodeCount nodes. Without forest it's one tree with eight
+// children per node, as above; with forest it looks more like a level full of objects: objects of 1 to 200 nodes are
+// added one after the other, the way loading them would, and every node of an object but its root hangs below one of
+// the object's earlier nodes, which gives many subtrees of very different sizes and depths
+// ---------------------------------------------------------------------------------------------------------
+std::vector<int> generateHierarchy(unsigned int nodeCount, bool forest)
+{
+	const unsigned int FANOUT = 8;
+	std::vector<int> parents(nodeCount, -1);
+	std::mt19937 rng(3);
+	unsigned int objectStart = 0, objectEnd = 0;
+	for (unsigned int i = 1; i < nodeCount; ++i)
+	{
+		if (!forest)
+			parents[i] = (i - 1) / FANOUT;
+		else if (i >= objectEnd)
+		{
+			objectStart = i;
+			objectEnd = i + 1 + rng() % 200;
+		}
+		else
+			parents[i] = objectStart + rng() % (i - objectStart);
+	}
+	return parents;
+}
+
+// builds both synthetic hierarchies as headless SceneGraphs and times, on a JobSystem of every size from 1 thread to
+// one per hardware thread, frames updates of every node, frames updates after 1% of the nodes moved, and culling
+// against a camera frustum. Prints the times and the speedup over 1 thread, and returns whether every size gave the
+// same world matrices and the same visible nodes as 1 thread.
+// ---------------------------------------------------------------------------------------------------------
+bool runSceneGraphScaling(unsigned int nodeCount, unsigned int frames)
+{
+	const AABB unitBox(glm::vec3(-1.0f), glm::vec3(1.0f));
+	const unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+	Camera viewer(glm::vec3(0.0f, 2.0f, 12.0f));
+	const Frustum frustum = createFrustumFromCamera(viewer, (float)SCR_WIDTH / (float)SCR_HEIGHT, glm::radians(viewer.Zoom), 0.1f, 100.0f);
+	std::cout << "SCENE GRAPH SCALING: " << nodeCount << " nodes, 1 to " << maxThreads << " threads, average of " << frames << " frames" << std::endl;
+
+	bool identical = true;
+	const char* shapes[2] = { "tree", "forest" };
+	for (int shape = 0; shape < 2; ++shape)
+	{
+		const std::vector<int> parents = generateHierarchy(nodeCount, shape == 1);
+		SceneGraph scene;
+		scene.reserve(nodeCount);
+		for (unsigned int i = 0; i < nodeCount; ++i)
+		{
+			scene.addNode(unitBox, nullptr, parents[i]);
+			scene.setLocalPosition(i, glm::vec3(2.0f * std::cos(float(i)), 0.1f * (i % 7), 2.0f * std::sin(float(i))));
+			scene.setLocalRotation(i, glm::vec3(0.0f, float(i * 7 % 360), 0.0f));
+			scene.setLocalScale(i, glm::vec3(0.9f));
+		}
+		scene.update();
+		scene.getBvh(); //built here so that the culling times don't include it
+
+		std::vector<glm::mat4> referenceMatrices;
+		std::vector<unsigned int> referenceVisible;
+		double referenceTimes[3] = {};
+		for (unsigned int threads = 1; threads <= maxThreads; ++threads)
+		{
+			JobSystem jobs(threads);
+			scene.setJobSystem(&jobs);
+
+			//every node, then every hundredth node rotated a little further, then culling
+			double times[3] = {};
+			auto start = std::chrono::steady_clock::now();
+			for (unsigned int frame = 0; frame < frames; ++frame)
+				scene.forceUpdate();
+			times[0] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+			start = std::chrono::steady_clock::now();
+			for (unsigned int frame = 0; frame < frames; ++frame)
+			{
+				for (unsigned int i = 0; i < nodeCount; i += 100)
+					scene.setLocalRotation(i, scene.getLocalRotation(i) + glm::vec3(0.0f, 1.0f, 0.0f));
+				scene.update();
+			}
+			times[1] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+			size_t visible = 0;
+			start = std::chrono::steady_clock::now();
+			for (unsigned int frame = 0; frame < frames; ++frame)
+				visible = scene.cull(frustum).size();
+			times[2] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+
+			//every size has rotated the same nodes by the same amount since the first one, so the world matches
+			//once the rotations of the earlier sizes are undone
+			for (unsigned int i = 0; i < nodeCount; i += 100)
+				scene.setLocalRotation(i, scene.getLocalRotation(i) - glm::vec3(0.0f, float(frames), 0.0f));
+			scene.update();
+			std::vector<unsigned int> visibleNodes = scene.cull(frustum);
+			std::sort(visibleNodes.begin(), visibleNodes.end());
+			if (threads == 1)
+			{
+				referenceMatrices = scene.getModelMatrices();
+				referenceVisible = visibleNodes;
+				std::copy(times, times + 3, referenceTimes);
+			}
+			else
+				identical = identical && scene.getModelMatrices() == referenceMatrices && visibleNodes == referenceVisible;
+
+			std::cout << "  " << shapes[shape] << ", " << threads << (threads == 1 ? " thread:  " : " threads: ")
+				<< "all nodes " << times[0] << " ms (" << referenceTimes[0] / times[0] << "x), 1% moved " << times[1]
+				<< " ms (" << referenceTimes[1] / times[1] << "x), cull " << times[2] << " ms (" << referenceTimes[2] / times[2]
+				<< "x, " << visible << " visible)" << std::endl;
+		}
+		scene.setJobSystem(nullptr);
+	}
+	std::cout << (identical ? "  every thread count gave the same world and visible nodes" : "  thread counts disagree") << std::endl;
+	return identical;
+}
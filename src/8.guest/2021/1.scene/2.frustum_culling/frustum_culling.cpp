@@ -26,12 +26,19 @@ public:
 #endif
 
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
+#include <string>
+#include <vector>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow* window);
+bool runBvhBenchmark(unsigned int nodeCount);
 
 // settings
 const unsigned int SCR_WIDTH = 800;
@@ -48,8 +55,19 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
-int main()
+int main(int argc, char* argv[])
 {
+	// "--bvh-benchmark [nodes]" times building, refitting and culling the bounding volume hierarchy of a grid of
+	// nodes like this demo's, scaled up, and exits; it doesn't need a window
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::string(argv[i]) == "--bvh-benchmark")
+		{
+			unsigned int nodeCount = i + 1 < argc ? std::atoi(argv[i + 1]) : 1000000;
+			return runBvhBenchmark(nodeCount > 0 ? nodeCount : 1000000) ? 0 : 1;
+		}
+	}
+
 	// glfw: initialize and configure
 	// ------------------------------
 	glfwInit();
@@ -102,27 +120,34 @@ int main()
 	// load entities
 	// -----------
 	Model model(FileSystem::getPath("resources/objects/planet/planet.obj"));
-	Entity ourEntity(model);
-	ourEntity.transform.setLocalPosition({ 0, 0, 0 });
+	SceneGraph scene;
+	scene.setJobSystem(&JobSystem::Shared());
+	Entity ourEntity(scene, model);
+	ourEntity.setLocalPosition({ 0, 0, 0 });
 	const float scale = 1.0;
-	ourEntity.transform.setLocalScale({ scale, scale, scale });
+	ourEntity.setLocalScale({ scale, scale, scale });
 
 	{
-		Entity* lastEntity = &ourEntity;
+		Entity lastEntity = ourEntity;
 
 		for (unsigned int x = 0; x < 20; ++x)
 		{
 			for (unsigned int z = 0; z < 20; ++z)
 			{
-				ourEntity.addChild(model);
-				lastEntity = ourEntity.children.back().get();
+				lastEntity = ourEntity.addChild(model);
 
 				//Set transform values
-				lastEntity->transform.setLocalPosition({ x * 10.f - 100.f,  0.f, z * 10.f - 100.f });
+				lastEntity.setLocalPosition({ x * 10.f - 100.f,  0.f, z * 10.f - 100.f });
 			}
 		}
 	}
-	ourEntity.updateSelfAndChild();
+	scene.update();
+
+	// draws are collected in a queue and issued sorted by GL state
+	GLRenderBackend glBackend;
+	RenderStateCache renderState(glBackend);
+	RenderQueue renderQueue;
+	renderQueue.SetDepthRange(0.1f, 100.0f);
 
 	// draw in wireframe
 	//glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -164,11 +189,13 @@ int main()
 
 		// draw our scene graph
 		unsigned int total = 0, display = 0;
-		ourEntity.drawSelfAndChild(camFrustum, ourShader, display, total);
+		scene.submit(camFrustum, ourShader, camera.Position, renderQueue, display, total);
+		renderState.Invalidate(); // ourShader.use() above went around the cache
+		renderQueue.Flush(renderState);
 		std::cout << "Total process in CPU : " << total << " / Total send to GPU : " << display << std::endl;
 
-		//ourEntity.transform.setLocalRotation({ 0.f, ourEntity.transform.getLocalRotation().y + 20 * deltaTime, 0.f });
-		ourEntity.updateSelfAndChild();
+		//ourEntity.setLocalRotation({ 0.f, ourEntity.getLocalRotation().y + 20 * deltaTime, 0.f });
+		scene.update();
 
 		// glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
 		// -------------------------------------------------------------------------------
@@ -176,6 +203,10 @@ int main()
 		glfwPollEvents();
 	}
 
+	// de-allocate the model's textures while the OpenGL context still exists
+	// ----------------------------------------------------------------------
+	model.Unload();
+
 	// glfw: terminate, clearing all previously allocated GLFW resources.
 	// ------------------------------------------------------------------
 	glfwTerminate();
@@ -234,3 +265,90 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 {
 	camera.ProcessMouseScroll(yoffset);
 }
+
+// lays out nodeCount unit boxes on a square grid with the spacing of the demo's planets and times, on one thread:
+// building the BVH, refitting it after 1% of the boxes moved, refitting it after all of them moved, and culling
+// the demo camera's frustum flat with FrustumCuller and through the BVH. Prints the times and returns whether the
+// BVH saw exactly the boxes the flat culler saw after the build and after each refit.
+// ---------------------------------------------------------------------------------------------------------
+bool runBvhBenchmark(unsigned int nodeCount)
+{
+	typedef std::chrono::steady_clock Clock;
+	auto elapsed = [](Clock::time_point start) { return std::chrono::duration<double, std::milli>(Clock::now() - start).count(); };
+	const int CULL_REPEATS = 20;
+
+	const unsigned int side = static_cast<unsigned int>(std::ceil(std::sqrt(double(nodeCount))));
+	CullingBoxes boxes;
+	boxes.Resize(nodeCount);
+	for (unsigned int i = 0; i < nodeCount; ++i)
+		boxes.Set(i, glm::vec3((i % side) * 10.f - side * 5.f, 0.f, (i / side) * 10.f - side * 5.f), glm::vec3(1.f));
+
+	const Camera benchmarkCamera(glm::vec3(0.0f, 10.0f, 0.0f));
+	const Frustum frustum = createFrustumFromCamera(benchmarkCamera, (float)SCR_WIDTH / (float)SCR_HEIGHT, glm::radians(benchmarkCamera.Zoom), 0.1f, 100.0f);
+	glm::vec4 planes[6];
+	getFrustumPlanes(frustum, planes);
+
+	std::vector<unsigned int> flatVisible(nodeCount), bvhVisible;
+	size_t flatCount = 0;
+	double flatTime = 0.0, bvhTime = 0.0;
+	BoundingVolumeHierarchy bvh;
+	bool identical = true;
+	//culls both ways, keeping the time of the last call of the repeats
+	auto cullBoth = [&]()
+	{
+		for (int repeat = 0; repeat < CULL_REPEATS; ++repeat)
+		{
+			auto start = Clock::now();
+			flatCount = FrustumCuller::Cull(planes, boxes, flatVisible.data());
+			flatTime = elapsed(start);
+			start = Clock::now();
+			bvhVisible.clear();
+			bvh.Cull(planes, bvhVisible);
+			bvhTime = elapsed(start);
+		}
+		std::sort(bvhVisible.begin(), bvhVisible.end());
+		if (!std::equal(bvhVisible.begin(), bvhVisible.end(), flatVisible.begin(), flatVisible.begin() + flatCount) || bvhVisible.size() != flatCount)
+			identical = false;
+	};
+
+	auto start = Clock::now();
+	bvh.Build(boxes);
+	const double buildTime = elapsed(start);
+	cullBoth();
+
+	std::cout << "BVH BENCHMARK: " << nodeCount << " boxes on a " << side << " x " << side << " grid" << std::endl;
+	std::cout << "  build:                " << buildTime << " ms" << std::endl;
+	std::cout << "  cull, flat:           " << flatTime << " ms, " << flatCount << " visible" << std::endl;
+	std::cout << "  cull, BVH:            " << bvhTime << " ms" << std::endl;
+
+	//every hundredth box drifts sideways by a fraction of the grid spacing
+	std::vector<unsigned int> moved;
+	for (unsigned int i = 0; i < nodeCount; i += 100)
+	{
+		boxes.CenterX[i] += 3.f;
+		boxes.CenterZ[i] -= 2.f;
+		moved.push_back(i);
+	}
+	start = Clock::now();
+	bvh.Refit(boxes, moved);
+	const double partialRefitTime = elapsed(start);
+	cullBoth();
+	std::cout << "  refit, 1% moved:      " << partialRefitTime << " ms" << std::endl;
+	std::cout << "  cull after refit:     flat " << flatTime << " ms, BVH " << bvhTime << " ms" << std::endl;
+
+	//the whole grid shifts and every box grows
+	for (unsigned int i = 0; i < nodeCount; ++i)
+	{
+		boxes.CenterX[i] += 1.f;
+		boxes.ExtentY[i] *= 2.f;
+	}
+	start = Clock::now();
+	bvh.Refit(boxes);
+	const double fullRefitTime = elapsed(start);
+	cullBoth();
+	std::cout << "  refit, all moved:     " << fullRefitTime << " ms" << std::endl;
+	std::cout << "  cull after refit:     flat " << flatTime << " ms, BVH " << bvhTime << " ms" << std::endl;
+
+	std::cout << (identical ? "  visible sets identical" : "  visible sets differ") << std::endl;
+	return identical;
+}
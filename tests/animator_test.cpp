@@ -0,0 +1,176 @@
+// Checks the pose blending in Animator on generated clips over a root -> arm hierarchy: a cross-fade mixes the
+// two clips by the time elapsed, additive layers add their motion scaled by their weight, with or without a clip
+// playing underneath, a reference pose scaled to zero doesn't poison the result, and once warmed up an update
+// doesn't allocate; PoseArena serves a frame that doesn't fit from overflow blocks and fits it from then on.
+#include <learnopengl/animator.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <new>
+#include <string>
+
+#include "test_common.h"
+
+// every heap allocation in the process, so the test can tell whether updates allocate
+size_t allocations = 0;
+
+void *operator new(size_t size)
+{
+    allocations++;
+    if (void *memory = std::malloc(size ? size : 1))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+// a clip of 10 ticks at 10 ticks per second in which the arm, one unit along x from the root in its bind pose,
+// moves and scales linearly from the first key to the second
+Animation makeClip(const glm::vec3 &positionFrom, const glm::vec3 &positionTo, const glm::vec3 &scaleFrom = glm::vec3(1.0f),
+    const glm::vec3 &scaleTo = glm::vec3(1.0f))
+{
+    aiNode root("root");
+    aiNode *arm = new aiNode("arm");
+    arm->mTransformation = aiMatrix4x4(1, 0, 0, 1, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1);
+    arm->mParent = &root;
+    root.mNumChildren = 1;
+    root.mChildren = new aiNode*[1] { arm };
+
+    aiNodeAnim *channel = new aiNodeAnim();
+    channel->mNodeName = aiString("arm");
+    channel->mNumPositionKeys = channel->mNumRotationKeys = channel->mNumScalingKeys = 2;
+    channel->mPositionKeys = new aiVectorKey[2] { aiVectorKey(0.0, aiVector3D(positionFrom.x, positionFrom.y, positionFrom.z)),
+                                                  aiVectorKey(10.0, aiVector3D(positionTo.x, positionTo.y, positionTo.z)) };
+    channel->mRotationKeys = new aiQuatKey[2] { aiQuatKey(0.0, aiQuaternion()), aiQuatKey(10.0, aiQuaternion()) };
+    channel->mScalingKeys = new aiVectorKey[2] { aiVectorKey(0.0, aiVector3D(scaleFrom.x, scaleFrom.y, scaleFrom.z)),
+                                                 aiVectorKey(10.0, aiVector3D(scaleTo.x, scaleTo.y, scaleTo.z)) };
+    aiAnimation clip;
+    clip.mDuration = 10.0;
+    clip.mTicksPerSecond = 10.0;
+    clip.mNumChannels = 1;
+    clip.mChannels = new aiNodeAnim*[1] { channel };
+
+    std::map<std::string, BoneInfo> boneInfoMap;
+    boneInfoMap["arm"] = BoneInfo{ 0, glm::mat4(1.0f) };
+    int boneCount = 1;
+    return Animation(&clip, &root, boneInfoMap, boneCount);
+}
+
+glm::vec3 armPosition(const Animator &animator)
+{
+    return glm::vec3(animator.GetFinalBoneMatrices()[0][3]);
+}
+
+bool near(const glm::vec3 &a, const glm::vec3 &b)
+{
+    return glm::length(a - b) < 1e-4f;
+}
+
+int main()
+{
+    Animation still = makeClip(glm::vec3(0.0f), glm::vec3(0.0f));
+    Animation away = makeClip(glm::vec3(10.0f, 0.0f, 0.0f), glm::vec3(10.0f, 0.0f, 0.0f));
+    Animation raise = makeClip(glm::vec3(0.0f), glm::vec3(0.0f, 4.0f, 0.0f));
+
+    // a cross-fade moves from one clip to the other by the fraction of the fade that has passed
+    {
+        Animator animator(&still);
+        animator.UpdateAnimation(0.1f);
+        CHECK(near(armPosition(animator), glm::vec3(0.0f)));
+        animator.CrossFade(&away, 1.0f);
+        animator.UpdateAnimation(0.25f);
+        CHECK(near(armPosition(animator), glm::vec3(2.5f, 0.0f, 0.0f)));
+        animator.UpdateAnimation(0.5f);
+        CHECK(near(armPosition(animator), glm::vec3(7.5f, 0.0f, 0.0f)));
+        animator.UpdateAnimation(0.5f);
+        CHECK(near(armPosition(animator), glm::vec3(10.0f, 0.0f, 0.0f)));
+    }
+
+    // rotations blend along the shortest arc
+    {
+        PoseArena arena;
+        LocalPose a = LocalPose::Allocate(arena, 1), b = LocalPose::Allocate(arena, 1);
+        a.translations[0] = b.translations[0] = glm::vec3(0.0f);
+        a.scales[0] = b.scales[0] = glm::vec3(1.0f);
+        a.rotations[0] = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+        b.rotations[0] = glm::angleAxis(glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+        BlendPoses(a, b, 0.5f);
+        CHECK(std::abs(glm::degrees(glm::angle(a.rotations[0])) - 45.0f) < 1e-3f);
+    }
+
+    // an additive layer adds how far it has moved from its first frame, scaled by its weight
+    {
+        Animator animator(&still);
+        const int layer = animator.AddAdditiveLayer(&raise, 0.5f);
+        animator.UpdateAnimation(0.5f);
+        CHECK(near(armPosition(animator), glm::vec3(0.0f, 1.0f, 0.0f)));
+        animator.SetLayerWeight(layer, 0.0f);
+        animator.UpdateAnimation(0.1f);
+        CHECK(near(armPosition(animator), glm::vec3(0.0f)));
+    }
+
+    // without a clip playing the layer moves the bind pose
+    {
+        Animator animator(nullptr);
+        animator.AddAdditiveLayer(&raise);
+        animator.UpdateAnimation(0.5f);
+        CHECK(near(armPosition(animator), glm::vec3(1.0f, 2.0f, 0.0f)));
+    }
+
+    // a layer whose first frame is scaled to zero on x leaves x alone instead of dividing by zero
+    {
+        Animation grow = makeClip(glm::vec3(0.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 1.0f), glm::vec3(2.0f, 3.0f, 1.0f));
+        Animator animator(&still);
+        animator.AddAdditiveLayer(&grow);
+        animator.UpdateAnimation(0.5f);
+        const glm::mat4 &matrix = animator.GetFinalBoneMatrices()[0];
+        bool finite = true;
+        for (int column = 0; column < 4; column++)
+            for (int row = 0; row < 4; row++)
+                finite = finite && std::isfinite(matrix[column][row]);
+        CHECK(finite);
+        CHECK(near(glm::vec3(glm::length(glm::vec3(matrix[0])), glm::length(glm::vec3(matrix[1])), glm::length(glm::vec3(matrix[2]))),
+                   glm::vec3(1.0f, 2.0f, 1.0f)));
+    }
+
+    // a cross-fade with a layer on top uses the pose arena for three poses a frame, but once the first frame
+    // has been through no update allocates any more
+    {
+        Animator animator(&still);
+        animator.CrossFade(&away, 100.0f);
+        animator.AddAdditiveLayer(&raise, 0.5f);
+        animator.UpdateAnimation(0.01f);
+        const size_t before = allocations;
+        for (int frame = 0; frame < 1000; frame++)
+            animator.UpdateAnimation(0.01f);
+        CHECK(allocations == before);
+    }
+
+    // a frame that doesn't fit into the arena spills into overflow blocks; Reset grows the arena so the same
+    // frame fits without allocating
+    {
+        PoseArena arena(64);
+        for (int frame = 0; frame < 3; frame++)
+        {
+            arena.Reset();
+            const size_t before = allocations;
+            for (int pose = 0; pose < 3; pose++)
+                LocalPose::Allocate(arena, 20);
+            if (frame == 0)
+                CHECK(allocations > before && arena.GetUsed() > arena.GetCapacity());
+            else
+                CHECK(allocations == before && arena.GetUsed() <= arena.GetCapacity());
+        }
+    }
+
+    return TestResult();
+}
@@ -0,0 +1,155 @@
+// Checks that the batched frustum culling agrees with AABB::isOnFrustum box for box: FrustumCuller::Cull (AVX, SSE
+// or scalar, whichever this build picked) and CullScalar on random boxes against random camera frustums, boxes
+// exactly touching or just missing a plane, partial SIMD batches, and SceneGraph::cull, which goes through the
+// bounding volume hierarchy.
+#include <learnopengl/shader_m.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/model.h>
+#include <learnopengl/entity.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "test_common.h"
+
+// the visible indices AABB::isOnFrustum gives, in ascending order
+std::vector<unsigned int> referenceCull(const Frustum &frustum, const CullingBoxes &boxes)
+{
+    std::vector<unsigned int> visible;
+    for (size_t i = 0; i < boxes.Size(); i++)
+    {
+        const AABB box(glm::vec3(boxes.CenterX[i], boxes.CenterY[i], boxes.CenterZ[i]), boxes.ExtentX[i], boxes.ExtentY[i], boxes.ExtentZ[i]);
+        if (box.isOnFrustum(frustum))
+            visible.push_back(static_cast<unsigned int>(i));
+    }
+    return visible;
+}
+
+std::vector<unsigned int> batchCull(const Frustum &frustum, const CullingBoxes &boxes, bool scalar)
+{
+    glm::vec4 planes[6];
+    getFrustumPlanes(frustum, planes);
+    std::vector<unsigned int> visible(boxes.Size());
+    visible.resize(scalar ? FrustumCuller::CullScalar(planes, boxes, visible.data()) : FrustumCuller::Cull(planes, boxes, visible.data()));
+    return visible;
+}
+
+// a camera at a random spot looking in a random direction, with a random field of view
+Frustum randomFrustum(std::mt19937 &rng)
+{
+    std::uniform_real_distribution<float> position(-20.0f, 20.0f), angle(-180.0f, 180.0f), pitch(-80.0f, 80.0f), fov(30.0f, 90.0f);
+    Camera camera(glm::vec3(position(rng), position(rng), position(rng)), glm::vec3(0.0f, 1.0f, 0.0f), angle(rng), pitch(rng));
+    return createFrustumFromCamera(camera, 4.0f / 3.0f, glm::radians(fov(rng)), 0.1f, 50.0f);
+}
+
+// the box -size..size on every axis, with inward facing planes
+Frustum boxFrustum(float size)
+{
+    Frustum frustum;
+    frustum.leftFace = { glm::vec3(-size, 0.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f) };
+    frustum.rightFace = { glm::vec3(size, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f) };
+    frustum.bottomFace = { glm::vec3(0.0f, -size, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) };
+    frustum.topFace = { glm::vec3(0.0f, size, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f) };
+    frustum.nearFace = { glm::vec3(0.0f, 0.0f, -size), glm::vec3(0.0f, 0.0f, 1.0f) };
+    frustum.farFace = { glm::vec3(0.0f, 0.0f, size), glm::vec3(0.0f, 0.0f, -1.0f) };
+    return frustum;
+}
+
+int main()
+{
+    std::mt19937 rng(12345);
+    std::cout << "frustum culler batch width " << FrustumCuller::GetBatchWidth() << std::endl;
+
+    // random boxes, rotated and scaled the way SceneGraph makes its world bounds; 1003 leaves a partial batch
+    CullingBoxes boxes;
+    {
+        std::uniform_real_distribution<float> position(-40.0f, 40.0f), size(0.05f, 3.0f), angle(-180.0f, 180.0f);
+        const AABB local(glm::vec3(-1.0f), glm::vec3(1.0f));
+        boxes.Resize(1003);
+        for (size_t i = 0; i < boxes.Size(); i++)
+        {
+            const glm::mat4 model = composeTRS(glm::vec3(position(rng), position(rng), position(rng)), glm::vec3(angle(rng), angle(rng), angle(rng)), glm::vec3(size(rng), size(rng), size(rng)));
+            const AABB world = local.getGlobalAABB(model);
+            boxes.Set(i, world.center, world.extents);
+        }
+    }
+    size_t visibleTotal = 0;
+    for (int test = 0; test < 50; test++)
+    {
+        const Frustum frustum = randomFrustum(rng);
+        const std::vector<unsigned int> expected = referenceCull(frustum, boxes);
+        CHECK(batchCull(frustum, boxes, false) == expected);
+        CHECK(batchCull(frustum, boxes, true) == expected);
+        visibleTotal += expected.size();
+    }
+    // the cameras must see some of the boxes but not all of them for the comparison to mean anything
+    CHECK(visibleTotal > 0 && visibleTotal < 50 * boxes.Size());
+
+    // boxes whose side lies exactly on a plane count as visible, the same boxes moved a little further out don't
+    {
+        const Frustum frustum = boxFrustum(5.0f);
+        const glm::vec3 axes[3] = { glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f) };
+        CullingBoxes touching;
+        std::vector<unsigned int> expected;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            for (float side : { -1.0f, 1.0f })
+            {
+                for (float gap : { 0.0f, 0.001f })
+                {
+                    const size_t i = touching.Size();
+                    touching.Resize(i + 1);
+                    touching.Set(i, axes[axis] * side * (6.0f + gap), glm::vec3(1.0f));
+                    if (gap == 0.0f)
+                        expected.push_back(static_cast<unsigned int>(i));
+                }
+            }
+        }
+        CHECK(referenceCull(frustum, touching) == expected);
+        CHECK(batchCull(frustum, touching, false) == expected);
+        CHECK(batchCull(frustum, touching, true) == expected);
+    }
+
+    // every count up to two AVX batches and a bit, so each partial batch size is covered
+    for (size_t count = 0; count <= 19; count++)
+    {
+        CullingBoxes subset;
+        subset.Resize(count);
+        for (size_t i = 0; i < count; i++)
+            subset.Set(i, glm::vec3(boxes.CenterX[i], boxes.CenterY[i], boxes.CenterZ[i]), glm::vec3(boxes.ExtentX[i], boxes.ExtentY[i], boxes.ExtentZ[i]));
+        const Frustum frustum = boxFrustum(20.0f);
+        const std::vector<unsigned int> expected = referenceCull(frustum, subset);
+        CHECK(batchCull(frustum, subset, false) == expected);
+        CHECK(batchCull(frustum, subset, true) == expected);
+    }
+
+    // SceneGraph::cull finds the nodes through its hierarchy; it has to give the same set as testing every node
+    {
+        SceneGraph scene;
+        std::uniform_real_distribution<float> offset(-6.0f, 6.0f), angle(-180.0f, 180.0f);
+        const AABB local(glm::vec3(-0.5f), glm::vec3(0.5f));
+        for (int i = 0; i < 2000; i++)
+        {
+            const int node = scene.addNode(local, nullptr, i < 20 ? -1 : static_cast<int>(rng() % i));
+            scene.setLocalPosition(node, glm::vec3(offset(rng), offset(rng), offset(rng)));
+            scene.setLocalRotation(node, glm::vec3(0.0f, angle(rng), 0.0f));
+        }
+        scene.update();
+        for (int test = 0; test < 20; test++)
+        {
+            const Frustum frustum = randomFrustum(rng);
+            std::vector<unsigned int> visible = scene.cull(frustum);
+            std::sort(visible.begin(), visible.end());
+            std::vector<unsigned int> expected;
+            for (int node = 0; node < static_cast<int>(scene.size()); node++)
+            {
+                if (scene.isOnFrustum(frustum, node))
+                    expected.push_back(static_cast<unsigned int>(node));
+            }
+            CHECK(visible == expected);
+        }
+    }
+
+    return TestResult();
+}
@@ -0,0 +1,225 @@
+// Checks the CPU side of the text rendering in glyph_atlas.h: SkylinePacker never overlaps rectangles or leaves
+// the page and fails once the page is full, DecodeUtf8 decodes multibyte sequences and turns malformed ones into
+// U+FFFD, and LayoutText places glyph quads in both y directions, skips glyphs the lookup doesn't have and starts
+// a new line at '\n'.
+#include <learnopengl/glyph_atlas.h>
+
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "test_common.h"
+
+bool overlaps(const glm::ivec4 &a, const glm::ivec4 &b)
+{
+    return a.x < b.x + b.z && b.x < a.x + a.z && a.y < b.y + b.w && b.y < a.y + a.w;
+}
+
+// decodes all of text, one code point per call
+std::vector<char32_t> decode(const std::string &text)
+{
+    std::vector<char32_t> codepoints;
+    for (size_t pos = 0; pos < text.size(); )
+        codepoints.push_back(DecodeUtf8(text, pos));
+    return codepoints;
+}
+
+// a glyph of size.x x size.y pixels on page 0 whose texture coordinates are its size, so quads are easy to tell apart
+AtlasGlyph makeGlyph(glm::ivec2 size, glm::ivec2 bearing, float advance, int page = 0)
+{
+    AtlasGlyph glyph;
+    glyph.valid = true;
+    glyph.size = size;
+    glyph.bearing = bearing;
+    glyph.advance = advance;
+    glyph.page = page;
+    glyph.uvMin = glm::vec2(0.0f);
+    glyph.uvMax = glm::vec2(size);
+    return glyph;
+}
+
+// twice the signed area of the triangle; positive is counter-clockwise with y up
+float winding(const TextVertex &a, const TextVertex &b, const TextVertex &c)
+{
+    return (b.position.x - a.position.x) * (c.position.y - a.position.y) - (b.position.y - a.position.y) * (c.position.x - a.position.x);
+}
+
+int main()
+{
+    // random glyph sized rectangles until the page is full: none may overlap or stick out of the page
+    {
+        std::mt19937 rng(3);
+        std::uniform_int_distribution<int> size(1, 40);
+        for (int run = 0; run < 50; run++)
+        {
+            SkylinePacker packer(256, 256);
+            std::vector<glm::ivec4> packed;
+            long long area = 0;
+            int failures = 0;
+            while (failures < 20)
+            {
+                glm::ivec2 rect(size(rng), size(rng)), position;
+                if (!packer.Pack(rect.x, rect.y, position))
+                {
+                    failures++;
+                    continue;
+                }
+                packed.push_back(glm::ivec4(position, rect));
+                area += static_cast<long long>(rect.x) * rect.y;
+            }
+            bool inside = true, separate = true;
+            for (size_t i = 0; i < packed.size(); i++)
+            {
+                inside = inside && packed[i].x >= 0 && packed[i].y >= 0 && packed[i].x + packed[i].z <= 256 && packed[i].y + packed[i].w <= 256;
+                for (size_t j = i + 1; j < packed.size(); j++)
+                    separate = separate && !overlaps(packed[i], packed[j]);
+            }
+            CHECK(inside);
+            CHECK(separate);
+            CHECK(packer.Occupancy() == static_cast<float>(area) / (256.0f * 256.0f));
+            // a page filled with glyphs this size should be mostly used
+            CHECK(packer.Occupancy() > 0.7f);
+        }
+    }
+
+    // equal squares tile the page exactly, then nothing fits any more until Reset
+    {
+        SkylinePacker packer(64, 64);
+        glm::ivec2 position;
+        int packed = 0;
+        while (packed < 100 && packer.Pack(16, 16, position))
+            packed++;
+        CHECK(packed == 16);
+        CHECK(packer.Occupancy() == 1.0f);
+        CHECK(!packer.Pack(1, 1, position));
+        // empty rectangles need no room
+        CHECK(packer.Pack(0, 0, position) && position == glm::ivec2(0));
+        packer.Reset(64, 64);
+        CHECK(packer.Occupancy() == 0.0f);
+        CHECK(packer.Pack(64, 64, position) && position == glm::ivec2(0));
+        // too wide or too tall for the page never fits
+        packer.Reset(64, 64);
+        CHECK(!packer.Pack(65, 1, position));
+        CHECK(!packer.Pack(1, 65, position));
+        CHECK(!SkylinePacker().Pack(1, 1, position));
+    }
+
+    // well-formed UTF-8 of every length
+    {
+        CHECK(decode("A") == std::vector<char32_t>({ 'A' }));
+        CHECK(decode("\xC3\xA9") == std::vector<char32_t>({ 0xE9 }));              // e acute
+        CHECK(decode("\xE2\x82\xAC") == std::vector<char32_t>({ 0x20AC }));        // euro sign
+        CHECK(decode("\xF0\x9F\x98\x80") == std::vector<char32_t>({ 0x1F600 }));   // emoji
+        CHECK(decode("a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80z") == std::vector<char32_t>({ 'a', 0xE9, 0x20AC, 0x1F600, 'z' }));
+        CHECK(decode("\xF4\x8F\xBF\xBF") == std::vector<char32_t>({ 0x10FFFF }));  // the last code point
+        size_t pos = 1;
+        CHECK(DecodeUtf8("a\xE2\x82\xAC" "b", pos) == 0x20AC && pos == 4);
+    }
+
+    // malformed UTF-8 gives U+FFFD and skips one byte, so the next character still comes through
+    {
+        CHECK(decode("\x80" "a") == std::vector<char32_t>({ 0xFFFD, 'a' }));                   // stray continuation byte
+        CHECK(decode("\xE2\x82") == std::vector<char32_t>({ 0xFFFD, 0xFFFD }));                // truncated at the end
+        CHECK(decode("\xE2" "ab") == std::vector<char32_t>({ 0xFFFD, 'a', 'b' }));             // truncated by a new character
+        CHECK(decode("\xC0\xAF") == std::vector<char32_t>({ 0xFFFD, 0xFFFD }));                // overlong '/'
+        CHECK(decode("\xE0\x80\xAF") == std::vector<char32_t>({ 0xFFFD, 0xFFFD, 0xFFFD }));    // overlong '/' in three bytes
+        CHECK(decode("\xED\xA0\x80") == std::vector<char32_t>({ 0xFFFD, 0xFFFD, 0xFFFD }));    // UTF-16 surrogate
+        CHECK(decode("\xF4\x90\x80\x80") == std::vector<char32_t>({ 0xFFFD, 0xFFFD, 0xFFFD, 0xFFFD })); // above U+10FFFF
+        CHECK(decode("\xFF" "a") == std::vector<char32_t>({ 0xFFFD, 'a' }));                   // no such lead byte
+        // random bytes always decode, at most one code point per byte
+        std::mt19937 rng(11);
+        bool bounded = true;
+        for (int run = 0; run < 200; run++)
+        {
+            std::string bytes(rng() % 64, '\0');
+            for (char &byte : bytes)
+                byte = static_cast<char>(rng() & 0xFF);
+            bounded = bounded && decode(bytes).size() <= bytes.size();
+        }
+        CHECK(bounded);
+    }
+
+    // layout: 'A' is a regular glyph, ' ' has no bitmap, U+20AC is a multibyte one and U+FFFD stands in for
+    // malformed input; 'B' is never available
+    std::map<char32_t, AtlasGlyph> glyphs;
+    glyphs['A'] = makeGlyph(glm::ivec2(8, 10), glm::ivec2(1, 10), 10.0f);
+    glyphs[' '] = makeGlyph(glm::ivec2(0, 0), glm::ivec2(0, 0), 4.0f, -1);
+    glyphs[0x20AC] = makeGlyph(glm::ivec2(9, 11), glm::ivec2(0, 10), 12.0f);
+    glyphs[0xFFFD] = makeGlyph(glm::ivec2(6, 6), glm::ivec2(0, 6), 7.0f);
+    std::vector<char32_t> looked;
+    auto lookup = [&](char32_t codepoint) -> const AtlasGlyph* {
+        looked.push_back(codepoint);
+        std::map<char32_t, AtlasGlyph>::const_iterator it = glyphs.find(codepoint);
+        return it != glyphs.end() ? &it->second : nullptr;
+    };
+    LineMetrics metrics;
+    metrics.ascent = 12.0f;
+    metrics.lineHeight = 20.0f;
+
+    // y up: the quad hangs from the baseline by the bearing, everything scales around the pen
+    {
+        std::vector<TextVertex> vertices;
+        float end = LayoutText(lookup, metrics, "A", 100.0f, 50.0f, 2.0f, false, vertices);
+        CHECK(end == 120.0f);
+        CHECK(vertices.size() == 6);
+        if (vertices.size() == 6)
+        {
+            CHECK(vertices[0].position == glm::vec2(102.0f, 70.0f));  // top left
+            CHECK(vertices[2].position == glm::vec2(118.0f, 50.0f));  // bottom right
+            CHECK(vertices[0].texCoords == glm::vec2(0.0f) && vertices[2].texCoords == glm::vec2(8.0f, 10.0f));
+            CHECK(winding(vertices[0], vertices[1], vertices[2]) > 0.0f && winding(vertices[3], vertices[4], vertices[5]) > 0.0f);
+        }
+    }
+
+    // y down: the top of the line is ascent above the baseline, y grows downwards
+    {
+        std::vector<TextVertex> vertices;
+        LayoutText(lookup, metrics, "A", 0.0f, 0.0f, 1.0f, true, vertices);
+        CHECK(vertices.size() == 6);
+        if (vertices.size() == 6)
+        {
+            CHECK(vertices[0].position == glm::vec2(1.0f, 2.0f));
+            CHECK(vertices[2].position == glm::vec2(9.0f, 12.0f));
+            // counter-clockwise on screen is clockwise in these coordinates
+            CHECK(winding(vertices[0], vertices[1], vertices[2]) < 0.0f && winding(vertices[3], vertices[4], vertices[5]) < 0.0f);
+        }
+    }
+
+    // blanks advance without a quad, unavailable glyphs neither advance nor draw, multibyte and malformed
+    // input reach the lookup as their code point
+    {
+        std::vector<TextVertex> vertices;
+        looked.clear();
+        float end = LayoutText(lookup, metrics, "A B\xE2\x82\xAC\x80", 0.0f, 0.0f, 1.0f, false, vertices);
+        CHECK(looked == std::vector<char32_t>({ 'A', ' ', 'B', 0x20AC, 0xFFFD }));
+        CHECK(end == 10.0f + 4.0f + 12.0f + 7.0f);
+        CHECK(vertices.size() == 3 * 6);
+        if (vertices.size() == 3 * 6)
+        {
+            CHECK(vertices[6].position.x == 14.0f && vertices[6].page == 0.0f);  // the euro sign right after the space
+            CHECK(vertices[12].position.x == 26.0f);                             // U+FFFD after it
+        }
+    }
+
+    // '\n' goes back to the starting x one line further on, in the direction y grows, and isn't looked up
+    {
+        std::vector<TextVertex> down, up;
+        looked.clear();
+        float end = LayoutText(lookup, metrics, "AA\nA", 5.0f, 0.0f, 0.5f, true, down);
+        CHECK(end == 10.0f);
+        CHECK(looked == std::vector<char32_t>({ 'A', 'A', 'A' }));
+        CHECK(down.size() == 3 * 6);
+        if (down.size() == 3 * 6)
+            CHECK(down[12].position == glm::vec2(5.5f, 1.0f + 10.0f));
+        LayoutText(lookup, metrics, "A\n\nA", 5.0f, 100.0f, 1.0f, false, up);
+        CHECK(up.size() == 2 * 6);
+        if (up.size() == 2 * 6)
+            CHECK(up[6].position == glm::vec2(6.0f, 100.0f - 40.0f + 10.0f));
+        // a trailing newline leaves the pen at the start of the new, empty line
+        std::vector<TextVertex> trailing;
+        CHECK(LayoutText(lookup, metrics, "AA\n", 5.0f, 0.0f, 1.0f, true, trailing) == 5.0f);
+    }
+
+    return TestResult();
+}
@@ -0,0 +1,138 @@
+// Checks GlyphCache with FreeType and a font from resources/fonts: glyphs are missing until rasterized, the line
+// metrics come from the face without counting as lookups, and on a budget of two small pages full pages are
+// evicted least recently used first, with their glyphs rasterized again the next time they're asked for.
+#include <learnopengl/glyph_cache.h>
+
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "test_common.h"
+
+const char *FONT = "resources/fonts/Antonio-Bold.ttf";
+
+// the page GlyphCache::Update last wrote to, -1 if none; TakeDirtyRegion doesn't count as using a page
+int writtenPage(GlyphCache &cache)
+{
+    int written = -1;
+    glm::ivec4 region;
+    for (unsigned int page = 0; page < cache.GetPageCount(); page++)
+        if (cache.TakeDirtyRegion(page, region))
+            written = static_cast<int>(page);
+    return written;
+}
+
+int main()
+{
+    // glyphs show up after the worker has rasterized them; metrics come with the first glyph of a size
+    {
+        GlyphCache cache;
+        const unsigned int font = cache.AddFont(FONT);
+        CHECK(cache.GetLineMetrics(font, 32).lineHeight == 0.0f);
+        CHECK(cache.GetGlyph(font, 32, 'A') == nullptr);
+        CHECK(cache.GetGlyph(font, 32, 'A') == nullptr);
+        cache.Flush();
+        const AtlasGlyph *glyph = cache.GetGlyph(font, 32, 'A');
+        CHECK(glyph && glyph->valid && glyph->page == 0 && glyph->size.x > 0 && glyph->advance > 0.0f);
+        CHECK(cache.GetStats().misses == 2 && cache.GetStats().hits == 1 && cache.GetStats().rasterized == 1);
+        const LineMetrics metrics = cache.GetLineMetrics(font, 32);
+        CHECK(glyph && metrics.ascent >= static_cast<float>(glyph->bearing.y));
+        CHECK(metrics.lineHeight >= metrics.ascent);
+        CHECK(cache.GetLineMetrics(font, 33).lineHeight == 0.0f);
+        // asking for metrics is no lookup
+        CHECK(cache.GetStats().misses == 2 && cache.GetStats().hits == 1);
+
+        // y down layout only asks for the glyphs of the text
+        std::vector<TextVertex> vertices;
+        LayoutText(cache, font, 32, "AB\nA", 0.0f, 0.0f, 1.0f, true, vertices);
+        CHECK(vertices.size() == 2 * 6);
+        cache.Flush();
+        vertices.clear();
+        LayoutText(cache, font, 32, "AB\nA", 0.0f, 0.0f, 1.0f, true, vertices);
+        CHECK(vertices.size() == 3 * 6);
+        CHECK(cache.GetStats().rasterized == 2);
+        // the first line's glyphs stand on the baseline ascent below the top
+        glyph = cache.GetGlyph(font, 32, 'A');
+        if (glyph && vertices.size() == 3 * 6)
+        {
+            CHECK(vertices[0].position.y == metrics.ascent - glyph->bearing.y);
+            CHECK(vertices[12].position.y == vertices[0].position.y + metrics.lineHeight);
+        }
+    }
+
+    // two pages of 128 x 128 fill up quickly: glyphs of random sizes, one at a time, and watch where they go
+    {
+        GlyphCache cache(128, 2);
+        const unsigned int font = cache.AddFont(FONT);
+        const std::string characters = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+        std::mt19937 rng(5);
+        std::uniform_int_distribution<unsigned int> size(10, 48);
+        std::uniform_int_distribution<size_t> character(0, characters.size() - 1);
+        std::map<uint64_t, int> pageOf; // page of every glyph placed, until it's evicted
+        int lastPage = -1;
+        unsigned int evictions = 0;
+        bool recentPageKept = true, evictedGone = true, othersKept = true, rerasterized = true;
+        for (int request = 0; request < 400; request++)
+        {
+            const unsigned int pixelSize = size(rng);
+            const char32_t codepoint = characters[character(rng)];
+            const uint64_t key = (static_cast<uint64_t>(pixelSize) << 32) | codepoint;
+            if (pageOf.count(key))
+                continue;
+            // a miss, which doesn't use any page
+            CHECK(cache.GetGlyph(font, pixelSize, codepoint) == nullptr);
+            const unsigned long long evictedBefore = cache.GetStats().evictedPages;
+            cache.Flush();
+            const int page = writtenPage(cache);
+            if (cache.GetStats().evictedPages != evictedBefore)
+            {
+                evictions++;
+                // the page the previous glyph went to is the most recently used one and must be kept
+                recentPageKept = recentPageKept && page != lastPage;
+                // the evicted page's glyphs are gone and come back on request; the other page's are still there
+                std::vector<uint64_t> evicted;
+                for (std::map<uint64_t, int>::iterator it = pageOf.begin(); it != pageOf.end(); )
+                {
+                    if (it->second == page)
+                    {
+                        evicted.push_back(it->first);
+                        it = pageOf.erase(it);
+                    }
+                    else
+                        ++it;
+                }
+                for (const std::pair<const uint64_t, int> &placed : pageOf)
+                    othersKept = othersKept && cache.GetGlyph(font, static_cast<unsigned int>(placed.first >> 32), static_cast<char32_t>(placed.first & 0xFFFFFFFF)) != nullptr;
+                if (!evicted.empty())
+                {
+                    const unsigned int evictedSize = static_cast<unsigned int>(evicted[0] >> 32);
+                    const char32_t evictedCodepoint = static_cast<char32_t>(evicted[0] & 0xFFFFFFFF);
+                    evictedGone = evictedGone && cache.GetGlyph(font, evictedSize, evictedCodepoint) == nullptr;
+                    const unsigned long long rasterizedBefore = cache.GetStats().rasterized;
+                    cache.Flush();
+                    const AtlasGlyph *glyph = cache.GetGlyph(font, evictedSize, evictedCodepoint);
+                    rerasterized = rerasterized && glyph && cache.GetStats().rasterized == rasterizedBefore + 1;
+                    pageOf[evicted[0]] = glyph ? glyph->page : -1;
+                    // the lookups above used pages; the glyph placed last is what counts from here
+                    lastPage = writtenPage(cache);
+                    pageOf[key] = page;
+                    continue;
+                }
+            }
+            pageOf[key] = page;
+            lastPage = page;
+        }
+        CHECK(evictions > 5);
+        CHECK(recentPageKept);
+        CHECK(evictedGone);
+        CHECK(othersKept);
+        CHECK(rerasterized);
+        CHECK(cache.GetPageCount() == 2);
+        CHECK(cache.GetStats().evictedPages == evictions);
+        std::cout << evictions << " page evictions, " << cache.GetStats().evictedGlyphs << " glyphs evicted, "
+                  << cache.GetStats().rasterized << " rasterized" << std::endl;
+    }
+
+    return TestResult();
+}
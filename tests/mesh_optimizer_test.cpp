@@ -0,0 +1,129 @@
+// Checks the import-time optimizations of MeshOptimizer on a generated grid whose triangles come in
+// random order and whose vertices are duplicated per triangle, like an unindexed import: welding merges
+// the copies, the vertex cache order lowers the ACMR, and none of the steps changes the surface.
+#include <learnopengl/mesh_optimizer.h>
+
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+
+#include "test_common.h"
+
+const unsigned int GRID_SIZE = 64; // quads per side
+
+// every triangle as its three corner positions, rotated to start at the smallest one and sorted, so two
+// index buffers over different vertex buffers can be compared
+std::vector<std::array<float, 9>> triangleSet(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices)
+{
+    std::vector<std::array<float, 9>> triangles;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        std::array<std::array<float, 3>, 3> corners;
+        for (int k = 0; k < 3; k++)
+        {
+            const glm::vec3 &p = vertices[indices[i + k]].Position;
+            corners[k] = { p.x, p.y, p.z };
+        }
+        std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end()), corners.end());
+        std::array<float, 9> triangle;
+        for (int k = 0; k < 9; k++)
+            triangle[k] = corners[k / 3][k % 3];
+        triangles.push_back(triangle);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+bool indicesValid(const std::vector<unsigned int> &indices, size_t vertexCount)
+{
+    for (unsigned int index : indices)
+        if (index >= vertexCount)
+            return false;
+    return indices.size() % 3 == 0;
+}
+
+void buildShuffledGrid(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices)
+{
+    std::vector<std::array<glm::vec2, 3>> triangles;
+    for (unsigned int y = 0; y < GRID_SIZE; y++)
+    {
+        for (unsigned int x = 0; x < GRID_SIZE; x++)
+        {
+            const glm::vec2 p00(x, y), p10(x + 1, y), p01(x, y + 1), p11(x + 1, y + 1);
+            triangles.push_back({ p00, p10, p11 });
+            triangles.push_back({ p00, p11, p01 });
+        }
+    }
+    std::mt19937 random(7);
+    std::shuffle(triangles.begin(), triangles.end(), random);
+    for (const std::array<glm::vec2, 3> &triangle : triangles)
+    {
+        for (const glm::vec2 &corner : triangle)
+        {
+            Vertex vertex = {};
+            vertex.Position = glm::vec3(corner.x, 0.0f, corner.y);
+            vertex.Normal = glm::vec3(0.0f, 1.0f, 0.0f);
+            vertex.TexCoords = corner / static_cast<float>(GRID_SIZE);
+            indices.push_back(static_cast<unsigned int>(vertices.size()));
+            vertices.push_back(vertex);
+        }
+    }
+}
+
+int main()
+{
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;
+    buildShuffledGrid(vertices, indices);
+    const std::vector<std::array<float, 9>> surface = triangleSet(vertices, indices);
+    const size_t triangleCount = indices.size() / 3;
+
+    // welding leaves one vertex per grid point
+    MeshOptimizer::WeldVertices(vertices, indices);
+    CHECK(vertices.size() == (GRID_SIZE + 1) * (GRID_SIZE + 1));
+    CHECK(indicesValid(indices, vertices.size()));
+    CHECK(triangleSet(vertices, indices) == surface);
+
+    const VertexCacheStats before = MeshOptimizer::AnalyzeVertexCache(indices, vertices.size());
+    MeshOptimizer::OptimizeVertexCache(indices, vertices.size());
+    const VertexCacheStats after = MeshOptimizer::AnalyzeVertexCache(indices, vertices.size());
+    std::cout << "ACMR " << before.acmr << " -> " << after.acmr << ", ATVR " << before.atvr << " -> " << after.atvr << std::endl;
+    CHECK(after.triangles == triangleCount);
+    CHECK(after.acmr < before.acmr);
+    // a regular grid gets well below one transformed vertex per triangle with a 16 entry cache
+    CHECK(after.acmr < 0.8f);
+    CHECK(indicesValid(indices, vertices.size()));
+    CHECK(triangleSet(vertices, indices) == surface);
+
+    // the fetch order only renames vertices: they end up numbered in order of first use
+    MeshOptimizer::OptimizeVertexFetch(vertices, indices);
+    CHECK(indicesValid(indices, vertices.size()));
+    CHECK(triangleSet(vertices, indices) == surface);
+    unsigned int next = 0;
+    bool firstUseOrder = true;
+    for (unsigned int index : indices)
+    {
+        if (index > next)
+            firstUseOrder = false;
+        if (index == next)
+            next++;
+    }
+    CHECK(firstUseOrder);
+    CHECK(MeshOptimizer::AnalyzeVertexCache(indices, vertices.size()).transformedVertices == after.transformedVertices);
+
+    // Optimize runs the same steps; unreferenced vertices are dropped by the fetch pass
+    std::vector<Vertex> combinedVertices;
+    std::vector<unsigned int> combinedIndices;
+    buildShuffledGrid(combinedVertices, combinedIndices);
+    Vertex unused = {};
+    unused.Position = glm::vec3(-1.0f);
+    combinedVertices.push_back(unused);
+    MeshOptimizer::Optimize(combinedVertices, combinedIndices, MESH_OPTIMIZE_WELD | MESH_OPTIMIZE_VERTEX_CACHE | MESH_OPTIMIZE_VERTEX_FETCH);
+    CHECK(combinedVertices.size() == (GRID_SIZE + 1) * (GRID_SIZE + 1));
+    CHECK(indicesValid(combinedIndices, combinedVertices.size()));
+    CHECK(triangleSet(combinedVertices, combinedIndices) == surface);
+    CHECK(MeshOptimizer::AnalyzeVertexCache(combinedIndices, combinedVertices.size()).acmr < 0.8f);
+
+    return TestResult();
+}
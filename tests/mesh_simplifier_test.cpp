@@ -0,0 +1,147 @@
+// Checks MeshSimplifier on a bumpy closed sphere and on an open grid: every level of detail is a valid
+// index buffer into the original vertices, levels shrink as asked, the error reported for them is a real
+// bound on how far the original vertices are from the simplified surface and stays near the cap, and open
+// borders stay where they are.
+#include <learnopengl/mesh_simplifier.h>
+
+#include <cmath>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "test_common.h"
+
+bool indicesValid(const std::vector<unsigned int> &indices, size_t vertexCount)
+{
+    for (unsigned int index : indices)
+        if (index >= vertexCount)
+            return false;
+    return indices.size() % 3 == 0;
+}
+
+// icosphere with a low frequency bump on top, so the simplifier has curvature to preserve
+void buildBumpySphere(unsigned int subdivisions, std::vector<Vertex> &vertices, std::vector<unsigned int> &indices)
+{
+    const float t = (1.0f + std::sqrt(5.0f)) / 2.0f;
+    std::vector<glm::vec3> positions = {
+        { -1, t, 0 }, { 1, t, 0 }, { -1, -t, 0 }, { 1, -t, 0 }, { 0, -1, t }, { 0, 1, t },
+        { 0, -1, -t }, { 0, 1, -t }, { t, 0, -1 }, { t, 0, 1 }, { -t, 0, -1 }, { -t, 0, 1 }
+    };
+    indices = { 0, 11, 5, 0, 5, 1, 0, 1, 7, 0, 7, 10, 0, 10, 11, 1, 5, 9, 5, 11, 4, 11, 10, 2, 10, 7, 6, 7, 1, 8,
+                3, 9, 4, 3, 4, 2, 3, 2, 6, 3, 6, 8, 3, 8, 9, 4, 9, 5, 2, 4, 11, 6, 2, 10, 8, 6, 7, 9, 8, 1 };
+    for (unsigned int level = 0; level < subdivisions; level++)
+    {
+        std::map<std::pair<unsigned int, unsigned int>, unsigned int> midpoints;
+        auto midpoint = [&](unsigned int a, unsigned int b) {
+            const std::pair<unsigned int, unsigned int> key(std::min(a, b), std::max(a, b));
+            auto it = midpoints.find(key);
+            if (it != midpoints.end())
+                return it->second;
+            positions.push_back((positions[a] + positions[b]) * 0.5f);
+            const unsigned int index = static_cast<unsigned int>(positions.size() - 1);
+            midpoints[key] = index;
+            return index;
+        };
+        std::vector<unsigned int> subdivided;
+        for (size_t i = 0; i < indices.size(); i += 3)
+        {
+            const unsigned int a = indices[i], b = indices[i + 1], c = indices[i + 2];
+            const unsigned int ab = midpoint(a, b), bc = midpoint(b, c), ca = midpoint(c, a);
+            subdivided.insert(subdivided.end(), { a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca });
+        }
+        indices.swap(subdivided);
+    }
+    vertices.clear();
+    for (const glm::vec3 &position : positions)
+    {
+        Vertex vertex = {};
+        vertex.Normal = glm::normalize(position);
+        vertex.Position = vertex.Normal * (1.0f + 0.1f * std::sin(3.0f * vertex.Normal.x) * std::cos(2.0f * vertex.Normal.y));
+        vertices.push_back(vertex);
+    }
+}
+
+void buildGrid(unsigned int size, std::vector<Vertex> &vertices, std::vector<unsigned int> &indices)
+{
+    for (unsigned int y = 0; y <= size; y++)
+    {
+        for (unsigned int x = 0; x <= size; x++)
+        {
+            Vertex vertex = {};
+            vertex.Position = glm::vec3(x, 0.02f * std::sin(0.5f * x) * y, y);
+            vertex.Normal = glm::vec3(0.0f, 1.0f, 0.0f);
+            vertices.push_back(vertex);
+        }
+    }
+    for (unsigned int y = 0; y < size; y++)
+    {
+        for (unsigned int x = 0; x < size; x++)
+        {
+            const unsigned int i = y * (size + 1) + x;
+            indices.insert(indices.end(), { i, i + size + 1, i + size + 2, i, i + size + 2, i + 1 });
+        }
+    }
+}
+
+// builds levels of detail the way Model does: each one halves the target of the previous one and is
+// simplified from the full mesh
+void checkLodChain(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices, float maxError, const char *name)
+{
+    size_t target = indices.size();
+    size_t previousCount = indices.size();
+    for (unsigned int level = 1; level <= 4; level++)
+    {
+        target = target / 2 / 3 * 3;
+        float error = -1.0f;
+        const std::vector<unsigned int> lod = MeshSimplifier::Simplify(vertices, indices, target, maxError, &error);
+        const float distance = MeshSimplifier::MeasureDistance(vertices, indices, lod);
+        std::cout << name << " lod " << level << ": " << lod.size() / 3 << " triangles (target " << target / 3 << "), error "
+                  << error << ", measured distance " << distance << std::endl;
+        CHECK(indicesValid(lod, vertices.size()));
+        CHECK(!lod.empty());
+        CHECK(lod.size() < previousCount);
+        // the reported error bounds the measured distance from above
+        CHECK(distance <= error);
+        // the cap applies to quadric errors, distances to the planes of the original triangles rather than to
+        // the triangles themselves, so the surface may end up somewhat further away, but not by a multiple
+        CHECK(error <= maxError * 1.5f);
+        previousCount = lod.size();
+    }
+}
+
+int main()
+{
+    std::vector<Vertex> sphere;
+    std::vector<unsigned int> sphereIndices;
+    buildBumpySphere(4, sphere, sphereIndices);
+    checkLodChain(sphere, sphereIndices, 0.05f, "sphere");
+
+    // a zero error cap allows no collapse that moves the surface
+    float error = -1.0f;
+    const std::vector<unsigned int> exact = MeshSimplifier::Simplify(sphere, sphereIndices, sphereIndices.size() / 4, 0.0f, &error);
+    CHECK(exact.size() == sphereIndices.size());
+    CHECK(error == 0.0f);
+
+    // a target above the current size leaves the mesh alone
+    CHECK(MeshSimplifier::Simplify(sphere, sphereIndices, sphereIndices.size(), 1.0f) == sphereIndices);
+
+    std::vector<Vertex> grid;
+    std::vector<unsigned int> gridIndices;
+    const unsigned int gridSize = 32;
+    buildGrid(gridSize, grid, gridIndices);
+    checkLodChain(grid, gridIndices, 0.5f, "grid");
+    // border vertices are locked, so every one of them is still used by the coarsest level
+    const std::vector<unsigned int> coarse = MeshSimplifier::Simplify(grid, gridIndices, 0, 0.5f);
+    std::vector<bool> used(grid.size(), false);
+    for (unsigned int index : coarse)
+        used[index] = true;
+    bool bordersKept = true;
+    for (unsigned int y = 0; y <= gridSize; y++)
+        for (unsigned int x = 0; x <= gridSize; x++)
+            if ((x == 0 || y == 0 || x == gridSize || y == gridSize) && !used[y * (gridSize + 1) + x])
+                bordersKept = false;
+    CHECK(bordersKept);
+    CHECK(coarse.size() < gridIndices.size() / 4);
+
+    return TestResult();
+}
@@ -0,0 +1,185 @@
+// Checks RenderQueue and RenderStateCache through RecordingRenderBackend, so without a GL context: the radix sort
+// agrees with sorting the keys computed independently, draws of the same state go front to back, every submitted draw is
+// issued exactly once, and the state cache only lets through the binds that change something.
+#include <learnopengl/render_queue.h>
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "test_common.h"
+
+const unsigned int PROGRAMS = 3;
+const unsigned int MATERIALS = 4;
+const unsigned int VERTEX_ARRAYS = 5;
+const unsigned int DRAWS = 2000;
+
+struct Submitted
+{
+    unsigned int program, material, vao;
+    float depth;
+};
+
+int main()
+{
+    std::mt19937 rng(7);
+
+    // every material is a diffuse and a specular texture; material m uses texture ids 100 + 2m and 101 + 2m
+    std::vector<std::vector<Texture>> materials(MATERIALS);
+    const std::string samplerNames[2] = { "texture_diffuse1", "texture_specular1" };
+    for (unsigned int m = 0; m < MATERIALS; m++)
+    {
+        for (unsigned int t = 0; t < 2; t++)
+        {
+            Texture texture;
+            texture.id = 100 + 2 * m + t;
+            materials[m].push_back(texture);
+        }
+    }
+
+    RenderQueue queue;
+    queue.SetDepthRange(0.0f, 100.0f);
+    std::vector<Submitted> submitted;
+    std::uniform_int_distribution<unsigned int> program(0, PROGRAMS - 1), material(0, MATERIALS - 1), vao(0, VERTEX_ARRAYS - 1);
+    std::uniform_real_distribution<float> depth(0.0f, 100.0f);
+    for (unsigned int i = 0; i < DRAWS; i++)
+    {
+        // program ids and vertex arrays are GL names, so not starting at 0
+        Submitted draw = { 10 + program(rng), material(rng), 20 + vao(rng), depth(rng) };
+        RenderItem item;
+        item.vao = draw.vao;
+        item.textures = materials[draw.material].data();
+        item.samplerNames = samplerNames;
+        item.textureCount = 2;
+        item.indexCount = 36;
+        queue.Submit(draw.program, item, glm::mat4(1.0f), draw.depth);
+        submitted.push_back(draw);
+    }
+    CHECK(queue.Size() == DRAWS);
+
+    // the radix sort has to agree with sorting the keys
+    queue.Sort();
+    std::vector<uint64_t> sortedKeys;
+    for (size_t i = 0; i < queue.Size(); i++)
+        sortedKeys.push_back(queue.GetSortedKey(i));
+    CHECK(std::is_sorted(sortedKeys.begin(), sortedKeys.end()));
+    // programs and materials are numbered in order of first use, depths spread over 16 bits
+    std::vector<uint64_t> expectedKeys;
+    std::vector<unsigned int> programOrder, materialOrder;
+    for (const Submitted& draw : submitted)
+    {
+        if (std::find(programOrder.begin(), programOrder.end(), draw.program) == programOrder.end())
+            programOrder.push_back(draw.program);
+        if (std::find(materialOrder.begin(), materialOrder.end(), draw.material) == materialOrder.end())
+            materialOrder.push_back(draw.material);
+        const unsigned int programIndex = static_cast<unsigned int>(std::find(programOrder.begin(), programOrder.end(), draw.program) - programOrder.begin());
+        const unsigned int materialIndex = static_cast<unsigned int>(std::find(materialOrder.begin(), materialOrder.end(), draw.material) - materialOrder.begin());
+        expectedKeys.push_back(RenderQueue::MakeKey(programIndex, materialIndex, draw.vao, static_cast<unsigned int>(draw.depth / 100.0f * 65535.0f)));
+    }
+    std::sort(expectedKeys.begin(), expectedKeys.end());
+    CHECK(sortedKeys == expectedKeys);
+
+    // draw the queue and, for comparison, the same draws unsorted through their own state cache
+    RecordingRenderBackend sortedBackend, unsortedBackend;
+    RenderStateCache sortedState(sortedBackend), unsortedState(unsortedBackend);
+    queue.Flush(sortedState);
+    CHECK(queue.Size() == 0);
+    for (const Submitted& draw : submitted)
+    {
+        unsortedState.UseProgram(draw.program);
+        for (unsigned int t = 0; t < 2; t++)
+        {
+            unsortedState.SetUniform(unsortedState.GetUniformLocation(samplerNames[t]), static_cast<int>(t));
+            unsortedState.BindTexture(t, materials[draw.material][t].id);
+        }
+        unsortedState.SetUniform(unsortedState.GetUniformLocation("model"), glm::mat4(1.0f));
+        unsortedState.BindVertexArray(draw.vao);
+        unsortedState.DrawElements(36, 0);
+    }
+    unsortedState.Reset();
+
+    // every draw is issued once, and since the draws come grouped by state each program, texture set and vertex
+    // array is bound at most once per group
+    const RenderCallCounts& calls = sortedBackend.calls;
+    CHECK(calls.drawElements == DRAWS);
+    std::multiset<unsigned int> drawnArrays(sortedBackend.drawnVertexArrays.begin(), sortedBackend.drawnVertexArrays.end());
+    std::multiset<unsigned int> submittedArrays;
+    for (const Submitted& draw : submitted)
+        submittedArrays.insert(draw.vao);
+    CHECK(drawnArrays == submittedArrays);
+    CHECK(calls.useProgram == PROGRAMS);
+    CHECK(calls.bindVertexArray <= PROGRAMS * MATERIALS * VERTEX_ARRAYS + 1); // + 1 for unbinding at the end
+    CHECK(calls.bindTexture <= PROGRAMS * MATERIALS * 2);
+    // locations are looked up once per name and program; the sampler uniforms keep their value once set
+    CHECK(calls.getUniformLocation == PROGRAMS * 3);
+    CHECK(calls.uniform == DRAWS + PROGRAMS * 2);
+
+    // the unsorted draws go through the same cache, so the sort is what saves the state changes
+    CHECK(unsortedBackend.calls.drawElements == DRAWS);
+    CHECK(calls.StateChanges() * 2 < unsortedBackend.calls.StateChanges());
+    std::cout << "state changes for " << DRAWS << " draws: sorted " << calls.StateChanges() << ", unsorted " << unsortedBackend.calls.StateChanges() << std::endl;
+
+    // within the same state the nearer draw comes first, wherever it was submitted
+    {
+        RenderQueue depthQueue;
+        depthQueue.SetDepthRange(0.0f, 10.0f);
+        const float depths[4] = { 7.0f, 1.0f, 9.5f, 3.0f };
+        for (unsigned int i = 0; i < 4; i++)
+        {
+            RenderItem item;
+            item.vao = 1;
+            depthQueue.Submit(10, item, glm::mat4(1.0f), depths[i]);
+        }
+        depthQueue.Sort();
+        for (size_t i = 0; i + 1 < depthQueue.Size(); i++)
+            CHECK((depthQueue.GetSortedKey(i) & 0xFFFF) < (depthQueue.GetSortedKey(i + 1) & 0xFFFF));
+        // depths outside the range are clamped to its ends
+        depthQueue.Clear();
+        RenderItem item;
+        depthQueue.Submit(10, item, glm::mat4(1.0f), 50.0f);
+        depthQueue.Submit(10, item, glm::mat4(1.0f), -5.0f);
+        depthQueue.Sort();
+        CHECK((depthQueue.GetSortedKey(0) & 0xFFFF) == 0);
+        CHECK((depthQueue.GetSortedKey(1) & 0xFFFF) == 0xFFFF);
+    }
+
+    // the key fields can't spill into each other
+    CHECK(RenderQueue::MakeKey(1, 0, 0, 0) > RenderQueue::MakeKey(0, 0x3FFFF, 0xFFFFF, 0xFFFF));
+    CHECK(RenderQueue::MakeKey(0, 1, 0, 0) > RenderQueue::MakeKey(0, 0, 0xFFFFF, 0xFFFF));
+    CHECK(RenderQueue::MakeKey(0, 0, 1, 0) > RenderQueue::MakeKey(0, 0, 0, 0xFFFF));
+
+    // the state cache drops repeated binds until it is invalidated
+    {
+        RecordingRenderBackend backend;
+        RenderStateCache state(backend);
+        state.UseProgram(3);
+        state.UseProgram(3);
+        state.BindTexture(0, 5);
+        state.BindTexture(0, 5);
+        state.BindTexture(1, 5);
+        state.BindVertexArray(2);
+        state.BindVertexArray(2);
+        state.SetUniform(4, 1);
+        state.SetUniform(4, 1);
+        state.SetUniform(-1, 1);
+        CHECK(backend.calls.useProgram == 1);
+        CHECK(backend.calls.bindTexture == 2);
+        CHECK(backend.calls.activeTexture == 2);
+        CHECK(backend.calls.bindVertexArray == 1);
+        CHECK(backend.calls.uniform == 1);
+        // a sampler value set for one program doesn't carry over to another
+        state.UseProgram(4);
+        state.SetUniform(4, 1);
+        CHECK(backend.calls.uniform == 2);
+        state.Invalidate();
+        state.UseProgram(4);
+        state.BindTexture(1, 5);
+        state.BindVertexArray(2);
+        CHECK(backend.calls.useProgram == 3);
+        CHECK(backend.calls.bindTexture == 3);
+        CHECK(backend.calls.bindVertexArray == 2);
+    }
+
+    return TestResult();
+}
@@ -0,0 +1,170 @@
+// Checks that SceneGraph gives the same results with a job system as without one: world matrices and bounds after
+// the parallel update of a forest of random subtrees, of one deep tree and of a long chain, also after a few nodes
+// move and after nodes are added, and the draws submit() queues, which jobs collect in lists of their own.
+#include <learnopengl/shader.h>
+#include <learnopengl/camera.h>
+#include <learnopengl/model.h>
+#include <learnopengl/entity.h>
+
+#include <random>
+#include <vector>
+
+#include "test_common.h"
+
+// parents of a hierarchy with a bit of everything: a few hundred roots with subtrees of very different sizes,
+// one 8-ary tree of 20000 nodes and a chain of 3000
+std::vector<int> makeParents()
+{
+    std::mt19937 rng(5);
+    std::vector<int> parents;
+    for (int i = 0; i < 20000; i++)
+        parents.push_back(rng() % 8 == 0 || i == 0 ? -1 : i - 1 - static_cast<int>(rng() % std::min(i, 200)));
+    const int treeRoot = static_cast<int>(parents.size());
+    parents.push_back(-1);
+    for (int i = 1; i < 20000; i++)
+        parents.push_back(treeRoot + (i - 1) / 8);
+    parents.push_back(-1);
+    for (int i = 1; i < 3000; i++)
+        parents.push_back(static_cast<int>(parents.size()) - 1);
+    return parents;
+}
+
+void addNodes(SceneGraph &scene, const std::vector<int> &parents, size_t begin, size_t end, Model *model)
+{
+    const AABB local(glm::vec3(-0.5f), glm::vec3(0.5f));
+    for (size_t i = begin; i < end; i++)
+    {
+        const int node = model ? scene.addNode(*model, parents[i]) : scene.addNode(local, nullptr, parents[i]);
+        scene.setLocalPosition(node, glm::vec3(std::cos(float(i)), 0.01f * (i % 13), std::sin(float(i))));
+        scene.setLocalRotation(node, glm::vec3(0.0f, float(i * 7 % 360), 0.0f));
+        scene.setLocalScale(node, glm::vec3(0.99f));
+    }
+}
+
+// the same float operations in the same order give the same bits, so the results have to match exactly
+bool sameWorld(const SceneGraph &a, const SceneGraph &b)
+{
+    if (a.size() != b.size() || a.getModelMatrices() != b.getModelMatrices())
+        return false;
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        if (a.isDirty(static_cast<int>(i)) || b.isDirty(static_cast<int>(i)))
+            return false;
+        if (a.getWorldBounds().CenterX[i] != b.getWorldBounds().CenterX[i] || a.getWorldBounds().ExtentZ[i] != b.getWorldBounds().ExtentZ[i])
+            return false;
+    }
+    return true;
+}
+
+// the model matrices in the order the queue draws them; draws with equal keys keep the order they were queued in
+class MatrixRecordingBackend : public RecordingRenderBackend
+{
+public:
+    std::vector<glm::mat4> matrices;
+
+    void SetUniform(int location, int value) override { RecordingRenderBackend::SetUniform(location, value); }
+    void SetUniform(int location, const glm::mat4 &value) override
+    {
+        RecordingRenderBackend::SetUniform(location, value);
+        matrices.push_back(value);
+    }
+};
+
+std::vector<glm::mat4> drawnMatrices(RenderQueue &queue)
+{
+    MatrixRecordingBackend backend;
+    RenderStateCache state(backend);
+    queue.Flush(state);
+    return backend.matrices;
+}
+
+int main()
+{
+    const std::vector<int> parents = makeParents();
+    JobSystem jobs(4);
+
+    // updating everything, a few nodes, and again after adding nodes, which makes the update split the work anew
+    {
+        SceneGraph serial, parallel;
+        parallel.setJobSystem(&jobs);
+        const size_t firstPart = parents.size() - 5000;
+        addNodes(serial, parents, 0, firstPart, nullptr);
+        addNodes(parallel, parents, 0, firstPart, nullptr);
+        serial.update();
+        parallel.update();
+        CHECK(sameWorld(serial, parallel));
+
+        for (int node = 0; node < static_cast<int>(serial.size()); node += 97)
+        {
+            serial.setLocalRotation(node, serial.getLocalRotation(node) + glm::vec3(5.0f, 0.0f, 0.0f));
+            parallel.setLocalRotation(node, parallel.getLocalRotation(node) + glm::vec3(5.0f, 0.0f, 0.0f));
+        }
+        serial.update();
+        parallel.update();
+        CHECK(sameWorld(serial, parallel));
+
+        addNodes(serial, parents, firstPart, parents.size(), nullptr);
+        addNodes(parallel, parents, firstPart, parents.size(), nullptr);
+        serial.setLocalPosition(0, glm::vec3(3.0f));
+        parallel.setLocalPosition(0, glm::vec3(3.0f));
+        serial.update();
+        parallel.update();
+        CHECK(sameWorld(serial, parallel));
+
+        // a different number of threads splits differently but still gives the same world
+        JobSystem moreJobs(7);
+        parallel.setJobSystem(&moreJobs);
+        parallel.forceUpdate();
+        CHECK(sameWorld(serial, parallel));
+    }
+
+    // submit() queues the same draws in the same order however many threads filled the lists. The parallel culling
+    // lists the visible nodes in another order than the serial one, so without a job system only the count matches
+    {
+        Model planet("resources/objects/planet/planet.obj", false, VERTEX_FORMAT_FULL, MESH_OPTIMIZE_NONE, false);
+        CHECK(!planet.meshes.empty());
+        Shader shader;
+        JobSystem fewerJobs(2);
+        SceneGraph serial, parallel, fewer;
+        parallel.setJobSystem(&jobs);
+        fewer.setJobSystem(&fewerJobs);
+        addNodes(serial, parents, 0, 8000, &planet);
+        addNodes(parallel, parents, 0, 8000, &planet);
+        addNodes(fewer, parents, 0, 8000, &planet);
+        Camera camera(glm::vec3(0.0f, 2.0f, 10.0f));
+        const Frustum frustum = createFrustumFromCamera(camera, 4.0f / 3.0f, glm::radians(60.0f), 0.1f, 100.0f);
+        RenderQueue serialQueue, parallelQueue, fewerQueue;
+        unsigned int serialDisplay = 0, parallelDisplay = 0, fewerDisplay = 0, total = 0;
+        serial.submit(frustum, shader, camera.Position, serialQueue, serialDisplay, total);
+        parallel.submit(frustum, shader, camera.Position, parallelQueue, parallelDisplay, total);
+        fewer.submit(frustum, shader, camera.Position, fewerQueue, fewerDisplay, total);
+        CHECK(serialDisplay == parallelDisplay && serialDisplay == fewerDisplay);
+        // enough visible nodes that the draws are collected by several jobs
+        CHECK(serialDisplay > 2000);
+        CHECK(serialQueue.Size() == serialDisplay * planet.meshes.size());
+        CHECK(parallelQueue.Size() == serialQueue.Size());
+        // the same as queueing the visible nodes one after the other
+        RenderQueue reference;
+        for (unsigned int node : parallel.cull(frustum))
+            reference.Submit(shader, planet, parallel.getModelMatrix(node), glm::length(glm::vec3(parallel.getModelMatrix(node)[3]) - camera.Position));
+        const std::vector<glm::mat4> drawn = drawnMatrices(parallelQueue);
+        CHECK(drawn == drawnMatrices(reference));
+        CHECK(drawn == drawnMatrices(fewerQueue));
+
+        // a list appended in one piece is the same as submitting straight to the queue
+        RenderQueue direct, appended;
+        RenderList list;
+        for (int node = 0; node < 100; node++)
+        {
+            // a few draws share a depth, so their order comes from the order they were added in
+            const float depth = 0.5f * (node / 4);
+            direct.Submit(shader, planet, serial.getModelMatrix(node), depth);
+            list.Submit(shader, planet, serial.getModelMatrix(node), depth);
+        }
+        appended.Append(list);
+        CHECK(list.Size() == direct.Size());
+        CHECK(drawnMatrices(direct) == drawnMatrices(appended));
+    }
+
+    return TestResult();
+}
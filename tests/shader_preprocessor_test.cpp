@@ -0,0 +1,143 @@
+// Checks ShaderPreprocessor on GLSL files written to a scratch directory: nested #include next to the includer,
+// every file included once, cycles and missing files reported without recursing forever, #line directives,
+// #pragma once, defines injected after #version (unused ones dropped, order irrelevant), sources registered in
+// memory, and Refresh() picking up edited files. A shader without includes or defines must come out unchanged.
+#include <learnopengl/shader_preprocessor.h>
+#include <learnopengl/vertex_format.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "test_common.h"
+
+std::filesystem::path scratch;
+
+std::string write(const std::string &name, const std::string &text)
+{
+    const std::filesystem::path path = scratch / name;
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream(path, std::ios::binary) << text;
+    return ShaderPreprocessor::Normalize(path.string());
+}
+
+bool contains(const std::string &text, const std::string &part)
+{
+    return text.find(part) != std::string::npos;
+}
+
+size_t count(const std::string &text, const std::string &part)
+{
+    size_t found = 0;
+    for (size_t pos = text.find(part); pos != std::string::npos; pos = text.find(part, pos + 1))
+        found++;
+    return found;
+}
+
+int main()
+{
+    scratch = std::filesystem::temp_directory_path() / ("logl_preprocessor_test_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+    std::filesystem::create_directories(scratch);
+
+    // untouched: no includes, no defines, no trailing newline
+    {
+        ShaderPreprocessor preprocessor;
+        const std::string text = "#version 330 core\nout vec4 color;\nvoid main() { color = vec4(1.0); }";
+        const std::string path = write("plain.fs", text);
+        CHECK(preprocessor.Process(path).source == text);
+        // a define the shader never mentions doesn't change it either
+        CHECK(preprocessor.Process(path, ShaderDefines{ { "UNUSED", "1" } }).source == text);
+    }
+
+    // nested includes, resolved next to the including file; common.glsl is included twice but pasted once
+    {
+        ShaderPreprocessor preprocessor;
+        write("lib/common.glsl", "#pragma once\nfloat common_value() { return 1.0; }\n");
+        write("lib/lighting.glsl", "#include \"common.glsl\"\nfloat lighting() { return common_value(); }\n");
+        const std::string path = write("nested.fs", "#version 330 core\n#include \"lib/lighting.glsl\"\n#include \"lib/common.glsl\"\nvoid main() { }\n");
+        const PreprocessedShader shader = preprocessor.Process(path);
+        CHECK(shader.files.size() == 3);
+        CHECK(shader.files.size() == 3 && shader.files[0] == path);
+        CHECK(shader.files.size() == 3 && contains(shader.files[1], "lighting.glsl") && contains(shader.files[2], "common.glsl"));
+        CHECK(count(shader.source, "float common_value()") == 1);
+        CHECK(contains(shader.source, "float lighting()"));
+        CHECK(!contains(shader.source, "#include"));
+        CHECK(!contains(shader.source, "#pragma once"));
+        // common.glsl must come before the lighting code that calls it
+        CHECK(shader.source.find("float common_value()") < shader.source.find("float lighting()"));
+        // each include starts at its own line 1 and the includer continues on the line after the #include
+        CHECK(contains(shader.source, "#line 1 1\n"));
+        CHECK(contains(shader.source, "#line 1 2\n"));
+        CHECK(contains(shader.source, "#line 2 1\n")); // back in lighting.glsl after including common.glsl
+        CHECK(contains(shader.source, "#line 3 0\n")); // back in nested.fs after including lighting.glsl
+        CHECK(shader.source.compare(0, 18, "#version 330 core\n") == 0);
+    }
+
+    // a cycle is reported and cut, a missing file is reported and skipped (the two ERROR lines in the output)
+    {
+        ShaderPreprocessor preprocessor;
+        write("cycle/a.glsl", "#include \"b.glsl\"\nfloat a() { return 1.0; }\n");
+        write("cycle/b.glsl", "#include \"a.glsl\"\nfloat b() { return 2.0; }\n");
+        const std::string path = write("cycle/main.fs", "#version 330 core\n#include \"a.glsl\"\n#include \"missing.glsl\"\nvoid main() { }\n");
+        const PreprocessedShader shader = preprocessor.Process(path);
+        CHECK(shader.files.size() == 3);
+        CHECK(count(shader.source, "float a()") == 1);
+        CHECK(count(shader.source, "float b()") == 1);
+        CHECK(contains(shader.source, "void main()"));
+    }
+
+    // defines go after #version whatever order they were set in; unused ones are dropped
+    {
+        ShaderPreprocessor preprocessor;
+        const std::string path = write("defines.fs", "#version 330 core\nuniform vec3 lights[NR_LIGHTS];\n#ifdef USE_SHADOWS\nfloat shadow;\n#endif\nvoid main() { }\n");
+        const std::string first = preprocessor.Process(path, ShaderDefines{ { "NR_LIGHTS", "32" }, { "USE_SHADOWS", "1" }, { "UNUSED", "1" } }).source;
+        const std::string second = preprocessor.Process(path, ShaderDefines().Set("UNUSED").Set("USE_SHADOWS").Set("NR_LIGHTS", 32)).source;
+        CHECK(first == second);
+        CHECK(first.compare(0, 18, "#version 330 core\n") == 0);
+        CHECK(first.find("#define NR_LIGHTS 32\n") == 18);
+        CHECK(contains(first, "#define USE_SHADOWS 1\n"));
+        CHECK(!contains(first, "UNUSED"));
+        // the shader's own second line is numbered 2 again after the injected lines
+        CHECK(contains(first, "#line 2 0\nuniform vec3 lights[NR_LIGHTS];"));
+        // a different value is a different permutation
+        CHECK(preprocessor.Process(path, ShaderDefines{ { "NR_LIGHTS", "16" } }).source != first);
+        // without #version the defines go first
+        const std::string bare = write("bare.fs", "float value = VALUE;\n");
+        CHECK(preprocessor.Process(bare, ShaderDefines{ { "VALUE", "2.0" } }).source == "#define VALUE 2.0\n#line 1 0\nfloat value = VALUE;\n");
+    }
+
+    // sources registered in memory are included like files
+    {
+        ShaderPreprocessor preprocessor;
+        preprocessor.AddSource(COMPACT_VERTEX_GLSL_NAME, COMPACT_VERTEX_GLSL);
+        const std::string path = write("compact.vs", "#version 330 core\n#include \"learnopengl/compact_vertex.glsl\"\nvoid main() { }\n");
+        const PreprocessedShader shader = preprocessor.Process(path);
+        CHECK(shader.files.size() == 2);
+        CHECK(contains(shader.source, "octDecode"));
+        // and can be replaced, which forgets the shaders built from them
+        preprocessor.AddSource(COMPACT_VERTEX_GLSL_NAME, "vec3 replaced() { return vec3(0.0); }\n");
+        CHECK(contains(preprocessor.Process(path).source, "replaced"));
+    }
+
+    // Refresh() reports edited files and everything including them builds from the new text
+    {
+        ShaderPreprocessor preprocessor;
+        const std::string include = write("refresh/value.glsl", "float value() { return 1.0; }\n");
+        const std::string path = write("refresh/main.fs", "#version 330 core\n#include \"value.glsl\"\nvoid main() { }\n");
+        CHECK(contains(preprocessor.Process(path).source, "return 1.0;"));
+        CHECK(preprocessor.Refresh().empty());
+        write("refresh/value.glsl", "float value() { return 2.0; }\n");
+        // file times can be coarse; make sure the edit doesn't look as old as the first write
+        std::filesystem::last_write_time(include, std::filesystem::last_write_time(include) + std::chrono::seconds(2));
+        const std::vector<std::string> changed = preprocessor.Refresh();
+        CHECK(changed.size() == 1 && changed[0] == include);
+        CHECK(ShaderPreprocessor::DependsOn(preprocessor.Process(path).files, changed));
+        CHECK(contains(preprocessor.Process(path).source, "return 2.0;"));
+    }
+
+    std::error_code error;
+    std::filesystem::remove_all(scratch, error);
+    return TestResult();
+}
@@ -0,0 +1,108 @@
+// Checks the CPU side of Breakout's sprite batching: SpriteBatch puts every queued sprite in exactly one run, one run
+// per texture in order of first use, keeps the submission order within a run and writes the instance data the sprite
+// shader expects, both on a handful of sprites and on 10000 in random runs like a level's bricks.
+#include "sprite_batch.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "test_common.h"
+
+// builds batch into a vector of its size
+std::vector<SpriteInstance> buildSprites(SpriteBatch &batch)
+{
+    std::vector<SpriteInstance> instances(batch.Size());
+    batch.Build(instances.data());
+    return instances;
+}
+
+int main()
+{
+    // sprite i sits at x = i, so the output order shows where every sprite went
+    {
+        SpriteBatch batch;
+        const unsigned int textures[6] = { 5, 7, 5, 9, 7, 5 };
+        for (unsigned int i = 0; i < 6; i++)
+            batch.Add(textures[i], glm::vec2(i, 2.0f), glm::vec2(3.0f, 4.0f), 90.0f, glm::vec3(0.25f, 0.5f, 0.75f));
+        CHECK(batch.Size() == 6 && !batch.Empty());
+        std::vector<SpriteInstance> instances = buildSprites(batch);
+        const std::vector<SpriteBatchRange> &runs = batch.Batches();
+        CHECK(runs.size() == 3);
+        if (runs.size() == 3)
+        {
+            CHECK(runs[0].Texture == 5 && runs[0].First == 0 && runs[0].Count == 3);
+            CHECK(runs[1].Texture == 7 && runs[1].First == 3 && runs[1].Count == 2);
+            CHECK(runs[2].Texture == 9 && runs[2].First == 5 && runs[2].Count == 1);
+        }
+        const float order[6] = { 0.0f, 2.0f, 5.0f, 1.0f, 4.0f, 3.0f };
+        for (unsigned int i = 0; i < 6; i++)
+            CHECK(instances[i].Rect.x == order[i]);
+        // the rect is position and size, the shader takes the rotation in radians
+        CHECK(instances[0].Rect == glm::vec4(0.0f, 2.0f, 3.0f, 4.0f));
+        CHECK(instances[0].ColorRotation == glm::vec4(0.25f, 0.5f, 0.75f, glm::radians(90.0f)));
+
+        // the runs stay valid after Clear, until the next Build replaces them
+        batch.Clear();
+        CHECK(batch.Empty() && batch.Batches().size() == 3);
+        batch.Add(9, glm::vec2(0.0f), glm::vec2(1.0f), 0.0f, glm::vec3(1.0f));
+        buildSprites(batch);
+        CHECK(batch.Batches().size() == 1 && batch.Batches()[0].Texture == 9 && batch.Batches()[0].Count == 1);
+        batch.Clear();
+        buildSprites(batch);
+        CHECK(batch.Batches().empty());
+    }
+
+    // many sprites over a few textures, in runs of random length
+    {
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<unsigned int> texture(1, 7), length(1, 20);
+        SpriteBatch batch;
+        std::vector<unsigned int> submitted;
+        while (submitted.size() < 10000)
+        {
+            const unsigned int id = texture(rng);
+            for (unsigned int n = length(rng); n > 0; n--)
+            {
+                batch.Add(id, glm::vec2(static_cast<float>(submitted.size()), 0.0f), glm::vec2(1.0f), 0.0f, glm::vec3(1.0f));
+                submitted.push_back(id);
+            }
+        }
+        const std::vector<SpriteInstance> instances = buildSprites(batch);
+
+        // the expected output: the textures in order of first use, each with its sprites in submission order
+        std::vector<unsigned int> firstUse;
+        for (unsigned int id : submitted)
+            if (std::find(firstUse.begin(), firstUse.end(), id) == firstUse.end())
+                firstUse.push_back(id);
+        std::vector<float> expected;
+        for (unsigned int id : firstUse)
+            for (size_t i = 0; i < submitted.size(); i++)
+                if (submitted[i] == id)
+                    expected.push_back(static_cast<float>(i));
+
+        const std::vector<SpriteBatchRange> &runs = batch.Batches();
+        CHECK(runs.size() == firstUse.size());
+        unsigned int first = 0;
+        bool ordered = true, contiguous = true, grouped = true;
+        for (size_t r = 0; r < runs.size() && r < firstUse.size(); r++)
+        {
+            ordered = ordered && runs[r].Texture == firstUse[r];
+            contiguous = contiguous && runs[r].First == first;
+            for (unsigned int i = runs[r].First; i < runs[r].First + runs[r].Count && i < instances.size(); i++)
+                grouped = grouped && submitted[static_cast<unsigned int>(instances[i].Rect.x)] == runs[r].Texture;
+            first += runs[r].Count;
+        }
+        CHECK(ordered);
+        CHECK(contiguous);
+        CHECK(grouped);
+        CHECK(first == submitted.size());
+        // every sprite written once, in submission order within its run
+        bool same = instances.size() == expected.size();
+        for (size_t i = 0; same && i < instances.size(); i++)
+            same = instances[i].Rect.x == expected[i];
+        CHECK(same);
+    }
+
+    return TestResult();
+}
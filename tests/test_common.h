@@ -0,0 +1,26 @@
+#ifndef TEST_COMMON_H
+#define TEST_COMMON_H
+
+#include <iostream>
+
+// Minimal checks for the tests in this directory. A failed CHECK is reported and the test carries on,
+// so one run shows every failure; main returns TestResult() for ctest.
+inline int& TestFailures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition) \
+    do { if (!(condition)) { std::cout << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #condition << std::endl; TestFailures()++; } } while (0)
+
+inline int TestResult()
+{
+    if (TestFailures() == 0)
+        std::cout << "all checks passed" << std::endl;
+    else
+        std::cout << TestFailures() << " checks failed" << std::endl;
+    return TestFailures() == 0 ? 0 : 1;
+}
+
+#endif
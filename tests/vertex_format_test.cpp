@@ -0,0 +1,116 @@
+// Checks the compact vertex format: every unit vector survives the octahedral snorm16 round trip within
+// a fixed angle, and the vertices of the models shipped in resources/objects stay within the same bounds
+// when packed with VertexPacking::PackCompact.
+#include <learnopengl/filesystem.h>
+#include <learnopengl/model.h>
+#include <learnopengl/vertex_format.h>
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "test_common.h"
+
+// largest acceptable quantization error of a normal or tangent in degrees; snorm16 steps are well below
+// that, most of what MeasureError reports is the float precision of acos near 1
+const float MAX_DIRECTION_ERROR = 0.1f;
+
+// half floats keep 11 significant bits
+float maxTexCoordError(glm::vec2 texCoords)
+{
+    return glm::max(1.0f, glm::max(std::abs(texCoords.x), std::abs(texCoords.y))) / 2048.0f;
+}
+
+void checkRandomDirections()
+{
+    std::mt19937 random(42);
+    std::normal_distribution<float> gaussian;
+    std::vector<Vertex> vertices;
+    for (int i = 0; i < 100000; i++)
+    {
+        Vertex vertex = {};
+        vertex.Normal = glm::normalize(glm::vec3(gaussian(random), gaussian(random), gaussian(random)));
+        glm::vec3 side = glm::cross(vertex.Normal, glm::normalize(glm::vec3(gaussian(random), gaussian(random), gaussian(random))));
+        vertex.Tangent = glm::normalize(side);
+        vertex.Bitangent = glm::cross(vertex.Normal, vertex.Tangent) * (i % 2 == 0 ? 1.0f : -1.0f);
+        vertex.TexCoords = glm::vec2(i % 101, i % 37) / 16.0f;
+        vertices.push_back(vertex);
+    }
+    // the axes and the octahedron's edges are where the encoding folds
+    const glm::vec3 edges[] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 }, { 1, 1, 0 }, { 1, 0, -1 }, { 0, -1, -1 } };
+    for (const glm::vec3 &edge : edges)
+    {
+        Vertex vertex = {};
+        vertex.Normal = glm::normalize(edge);
+        vertex.Tangent = glm::normalize(glm::cross(vertex.Normal, glm::vec3(0.3f, 0.5f, 0.7f)));
+        vertex.Bitangent = glm::cross(vertex.Normal, vertex.Tangent);
+        vertices.push_back(vertex);
+    }
+    VertexPacking::PackingError error = VertexPacking::MeasureError(vertices);
+    std::cout << "random directions: normal " << error.maxNormalDegrees << " deg, tangent " << error.maxTangentDegrees << " deg" << std::endl;
+    CHECK(error.maxNormalDegrees <= MAX_DIRECTION_ERROR);
+    CHECK(error.maxTangentDegrees <= MAX_DIRECTION_ERROR);
+    CHECK(error.maxTexCoordError <= 1.0f / 2048.0f);
+    CHECK(error.bitangentSignErrors == 0);
+}
+
+// the vertices as Model builds them, without creating any GL objects; vertices without a usable tangent
+// frame (no texture coordinates, degenerate triangles) are skipped since there's nothing to preserve
+std::vector<Vertex> importVertices(const std::string &path)
+{
+    std::vector<Vertex> vertices;
+    Assimp::Importer importer;
+    const aiScene *scene = importer.ReadFile(path, MODEL_IMPORT_FLAGS);
+    if (!scene)
+    {
+        std::cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << std::endl;
+        return vertices;
+    }
+    for (unsigned int m = 0; m < scene->mNumMeshes; m++)
+    {
+        const aiMesh *mesh = scene->mMeshes[m];
+        if (!mesh->HasNormals() || !mesh->HasTangentsAndBitangents() || !mesh->mTextureCoords[0])
+            continue;
+        for (unsigned int i = 0; i < mesh->mNumVertices; i++)
+        {
+            Vertex vertex = {};
+            vertex.Position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+            vertex.Normal = glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
+            vertex.TexCoords = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
+            vertex.Tangent = glm::vec3(mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z);
+            vertex.Bitangent = glm::vec3(mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z);
+            const float handedness = glm::dot(glm::cross(vertex.Normal, vertex.Tangent), vertex.Bitangent);
+            if (!std::isfinite(handedness) || std::abs(handedness) < 1e-3f || glm::length(vertex.Normal) < 0.5f || glm::length(vertex.Tangent) < 0.5f)
+                continue;
+            vertices.push_back(vertex);
+        }
+    }
+    return vertices;
+}
+
+void checkShippedModel(const std::string &name)
+{
+    const std::vector<Vertex> vertices = importVertices(FileSystem::getPath("resources/objects/" + name));
+    CHECK(!vertices.empty());
+    VertexPacking::PackingError error = VertexPacking::MeasureError(vertices);
+    float texCoordBound = 0.0f;
+    for (const Vertex &vertex : vertices)
+        texCoordBound = glm::max(texCoordBound, maxTexCoordError(vertex.TexCoords));
+    std::cout << name << ": " << vertices.size() << " vertices, normal " << error.maxNormalDegrees << " deg, tangent "
+              << error.maxTangentDegrees << " deg, texcoords " << error.maxTexCoordError << ", " << error.bitangentSignErrors << " sign errors" << std::endl;
+    CHECK(error.maxNormalDegrees <= MAX_DIRECTION_ERROR);
+    CHECK(error.maxTangentDegrees <= MAX_DIRECTION_ERROR);
+    CHECK(error.maxTexCoordError <= texCoordBound);
+    CHECK(error.bitangentSignErrors == 0);
+}
+
+int main()
+{
+    checkRandomDirections();
+    checkShippedModel("planet/planet.obj");
+    checkShippedModel("rock/rock.obj");
+    checkShippedModel("cyborg/cyborg.obj");
+    checkShippedModel("nanosuit/nanosuit.obj");
+    return TestResult();
+}